@@ -16,6 +16,7 @@ Item {
     property double scaley
     property bool dropped
     property string fps
+    property string cacheInfo
     property bool showMarkers
     property bool showTimecode
     property bool showFps
@@ -98,6 +99,21 @@ Item {
             rightMargin: 10
         }
     }
+    Text {
+        id: cacheinfo
+        objectName: "cacheinfo"
+        color: "white"
+        style: Text.Outline;
+        styleColor: "black"
+        text: root.cacheInfo
+        visible: root.cacheInfo != ""
+        font.pixelSize: root.displayFontSize
+        anchors {
+            left: root.left
+            top: root.top
+            margins: 10
+        }
+    }
 
     TextField {
         id: marker
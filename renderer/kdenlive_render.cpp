@@ -25,6 +25,7 @@
 #include <QUrl>
 #include <QDebug>
 #include "renderjob.h"
+#include "segmentedrenderjob.h"
 
 int main(int argc, char **argv)
 {
@@ -32,6 +33,9 @@ int main(int argc, char **argv)
     QStringList args = app.arguments();
     QStringList preargs;
     QString locale;
+    QList<QPair<int, int> > segments;
+    int parallel = 1;
+    QString ffmpeg = QStringLiteral("ffmpeg");
     if (args.count() >= 7) {
         int pid = 0;
         int in = -1;
@@ -58,6 +62,18 @@ int main(int argc, char **argv)
             locale = args.at(0).section(QLatin1Char(':'), 1);
             args.removeFirst();
         }
+        if (args.at(0).startsWith(QLatin1String("-segments:"))) {
+            const QStringList zones = args.takeFirst().section(QLatin1Char(':'), 1).split(QLatin1Char(','), QString::SkipEmptyParts);
+            for (const QString &zone : zones) {
+                segments << QPair<int, int>(zone.section(QLatin1Char('-'), 0, 0).toInt(), zone.section(QLatin1Char('-'), 1, 1).toInt());
+            }
+        }
+        if (args.at(0).startsWith(QLatin1String("-parallel:"))) {
+            parallel = args.takeFirst().section(QLatin1Char(':'), 1).toInt();
+        }
+        if (args.at(0).startsWith(QLatin1String("-ffmpeg:"))) {
+            ffmpeg = args.takeFirst().mid(8);
+        }
         if (args.at(0).startsWith(QLatin1String("in="))) {
             in = args.takeFirst().section(QLatin1Char('='), -1).toInt();
         }
@@ -119,6 +135,17 @@ int main(int argc, char **argv)
             }
         }
 
+        if (segments.count() > 1 && !dualpass) {
+            qDebug() << "//STARTING SEGMENTED RENDERING: " << segments.count() << " segments, " << parallel << " processes, " << dest;
+            if (!locale.isEmpty()) {
+                qputenv("LC_NUMERIC", locale.toUtf8().constData());
+            }
+            SegmentedRenderJob *segmentedJob = new SegmentedRenderJob(doerase, pid, render, ffmpeg, profile, rendermodule, player, src, dest, preargs, args, segments, parallel);
+            segmentedJob->start();
+            int result = app.exec();
+            delete segmentedJob;
+            return result;
+        }
         qDebug() << "//STARTING RENDERING: " << erase << ',' << usekuiserver << ',' << render << ',' << profile << ',' << rendermodule << ',' << player << ',' << src << ',' << dest << ',' << preargs << ',' << args << ',' << in << ',' << out;
         RenderJob *job = new RenderJob(doerase, usekuiserver, pid, render, profile, rendermodule, player, src, dest, preargs, args, in, out);
         if (!locale.isEmpty()) {
@@ -138,10 +165,13 @@ int main(int argc, char **argv)
         delete dualjob;
     } else {
         fprintf(stderr, "Kdenlive video renderer for MLT.\nUsage: "
-                "kdenlive_render [-erase] [-kuiserver] [-locale:LOCALE] [in=pos] [out=pos] [render] [profile] [rendermodule] [player] [src] [dest] [[arg1] [arg2] ...]\n"
+                "kdenlive_render [-erase] [-kuiserver] [-locale:LOCALE] [-segments:IN-OUT,IN-OUT...] [-parallel:COUNT] [-ffmpeg:PATH] [in=pos] [out=pos] [render] [profile] [rendermodule] [player] [src] [dest] [[arg1] [arg2] ...]\n"
                 "  -erase: if that parameter is present, src file will be erased at the end\n"
                 "  -kuiserver: if that parameter is present, use KDE job tracker\n"
                 "  -locale:LOCALE : set a locale for rendering. For example, -locale:fr_FR.UTF-8 will use a french locale (comma as numeric separator)\n"
+                "  -segments:IN-OUT,IN-OUT... : render these frame ranges separately, then join them without re-encoding (not for 2 pass encoding)\n"
+                "  -parallel:COUNT : number of segments rendered at the same time\n"
+                "  -ffmpeg:PATH : path to FFmpeg, used to join the segments\n"
                 "  in=pos: start rendering at frame pos\n"
                 "  out=pos: end rendering at frame pos\n"
                 "  render: path to MLT melt renderer\n"
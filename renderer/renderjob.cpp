@@ -21,7 +21,10 @@
 
 #include <QtDBus>
 #include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QThread>
+#include <QXmlStreamReader>
 #include <QStringList>
 
 // Can't believe I need to do this to sleep.
@@ -50,7 +53,11 @@ RenderJob::RenderJob(bool erase, bool usekuiserver, int pid, const QString &rend
     m_seconds(0),
     m_frame(0),
     m_pid(pid),
-    m_dualpass(false)
+    m_dualpass(false),
+    m_firstFrameTime(-1),
+    m_lastStatsTime(0),
+    m_fps(0),
+    m_length(0)
 {
     m_renderProcess = new QProcess;
     m_renderProcess->setReadChannel(QProcess::StandardError);
@@ -76,6 +83,14 @@ RenderJob::RenderJob(bool erase, bool usekuiserver, int pid, const QString &rend
     m_args << QStringLiteral("-consumer") << rendermodule + QLatin1Char(':') + m_dest << QStringLiteral("progress=1") << args;
 
     m_dualpass = args.contains(QStringLiteral("pass=1"));
+    if (in >= 0 && out > in) {
+        m_length = out - in + 1;
+    } else {
+        m_length = producerLength(scenelist);
+        if (in > 0 && m_length > in) {
+            m_length -= in;
+        }
+    }
 
     // Create a log of every render process.
     if (!m_logfile.open(QIODevice::WriteOnly | QIODevice::Text)) {
@@ -128,41 +143,153 @@ void RenderJob::slotAbort()
 
 void RenderJob::receivedStderr()
 {
-    QString result = QString::fromLocal8Bit(m_renderProcess->readAllStandardError()).simplified();
-    if (!result.startsWith(QLatin1String("Current Frame"))) {
-        m_errorMessage.append(result + QStringLiteral("<br>"));
-    } else {
-        m_logstream << "melt: " << result << endl;
-        int pro = result.section(QLatin1Char(' '), -1).toInt();
-        if (pro <= m_progress || pro <= 0 || pro > 100) {
-            return;
+    // melt uses carriage returns to refresh its progress line, so one read can contain several lines
+    const QStringList lines = QString::fromLocal8Bit(m_renderProcess->readAllStandardError()).split(QRegExp(QStringLiteral("[\\r\\n]")), QString::SkipEmptyParts);
+    QString lastProgress;
+    for (const QString &line : lines) {
+        QString result = line.simplified();
+        if (result.isEmpty()) {
+            continue;
         }
+        if (!result.startsWith(QLatin1String("Current Frame"))) {
+            m_errorMessage.append(result + QStringLiteral("<br>"));
+        } else {
+            lastProgress = result;
+        }
+    }
+    if (!lastProgress.isEmpty()) {
+        parseProgress(lastProgress);
+    }
+}
+
+void RenderJob::parseProgress(const QString &result)
+{
+    // Line format is: "Current Frame: 125, percentage: 12"
+    int frame = result.section(QLatin1Char(','), 0, 0).section(QLatin1Char(' '), -1).toInt();
+    int pro = result.section(QLatin1Char(' '), -1).toInt();
+    qint64 elapsed = m_timer.elapsed();
+    if (m_firstFrameTime < 0) {
+        m_firstFrameTime = elapsed;
+        m_frame = frame;
+        m_lastStatsTime = elapsed;
+    } else if (frame > m_frame && elapsed > m_lastStatsTime) {
+        double fps = (frame - m_frame) * 1000.0 / (elapsed - m_lastStatsTime);
+        // Smooth the speed so that the remaining time does not jump around
+        m_fps = m_fps > 0 ? 0.8 * m_fps + 0.2 * fps : fps;
+    }
+    bool progressChanged = pro > 0 && pro <= 100 && pro > m_progress;
+    if (!progressChanged && elapsed - m_lastStatsTime < 1000) {
+        return;
+    }
+    m_logstream << "melt: " << result << endl;
+    if (progressChanged) {
         m_progress = pro;
         if (m_args.contains(QStringLiteral("pass=1"))) {
             m_progress /= 2.0;
         } else if (m_args.contains(QStringLiteral("pass=2"))) {
             m_progress = 50 + m_progress / 2.0;
         }
-        int frame = result.section(QLatin1Char(','), 1).section(QLatin1Char(' '), -1).toInt();
         if (m_kdenliveinterface && m_kdenliveinterface->isValid()) {
             m_dbusargs[1] = m_progress;
             m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dbusargs);
         }
-        if (m_jobUiserver) {
-            m_jobUiserver->call(QStringLiteral("setPercent"), (uint) m_progress);
-            int seconds = m_startTime.secsTo(QTime::currentTime());
-            if (seconds == m_seconds) {
-                return;
+    }
+    if (frame > m_frame) {
+        m_frame = frame;
+        m_lastStatsTime = elapsed;
+    }
+    sendStats();
+    if (m_jobUiserver) {
+        m_jobUiserver->call(QStringLiteral("setPercent"), (uint) m_progress);
+        int seconds = (int)(elapsed / 1000);
+        if (seconds == m_seconds || m_progress <= 0) {
+            return;
+        }
+        int remaining = (int)(seconds * (100 - m_progress) / m_progress);
+        if (m_fps > 0 && pro > 0) {
+            // Estimate from the real encoding speed
+            int total = m_length > 0 ? m_length : m_frame * 100 / pro;
+            remaining = (int)((total - m_frame) / m_fps);
+            if (m_args.contains(QStringLiteral("pass=1"))) {
+                remaining += (int)(total / m_fps);
             }
-            if (seconds < 0) {
-                seconds += 24 * 60 * 60;
+        }
+        m_jobUiserver->call(QStringLiteral("setDescriptionField"), (uint) 0,
+                            QString(), tr("Remaining time: ") + QTime(0, 0, 0).addSecs(qMax(0, remaining)).toString(QStringLiteral("hh:mm:ss")) + QStringLiteral(" (%1 fps)").arg(m_fps, 0, 'f', 1));
+        m_seconds = seconds;
+    }
+}
+
+int RenderJob::producerLength(const QString &scenelist)
+{
+    QString path = scenelist;
+    if (path.startsWith(QLatin1String("consumer:"))) {
+        path.remove(0, 9);
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    // MLT plays the last top level producer of the document
+    QXmlStreamReader xml(&file);
+    int length = 0;
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+        if (xml.name() == QLatin1String("mlt")) {
+            continue;
+        }
+        const QStringRef name = xml.name();
+        if (name == QLatin1String("producer") || name == QLatin1String("playlist") || name == QLatin1String("tractor")) {
+            const QXmlStreamAttributes attributes = xml.attributes();
+            if (attributes.hasAttribute(QStringLiteral("out"))) {
+                length = attributes.value(QStringLiteral("out")).toInt() - attributes.value(QStringLiteral("in")).toInt() + 1;
+            } else {
+                length = 0;
             }
-            m_jobUiserver->call(QStringLiteral("setDescriptionField"), (uint) 0,
-                                QString(), tr("Remaining time: ") + QTime(0, 0, 0).addSecs((int)(seconds * (100 - m_progress) / m_progress)).toString(QStringLiteral("hh:mm:ss")));
-            //m_jobUiserver->call("setSpeed", (frame - m_frame) / (seconds - m_seconds));
-            m_frame = frame;
-            m_seconds = seconds;
         }
+        xml.skipCurrentElement();
+    }
+    return qMax(0, length);
+}
+
+void RenderJob::sendStats(bool finished)
+{
+    QJsonObject stats;
+    qint64 elapsed = m_timer.elapsed();
+    stats.insert(QStringLiteral("frame"), m_frame);
+    stats.insert(QStringLiteral("progress"), m_progress);
+    stats.insert(QStringLiteral("bytes"), QFileInfo(m_dest).size());
+    stats.insert(QStringLiteral("elapsed"), elapsed);
+    if (m_args.contains(QStringLiteral("pass=1"))) {
+        stats.insert(QStringLiteral("pass"), 1);
+    } else if (m_args.contains(QStringLiteral("pass=2"))) {
+        stats.insert(QStringLiteral("pass"), 2);
+    }
+    if (m_length > 0) {
+        stats.insert(QStringLiteral("frames"), m_length);
+    }
+    if (finished) {
+        // Per stage timings: process startup until first frame, then encoding
+        qint64 encoding = m_firstFrameTime < 0 ? 0 : elapsed - m_firstFrameTime;
+        QJsonObject stages;
+        stages.insert(QStringLiteral("startup"), m_firstFrameTime < 0 ? elapsed : m_firstFrameTime);
+        stages.insert(QStringLiteral("encoding"), encoding);
+        stats.insert(QStringLiteral("stages"), stages);
+        stats.insert(QStringLiteral("fps"), encoding > 0 ? m_frame * 1000.0 / encoding : 0.);
+        stats.insert(QStringLiteral("finished"), true);
+    } else {
+        stats.insert(QStringLiteral("fps"), m_fps);
+    }
+    const QString json = QString::fromUtf8(QJsonDocument(stats).toJson(QJsonDocument::Compact));
+    if (finished) {
+        m_logstream << "stats: " << json << endl;
+    }
+    if (m_kdenliveinterface && m_kdenliveinterface->isValid()) {
+        QList<QVariant> args;
+        args << m_dest << json;
+        m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingStats"), args);
     }
 }
 
@@ -193,7 +320,6 @@ void RenderJob::start()
             QString dbusView = QStringLiteral("org.kde.JobViewV2");
             m_jobUiserver = new QDBusInterface(QStringLiteral("org.kde.JobViewServer"), reply, dbusView);
             if (m_jobUiserver && m_jobUiserver->isValid()) {
-                m_startTime = QTime::currentTime();
                 if (!m_args.contains(QStringLiteral("pass=2"))) {
                     m_jobUiserver->call(QStringLiteral("setPercent"), (uint) 0);
                 }
@@ -213,6 +339,7 @@ void RenderJob::start()
 
     // Because of the logging, we connect to stderr in all cases.
     connect(m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
+    m_timer.start();
     m_renderProcess->start(m_prog, m_args);
     m_logstream << "Started render process: " << m_prog << ' ' << m_args.join(QLatin1Char(' ')) << endl;
 }
@@ -297,6 +424,7 @@ void RenderJob::slotIsOver(QProcess::ExitStatus status, bool isWritable)
         QProcess::startDetached(QStringLiteral("kdialog"), args);
         qApp->quit();
     } else {
+        sendStats(true);
         if (!m_dualpass && m_kdenliveinterface) {
             m_dbusargs[1] = (int) - 1;
             m_dbusargs.append(QString());
@@ -23,6 +23,7 @@
 #include <QProcess>
 #include <QObject>
 #include <QDBusInterface>
+#include <QElapsedTimer>
 #include <QTime>
 // Testing
 #include <QTemporaryFile>
@@ -67,11 +68,26 @@ private:
     QProcess *m_renderProcess;
     QString m_errorMessage;
     QList<QVariant> m_dbusargs;
-    QTime m_startTime;
     QStringList m_args;
     /** @brief Used to write to the log file. */
     QTextStream m_logstream;
+    /** @brief Measures the render process, from start to exit. */
+    QElapsedTimer m_timer;
+    /** @brief Time (ms) when melt reported its first frame, ie. the end of the startup stage. */
+    qint64 m_firstFrameTime;
+    /** @brief Time (ms) of the last statistics sent to Kdenlive. */
+    qint64 m_lastStatsTime;
+    /** @brief Smoothed encoding speed in frames per second. */
+    double m_fps;
+    /** @brief Number of frames to render, 0 if unknown. */
+    int m_length;
     void initKdenliveDbusInterface();
+    /** @brief Parse one melt progress line and update the render statistics. */
+    void parseProgress(const QString &line);
+    /** @brief Length of the main producer of a MLT xml scene list, 0 if it cannot be read. */
+    static int producerLength(const QString &scenelist);
+    /** @brief Send a JSON record describing the current render state to Kdenlive (and the log). */
+    void sendStats(bool finished = false);
 
 signals:
     void renderingFinished();
@@ -0,0 +1,406 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#include "segmentedrenderjob.h"
+
+#include <QtDBus>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Number of times a failed segment is rendered again before giving up
+static const int MAX_RETRIES = 2;
+
+SegmentedRenderJob::SegmentedRenderJob(bool erase, int pid, const QString &renderer, const QString &ffmpeg, const QString &profile, const QString &rendermodule, const QString &player, const QString &scenelist, const QString &dest, const QStringList &preargs, const QStringList &args, const QList<QPair<int, int> > &segments, int parallel) :
+    QObject(),
+    m_scenelist(scenelist),
+    m_dest(dest),
+    m_prog(renderer),
+    m_ffmpeg(ffmpeg),
+    m_profile(profile),
+    m_rendermodule(rendermodule),
+    m_player(player),
+    m_preargs(preargs),
+    m_args(args),
+    m_erase(erase),
+    m_pid(pid),
+    m_parallel(qMax(1, parallel)),
+    m_concatProcess(nullptr),
+    m_kdenliveinterface(nullptr),
+    m_progress(0),
+    m_aborted(false),
+    m_lastStatsTime(0),
+    m_logfile(dest + QStringLiteral(".txt"))
+{
+    // Disable VDPAU so that rendering will work even if there is a Kdenlive instance using VDPAU
+    qputenv("MLT_NO_VDPAU", "1");
+    for (const QPair<int, int> &zone : segments) {
+        Segment seg;
+        seg.in = zone.first;
+        seg.out = zone.second;
+        seg.progress = 0;
+        seg.retries = 0;
+        seg.process = nullptr;
+        m_segments << seg;
+    }
+    QFileInfo info(m_dest);
+    m_segmentDir = QDir(info.absolutePath());
+    const QString segmentFolder = QStringLiteral(".%1.segments").arg(info.fileName());
+    m_segmentDir.mkpath(segmentFolder);
+    m_segmentDir.cd(segmentFolder);
+
+    // Create a log of every render process.
+    if (!m_logfile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Unable to log to " << m_logfile.fileName();
+    } else {
+        m_logstream.setDevice(&m_logfile);
+    }
+}
+
+SegmentedRenderJob::~SegmentedRenderJob()
+{
+    for (Segment &seg : m_segments) {
+        delete seg.process;
+    }
+    delete m_concatProcess;
+    m_logfile.close();
+}
+
+void SegmentedRenderJob::start()
+{
+    initKdenliveDbusInterface();
+    if (!m_segmentDir.dirName().endsWith(QLatin1String(".segments")) || !QFileInfo(m_segmentDir.absolutePath()).isWritable()) {
+        finish(-2, tr("Cannot write to %1, check permissions.").arg(m_dest));
+        return;
+    }
+    m_logstream << "Rendering " << m_segments.count() << " segments using " << m_parallel << " processes" << endl;
+    m_timer.start();
+    startSegments();
+}
+
+void SegmentedRenderJob::initKdenliveDbusInterface()
+{
+    QString kdenliveId;
+    QDBusConnection connection = QDBusConnection::sessionBus();
+    QDBusConnectionInterface *ibus = connection.interface();
+    kdenliveId = QStringLiteral("org.kde.kdenlive-%1").arg(m_pid);
+    if (!ibus->isServiceRegistered(kdenliveId)) {
+        kdenliveId.clear();
+        const QStringList services = ibus->registeredServiceNames();
+        for (const QString &service : services) {
+            if (!service.startsWith(QLatin1String("org.kde.kdenlive"))) {
+                continue;
+            }
+            kdenliveId = service;
+            break;
+        }
+    }
+    m_dbusargs.clear();
+    if (kdenliveId.isEmpty()) {
+        return;
+    }
+    m_kdenliveinterface = new QDBusInterface(kdenliveId,
+            QStringLiteral("/kdenlive/MainWindow_1"),
+            QStringLiteral("org.kde.kdenlive.rendering"),
+            connection,
+            this);
+    m_dbusargs.append(m_dest);
+    m_dbusargs.append((int) 0);
+    m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dbusargs);
+    connect(m_kdenliveinterface, SIGNAL(abortRenderJob(QString)), this, SLOT(slotAbort(QString)));
+}
+
+const QString SegmentedRenderJob::segmentFile(int ix) const
+{
+    return m_segmentDir.absoluteFilePath(QStringLiteral("segment_%1.%2").arg(ix, 4, 10, QLatin1Char('0')).arg(QFileInfo(m_dest).suffix()));
+}
+
+void SegmentedRenderJob::startSegments()
+{
+    int running = 0;
+    for (const Segment &seg : m_segments) {
+        if (seg.process) {
+            running++;
+        }
+    }
+    for (int i = 0; i < m_segments.count() && running < m_parallel; ++i) {
+        if (m_segments.at(i).process == nullptr && m_segments.at(i).progress < 100) {
+            startSegment(i);
+            running++;
+        }
+    }
+}
+
+void SegmentedRenderJob::startSegment(int ix)
+{
+    Segment &seg = m_segments[ix];
+    QStringList args;
+    args << m_scenelist;
+    args << QStringLiteral("in=") + QString::number(seg.in);
+    args << QStringLiteral("out=") + QString::number(seg.out);
+    args << m_preargs;
+    if (m_scenelist.startsWith(QLatin1String("consumer:"))) {
+        // Use MLT's producer_consumer, safer to pass profile in an explicit way
+        args << QStringLiteral("profile=") + m_profile;
+    }
+    args << QStringLiteral("-profile") << m_profile;
+    args << QStringLiteral("-consumer") << m_rendermodule + QLatin1Char(':') + segmentFile(ix) << QStringLiteral("progress=1") << m_args;
+    seg.progress = 0;
+    seg.process = new QProcess;
+    seg.process->setProperty("segment", ix);
+    seg.process->setReadChannel(QProcess::StandardError);
+    connect(seg.process, &QProcess::readyReadStandardError, this, &SegmentedRenderJob::slotSegmentOutput);
+    connect(seg.process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, &SegmentedRenderJob::slotSegmentFinished);
+    connect(seg.process, &QProcess::errorOccurred, this, &SegmentedRenderJob::slotProcessError);
+    m_logstream << "Started segment " << ix << ": " << m_prog << ' ' << args.join(QLatin1Char(' ')) << endl;
+    seg.process->start(m_prog, args);
+}
+
+void SegmentedRenderJob::slotSegmentOutput()
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process) {
+        return;
+    }
+    int ix = process->property("segment").toInt();
+    const QStringList lines = QString::fromLocal8Bit(process->readAllStandardError()).split(QRegExp(QStringLiteral("[\\r\\n]")), QString::SkipEmptyParts);
+    for (const QString &line : lines) {
+        QString result = line.simplified();
+        if (result.startsWith(QLatin1String("Current Frame"))) {
+            int pro = result.section(QLatin1Char(' '), -1).toInt();
+            if (pro > m_segments.at(ix).progress && pro < 100) {
+                m_segments[ix].progress = pro;
+            }
+        } else if (!result.isEmpty()) {
+            m_errorMessage.append(result + QStringLiteral("<br>"));
+        }
+    }
+    updateProgress();
+}
+
+void SegmentedRenderJob::slotSegmentFinished(int exitCode, QProcess::ExitStatus status)
+{
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process || m_aborted) {
+        return;
+    }
+    int ix = process->property("segment").toInt();
+    Segment &seg = m_segments[ix];
+    seg.process = nullptr;
+    process->deleteLater();
+    if (status == QProcess::CrashExit || exitCode != 0 || !QFile::exists(segmentFile(ix))) {
+        m_logstream << "Segment " << ix << " failed" << endl;
+        QFile::remove(segmentFile(ix));
+        seg.progress = 0;
+        if (seg.retries >= MAX_RETRIES) {
+            slotAbort();
+            finish(-2, tr("Rendering of segment %1 failed.").arg(ix + 1) + QStringLiteral("<br>") + m_errorMessage);
+            return;
+        }
+        seg.retries++;
+    } else {
+        seg.progress = 100;
+        m_logstream << "Segment " << ix << " finished" << endl;
+    }
+    updateProgress();
+    for (const Segment &s : m_segments) {
+        if (s.progress < 100) {
+            startSegments();
+            return;
+        }
+    }
+    concatSegments();
+}
+
+void SegmentedRenderJob::updateProgress()
+{
+    // Segments have different lengths, weight their progress accordingly
+    qint64 total = 0;
+    qint64 done = 0;
+    for (const Segment &seg : m_segments) {
+        int length = seg.out - seg.in + 1;
+        total += length;
+        done += (qint64) length * seg.progress / 100;
+    }
+    // Keep the last percent for the concatenation step
+    int progress = total > 0 ? (int)(done * 99 / total) : 0;
+    if (progress > m_progress) {
+        m_progress = progress;
+        if (m_kdenliveinterface && m_kdenliveinterface->isValid()) {
+            m_dbusargs[1] = m_progress;
+            m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingProgress"), m_dbusargs);
+        }
+        sendStats();
+    } else if (m_timer.elapsed() - m_lastStatsTime > 1000) {
+        sendStats();
+    }
+}
+
+void SegmentedRenderJob::sendStats(bool finished)
+{
+    QJsonObject stats;
+    QJsonArray segments;
+    qint64 bytes = 0;
+    int frames = 0;
+    int total = 0;
+    for (int i = 0; i < m_segments.count(); ++i) {
+        const Segment &seg = m_segments.at(i);
+        segments.append(seg.progress);
+        bytes += QFileInfo(segmentFile(i)).size();
+        frames += (seg.out - seg.in + 1) * seg.progress / 100;
+        total += seg.out - seg.in + 1;
+    }
+    m_lastStatsTime = m_timer.elapsed();
+    stats.insert(QStringLiteral("frame"), frames);
+    stats.insert(QStringLiteral("frames"), total);
+    stats.insert(QStringLiteral("progress"), m_progress);
+    stats.insert(QStringLiteral("bytes"), finished ? QFileInfo(m_dest).size() : bytes);
+    stats.insert(QStringLiteral("elapsed"), m_lastStatsTime);
+    stats.insert(QStringLiteral("fps"), m_lastStatsTime > 0 ? frames * 1000.0 / m_lastStatsTime : 0.);
+    stats.insert(QStringLiteral("segments"), segments);
+    if (finished) {
+        stats.insert(QStringLiteral("finished"), true);
+    }
+    const QString json = QString::fromUtf8(QJsonDocument(stats).toJson(QJsonDocument::Compact));
+    if (finished) {
+        m_logstream << "stats: " << json << endl;
+    }
+    if (m_kdenliveinterface && m_kdenliveinterface->isValid()) {
+        QList<QVariant> args;
+        args << m_dest << json;
+        m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingStats"), args);
+    }
+}
+
+void SegmentedRenderJob::concatSegments()
+{
+    // Write the list of segments for FFmpeg's concat demuxer
+    QFile list(m_segmentDir.absoluteFilePath(QStringLiteral("segments.txt")));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        finish(-2, tr("Cannot write to %1, check permissions.").arg(list.fileName()));
+        return;
+    }
+    QTextStream stream(&list);
+    for (int i = 0; i < m_segments.count(); ++i) {
+        QString path = segmentFile(i);
+        stream << "file '" << path.replace(QLatin1Char('\''), QStringLiteral("'\\''")) << "'\n";
+    }
+    list.close();
+    QStringList args;
+    args << QStringLiteral("-y") << QStringLiteral("-f") << QStringLiteral("concat") << QStringLiteral("-safe") << QStringLiteral("0");
+    args << QStringLiteral("-i") << list.fileName() << QStringLiteral("-map") << QStringLiteral("0") << QStringLiteral("-c") << QStringLiteral("copy") << m_dest;
+    m_concatProcess = new QProcess;
+    m_concatProcess->setProcessChannelMode(QProcess::MergedChannels);
+    connect(m_concatProcess, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, &SegmentedRenderJob::slotConcatFinished);
+    connect(m_concatProcess, &QProcess::errorOccurred, this, &SegmentedRenderJob::slotProcessError);
+    m_logstream << "Joining segments: " << m_ffmpeg << ' ' << args.join(QLatin1Char(' ')) << endl;
+    m_concatProcess->start(m_ffmpeg, args);
+}
+
+void SegmentedRenderJob::slotConcatFinished(int exitCode, QProcess::ExitStatus status)
+{
+    if (m_aborted) {
+        return;
+    }
+    if (status == QProcess::CrashExit || exitCode != 0) {
+        finish(-2, tr("Joining the rendered segments failed.") + QStringLiteral("<br>") + QString::fromLocal8Bit(m_concatProcess->readAll()));
+        return;
+    }
+    m_progress = 100;
+    sendStats(true);
+    finish(-1);
+}
+
+void SegmentedRenderJob::slotProcessError(QProcess::ProcessError error)
+{
+    // Other errors are followed by the finished signal, but a process that failed to start never finishes
+    QProcess *process = qobject_cast<QProcess *>(sender());
+    if (!process || m_aborted || error != QProcess::FailedToStart) {
+        return;
+    }
+    const QString program = process->program();
+    m_logstream << "Cannot start " << program << endl;
+    slotAbort();
+    finish(-2, tr("Cannot start %1, check your installation.").arg(program.isEmpty() ? tr("FFmpeg") : program));
+}
+
+void SegmentedRenderJob::slotAbort(const QString &url)
+{
+    if (m_dest == url) {
+        slotAbort();
+        finish(-3);
+    }
+}
+
+void SegmentedRenderJob::slotAbort()
+{
+    m_aborted = true;
+    for (const Segment &seg : m_segments) {
+        if (seg.process) {
+            seg.process->kill();
+        }
+    }
+    if (m_concatProcess) {
+        m_concatProcess->kill();
+    }
+}
+
+void SegmentedRenderJob::finish(int status, const QString &error)
+{
+    if (status != -1) {
+        QFile(m_dest).remove();
+    }
+    // Make sure we only delete our temporary folder
+    if (m_segmentDir.dirName().endsWith(QLatin1String(".segments"))) {
+        m_segmentDir.removeRecursively();
+    }
+    if (m_erase) {
+        QFile(m_scenelist).remove();
+    }
+    if (m_kdenliveinterface) {
+        m_dbusargs[1] = status;
+        m_dbusargs.append(error);
+        m_kdenliveinterface->callWithArgumentList(QDBus::NoBlock, QStringLiteral("setRenderingFinished"), m_dbusargs);
+    }
+    if (status == -1) {
+        m_logstream << "Rendering of " << m_dest << " finished" << endl;
+        if (m_player.length() > 3 && m_player.contains(QLatin1Char(' '))) {
+            QStringList args = m_player.split(QLatin1Char(' '));
+            QString exec = args.takeFirst();
+            // Decode url
+            QString url = QUrl::fromEncoded(args.takeLast().toUtf8()).toLocalFile();
+            args << url;
+            QProcess::startDetached(exec, args);
+        }
+    } else {
+        m_logstream << error << endl;
+        if (status == -2) {
+            QProcess::startDetached(QStringLiteral("kdialog"), QStringList() << QStringLiteral("--error") << tr("Rendering of %1 aborted, resulting video will probably be corrupted.").arg(m_dest));
+        }
+    }
+    m_logstream.flush();
+    m_logfile.close();
+    if (status == -1) {
+        // Only keep the log of failed renders
+        m_logfile.remove();
+    }
+    qApp->quit();
+}
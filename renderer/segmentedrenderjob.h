@@ -0,0 +1,105 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#ifndef SEGMENTEDRENDERJOB_H
+#define SEGMENTEDRENDERJOB_H
+
+#include <QProcess>
+#include <QObject>
+#include <QDBusInterface>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+
+/**
+ * @class SegmentedRenderJob
+ * @brief Renders a zone as several segments in parallel melt processes, then joins them.
+ * Each segment is rendered with the in/out arguments of melt into a temporary folder next to
+ * the destination file. Failed segments are retried. When all segments are ready, they are
+ * concatenated without re-encoding with FFmpeg's concat demuxer.
+ */
+
+class SegmentedRenderJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    SegmentedRenderJob(bool erase, int pid, const QString &renderer, const QString &ffmpeg, const QString &profile, const QString &rendermodule, const QString &player, const QString &scenelist, const QString &dest, const QStringList &preargs, const QStringList &args, const QList<QPair<int, int> > &segments, int parallel);
+    ~SegmentedRenderJob();
+
+public slots:
+    void start();
+
+private slots:
+    void slotAbort();
+    void slotAbort(const QString &url);
+    void slotSegmentOutput();
+    void slotSegmentFinished(int exitCode, QProcess::ExitStatus status);
+    void slotConcatFinished(int exitCode, QProcess::ExitStatus status);
+    /** @brief A segment or the join process could not be run. */
+    void slotProcessError(QProcess::ProcessError error);
+
+private:
+    struct Segment {
+        int in;
+        int out;
+        int progress;
+        int retries;
+        QProcess *process;
+    };
+    QString m_scenelist;
+    QString m_dest;
+    QString m_prog;
+    QString m_ffmpeg;
+    QString m_profile;
+    QString m_rendermodule;
+    QString m_player;
+    QStringList m_preargs;
+    QStringList m_args;
+    bool m_erase;
+    int m_pid;
+    int m_parallel;
+    QVector<Segment> m_segments;
+    /** @brief Temporary folder where segments are rendered. */
+    QDir m_segmentDir;
+    QProcess *m_concatProcess;
+    QDBusInterface *m_kdenliveinterface;
+    QList<QVariant> m_dbusargs;
+    int m_progress;
+    bool m_aborted;
+    QString m_errorMessage;
+    QElapsedTimer m_timer;
+    qint64 m_lastStatsTime;
+    QFile m_logfile;
+    QTextStream m_logstream;
+    void initKdenliveDbusInterface();
+    /** @brief Start as many waiting segments as allowed. */
+    void startSegments();
+    void startSegment(int ix);
+    const QString segmentFile(int ix) const;
+    /** @brief Concatenate rendered segments into the destination file. */
+    void concatSegments();
+    void updateProgress();
+    void sendStats(bool finished = false);
+    void finish(int status, const QString &error = QString());
+};
+
+#endif
@@ -37,6 +37,8 @@ AbstractProjectItem::AbstractProjectItem(PROJECTITEMTYPE type, const QString &id
     , m_jobProgress(0)
     , m_itemType(type)
     , m_isCurrent(false)
+    , m_row(-1)
+    , m_searchKeyValid(false)
 {
 }
 
@@ -50,6 +52,8 @@ AbstractProjectItem::AbstractProjectItem(PROJECTITEMTYPE type, const QDomElement
     , m_jobProgress(0)
     , m_itemType(type)
     , m_isCurrent(false)
+    , m_row(-1)
+    , m_searchKeyValid(false)
 {
 }
 
@@ -113,7 +117,7 @@ void AbstractProjectItem::setParent(AbstractProjectItem *parent)
         QObject::setParent(m_parent);
     }
 
-    if (m_parent && !m_parent->contains(this)) {
+    if (m_parent && !m_parent->hasChild(this)) {
         m_parent->addChild(this);
     }
 }
@@ -142,18 +146,27 @@ QPixmap AbstractProjectItem::roundedPixmap(const QPixmap &source)
 
 void AbstractProjectItem::addChild(AbstractProjectItem *child)
 {
-    if (child && !contains(child)) {
+    if (child && !hasChild(child)) {
         bin()->emitAboutToAddItem(child);
         append(child);
+        child->m_row = count() - 1;
+        bin()->registerItem(child);
         bin()->emitItemAdded(child);
     }
 }
 
 void AbstractProjectItem::removeChild(AbstractProjectItem *child)
 {
-    if (child && contains(child)) {
+    if (child && hasChild(child)) {
         bin()->emitAboutToRemoveItem(child);
-        removeAll(child);
+        const int row = child->m_row;
+        removeAt(row);
+        child->m_row = -1;
+        // Following siblings moved up by one row
+        for (int i = row; i < count(); ++i) {
+            at(i)->m_row = i;
+        }
+        bin()->unregisterItem(child);
         bin()->emitItemRemoved(child);
     }
 }
@@ -161,11 +174,20 @@ void AbstractProjectItem::removeChild(AbstractProjectItem *child)
 int AbstractProjectItem::index() const
 {
     if (m_parent) {
-        return m_parent->indexOf(const_cast<AbstractProjectItem *>(this));
+        if (m_row < 0 || m_row >= m_parent->count() || m_parent->at(m_row) != this) {
+            m_row = m_parent->indexOf(const_cast<AbstractProjectItem *>(this));
+        }
+        return m_row;
     }
     return 0;
 }
 
+bool AbstractProjectItem::hasChild(const AbstractProjectItem *child) const
+{
+    // Cached rows are kept up to date by addChild and removeChild
+    return child->m_row >= 0 && child->m_row < count() && at(child->m_row) == child;
+}
+
 AbstractProjectItem::PROJECTITEMTYPE AbstractProjectItem::itemType() const
 {
     return m_itemType;
@@ -233,6 +255,7 @@ QString AbstractProjectItem::name() const
 void AbstractProjectItem::setName(const QString &name)
 {
     m_name = name;
+    invalidateSearchKey();
 }
 
 QString AbstractProjectItem::description() const
@@ -243,6 +266,22 @@ QString AbstractProjectItem::description() const
 void AbstractProjectItem::setDescription(const QString &description)
 {
     m_description = description;
+    invalidateSearchKey();
+}
+
+const QString &AbstractProjectItem::searchKey() const
+{
+    if (!m_searchKeyValid) {
+        // Same texts as the name, date and description columns of the bin
+        m_searchKey = (m_name + QLatin1Char('\n') + QVariant(m_date).toString() + QLatin1Char('\n') + m_description).toLower();
+        m_searchKeyValid = true;
+    }
+    return m_searchKey;
+}
+
+void AbstractProjectItem::invalidateSearchKey()
+{
+    m_searchKeyValid = false;
 }
 
 QPoint AbstractProjectItem::zone() const
@@ -98,6 +98,8 @@ public:
 
     /** @brief Returns the index this item has in its parent's child list. */
     int index() const;
+    /** @brief Returns true if @param child is in this item's child list, without searching the list. */
+    bool hasChild(const AbstractProjectItem *child) const;
 
     /** @brief Returns the type of this item (folder, clip, subclip, etc). */
     PROJECTITEMTYPE itemType() const;
@@ -189,6 +191,9 @@ public:
     /** @brief Sets a new description. */
     virtual void setDescription(const QString &description);
 
+    /** @brief Returns the lower case text (name, date and description) matched by the bin search. */
+    const QString &searchKey() const;
+
     /** @brief Flags this item as being current (or not) and notifies the bin model about it. */
     virtual void setCurrent(bool current, bool notify = true) = 0;
 
@@ -218,9 +223,15 @@ protected:
 
     /** @brief Returns a rounded border pixmap from the @param source pixmap. */
     QPixmap roundedPixmap(const QPixmap &source);
+    /** @brief Must be called when the name, date or description changed. */
+    void invalidateSearchKey();
 
 private:
     bool m_isCurrent;
+    /** @brief Cached row in the parent's child list, checked before use. */
+    mutable int m_row;
+    mutable QString m_searchKey;
+    mutable bool m_searchKeyValid;
 };
 
 #endif
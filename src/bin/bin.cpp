@@ -763,6 +763,8 @@ void Bin::abortOperations()
     }
     delete m_rootFolder;
     m_rootFolder = nullptr;
+    m_clipIndex.clear();
+    m_folderIndex.clear();
     delete m_itemView;
     m_itemView = nullptr;
     delete m_jobManager;
@@ -776,14 +778,14 @@ void Bin::abortAudioThumbs()
         return;
     }
     if (!m_processingAudioThumb.isEmpty()) {
-        ProjectClip *clip = m_rootFolder->clip(m_processingAudioThumb);
+        ProjectClip *clip = findClip(m_processingAudioThumb);
         if (clip) {
             clip->abortAudioThumbs();
         }
     }
     m_audioThumbMutex.lock();
     foreach (const QString &id, m_audioThumbsList) {
-        ProjectClip *clip = m_rootFolder->clip(id);
+        ProjectClip *clip = findClip(id);
         if (clip) {
             clip->setJobStatus(AbstractClipJob::THUMBJOB, JobDone, 0);
         }
@@ -804,7 +806,7 @@ void Bin::slotCreateAudioThumbs()
         m_processingAudioThumb = m_audioThumbsList.takeFirst();
         count++;
         m_audioThumbMutex.unlock();
-        ProjectClip *clip = m_rootFolder->clip(m_processingAudioThumb);
+        ProjectClip *clip = findClip(m_processingAudioThumb);
         if (clip) {
             clip->slotCreateAudioThumbs();
             m_processedAudio += clip->duration().ms();
@@ -970,7 +972,7 @@ void Bin::deleteClip(const QString &id)
     if (m_monitor->activeClipId() == id) {
         emit openClip(nullptr);
     }
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         qCWarning(KDENLIVE_LOG) << "Cannot bin find clip to delete: " << id;
         return;
@@ -1255,6 +1257,8 @@ void Bin::setDocument(KdenliveDoc *project)
         }
     }
     delete m_rootFolder;
+    m_clipIndex.clear();
+    m_folderIndex.clear();
     delete m_itemView;
     m_itemView = nullptr;
     delete m_jobManager;
@@ -1314,7 +1318,7 @@ void Bin::createClip(const QDomElement &xml)
     QString groupId = ProjectClip::getXmlProperty(xml, QStringLiteral("kdenlive:folderid"));
     ProjectFolder *parentFolder = m_rootFolder;
     if (!groupId.isEmpty()) {
-        parentFolder = m_rootFolder->folder(groupId);
+        parentFolder = findFolder(groupId);
         if (!parentFolder) {
             // parent folder does not exist, put in root folder
             parentFolder = m_rootFolder;
@@ -1432,7 +1436,7 @@ void Bin::selectClipById(const QString &clipId, int frame, const QPoint &zone)
 
 void Bin::doAddFolder(const QString &id, const QString &name, const QString &parentId)
 {
-    ProjectFolder *parentFolder = m_rootFolder->folder(parentId);
+    ProjectFolder *parentFolder = findFolder(parentId);
     if (!parentFolder) {
         qCDebug(KDENLIVE_LOG) << "  / / ERROR IN PARENT FOLDER";
         return;
@@ -1444,7 +1448,7 @@ void Bin::doAddFolder(const QString &id, const QString &name, const QString &par
 
 void Bin::renameFolder(const QString &id, const QString &name)
 {
-    ProjectFolder *folder = m_rootFolder->folder(id);
+    ProjectFolder *folder = findFolder(id);
     if (!folder || !folder->parent()) {
         qCDebug(KDENLIVE_LOG) << "  / / ERROR IN PARENT FOLDER";
         return;
@@ -1468,7 +1472,7 @@ void Bin::slotLoadFolders(const QMap<QString, QString> &foldersData)
             parentFolder = m_rootFolder;
         } else {
             // This is a sub-folder
-            parentFolder = m_rootFolder->folder(parentId);
+            parentFolder = findFolder(parentId);
             if (parentFolder == m_rootFolder) {
                 // parent folder not yet created, create unnamed placeholder
                 parentFolder = new ProjectFolder(parentId, QString(), parentFolder);
@@ -1507,7 +1511,7 @@ void Bin::slotLoadFolders(const QMap<QString, QString> &foldersData)
 void Bin::removeFolder(const QString &id, QUndoCommand *deleteCommand)
 {
     // Check parent item
-    ProjectFolder *folder = m_rootFolder->folder(id);
+    ProjectFolder *folder = findFolder(id);
     AbstractProjectItem *parent = folder->parent();
     if (!folder->isEmpty()) {
         // Folder has clips inside, warn user
@@ -1547,7 +1551,7 @@ void Bin::removeSubClip(const QString &id, QUndoCommand *deleteCommand)
 
 void Bin::doRemoveFolder(const QString &id)
 {
-    ProjectFolder *folder = m_rootFolder->folder(id);
+    ProjectFolder *folder = findFolder(id);
     if (!folder) {
         qCDebug(KDENLIVE_LOG) << "  / / FOLDER not found";
         return;
@@ -1604,6 +1608,62 @@ void Bin::emitItemRemoved(AbstractProjectItem *item)
     m_itemModel->onItemRemoved(item);
 }
 
+void Bin::registerItem(AbstractProjectItem *item)
+{
+    switch (item->itemType()) {
+    case AbstractProjectItem::ClipItem:
+        m_clipIndex.insert(item->clipId(), static_cast<ProjectClip *>(item));
+        break;
+    case AbstractProjectItem::FolderItem:
+        // A folder moved to another parent brings its children along
+        m_folderIndex.insert(item->clipId(), static_cast<ProjectFolder *>(item));
+        for (int i = 0; i < item->count(); ++i) {
+            registerItem(item->at(i));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Bin::unregisterItem(AbstractProjectItem *item)
+{
+    switch (item->itemType()) {
+    case AbstractProjectItem::ClipItem:
+        if (m_clipIndex.value(item->clipId()) == item) {
+            m_clipIndex.remove(item->clipId());
+        }
+        break;
+    case AbstractProjectItem::FolderItem:
+        if (m_folderIndex.value(item->clipId()) == item) {
+            m_folderIndex.remove(item->clipId());
+        }
+        for (int i = 0; i < item->count(); ++i) {
+            unregisterItem(item->at(i));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+ProjectClip *Bin::findClip(const QString &id) const
+{
+    ProjectClip *clip = m_clipIndex.value(id);
+    Q_ASSERT_X(m_rootFolder == nullptr || clip == m_rootFolder->clip(id), "Bin::findClip", "clip index out of sync with the bin tree");
+    return clip;
+}
+
+ProjectFolder *Bin::findFolder(const QString &id) const
+{
+    if (m_rootFolder && id == m_rootFolder->clipId()) {
+        return m_rootFolder;
+    }
+    ProjectFolder *folder = m_folderIndex.value(id);
+    Q_ASSERT_X(m_rootFolder == nullptr || folder == m_rootFolder->folder(id), "Bin::findFolder", "folder index out of sync with the bin tree");
+    return folder;
+}
+
 void Bin::rowsInserted(const QModelIndex &parent, int start, int end)
 {
     Q_UNUSED(parent)
@@ -2086,7 +2146,7 @@ void Bin::slotEditClipCommand(const QString &id, const QMap<QString, QString> &o
 
 void Bin::reloadClip(const QString &id)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         return;
     }
@@ -2099,7 +2159,7 @@ void Bin::reloadClip(const QString &id)
 
 void Bin::slotThumbnailReady(const QString &id, const QImage &img, bool fromFile)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (clip) {
         clip->setThumbnail(img);
         // Save thumbnail for later reuse
@@ -2113,7 +2173,7 @@ void Bin::slotThumbnailReady(const QString &id, const QImage &img, bool fromFile
 QStringList Bin::getBinFolderClipIds(const QString &id) const
 {
     QStringList ids;
-    ProjectFolder *folder = m_rootFolder->folder(id);
+    ProjectFolder *folder = findFolder(id);
     if (folder) {
         for (int i = 0; i < folder->count(); i++) {
             AbstractProjectItem *child = folder->at(i);
@@ -2129,16 +2189,16 @@ ProjectClip *Bin::getBinClip(const QString &id)
 {
     ProjectClip *clip = nullptr;
     if (id.contains(QLatin1Char('_'))) {
-        clip = m_rootFolder->clip(id.section(QLatin1Char('_'), 0, 0));
+        clip = findClip(id.section(QLatin1Char('_'), 0, 0));
     } else if (!id.isEmpty()) {
-        clip = m_rootFolder->clip(id);
+        clip = findClip(id);
     }
     return clip;
 }
 
 void Bin::setWaitingStatus(const QString &id)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (clip) {
         clip->setClipStatus(AbstractProjectItem::StatusWaiting);
     }
@@ -2148,7 +2208,7 @@ void Bin::slotRemoveInvalidClip(const QString &id, bool replace, const QString &
 {
     Q_UNUSED(replace)
 
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         return;
     }
@@ -2157,7 +2217,7 @@ void Bin::slotRemoveInvalidClip(const QString &id, bool replace, const QString &
 
 void Bin::slotProducerReady(const requestClipInfo &info, ClipController *controller)
 {
-    ProjectClip *clip = m_rootFolder->clip(info.clipId);
+    ProjectClip *clip = findClip(info.clipId);
     if (clip) {
         if (clip->setProducer(controller, info.replaceProducer) && !clip->hasProxy()) {
             emit producerReady(info.clipId);
@@ -2208,7 +2268,7 @@ void Bin::slotProducerReady(const requestClipInfo &info, ClipController *control
         QString groupId = controller->property(QStringLiteral("kdenlive:folderid"));
         ProjectFolder *parentFolder;
         if (!groupId.isEmpty()) {
-            parentFolder = m_rootFolder->folder(groupId);
+            parentFolder = findFolder(groupId);
             if (!parentFolder) {
                 // parent folder does not exist, put in root folder
                 parentFolder = m_rootFolder;
@@ -2369,7 +2429,7 @@ const QSize Bin::getRenderSize()
 
 void Bin::slotUpdateJobStatus(const QString &id, int jobType, int status, const QString &label, const QString &actionName, const QString &details)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (clip) {
         clip->setJobStatus((AbstractClipJob::JOBTYPE) jobType, (ClipJobStatus) status);
     }
@@ -2455,7 +2515,7 @@ void Bin::slotShowJobLog()
 
 void Bin::gotProxy(const QString &id, const QString &path)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (clip) {
         QDomDocument doc;
         clip->setProducerProperty(QStringLiteral("kdenlive:proxy"), path);
@@ -2584,7 +2644,7 @@ void Bin::slotItemDropped(const QStringList &ids, const QModelIndex &parent)
             folderIds << id;
             continue;
         }
-        ProjectClip *currentItem = m_rootFolder->clip(id);
+        ProjectClip *currentItem = findClip(id);
         AbstractProjectItem *currentParent = currentItem->parent();
         if (currentParent != parentItem) {
             // Item was dropped on a different folder
@@ -2594,7 +2654,7 @@ void Bin::slotItemDropped(const QStringList &ids, const QModelIndex &parent)
     if (!folderIds.isEmpty()) {
         foreach (QString id, folderIds) {
             id.remove(0, 1);
-            ProjectFolder *currentItem = m_rootFolder->folder(id);
+            ProjectFolder *currentItem = findFolder(id);
             AbstractProjectItem *currentParent = currentItem->parent();
             if (currentParent != parentItem) {
                 // Item was dropped on a different folder
@@ -2680,7 +2740,7 @@ void Bin::slotMoveEffect(const QString &id, const QList<int> &currentPos, int ne
 
 void Bin::moveEffect(const QString &id, const QList<int> &oldPos, const QList<int> &newPos)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         return;
     }
@@ -2710,7 +2770,7 @@ void Bin::removeEffect(const QString &id, const QDomElement &effect)
         qCWarning(KDENLIVE_LOG) << " / /ERROR, trying to remove empty effect";
         return;
     }
-    ProjectClip *currentItem = m_rootFolder->clip(id);
+    ProjectClip *currentItem = findClip(id);
     if (!currentItem) {
         return;
     }
@@ -2720,7 +2780,7 @@ void Bin::removeEffect(const QString &id, const QDomElement &effect)
 
 void Bin::addEffect(const QString &id, QDomElement &effect)
 {
-    ProjectClip *currentItem = m_rootFolder->clip(id);
+    ProjectClip *currentItem = findClip(id);
     if (!currentItem) {
         return;
     }
@@ -2730,7 +2790,7 @@ void Bin::addEffect(const QString &id, QDomElement &effect)
 
 void Bin::updateEffect(const QString &id, QDomElement &effect, int ix, bool refreshStackWidget, bool updateClip)
 {
-    ProjectClip *currentItem = m_rootFolder->clip(id);
+    ProjectClip *currentItem = findClip(id);
     if (!currentItem) {
         return;
     }
@@ -2742,7 +2802,7 @@ void Bin::updateEffect(const QString &id, QDomElement &effect, int ix, bool refr
 
 void Bin::changeEffectState(const QString &id, const QList<int> &indexes, bool disable, bool refreshStack)
 {
-    ProjectClip *currentItem = m_rootFolder->clip(id);
+    ProjectClip *currentItem = findClip(id);
     if (!currentItem) {
         return;
     }
@@ -2782,12 +2842,12 @@ void Bin::slotGotFocus()
 
 void Bin::doMoveClip(const QString &id, const QString &newParentId)
 {
-    ProjectClip *currentItem = m_rootFolder->clip(id);
+    ProjectClip *currentItem = findClip(id);
     if (!currentItem) {
         return;
     }
     AbstractProjectItem *currentParent = currentItem->parent();
-    ProjectFolder *newParent = m_rootFolder->folder(newParentId);
+    ProjectFolder *newParent = findFolder(newParentId);
     currentParent->removeChild(currentItem);
     currentItem->setParent(newParent);
     currentItem->updateParentInfo(newParentId, newParent->name());
@@ -2795,9 +2855,9 @@ void Bin::doMoveClip(const QString &id, const QString &newParentId)
 
 void Bin::doMoveFolder(const QString &id, const QString &newParentId)
 {
-    ProjectFolder *currentItem = m_rootFolder->folder(id);
+    ProjectFolder *currentItem = findFolder(id);
     AbstractProjectItem *currentParent = currentItem->parent();
-    ProjectFolder *newParent = m_rootFolder->folder(newParentId);
+    ProjectFolder *newParent = findFolder(newParentId);
     currentParent->removeChild(currentItem);
     currentItem->setParent(newParent);
     emit storeFolder(id, newParent->clipId(), currentParent->clipId(), currentItem->name());
@@ -3018,7 +3078,7 @@ void Bin::renameSubClipCommand(const QString &id, const QString &newName, const
 
 void Bin::renameSubClip(const QString &id, const QString &newName, const QString &oldName, int in, int out)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         return;
     }
@@ -3244,7 +3304,7 @@ void Bin::slotGotFilterJobResults(const QString &id, int startPos, int track, co
         }
         if (startPos == -1) {
             // Processing bin clip
-            ProjectClip *currentItem = m_rootFolder->clip(id);
+            ProjectClip *currentItem = findClip(id);
             if (!currentItem) {
                 return;
             }
@@ -3281,8 +3341,19 @@ void Bin::slotGotFilterJobResults(const QString &id, int startPos, int track, co
     // Currently, only the first value of results is used
     ProjectClip *clip = getBinClip(id);
     if (!clip) {
+        m_streamedMarkers.remove(id);
         return;
     }
+    if (filterInfo.contains(QStringLiteral("streamed"))) {
+        // Remove the temporary markers shown while the job was running
+        QList<CommentedTime> oldMarkers = m_streamedMarkers.take(id);
+        if (!oldMarkers.isEmpty()) {
+            clip->addMarkers(oldMarkers);
+        }
+        if (filterInfo.contains(QStringLiteral("canceled"))) {
+            return;
+        }
+    }
     // Check for return value
     int markersType = -1;
     if (filterInfo.contains(QStringLiteral("addmarkers"))) {
@@ -3302,7 +3373,7 @@ void Bin::slotGotFilterJobResults(const QString &id, int startPos, int track, co
         QString mess = filterInfo.value(QStringLiteral("resultmessage"));
         mess.replace(QLatin1String("%count"), QString::number(value.count()));
         emit displayBinMessage(mess, KMessageWidget::Information);
-    } else {
+    } else if (!filterInfo.contains(QStringLiteral("partial"))) {
         emit displayBinMessage(i18n("Processing data analysis"), KMessageWidget::Information);
     }
     if (filterInfo.contains(QStringLiteral("cutscenes"))) {
@@ -3336,7 +3407,7 @@ void Bin::slotGotFilterJobResults(const QString &id, int startPos, int track, co
         QUndoCommand *command = new QUndoCommand();
         command->setText(i18n("Add Markers"));
         QList<CommentedTime> markersList;
-        int index = 1;
+        int index = filterInfo.value(QStringLiteral("markerindex"), QStringLiteral("1")).toInt();
         bool simpleList = false;
         double sourceFps = clip->getOriginalFps();
         if (sourceFps == 0) {
@@ -3366,7 +3437,21 @@ void Bin::slotGotFilterJobResults(const QString &id, int startPos, int track, co
             index++;
             cutPos = newPos;
         }
-        slotAddClipMarker(id, markersList);
+        if (filterInfo.contains(QStringLiteral("partial"))) {
+            // Show the scenes found so far, the job's final result adds them as a single undo step
+            QList<CommentedTime> &oldMarkers = m_streamedMarkers[id];
+            for (const CommentedTime &marker : markersList) {
+                CommentedTime oldMarker = clip->controller() ? clip->controller()->markerAt(marker.time()) : CommentedTime();
+                if (oldMarker == CommentedTime()) {
+                    oldMarker = marker;
+                    oldMarker.setMarkerType(-1);
+                }
+                oldMarkers << oldMarker;
+            }
+            clip->addMarkers(markersList);
+        } else {
+            slotAddClipMarker(id, markersList);
+        }
     }
     if (!dataProcessed || filterInfo.contains(QStringLiteral("storedata"))) {
         // Store returned data as clip extra data
@@ -3645,7 +3730,7 @@ void Bin::emitMessage(const QString &text, int progress, MessageType type)
 
 void Bin::slotCreateAudioThumb(const QString &id)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         return;
     }
@@ -3704,7 +3789,7 @@ void Bin::slotQueryRemoval(const QString &id, const QString &url, const QString
 
 void Bin::slotRefreshClipThumbnail(const QString &id)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         return;
     }
@@ -3713,7 +3798,7 @@ void Bin::slotRefreshClipThumbnail(const QString &id)
 
 void Bin::slotAddClipExtraData(const QString &id, const QString &key, const QString &data, QUndoCommand *groupCommand)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (!clip) {
         return;
     }
@@ -3730,7 +3815,7 @@ void Bin::slotAddClipExtraData(const QString &id, const QString &key, const QStr
 
 void Bin::slotUpdateClipProperties(const QString &id, const QMap<QString, QString> &properties, bool refreshPropertiesPanel)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (clip) {
         clip->setProperties(properties, refreshPropertiesPanel);
     }
@@ -3865,7 +3950,7 @@ QStringList Bin::getProxyHashList()
 
 void Bin::slotSendAudioThumb(const QString &id)
 {
-    ProjectClip *clip = m_rootFolder->clip(id);
+    ProjectClip *clip = findClip(id);
     if (clip && clip->audioThumbCreated()) {
         m_monitor->prepareAudioThumb(clip->audioChannels(), clip->audioFrameCache);
     } else {
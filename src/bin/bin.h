@@ -231,6 +231,10 @@ public:
     void emitItemAdded(AbstractProjectItem *item);
     void emitAboutToRemoveItem(AbstractProjectItem *item);
     void emitItemRemoved(AbstractProjectItem *item);
+    /** @brief Add an item and its children to the id index, called when an item is attached to a folder */
+    void registerItem(AbstractProjectItem *item);
+    /** @brief Remove an item and its children from the id index */
+    void unregisterItem(AbstractProjectItem *item);
     void setupMenu(QMenu *addMenu, QAction *defaultAction, const QHash<QString, QAction *> &actions);
 
     /** @brief The source file was modified, we will reload it soon, disable item in the meantime */
@@ -482,6 +486,12 @@ private:
     ProjectItemModel *m_itemModel;
     QAbstractItemView *m_itemView;
     ProjectFolder *m_rootFolder;
+    /** @brief Index of all clips in the bin, by id. Subclips share their master clip's id and are reached through it. */
+    QHash<QString, ProjectClip *> m_clipIndex;
+    /** @brief Index of all folders in the bin except the root folder, by id. */
+    QHash<QString, ProjectFolder *> m_folderIndex;
+    /** @brief Markers replaced by the temporary markers of a running scene detection, by clip id (type -1 where there was none). */
+    QHash<QString, QList<CommentedTime> > m_streamedMarkers;
     /** @brief An "Up" item that is inserted in bin when using icon view so that user can navigate up */
     ProjectFolderUp *m_folderUp;
     BinItemDelegate *m_binTreeViewDelegate;
@@ -548,6 +558,9 @@ private:
     QModelIndex getIndexForId(const QString &id, bool folderWanted) const;
     /** @brief Get a Clip item from its id. */
     AbstractProjectItem *getClipForId(const QString &id) const;
+    /** @brief Get a clip or folder from the id index. */
+    ProjectClip *findClip(const QString &id) const;
+    ProjectFolder *findFolder(const QString &id) const;
     ProjectClip *getFirstSelectedClip();
     void showTitleWidget(ProjectClip *clip);
     void showSlideshowWidget(ProjectClip *clip);
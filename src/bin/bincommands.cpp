@@ -134,6 +134,11 @@ void AddBinEffectCommand::redo()
 {
     m_bin->addEffect(m_clipId, m_effect);
 }
+// virtual
+qint64 AddBinEffectCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_effect);
+}
 
 RemoveBinEffectCommand::RemoveBinEffectCommand(Bin *bin, const QString &clipId, QDomElement &effect, QUndoCommand *parent) :
     QUndoCommand(parent),
@@ -153,6 +158,11 @@ void RemoveBinEffectCommand::redo()
 {
     m_bin->removeEffect(m_clipId, m_effect);
 }
+// virtual
+qint64 RemoveBinEffectCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_effect);
+}
 
 UpdateBinEffectCommand::UpdateBinEffectCommand(Bin *bin, const QString &clipId, QDomElement &oldEffect,  QDomElement &newEffect, int ix, bool refreshStack, bool updateClip, QUndoCommand *parent) :
     QUndoCommand(parent),
@@ -177,6 +187,11 @@ void UpdateBinEffectCommand::redo()
     m_bin->updateEffect(m_clipId, m_newEffect, m_ix, m_refreshStack, m_updateClip);
     m_refreshStack = true;
 }
+// virtual
+qint64 UpdateBinEffectCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_oldEffect) + UndoMemory::nodeSize(m_newEffect);
+}
 
 ChangeMasterEffectStateCommand::ChangeMasterEffectStateCommand(Bin *bin, const QString &clipId, const QList<int> &effectIndexes, bool disable, QUndoCommand *parent) :
     QUndoCommand(parent),
@@ -338,3 +353,8 @@ void AddClipCommand::redo()
         m_bin->deleteClip(m_id);
     }
 }
+// virtual
+qint64 AddClipCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_xml);
+}
@@ -24,6 +24,8 @@
 #include <QDomElement>
 #include <QMap>
 
+#include "doc/undomemory.h"
+
 class Bin;
 
 class AddBinFolderCommand : public QUndoCommand
@@ -79,36 +81,39 @@ private:
     QString m_newName;
 };
 
-class AddBinEffectCommand : public QUndoCommand
+class AddBinEffectCommand : public QUndoCommand, public UndoMemory
 {
 public:
     explicit AddBinEffectCommand(Bin *bin, const QString &clipId, QDomElement &effect, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     Bin *m_bin;
     QString m_clipId;
     QDomElement m_effect;
 };
 
-class RemoveBinEffectCommand : public QUndoCommand
+class RemoveBinEffectCommand : public QUndoCommand, public UndoMemory
 {
 public:
     explicit RemoveBinEffectCommand(Bin *bin, const QString &clipId, QDomElement &effect, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     Bin *m_bin;
     QString m_clipId;
     QDomElement m_effect;
 };
 
-class UpdateBinEffectCommand : public QUndoCommand
+class UpdateBinEffectCommand : public QUndoCommand, public UndoMemory
 {
 public:
     explicit UpdateBinEffectCommand(Bin *bin, const QString &clipId, QDomElement &oldEffect, QDomElement &newEffect, int ix, bool refreshStack, bool updateClip, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     Bin *m_bin;
     QString m_clipId;
@@ -194,12 +199,13 @@ private:
     bool m_firstExec;
 };
 
-class AddClipCommand : public QUndoCommand
+class AddClipCommand : public QUndoCommand, public UndoMemory
 {
 public:
     AddClipCommand(Bin *bin, const QDomElement &xml, const QString &id, bool doIt, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     Bin *m_bin;
     QDomElement m_xml;
@@ -361,6 +361,7 @@ bool ProjectClip::setProducer(ClipController *controller, bool replaceProducer)
         }
         m_date = m_controller->date;
         m_description = m_controller->description();
+        invalidateSearchKey();
         m_temporaryUrl.clear();
         if (m_type == Unknown) {
             m_type = m_controller->clipType();
@@ -626,6 +627,7 @@ void ProjectClip::setProperties(const QMap<QString, QString> &properties, bool r
     QStringList timelineProperties;
     if (properties.contains(QStringLiteral("templatetext"))) {
         m_description = properties.value(QStringLiteral("templatetext"));
+        invalidateSearchKey();
         bin()->emitItemUpdated(this);
         refreshPanel = true;
     }
@@ -684,6 +686,7 @@ void ProjectClip::setProperties(const QMap<QString, QString> &properties, bool r
 
     if (properties.contains(QStringLiteral("kdenlive:clipname"))) {
         m_name = properties.value(QStringLiteral("kdenlive:clipname"));
+        invalidateSearchKey();
         refreshPanel = true;
         bin()->emitItemUpdated(this);
     }
@@ -765,6 +768,7 @@ bool ProjectClip::rename(const QString &name, int column)
         oldProperites.insert(QStringLiteral("kdenlive:clipname"), m_name);
         newProperites.insert(QStringLiteral("kdenlive:clipname"), name);
         m_name = name;
+        invalidateSearchKey();
         edited = true;
         break;
     case 2:
@@ -780,6 +784,7 @@ bool ProjectClip::rename(const QString &name, int column)
             newProperites.insert(QStringLiteral("kdenlive:description"), name);
         }
         m_description = name;
+        invalidateSearchKey();
         edited = true;
         break;
     }
@@ -37,55 +37,32 @@ ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
 bool ProjectSortProxyModel::filterAcceptsRow(int sourceRow,
         const QModelIndex &sourceParent) const
 {
-    if (filterAcceptsRowItself(sourceRow, sourceParent)) {
+    if (m_searchString.isEmpty()) {
         return true;
     }
-    //accept if any of the children is accepted on it's own merits
-    if (hasAcceptedChildren(sourceRow, sourceParent)) {
-        return true;
-    }
-    return false;
-}
-
-bool ProjectSortProxyModel::filterAcceptsRowItself(int sourceRow,
-        const QModelIndex &sourceParent) const
-{
-    int cols = sourceModel()->columnCount();
-    for (int i = 0; i < cols; i++) {
-        QModelIndex index0 = sourceModel()->index(sourceRow, i, sourceParent);
-        if (!index0.isValid()) {
-            return false;
-        }
-        if (sourceModel()->data(index0).toString().contains(m_searchString, Qt::CaseInsensitive)) {
-            return true;
-        }
+    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (!index.isValid()) {
+        return false;
     }
-    return false;
+    return itemAccepted(static_cast<AbstractProjectItem *>(index.internalPointer()));
 }
 
-bool ProjectSortProxyModel::hasAcceptedChildren(int sourceRow, const QModelIndex &source_parent) const
+bool ProjectSortProxyModel::itemAccepted(const AbstractProjectItem *item) const
 {
-    QModelIndex item = sourceModel()->index(sourceRow, 0, source_parent);
-    if (!item.isValid()) {
-        return false;
-    }
-
-    //check if there are children
-    int childCount = item.model()->rowCount(item);
-    if (childCount == 0) {
-        return false;
+    QHash<const AbstractProjectItem *, bool>::const_iterator cached = m_accepted.constFind(item);
+    if (cached != m_accepted.constEnd()) {
+        return cached.value();
     }
-
-    for (int i = 0; i < childCount; ++i) {
-        if (filterAcceptsRowItself(i, item)) {
-            return true;
-        }
-        //recursive call -> NOTICE that this is depth-first searching, you're probably better off with breadth first search...
-        if (hasAcceptedChildren(i, item)) {
-            return true;
+    bool accepted = false;
+    if (!m_rejected.contains(item)) {
+        accepted = item->searchKey().contains(m_searchString);
+        //accept if any of the children is accepted on it's own merits
+        for (int i = 0; !accepted && i < item->count(); ++i) {
+            accepted = itemAccepted(item->at(i));
         }
     }
-    return false;
+    m_accepted.insert(item, accepted);
+    return accepted;
 }
 
 bool ProjectSortProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
@@ -121,9 +98,50 @@ QItemSelectionModel *ProjectSortProxyModel::selectionModel()
     return m_selection;
 }
 
+void ProjectSortProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    QAbstractItemModel *previous = this->sourceModel();
+    if (previous) {
+        disconnect(previous, &QAbstractItemModel::dataChanged, this, &ProjectSortProxyModel::slotClearFilterCache);
+        disconnect(previous, &QAbstractItemModel::rowsInserted, this, &ProjectSortProxyModel::slotClearFilterCache);
+        disconnect(previous, &QAbstractItemModel::rowsRemoved, this, &ProjectSortProxyModel::slotClearFilterCache);
+        disconnect(previous, &QAbstractItemModel::modelReset, this, &ProjectSortProxyModel::slotClearFilterCache);
+        disconnect(previous, &QAbstractItemModel::layoutChanged, this, &ProjectSortProxyModel::slotClearFilterCache);
+    }
+    // Connect before the base class so that the cache is cleared before rows are filtered again
+    if (sourceModel) {
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, &ProjectSortProxyModel::slotClearFilterCache);
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &ProjectSortProxyModel::slotClearFilterCache);
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &ProjectSortProxyModel::slotClearFilterCache);
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, &ProjectSortProxyModel::slotClearFilterCache);
+        connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &ProjectSortProxyModel::slotClearFilterCache);
+    }
+    slotClearFilterCache();
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
+void ProjectSortProxyModel::slotClearFilterCache()
+{
+    m_accepted.clear();
+    m_rejected.clear();
+}
+
 void ProjectSortProxyModel::slotSetSearchString(const QString &str)
 {
-    m_searchString = str;
+    const QString search = str.toLower();
+    if (!m_searchString.isEmpty() && search.contains(m_searchString)) {
+        // The search was narrowed, items that did not match before cannot match now
+        QHash<const AbstractProjectItem *, bool>::const_iterator i = m_accepted.constBegin();
+        for (; i != m_accepted.constEnd(); ++i) {
+            if (!i.value()) {
+                m_rejected.insert(i.key());
+            }
+        }
+    } else {
+        m_rejected.clear();
+    }
+    m_accepted.clear();
+    m_searchString = search;
     invalidateFilter();
 }
 
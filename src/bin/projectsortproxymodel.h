@@ -24,8 +24,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QSortFilterProxyModel>
 #include <QCollator>
+#include <QHash>
+#include <QSet>
 
 class QItemSelectionModel;
+class AbstractProjectItem;
 
 /**
  * @class ProjectSortProxyModel
@@ -39,6 +42,8 @@ class ProjectSortProxyModel : public QSortFilterProxyModel
 public:
     explicit ProjectSortProxyModel(QObject *parent = nullptr);
     QItemSelectionModel *selectionModel();
+    /** @brief Reimplemented to drop cached filter results when the source model changes */
+    void setSourceModel(QAbstractItemModel *sourceModel) Q_DECL_OVERRIDE;
 
 public slots:
     /** @brief Set search string that will filter the view */
@@ -49,6 +54,8 @@ public slots:
 private slots:
     /** @brief Called when a row change is detected by selection model */
     void onCurrentRowChanged(const QItemSelection &current, const QItemSelection &previous);
+    /** @brief Forget cached filter results, the source items changed */
+    void slotClearFilterCache();
 
 protected:
     /** @brief Decide which items should be displayed depending on the search string  */
@@ -56,13 +63,18 @@ protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const Q_DECL_OVERRIDE;
     /** @brief Reimplemented to show folders first  */
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const Q_DECL_OVERRIDE;
-    bool filterAcceptsRowItself(int source_row, const QModelIndex &source_parent) const;
-    bool hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const;
+    /** @brief Returns true if the item or one of its children matches the search string */
+    bool itemAccepted(const AbstractProjectItem *item) const;
 
 private:
     QItemSelectionModel *m_selection;
+    /** @brief Lower case search string */
     QString m_searchString;
     QCollator m_collator;
+    /** @brief Filter result of each item for the current search string */
+    mutable QHash<const AbstractProjectItem *, bool> m_accepted;
+    /** @brief Items rejected with all their children by a previous search string contained in the current one, they cannot match */
+    QSet<const AbstractProjectItem *> m_rejected;
 
 signals:
     /** @brief Emitted when the row changes, used to prepare action for selected item  */
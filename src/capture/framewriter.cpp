@@ -0,0 +1,152 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "framewriter.h"
+
+#include "kdenlive_debug.h"
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+FrameWriter::FrameWriter(int maxPending, QObject *parent) :
+    QObject(parent),
+    m_format(DefaultPng),
+    m_maxPending(qMax(1, maxPending)),
+    m_running(false)
+{
+    // A single writer keeps the frames on disk in capture order
+    m_pool.setMaxThreadCount(1);
+}
+
+FrameWriter::~FrameWriter()
+{
+    flush();
+}
+
+void FrameWriter::setFormat(FrameFormat format)
+{
+    QMutexLocker lock(&m_mutex);
+    m_format = format;
+}
+
+FrameWriter::FrameFormat FrameWriter::format() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_format;
+}
+
+QImage FrameWriter::acquireBuffer(const QSize &size)
+{
+    QMutexLocker lock(&m_mutex);
+    for (int i = 0; i < m_freeBuffers.count(); ++i) {
+        if (m_freeBuffers.at(i).size() == size) {
+            return m_freeBuffers.takeAt(i);
+        }
+    }
+    if (m_freeBuffers.count() >= m_maxPending) {
+        // Size changed, old buffers will not be reused
+        m_freeBuffers.clear();
+    }
+    return QImage(size, QImage::Format_RGB888);
+}
+
+void FrameWriter::enqueue(const QImage &image, const QString &path)
+{
+    int count;
+    bool saturated;
+    m_mutex.lock();
+    m_queue.enqueue(PendingFrame(image, path));
+    count = m_queue.count();
+    saturated = count >= m_maxPending;
+    if (!m_running) {
+        m_running = true;
+        QtConcurrent::run(&m_pool, this, &FrameWriter::processQueue);
+    }
+    m_mutex.unlock();
+    emit backlogChanged(count, saturated);
+}
+
+int FrameWriter::pending() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_queue.count();
+}
+
+bool FrameWriter::isSaturated() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_queue.count() >= m_maxPending;
+}
+
+void FrameWriter::flush()
+{
+    m_pool.waitForDone();
+}
+
+int FrameWriter::quality(FrameFormat format)
+{
+    // Qt maps the PNG quality to a zlib level of (100 - quality) * 9 / 91:
+    // 100 stores the data, 85 is level 1, the fastest deflate
+    switch (format) {
+    case UncompressedPng:
+        return 100;
+    case FastPng:
+        return 85;
+    default:
+        return -1;
+    }
+}
+
+void FrameWriter::processQueue()
+{
+    forever {
+        m_mutex.lock();
+        if (m_queue.isEmpty()) {
+            m_running = false;
+            m_mutex.unlock();
+            return;
+        }
+        // Keep the frame queued while writing so that pending() accounts for it
+        PendingFrame frame = m_queue.head();
+        const int writeQuality = quality(m_format);
+        m_mutex.unlock();
+
+        QSaveFile file(frame.second);
+        bool ok = file.open(QIODevice::WriteOnly);
+        if (ok) {
+            QImageWriter writer(&file, QByteArrayLiteral("png"));
+            writer.setQuality(writeQuality);
+            ok = writer.write(frame.first) && file.commit();
+            if (!ok) {
+                qCDebug(KDENLIVE_LOG) << "// Cannot write frame" << frame.second << writer.errorString();
+            }
+        }
+
+        int count;
+        bool saturated;
+        m_mutex.lock();
+        m_queue.dequeue();
+        count = m_queue.count();
+        saturated = count >= m_maxPending;
+        if (m_freeBuffers.count() < m_maxPending) {
+            m_freeBuffers.append(frame.first);
+        }
+        // Drop our reference so the recycled buffer is not shared anymore
+        frame.first = QImage();
+        m_mutex.unlock();
+
+        if (ok) {
+            emit frameSaved(frame.second);
+        } else {
+            emit writeFailed(frame.second);
+        }
+        emit backlogChanged(count, saturated);
+    }
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef FRAMEWRITER_H
+#define FRAMEWRITER_H
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QQueue>
+#include <QSize>
+#include <QThreadPool>
+
+/**
+  Writes captured frames to disk outside of the capture thread.
+
+  Frames are queued and encoded one at a time on a private single
+  thread pool, so the MLT consumer thread never waits on the encoder
+  or the disk. Images are taken from a small recycled pool: once a
+  frame is written its buffer goes back to the pool and the next
+  capture of the same size reuses it instead of allocating.
+
+  The queue is bounded. When more than maxPending frames are waiting,
+  isSaturated() returns true and backlogChanged() lets the UI hold
+  further captures until the disk catches up.
+ */
+class FrameWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** @brief Encoding used for the frame files, all of them are written as PNG. */
+    enum FrameFormat {
+        DefaultPng = 0,
+        FastPng = 1,
+        UncompressedPng = 2
+    };
+
+    explicit FrameWriter(int maxPending = 4, QObject *parent = nullptr);
+    /** @brief Waits until all queued frames are on disk. */
+    ~FrameWriter();
+
+    void setFormat(FrameFormat format);
+    FrameFormat format() const;
+
+    /** @brief Returns a detached RGB888 image of the requested size, recycled when possible. */
+    QImage acquireBuffer(const QSize &size);
+    /** @brief Queues an image obtained from acquireBuffer to be written at path.
+     *  The frame is never dropped, even when the queue is saturated. */
+    void enqueue(const QImage &image, const QString &path);
+
+    /** @brief Number of frames waiting to be written. */
+    int pending() const;
+    /** @brief True if the backlog reached maxPending frames. */
+    bool isSaturated() const;
+    /** @brief Blocks until the queue is empty. */
+    void flush();
+
+private:
+    typedef QPair<QImage, QString> PendingFrame;
+    mutable QMutex m_mutex;
+    QQueue<PendingFrame> m_queue;
+    QList<QImage> m_freeBuffers;
+    QThreadPool m_pool;
+    FrameFormat m_format;
+    int m_maxPending;
+    bool m_running;
+
+    /** @brief Drains the queue, runs on m_pool. */
+    void processQueue();
+    /** @brief Returns the QImageWriter quality matching a format, -1 for the default. */
+    static int quality(FrameFormat format);
+
+signals:
+    void frameSaved(const QString &path);
+    void writeFailed(const QString &path);
+    /** @brief Emitted whenever the number of pending frames changes. */
+    void backlogChanged(int pending, bool saturated);
+};
+
+#endif
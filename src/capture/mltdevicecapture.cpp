@@ -47,6 +47,7 @@ MltDeviceCapture::MltDeviceCapture(QString profile, /*VideoSurface *surface, */Q
     m_mltProfile(nullptr),
     m_showFrameEvent(nullptr),
     m_droppedFrames(0),
+    m_matrix(ColorConversion::Rec601),
     m_livePreview(KdenliveSettings::enable_recording_preview())
 {
     analyseAudio = KdenliveSettings::monitor_audio();
@@ -58,10 +59,14 @@ MltDeviceCapture::MltDeviceCapture(QString profile, /*VideoSurface *surface, */Q
     m_droppedFramesTimer.setSingleShot(false);
     m_droppedFramesTimer.setInterval(1000);
     connect(&m_droppedFramesTimer, &QTimer::timeout, this, &MltDeviceCapture::slotCheckDroppedFrames);
+    connect(&m_frameWriter, &FrameWriter::frameSaved, this, &MltDeviceCapture::frameSaved);
+    connect(&m_frameWriter, &FrameWriter::writeFailed, this, &MltDeviceCapture::frameWriteFailed);
+    connect(&m_frameWriter, &FrameWriter::backlogChanged, this, &MltDeviceCapture::writerBacklog);
 }
 
 MltDeviceCapture::~MltDeviceCapture()
 {
+    m_frameWriter.flush();
     delete m_mltConsumer;
     delete m_mltProducer;
     delete m_mltProfile;
@@ -80,6 +85,7 @@ bool MltDeviceCapture::buildConsumer(const QString &profileName)
     m_mltProfile = new Mlt::Profile(tmp);
     m_mltProfile->set_explicit(true);
     delete[] tmp;
+    m_matrix = ColorConversion::matrixForColorspace(m_mltProfile->colorspace());
 
     QString videoDriver = KdenliveSettings::videodrivername();
     if (!videoDriver.isEmpty()) {
@@ -94,7 +100,7 @@ bool MltDeviceCapture::buildConsumer(const QString &profileName)
     // OpenGL monitor
     m_mltConsumer = new Mlt::Consumer(*m_mltProfile, KdenliveSettings::audiobackend().toUtf8().constData());
     m_mltConsumer->set("preview_off", 1);
-    m_mltConsumer->set("preview_format", mlt_image_rgb24);
+    m_mltConsumer->set("preview_format", mlt_image_yuv422);
     m_showFrameEvent = m_mltConsumer->listen("consumer-frame-show", this, (mlt_listener) consumer_gl_frame_show);
     //m_mltConsumer->set("resize", 1);
     //m_mltConsumer->set("terminate_on_pause", 1);
@@ -218,16 +224,29 @@ void MltDeviceCapture::emitFrameUpdated(Mlt::Frame &frame)
 
 void MltDeviceCapture::showFrame(Mlt::Frame &frame)
 {
-    mlt_image_format format = mlt_image_rgb24;
+    // The consumer delivers yuv422 frames, converted here with the SIMD kernels
+    mlt_image_format format = mlt_image_yuv422;
     int width = 0;
     int height = 0;
     const uchar *image = frame.get_image(format, width, height);
-    QImage qimage(width, height, QImage::Format_RGB888);
-    memcpy(qimage.scanLine(0), image, static_cast<size_t>(width * height * 3));
-    emit showImageSignal(qimage);
+    // Reuse the previous preview buffer once the monitor has released it
+    if (m_previewImage.width() != width || m_previewImage.height() != height || !m_previewImage.isDetached()) {
+        m_previewImage = QImage(width, height, QImage::Format_RGB888);
+    }
+    ColorConversion::convertPacked(ColorConversion::Yuyv, image, width * 2, ColorConversion::Rgb24, m_previewImage.bits(), m_previewImage.bytesPerLine(), width, height, m_matrix);
+    emit showImageSignal(m_previewImage);
+
+    if (doCapture > 0 && --doCapture == 0) {
+        saveFrame(frame);
+    }
 
     if (sendFrameForAnalysis && frame.get_frame()->convert_image) {
-        emit frameUpdated(qimage.rgbSwapped());
+        // Scopes read pixels as QRgb, so write blue first instead of swapping a copy
+        if (m_analysisImage.width() != width || m_analysisImage.height() != height || !m_analysisImage.isDetached()) {
+            m_analysisImage = QImage(width, height, QImage::Format_RGB888);
+        }
+        ColorConversion::convertPacked(ColorConversion::Yuyv, image, width * 2, ColorConversion::Bgr24, m_analysisImage.bits(), m_analysisImage.bytesPerLine(), width, height, m_matrix);
+        emit frameUpdated(m_analysisImage);
     }
 }
 
@@ -236,22 +255,9 @@ void MltDeviceCapture::showAudio(Mlt::Frame &frame)
     if (!frame.is_valid() || frame.get_int("test_audio") != 0) {
         return;
     }
-    mlt_audio_format audio_format = mlt_audio_s16;
-    int freq = 0;
-    int num_channels = 0;
-    int samples = 0;
-    qint16 *data = (qint16 *)frame.get_audio(audio_format, freq, num_channels, samples);
-
-    if (!data) {
-        return;
-    }
-
-    // Data format: [ c00 c10 c01 c11 c02 c12 c03 c13 ... c0{samples-1} c1{samples-1} for 2 channels.
-    // So the vector is of size samples*channels.
-    audioShortVector sampleVector(samples * num_channels);
-    memcpy(sampleVector.data(), data, static_cast<size_t>(samples * num_channels * sizeof(qint16)));
-    if (samples > 0) {
-        emit audioSamplesSignal(sampleVector, freq, num_channels, samples);
+    AudioBlock block = AudioBlock::fromFrame(frame);
+    if (block.isValid()) {
+        emit audioSamplesSignal(block);
     }
 }
 
@@ -302,12 +308,12 @@ void MltDeviceCapture::slotCheckDroppedFrames()
 
 void MltDeviceCapture::saveFrame(Mlt::Frame &frame)
 {
-    mlt_image_format format = mlt_image_rgb24;
+    mlt_image_format format = mlt_image_yuv422;
     int width = 0;
     int height = 0;
     const uchar *image = frame.get_image(format, width, height);
-    QImage qimage(width, height, QImage::Format_RGB888);
-    memcpy(qimage.bits(), image, static_cast<size_t>(width * height * 3));
+    QImage qimage = m_frameWriter.acquireBuffer(QSize(width, height));
+    ColorConversion::convertPacked(ColorConversion::Yuyv, image, width * 2, ColorConversion::Rgb24, qimage.bits(), qimage.bytesPerLine(), width, height, m_matrix);
 
     // Re-enable overlay
     Mlt::Service service(m_mltProducer->parent().get_service());
@@ -315,8 +321,9 @@ void MltDeviceCapture::saveFrame(Mlt::Frame &frame)
     Mlt::Producer trackProducer(tractor.track(0));
     trackProducer.set("hide", 0);
 
-    qimage.save(m_capturePath);
-    emit frameSaved(m_capturePath);
+    // Encoding and disk access happen in the writer thread, frameSaved is emitted from there
+    m_frameWriter.setFormat((FrameWriter::FrameFormat) KdenliveSettings::sm_frameformat());
+    m_frameWriter.enqueue(qimage, m_capturePath);
     m_capturePath.clear();
 }
 
@@ -339,6 +346,11 @@ void MltDeviceCapture::captureFrame(const QString &path)
     doCapture = 5;
 }
 
+bool MltDeviceCapture::isWriterSaturated() const
+{
+    return m_frameWriter.isSaturated();
+}
+
 bool MltDeviceCapture::slotStartCapture(const QString &params, const QString &path, const QString &playlist, bool livePreview, bool xmlPlaylist)
 {
     stop();
@@ -349,6 +361,7 @@ bool MltDeviceCapture::slotStartCapture(const QString &params, const QString &pa
     char *tmp = qstrdup(m_activeProfile.toUtf8().constData());
     m_mltProfile = new Mlt::Profile(tmp);
     delete[] tmp;
+    m_matrix = ColorConversion::matrixForColorspace(m_mltProfile->colorspace());
 
     m_mltConsumer = new Mlt::Consumer(*m_mltProfile, "multi");
     if (m_mltConsumer == nullptr || !m_mltConsumer->is_valid()) {
@@ -398,7 +411,7 @@ bool MltDeviceCapture::slotStartCapture(const QString &params, const QString &pa
         // OpenGL monitor
         previewProps->set("mlt_service", KdenliveSettings::audiobackend().toUtf8().constData());
         previewProps->set("preview_off", 1);
-        previewProps->set("preview_format", mlt_image_rgb24);
+        previewProps->set("preview_format", mlt_image_yuv422);
         previewProps->set("terminate_on_pause", 0);
         m_showFrameEvent = m_mltConsumer->listen("consumer-frame-show", this, (mlt_listener) consumer_gl_frame_show);
         //m_mltConsumer->set("resize", 1);
@@ -600,78 +613,8 @@ void MltDeviceCapture::uyvy2rgb(unsigned char *yuv_buffer, int width, int height
 {
     processingImage = true;
     QImage image(width, height, QImage::Format_RGB888);
-    unsigned char *rgb_buffer = image.bits();
-
-    int rgb_ptr = 0, y_ptr = 0;
-    int len = width * height / 2;
-
-    for (int t = 0; t < len; ++t) {
-        int Y = yuv_buffer[y_ptr];
-        int U = yuv_buffer[y_ptr + 1];
-        int Y2 = yuv_buffer[y_ptr + 2];
-        int V = yuv_buffer[y_ptr + 3];
-        y_ptr += 4;
-
-        int r = ((298 * (Y - 16)               + 409 * (V - 128) + 128) >> 8);
-
-        int g = ((298 * (Y - 16) - 100 * (U - 128) - 208 * (V - 128) + 128) >> 8);
-
-        int b = ((298 * (Y - 16) + 516 * (U - 128)               + 128) >> 8);
-
-        if (r > 255) {
-            r = 255;
-        }
-        if (g > 255) {
-            g = 255;
-        }
-        if (b > 255) {
-            b = 255;
-        }
-
-        if (r < 0) {
-            r = 0;
-        }
-        if (g < 0) {
-            g = 0;
-        }
-        if (b < 0) {
-            b = 0;
-        }
-
-        rgb_buffer[rgb_ptr] = static_cast<uchar>(r);
-        rgb_buffer[rgb_ptr + 1] = static_cast<uchar>(g);
-        rgb_buffer[rgb_ptr + 2] = static_cast<uchar>(b);
-        rgb_ptr += 3;
-
-        r = ((298 * (Y2 - 16)               + 409 * (V - 128) + 128) >> 8);
-        g = ((298 * (Y2 - 16) - 100 * (U - 128) - 208 * (V - 128) + 128) >> 8);
-        b = ((298 * (Y2 - 16) + 516 * (U - 128)               + 128) >> 8);
-
-        if (r > 255) {
-            r = 255;
-        }
-        if (g > 255) {
-            g = 255;
-        }
-        if (b > 255) {
-            b = 255;
-        }
-
-        if (r < 0) {
-            r = 0;
-        }
-        if (g < 0) {
-            g = 0;
-        }
-        if (b < 0) {
-            b = 0;
-        }
-
-        rgb_buffer[rgb_ptr] = static_cast<uchar>(r);
-        rgb_buffer[rgb_ptr + 1] = static_cast<uchar>(g);
-        rgb_buffer[rgb_ptr + 2] = static_cast<uchar>(b);
-        rgb_ptr += 3;
-    }
+    // The buffer comes from mlt_image_yuv422, which is in YUYV order
+    ColorConversion::convertPacked(ColorConversion::Yuyv, yuv_buffer, width * 2, ColorConversion::Rgb24, image.bits(), image.bytesPerLine(), width, height, m_matrix);
     //emit imageReady(image);
     //m_captureDisplayWidget->setImage(image);
     emit unblockPreview();
@@ -29,6 +29,8 @@
 #include "gentime.h"
 #include "definitions.h"
 #include "monitor/abstractmonitor.h"
+#include "framewriter.h"
+#include "lib/video/colorConversion.h"
 
 #include <QTimer>
 #include <QMutex>
@@ -81,6 +83,8 @@ Q_OBJECT public:
     bool slotStartPreview(const QString &producer, bool xmlFormat = false);
     /** @brief Save current frame to file. */
     void captureFrame(const QString &path);
+    /** @brief True if too many captured frames are still waiting to be written. */
+    bool isWriterSaturated() const;
 
     /** @brief This will add the video clip from path and add it in the overlay track. */
     void setOverlay(const QString &path);
@@ -103,6 +107,8 @@ private:
     Mlt::Event *m_showFrameEvent;
     QString m_activeProfile;
     int m_droppedFrames;
+    /** @brief YUV matrix of the capture profile. */
+    ColorConversion::Matrix m_matrix;
     /** @brief When true, images will be displayed on monitor while capturing. */
     bool m_livePreview;
     /** @brief Count captured frames, used to display only one in ten images while capturing. */
@@ -112,6 +118,12 @@ private:
 
     QString m_capturePath;
 
+    /** @brief Writes captured frames in a background thread. */
+    FrameWriter m_frameWriter;
+    /** @brief Recycled images sent to the monitor and to the scopes. */
+    QImage m_previewImage;
+    QImage m_analysisImage;
+
     QTimer m_droppedFramesTimer;
 
     QMutex m_mutex;
@@ -134,6 +146,9 @@ signals:
     void showImageSignal(const QImage &);
 
     void frameSaved(const QString &);
+    void frameWriteFailed(const QString &);
+    /** @brief Number of captured frames waiting to be written, saturated if captures should be held. */
+    void writerBacklog(int pending, bool saturated);
 
     void droppedFrames(int);
 
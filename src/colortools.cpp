@@ -12,12 +12,144 @@
 
 #include <math.h>
 #include <QColor>
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtConcurrent>
 
 //#define DEBUG_CT
 #ifdef DEBUG_CT
 #include "kdenlive_debug.h"
 #endif
 
+namespace
+{
+// Planes with less pixels than this are computed in the calling thread
+const int ThreadingThreshold = 128 * 128;
+// Rows computed by one task
+const int RowsPerTask = 16;
+// Memory used by cached planes, in KB
+const int CacheSize = 16 * 1024;
+
+QCache<QString, QImage> planeCache(CacheSize);
+QMutex planeCacheMutex;
+
+bool findPlane(const QString &key, QImage &image)
+{
+    QMutexLocker lock(&planeCacheMutex);
+    QImage *cached = planeCache.object(key);
+    if (cached == nullptr) {
+        return false;
+    }
+    image = *cached;
+    return true;
+}
+
+void storePlane(const QString &key, const QImage &image)
+{
+    QMutexLocker lock(&planeCacheMutex);
+    planeCache.insert(key, new QImage(image), qMax(1, image.byteCount() / 1024));
+}
+
+/**
+  Calls rowFunction(y, line) for every row of the image, in parallel for big images.
+  line points to the pixels of row y. Rows must be independent.
+ */
+template <typename RowFunction>
+void processRows(QImage &image, RowFunction rowFunction)
+{
+    // Access the pixels once here, QImage::scanLine() may detach and is not safe in threads
+    uchar *bits = image.bits();
+    const int bytesPerLine = image.bytesPerLine();
+    const int height = image.height();
+    auto processBlock = [&](int first) {
+        const int last = qMin(height, first + RowsPerTask);
+        for (int y = first; y < last; ++y) {
+            rowFunction(y, reinterpret_cast<QRgb *>(bits + y * bytesPerLine));
+        }
+    };
+    if (image.width() * height < ThreadingThreshold) {
+        for (int y = 0; y < height; y += RowsPerTask) {
+            processBlock(y);
+        }
+        return;
+    }
+    QVector<int> blocks;
+    blocks.reserve(height / RowsPerTask + 1);
+    for (int y = 0; y < height; y += RowsPerTask) {
+        blocks << y;
+    }
+    QtConcurrent::blockingMap(blocks, processBlock);
+}
+
+inline int clampComponent(float value)
+{
+    // Not all possible (y,u,v) values have a correct RGB representation,
+    // clamp instead of overflowing (which would generate interesting patterns).
+    return value <= 0 ? 0 : (value >= 255 ? 255 : (int) value);
+}
+
+/** @brief Column coordinates mapped from {0,...,size-1} to [-scaling,scaling] (or [-scaling/2,scaling/2] for half) */
+QVector<float> axis(int size, float scaling, bool half)
+{
+    QVector<float> values(size);
+    const float last = qMax(1, size - 1);
+    for (int i = 0; i < size; ++i) {
+        values[i] = half ? scaling * (i / last - .5f) : scaling * (2 * i / last - 1);
+    }
+    return values;
+}
+
+/** @brief Normalized squared distance of each column to the center, for elliptic planes */
+QVector<float> ellipseTerm(int size)
+{
+    QVector<float> values(size);
+    const float center = (float) size / 2;
+    for (int i = 0; i < size; ++i) {
+        const float d = i - center;
+        values[i] = d * d / (center * center);
+    }
+    return values;
+}
+
+/** @brief Same conversion as QColor::setHsvF(), hue is -1 for achromatic colors */
+inline QRgb hsvToRgb(float hue, float sat, float val)
+{
+    if (hue < 0 || sat == 0) {
+        const int gray = qRound(val * 255);
+        return qRgb(gray, gray, gray);
+    }
+    const float h = hue >= 1 ? 0 : hue * 6;
+    const int i = (int) h;
+    const float f = h - i;
+    const float p = val * (1 - sat);
+    const float q = val * (1 - sat * f);
+    const float t = val * (1 - sat * (1 - f));
+    float r, g, b;
+    switch (i) {
+    case 0:
+        r = val; g = t; b = p;
+        break;
+    case 1:
+        r = q; g = val; b = p;
+        break;
+    case 2:
+        r = p; g = val; b = t;
+        break;
+    case 3:
+        r = p; g = q; b = val;
+        break;
+    case 4:
+        r = t; g = p; b = val;
+        break;
+    default:
+        r = val; g = p; b = q;
+        break;
+    }
+    return qRgb(qRound(r * 255), qRound(g * 255), qRound(b * 255));
+}
+}
+
 ColorTools::ColorTools(QObject *parent)
     : QObject(parent)
 {
@@ -30,86 +162,54 @@ QImage ColorTools::yuvColorWheel(const QSize &size, int Y, float scaling, bool m
         qCritical("ERROR: Size of the color wheel must not be 0!");
         return wheel;
     }
+    const QString key = QStringLiteral("yuv:%1x%2:%3:%4:%5:%6").arg(size.width()).arg(size.height()).arg(Y).arg(scaling).arg(modifiedVersion).arg(circleOnly);
+    if (findPlane(key, wheel)) {
+        emit signalYuvWheelCalculationFinished();
+        return wheel;
+    }
     if (circleOnly) {
         wheel.fill(qRgba(0, 0, 0, 0));
     }
 
-    double dr, dg, db, dv, dmax;
-    double ru, rv, rr;
     const int w = size.width();
     const int h = size.height();
-    const float w2 = (float)w / 2;
-    const float h2 = (float)h / 2;
-
-    for (int u = 0; u < w; ++u) {
-        // Transform u from {0,...,w} to [-1,1]
-        double du = (double) 2 * u / (w - 1) - 1;
-        du = scaling * du;
-
-        for (int v = 0; v < h; ++v) {
-            dv = (double) 2 * v / (h - 1) - 1;
-            dv = scaling * dv;
-
-            if (circleOnly) {
-                // Ellipsis equation: x²/a² + y²/b² = 1
-                // Here: x=ru, y=rv, a=w/2, b=h/2, 1=rr
-                // For rr > 1, the point lies outside. Don't draw it.
-                ru = u - w2;
-                rv = v - h2;
-                rr = ru * ru / (w2 * w2) + rv * rv / (h2 * h2);
-                if (rr > 1) {
-                    continue;
-                }
+    // Transform u from {0,...,w} to [-1,1]
+    const QVector<float> uAxis = axis(w, scaling, false);
+    const QVector<float> vAxis = axis(h, scaling, false);
+    // Ellipsis equation: x²/a² + y²/b² = 1
+    // Here: x=ru, y=rv, a=w/2, b=h/2, 1=rr
+    // For rr > 1, the point lies outside. Don't draw it.
+    const QVector<float> ru = ellipseTerm(w);
+    const QVector<float> rv = ellipseTerm(h);
+
+    processRows(wheel, [&](int line, QRgb *pixels) {
+        const int v = h - line - 1;
+        const float dv = vAxis.at(v);
+        const float rvv = rv.at(v);
+        // Calculate the RGB values from YUV
+        const float rBase = Y + 290.8f * dv;
+        const float gBase = Y - 148 * dv;
+        for (int u = 0; u < w; ++u) {
+            if (circleOnly && ru.at(u) + rvv > 1) {
+                continue;
             }
-
-            // Calculate the RGB values from YUV
-            dr = Y + 290.8 * dv;
-            dg = Y - 100.6 * du - 148 * dv;
-            db = Y + 517.2 * du;
-
+            const float du = uAxis.at(u);
+            float dr = rBase;
+            float dg = gBase - 100.6f * du;
+            float db = Y + 517.2f * du;
             if (modifiedVersion) {
                 // Scale the RGB values down, or up, to max 255
-                dmax = fabs(dr);
-                if (fabs(dg) > dmax) {
-                    dmax = fabs(dg);
-                }
-                if (fabs(db) > dmax) {
-                    dmax = fabs(db);
-                }
-                dmax = 255 / dmax;
-
-                dr *= dmax;
-                dg *= dmax;
-                db *= dmax;
-            }
-
-            // Avoid overflows (which would generate intersting patterns).
-            // Note that not all possible (y,u,v) values with u,v \in [-1,1]
-            // have a correct RGB representation, therefore some RGB values
-            // may exceed {0,...,255}.
-            if (dr < 0) {
-                dr = 0;
-            }
-            if (dg < 0) {
-                dg = 0;
-            }
-            if (db < 0) {
-                db = 0;
-            }
-            if (dr > 255) {
-                dr = 255;
-            }
-            if (dg > 255) {
-                dg = 255;
-            }
-            if (db > 255) {
-                db = 255;
+                const float dmax = qMax(fabsf(dr), qMax(fabsf(dg), fabsf(db)));
+                const float factor = dmax > 0 ? 255 / dmax : 0;
+                dr *= factor;
+                dg *= factor;
+                db *= factor;
             }
-
-            wheel.setPixel(u, (h - v - 1), qRgba(dr, dg, db, 255));
+            pixels[u] = qRgba(clampComponent(dr), clampComponent(dg), clampComponent(db), 255);
         }
-    }
+    });
 
+    storePlane(key, wheel);
     emit signalYuvWheelCalculationFinished();
     return wheel;
 }
@@ -121,50 +221,35 @@ QImage ColorTools::yuvVerticalPlane(const QSize &size, int angle, float scaling)
         qCritical("ERROR: Size of the color plane must not be 0!");
         return plane;
     }
+    const QString key = QStringLiteral("yuvv:%1x%2:%3:%4").arg(size.width()).arg(size.height()).arg(angle).arg(scaling);
+    if (findPlane(key, plane)) {
+        return plane;
+    }
 
-    double dr, dg, db, Y;
     const int w = size.width();
     const int h = size.height();
-    const double uscaling = scaling * cos(M_PI * angle / 180);
-    const double vscaling = scaling * sin(M_PI * angle / 180);
-
+    const float uscaling = scaling * cos(M_PI * angle / 180);
+    const float vscaling = scaling * sin(M_PI * angle / 180);
+    // See yuv2rgb, yuvColorWheel: the chroma part only depends on the column
+    QVector<float> rChroma(w), gChroma(w), bChroma(w);
     for (int uv = 0; uv < w; ++uv) {
-        double du = uscaling * ((double)2 * uv / w - 1); //(double)?
-        double dv = vscaling * ((double)2 * uv / w - 1);
-
-        for (int y = 0; y < h; ++y) {
-            Y = (double)255 * y / h;
-
-            // See yuv2rgb, yuvColorWheel
-            dr = Y + 290.8 * dv;
-            dg = Y - 100.6 * du - 148 * dv;
-            db = Y + 517.2 * du;
-            if (dr < 0) {
-                dr = 0;
-            }
-            if (dg < 0) {
-                dg = 0;
-            }
-            if (db < 0) {
-                db = 0;
-            }
-            if (dr > 255) {
-                dr = 255;
-            }
-            if (dg > 255) {
-                dg = 255;
-            }
-            if (db > 255) {
-                db = 255;
-            }
-
-            plane.setPixel(uv, (h - y - 1), qRgba(dr, dg, db, 255));
+        const float pos = 2.0f * uv / w - 1;
+        const float du = uscaling * pos;
+        const float dv = vscaling * pos;
+        rChroma[uv] = 290.8f * dv;
+        gChroma[uv] = -100.6f * du - 148 * dv;
+        bChroma[uv] = 517.2f * du;
+    }
 
+    processRows(plane, [&](int line, QRgb *pixels) {
+        const float Y = 255.0f * (h - line - 1) / h;
+        for (int uv = 0; uv < w; ++uv) {
+            pixels[uv] = qRgba(clampComponent(Y + rChroma.at(uv)), clampComponent(Y + gChroma.at(uv)), clampComponent(Y + bChroma.at(uv)), 255);
         }
-    }
+    });
 
+    storePlane(key, plane);
     return plane;
-
 }
 
 QImage ColorTools::rgbCurvePlane(const QSize &size, const ColorTools::ColorsRGB &color, float scaling, const QRgb &background)
@@ -176,40 +261,48 @@ QImage ColorTools::rgbCurvePlane(const QSize &size, const ColorTools::ColorsRGB
         qCritical("ERROR: Size of the color plane must not be 0!");
         return plane;
     }
+    const QString key = QStringLiteral("rgbplane:%1x%2:%3:%4:%5").arg(size.width()).arg(size.height()).arg((int) color).arg(scaling).arg(background);
+    if (findPlane(key, plane)) {
+        return plane;
+    }
 
     const int w = size.width();
     const int h = size.height();
-
-    double dcol;
-    double dx, dy;
-
-    for (int x = 0; x < w; ++x) {
-        double dval = (double)255 * x / (w - 1);
-
-        for (int y = 0; y < h; ++y) {
-            dy = (double)y / (h - 1);
-            dx = (double)x / (w - 1);
-
+    const float wLast = qMax(1, w - 1);
+    const float hLast = qMax(1, h - 1);
+
+    processRows(plane, [&](int line, QRgb *pixels) {
+        const float dy = (h - line - 1) / hLast;
+        for (int x = 0; x < w; ++x) {
+            const float dx = x / wLast;
+            const int dval = (int)(255 * dx);
+            int dcol;
             if (1 - scaling < 0.0001) {
-                dcol = (double)255 * dy;
+                dcol = (int)(255 * dy);
             } else {
-                dcol = (double)255 * (dy - (dy - dx) * (1 - scaling));
+                dcol = (int)(255 * (dy - (dy - dx) * (1 - scaling)));
             }
-
-            if (color == ColorTools::ColorsRGB::R) {
-                plane.setPixel(x, (h - y - 1), qRgb(dcol, dval, dval));
-            } else if (color == ColorTools::ColorsRGB::G) {
-                plane.setPixel(x, (h - y - 1), qRgb(dval, dcol, dval));
-            } else if (color == ColorTools::ColorsRGB::B) {
-                plane.setPixel(x, (h - y - 1), qRgb(dval, dval, dcol));
-            } else if (color == ColorTools::ColorsRGB::A) {
-                plane.setPixel(x, (h - y - 1), qRgb(dcol / 255. * qRed(background), dcol / 255. * qGreen(background), dcol / 255. * qBlue(background)));
-            } else {
-                plane.setPixel(x, (h - y - 1), qRgb(dcol, dcol, dcol));
+            switch (color) {
+            case ColorTools::ColorsRGB::R:
+                pixels[x] = qRgb(dcol, dval, dval);
+                break;
+            case ColorTools::ColorsRGB::G:
+                pixels[x] = qRgb(dval, dcol, dval);
+                break;
+            case ColorTools::ColorsRGB::B:
+                pixels[x] = qRgb(dval, dval, dcol);
+                break;
+            case ColorTools::ColorsRGB::A:
+                pixels[x] = qRgb(dcol * qRed(background) / 255, dcol * qGreen(background) / 255, dcol * qBlue(background) / 255);
+                break;
+            default:
+                pixels[x] = qRgb(dcol, dcol, dcol);
+                break;
             }
-
         }
-    }
+    });
+
+    storePlane(key, plane);
     return plane;
 }
 
@@ -222,33 +315,32 @@ QImage ColorTools::rgbCurveLine(const QSize &size, const ColorTools::ColorsRGB &
         return plane;
     }
 
-    const int w = size.width();
     const int h = size.height();
-
-    double dcol;
-    double dy;
-
-    for (int x = 0; x < w; ++x) {
-
-        for (int y = 0; y < h; ++y) {
-            dy = (double)y / (h - 1);
-
-            dcol = (double)255 * dy;
-
-            if (color == ColorTools::ColorsRGB::R) {
-                plane.setPixel(x, (h - y - 1), qRgb(dcol, 0, 0));
-            } else if (color == ColorTools::ColorsRGB::G) {
-                plane.setPixel(x, (h - y - 1), qRgb(0, dcol, 0));
-            } else if (color == ColorTools::ColorsRGB::B) {
-                plane.setPixel(x, (h - y - 1), qRgb(0, 0, dcol));
-            } else if (color == ColorTools::ColorsRGB::A) {
-                plane.setPixel(x, (h - y - 1), qRgb(dcol / 255. * qRed(background), dcol / 255. * qGreen(background), dcol / 255. * qBlue(background)));
-            } else {
-                plane.setPixel(x, (h - y - 1), qRgb(dcol, dcol, dcol));
-            }
-
+    const float hLast = qMax(1, h - 1);
+
+    // Each row has a single color
+    processRows(plane, [&](int line, QRgb *pixels) {
+        const int dcol = (int)(255 * (h - line - 1) / hLast);
+        QRgb rgb;
+        switch (color) {
+        case ColorTools::ColorsRGB::R:
+            rgb = qRgb(dcol, 0, 0);
+            break;
+        case ColorTools::ColorsRGB::G:
+            rgb = qRgb(0, dcol, 0);
+            break;
+        case ColorTools::ColorsRGB::B:
+            rgb = qRgb(0, 0, dcol);
+            break;
+        case ColorTools::ColorsRGB::A:
+            rgb = qRgb(dcol * qRed(background) / 255, dcol * qGreen(background) / 255, dcol * qBlue(background) / 255);
+            break;
+        default:
+            rgb = qRgb(dcol, dcol, dcol);
+            break;
         }
-    }
+        std::fill(pixels, pixels + size.width(), rgb);
+    });
     return plane;
 }
 
@@ -260,68 +352,40 @@ QImage ColorTools::yPbPrColorWheel(const QSize &size, int Y, float scaling, bool
         qCritical("ERROR: Size of the color wheel must not be 0!");
         return wheel;
     }
+    const QString key = QStringLiteral("ypbpr:%1x%2:%3:%4:%5").arg(size.width()).arg(size.height()).arg(Y).arg(scaling).arg(circleOnly);
+    if (findPlane(key, wheel)) {
+        return wheel;
+    }
     if (circleOnly) {
         wheel.fill(qRgba(0, 0, 0, 0));
     }
 
-    double dr, dg, db, dpR;
-    double rB, rR, rr;
     const int w = size.width();
     const int h = size.height();
-    const float w2 = (float)w / 2;
-    const float h2 = (float)h / 2;
-
-    for (int b = 0; b < w; ++b) {
-        // Transform pB from {0,...,w} to [-0.5,0.5]
-        double dpB = (double) b / (w - 1) - .5;
-        dpB = scaling * dpB;
-
-        for (int r = 0; r < h; ++r) {
-            dpR = (double) r / (h - 1) - .5;
-            dpR = scaling * dpR;
-
-            if (circleOnly) {
-                // see yuvColorWheel
-                rB = b - w2;
-                rR = r - h2;
-                rr = rB * rB / (w2 * w2) + rR * rR / (h2 * h2);
-                if (rr > 1) {
-                    continue;
-                }
-            }
-
-            // Calculate the RGB values from YPbPr
-            dr = Y + 357.5 * dpR;
-            dg = Y - 87.75 * dpB - 182.1 * dpR;
-            db = Y + 451.86 * dpB;
-
-            // Avoid overflows (which would generate intersting patterns).
-            // Note that not all possible (y,u,v) values with u,v \in [-1,1]
-            // have a correct RGB representation, therefore some RGB values
-            // may exceed {0,...,255}.
-            if (dr < 0) {
-                dr = 0;
-            }
-            if (dg < 0) {
-                dg = 0;
-            }
-            if (db < 0) {
-                db = 0;
-            }
-            if (dr > 255) {
-                dr = 255;
-            }
-            if (dg > 255) {
-                dg = 255;
+    // Transform pB from {0,...,w} to [-0.5,0.5]
+    const QVector<float> bAxis = axis(w, scaling, true);
+    const QVector<float> rAxis = axis(h, scaling, true);
+    // see yuvColorWheel
+    const QVector<float> rB = ellipseTerm(w);
+    const QVector<float> rR = ellipseTerm(h);
+
+    processRows(wheel, [&](int line, QRgb *pixels) {
+        const int r = h - line - 1;
+        const float dpR = rAxis.at(r);
+        const float rrR = rR.at(r);
+        // Calculate the RGB values from YPbPr
+        const float dr = Y + 357.5f * dpR;
+        const float gBase = Y - 182.1f * dpR;
+        for (int b = 0; b < w; ++b) {
+            if (circleOnly && rB.at(b) + rrR > 1) {
+                continue;
             }
-            if (db > 255) {
-                db = 255;
-            }
-
-            wheel.setPixel(b, (h - r - 1), qRgba(dr, dg, db, 255));
+            const float dpB = bAxis.at(b);
+            pixels[b] = qRgba(clampComponent(dr), clampComponent(gBase - 87.75f * dpB), clampComponent(Y + 451.86f * dpB), 255);
         }
-    }
+    });
 
+    storePlane(key, wheel);
     return wheel;
 }
 
@@ -369,73 +433,67 @@ QImage ColorTools::hsvCurvePlane(const QSize &size, const QColor &baseColor,
     Q_ASSERT(size.width() > 0);
     Q_ASSERT(size.height() > 0);
 
-    /*int xMax, yMax;
-
-    switch(xVariant) {
-    case COM_H:
-        xMax = 360;
-        break;
-    case COM_S:
-    case COM_V:
-        xMax = 256;
-        break;
-    }
-
-    switch (yVariant) {
-    case COM_H:
-        yMax = 360;
-        break;
-    case COM_S:
-    case COM_V:
-        yMax = 256;
-        break;
-    }*/
-
     QImage plane(size, QImage::Format_ARGB32);
+    const QString key = QStringLiteral("hsvcurve:%1x%2:%3:%4:%5:%6:%7").arg(size.width()).arg(size.height()).arg(baseColor.rgba()).arg(xVariant).arg(yVariant).arg(shear).arg(offsetY);
+    if (findPlane(key, plane)) {
+        return plane;
+    }
 
-    QColor col(0, 0, 0);
-
-    float hue, sat, val;
-    hue = baseColor.hueF();
-    sat = baseColor.saturationF();
-    val = baseColor.valueF();
-
-    for (int x = 0; x < size.width(); ++x) {
-        switch (xVariant) {
-        case COM_H:
-            hue = x / (size.width() - 1.0);
-            break;
-        case COM_S:
-            sat = x / (size.width() - 1.0);
-            break;
-        case COM_V:
-            val = x / (size.width() - 1.0);
-            break;
-        }
-        for (int y = 0; y < size.height(); ++y) {
+    const int w = size.width();
+    const int h = size.height();
+    const float wLast = qMax(1, w - 1);
+    const float hLast = qMax(1, h - 1);
+    const float baseHue = baseColor.hueF();
+    const float baseSat = baseColor.saturationF();
+    const float baseVal = baseColor.valueF();
+    uchar *bits = plane.bits();
+    const int bytesPerLine = plane.bytesPerLine();
+
+    // Rows are computed for each y value; with shear, a value is written to another row
+    // depending on the column, but different y values never end up in the same pixel.
+    auto computeRow = [&](int y, QRgb *pixels) {
+        float hue = baseHue;
+        float sat = baseSat;
+        float val = baseVal;
+        const float yValue = 1.0f - y / hLast;
+        for (int x = 0; x < w; ++x) {
+            const float xValue = x / wLast;
+            switch (xVariant) {
+            case COM_H:
+                hue = xValue;
+                break;
+            case COM_S:
+                sat = xValue;
+                break;
+            case COM_V:
+                val = xValue;
+                break;
+            }
             switch (yVariant) {
             case COM_H:
-                hue = 1.0 - y / (size.height() - 1.0);
+                hue = yValue;
                 break;
             case COM_S:
-                sat = 1.0 - y / (size.height() - 1.0);
+                sat = yValue;
                 break;
             case COM_V:
-                val = 1.0 - y / (size.height() - 1.0);
+                val = yValue;
                 break;
             }
-
-            col.setHsvF(hue, sat, val);
-
+            const QRgb rgb = hsvToRgb(hue, sat, val);
             if (!shear) {
-                plane.setPixel(x, y, col.rgba());
+                pixels[x] = rgb;
             } else {
-                plane.setPixel(x, int(2 * size.height() + y - x * size.width() / size.height() - offsetY * size.height()) % size.height(), col.rgba());
+                const int line = int(2 * h + y - x * w / h - offsetY * h) % h;
+                if (line >= 0) {
+                    reinterpret_cast<QRgb *>(bits + line * bytesPerLine)[x] = rgb;
+                }
             }
         }
-    }
+    };
+    processRows(plane, computeRow);
 
+    storePlane(key, plane);
     return plane;
 
 }
-
@@ -10,6 +10,9 @@
 
 /**
   Color tools.
+  The planes are computed row by row, in parallel for big sizes, and the
+  last generated planes are cached so that repainting a scope or a curve
+  editor with the same parameters does not compute them again.
  */
 
 #ifndef COLORTOOLS_H
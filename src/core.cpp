@@ -19,6 +19,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include "mltcontroller/producerqueue.h"
 #include "bin/bin.h"
 #include "library/librarywidget.h"
+#include "lib/audio/audioBlock.h"
 #include "kdenlive_debug.h"
 
 #include <QCoreApplication>
@@ -62,7 +63,7 @@ void Core::build(const QString &MltPath, const QUrl &Url, const QString &clipsTo
     m_self = new Core();
     m_self->initLocale();
 
-    qRegisterMetaType<audioShortVector> ("audioShortVector");
+    qRegisterMetaType<AudioBlock> ("AudioBlock");
     qRegisterMetaType< QVector<double> > ("QVector<double>");
     qRegisterMetaType<MessageType> ("MessageType");
     qRegisterMetaType<stringMap> ("stringMap");
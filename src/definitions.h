@@ -224,7 +224,6 @@ struct requestClipInfo {
 
 typedef QMap<QString, QString> stringMap;
 typedef QMap<int, QMap<int, QByteArray> > audioByteArray;
-typedef QVector<qint16> audioShortVector;
 
 class ItemInfo
 {
@@ -33,6 +33,7 @@
 #include <KNotification>
 #include <KMimeTypeTrader>
 #include <KIO/DesktopExecParser>
+#include <KIO/Global>
 #include <knotifications_version.h>
 #include <kio_version.h>
 
@@ -51,6 +52,7 @@
 #include <QStandardPaths>
 #include <QMimeDatabase>
 #include <QDir>
+#include <QJsonArray>
 
 #include <locale>
 #ifdef Q_OS_MAC
@@ -78,6 +80,7 @@ const int ParametersRole = Qt::UserRole + 1;
 const int TimeRole = Qt::UserRole + 2;
 const int ProgressRole = Qt::UserRole + 3;
 const int ExtraInfoRole = Qt::UserRole + 5;
+const int StatsRole = Qt::UserRole + 6;
 
 const int DirectRenderType = QTreeWidgetItem::Type;
 const int ScriptRenderType = QTreeWidgetItem::UserType;
@@ -251,6 +254,7 @@ RenderWidget::RenderWidget(const QString &projectfolder, bool enableProxy, const
     m_view.delete_script->setEnabled(false);
 
     connect(m_view.export_audio, &QCheckBox::stateChanged, this, &RenderWidget::slotUpdateAudioLabel);
+    connect(m_view.stemAudioExport, &QCheckBox::toggled, m_view.stemFullMix, &QWidget::setEnabled);
     m_view.export_audio->setCheckState(Qt::PartiallyChecked);
     checkCodecs();
     parseProfiles();
@@ -1167,14 +1171,24 @@ void RenderWidget::slotExport(bool scriptExport, int zoneIn, int zoneOut,
                 zoneOut /= ratio;
             }
         }
+        int renderIn = zoneIn;
+        int renderOut = zoneOut;
         if (m_view.render_guide->isChecked()) {
             double fps = profile->fps();
             double guideStart = m_view.guide_start->itemData(m_view.guide_start->currentIndex()).toDouble();
             double guideEnd = m_view.guide_end->itemData(m_view.guide_end->currentIndex()).toDouble();
-            render_process_args << "in=" + QString::number((int) GenTime(guideStart).frames(fps)) << "out=" + QString::number((int) GenTime(guideEnd).frames(fps));
-        } else {
-            render_process_args << "in=" + QString::number(zoneIn) << "out=" + QString::number(zoneOut);
+            renderIn = (int) GenTime(guideStart).frames(fps);
+            renderOut = (int) GenTime(guideEnd).frames(fps);
+        }
+        if (m_view.segmented_render->isChecked() && m_view.segmented_render->isEnabled() && !(m_view.checkTwoPass->isChecked() && m_view.checkTwoPass->isEnabled()) && !imageSequences.contains(extension)) {
+            const QString segments = segmentList(renderIn, renderOut, profile->fps());
+            if (!segments.isEmpty()) {
+                render_process_args << QStringLiteral("-segments:") + segments;
+                render_process_args << QStringLiteral("-parallel:%1").arg(segmentProcesses());
+                render_process_args << QStringLiteral("-ffmpeg:") + KdenliveSettings::ffmpegpath();
+            }
         }
+        render_process_args << "in=" + QString::number(renderIn) << "out=" + QString::number(renderOut);
 
         if (!overlayargs.isEmpty()) {
             render_process_args << "preargs=" + overlayargs.join(QLatin1Char(' '));
@@ -1365,6 +1379,7 @@ void RenderWidget::slotExport(bool scriptExport, int zoneIn, int zoneOut,
         renderProps.insert(QStringLiteral("renderratio"), QString::number(m_view.rescale_keep->isChecked()));
         renderProps.insert(QStringLiteral("renderplay"), QString::number(m_view.play_after->isChecked()));
         renderProps.insert(QStringLiteral("rendertwopass"), QString::number(m_view.checkTwoPass->isChecked()));
+        renderProps.insert(QStringLiteral("rendersegmented"), QString::number(m_view.segmented_render->isChecked()));
         renderProps.insert(QStringLiteral("renderquality"), QString::number(m_view.video->value()));
         renderProps.insert(QStringLiteral("renderaudioquality"), QString::number(m_view.audio->value()));
         renderProps.insert(QStringLiteral("renderspeed"), QString::number(m_view.speed->value()));
@@ -1484,6 +1499,50 @@ void RenderWidget::startRendering(RenderJobItem *item)
     }
 }
 
+int RenderWidget::segmentProcesses() const
+{
+    // Each melt process already uses the configured encoding threads
+    return qBound(2, QThread::idealThreadCount() / qMax(1, KdenliveSettings::encodethreads()), 8);
+}
+
+QString RenderWidget::segmentList(int in, int out, double fps) const
+{
+    // Segments should not be too short, joining has a cost and encoders need some frames to be efficient
+    int minLength = (int)(fps * 10);
+    int total = out - in + 1;
+    if (total < 2 * minLength) {
+        return QString();
+    }
+    // Use guides as natural cut points
+    QList<int> cuts;
+    cuts << in;
+    for (int i = 0; i < m_view.guide_end->count() - 1; ++i) {
+        int frame = (int) GenTime(m_view.guide_end->itemData(i).toDouble()).frames(fps);
+        if (frame - cuts.last() >= minLength && out - frame >= minLength) {
+            cuts << frame;
+        }
+    }
+    cuts << out + 1;
+    // Split long zones so that all processes get some work, with a few extra segments for load balancing
+    int maxLength = qMax(minLength, total / (2 * segmentProcesses()));
+    QStringList segments;
+    for (int i = 0; i < cuts.count() - 1; ++i) {
+        int start = cuts.at(i);
+        int end = cuts.at(i + 1);
+        int count = qMax(1, (end - start) / maxLength);
+        int length = (end - start) / count;
+        for (int j = 0; j < count; ++j) {
+            int segmentEnd = j == count - 1 ? end : start + length;
+            segments << QStringLiteral("%1-%2").arg(start).arg(segmentEnd - 1);
+            start = segmentEnd;
+        }
+    }
+    if (segments.count() < 2) {
+        return QString();
+    }
+    return segments.join(QLatin1Char(','));
+}
+
 int RenderWidget::waitingJobsCount() const
 {
     int count = 0;
@@ -2171,6 +2230,16 @@ void RenderWidget::setRenderJob(const QString &dest, int progress)
         QDateTime startTime = item->data(1, TimeRole).toDateTime();
         qint64 elapsedTime = startTime.secsTo(QDateTime::currentDateTime());
         qint64 remaining = elapsedTime * (100 - progress) / progress;
+        const QVariantMap stats = item->data(1, StatsRole).toMap();
+        double fps = stats.value(QStringLiteral("fps")).toDouble();
+        if (fps > 0 && stats.contains(QStringLiteral("frames"))) {
+            // The renderer knows the real encoding speed, use it
+            remaining = (qint64)((stats.value(QStringLiteral("frames")).toInt() - stats.value(QStringLiteral("frame")).toInt()) / fps);
+            if (stats.value(QStringLiteral("pass")).toInt() == 1) {
+                remaining += (qint64)(stats.value(QStringLiteral("frames")).toInt() / fps);
+            }
+            remaining = qMax((qint64) 0, remaining);
+        }
         int days = static_cast<int>(remaining / 86400);
         int remainingSecs = static_cast<int>(remaining % 86400);
         QTime when = QTime ( 0, 0, 0, 0 ) ;
@@ -2178,10 +2247,42 @@ void RenderWidget::setRenderJob(const QString &dest, int progress)
         QString est = (days > 0) ? i18np("%1 day ", "%1 days ", days) : QString();
         est.append(when.toString(QStringLiteral("hh:mm:ss")));
         QString t = i18n("Remaining time %1", est);
+        if (fps > 0) {
+            t.append(i18n(" (%1 fps)", QString::number(fps, 'f', 1)));
+        }
+        if (stats.contains(QStringLiteral("segments"))) {
+            const QVariantList segments = stats.value(QStringLiteral("segments")).toList();
+            int done = 0;
+            for (const QVariant &segment : segments) {
+                if (segment.toInt() == 100) {
+                    done++;
+                }
+            }
+            t.append(i18n(", %1/%2 segments", done, segments.count()));
+        }
         item->setData(1, Qt::UserRole, t);
     }
 }
 
+void RenderWidget::setRenderStats(const QString &dest, const QJsonObject &stats)
+{
+    QList<QTreeWidgetItem *> existing = m_view.running_jobs->findItems(dest, Qt::MatchExactly, 1);
+    if (existing.isEmpty()) {
+        return;
+    }
+    RenderJobItem *item = static_cast<RenderJobItem *>(existing.at(0));
+    item->setData(1, StatsRole, stats.toVariantMap());
+    if (stats.contains(QStringLiteral("segments"))) {
+        // Segmented rendering, show the progress of each segment
+        const QJsonArray segments = stats.value(QStringLiteral("segments")).toArray();
+        QStringList segmentInfo;
+        for (int i = 0; i < segments.count(); ++i) {
+            segmentInfo << i18n("Segment %1: %2%", i + 1, segments.at(i).toInt());
+        }
+        item->setToolTip(1, segmentInfo.join(QLatin1Char('\n')));
+    }
+}
+
 void RenderWidget::setRenderStatus(const QString &dest, int status, const QString &error)
 {
     RenderJobItem *item;
@@ -2207,6 +2308,22 @@ void RenderWidget::setRenderStatus(const QString &dest, int status, const QStrin
         est.append(when.toString(QStringLiteral("hh:mm:ss")));
         QString t = i18n("Rendering finished in %1", est);
         item->setData(1, Qt::UserRole, t);
+        const QVariantMap stats = item->data(1, StatsRole).toMap();
+        if (stats.value(QStringLiteral("finished")).toBool()) {
+            // Performance summary sent by the renderer
+            const QVariantMap stages = stats.value(QStringLiteral("stages")).toMap();
+            QString summary = item->data(1, ExtraInfoRole).toString();
+            if (!summary.isEmpty()) {
+                summary.append(QStringLiteral(" - "));
+            }
+            summary.append(i18n("%1 frames at %2 fps, %3 (startup %4s, encoding %5s)",
+                                stats.value(QStringLiteral("frame")).toInt(),
+                                QString::number(stats.value(QStringLiteral("fps")).toDouble(), 'f', 1),
+                                KIO::convertSize((KIO::filesize_t) stats.value(QStringLiteral("bytes")).toDouble()),
+                                QString::number(stages.value(QStringLiteral("startup")).toDouble() / 1000, 'f', 1),
+                                QString::number(stages.value(QStringLiteral("encoding")).toDouble() / 1000, 'f', 1)));
+            item->setData(1, ExtraInfoRole, summary);
+        }
         QString notif = i18n("Rendering of %1 finished in %2", item->text(1), est);
         KNotification *notify = new KNotification(QStringLiteral("RenderFinished"));
         notify->setText(notif);
@@ -2475,6 +2592,9 @@ void RenderWidget::setRenderProfile(const QMap<QString, QString> &props)
     if (props.contains(QStringLiteral("rendertwopass"))) {
         m_view.checkTwoPass->setChecked(props.value(QStringLiteral("rendertwopass")).toInt());
     }
+    if (props.contains(QStringLiteral("rendersegmented"))) {
+        m_view.segmented_render->setChecked(props.value(QStringLiteral("rendersegmented")).toInt());
+    }
 
     if (props.value(QStringLiteral("renderzone")) == QLatin1String("1")) {
         m_view.render_zone->setChecked(true);
@@ -2695,6 +2815,11 @@ bool RenderWidget::isStemAudioExportEnabled() const
             && m_view.stemAudioExport->isVisible() && m_view.stemAudioExport->isEnabled());
 }
 
+bool RenderWidget::isStemFullMixEnabled() const
+{
+    return isStemAudioExportEnabled() && m_view.stemFullMix->isChecked();
+}
+
 void RenderWidget::setRescaleEnabled(bool enable)
 {
     for (int i = 0; i < m_view.rescale_box->layout()->count(); ++i) {
@@ -23,6 +23,7 @@
 #include <KMessageWidget>
 
 #include <QPushButton>
+#include <QJsonObject>
 #include <QPainter>
 #include <QStyledItemDelegate>
 
@@ -118,6 +119,8 @@ public:
     void setProfile(const QString &profile);
     void setRenderJob(const QString &dest, int progress = 0);
     void setRenderStatus(const QString &dest, int status, const QString &error);
+    /** @brief Update a job with the statistics (frame, fps, encoded bytes, stage timings) sent by the renderer. */
+    void setRenderStats(const QString &dest, const QJsonObject &stats);
     void setDocumentPath(const QString &path);
     void reloadProfiles();
     void setRenderProfile(const QMap<QString, QString> &props);
@@ -134,6 +137,8 @@ public:
     bool proxyRendering();
     /** @brief Returns true if the stem audio export checkbox is set. */
     bool isStemAudioExportEnabled() const;
+    /** @brief Returns true if a stem export should also render the mix of all tracks. */
+    bool isStemFullMixEnabled() const;
     enum RenderError {
         CompositeError = 0,
         ProfileError = 1,
@@ -218,6 +223,10 @@ private:
     /** @brief Check if a job needs to be started. */
     void checkRenderStatus();
     void startRendering(RenderJobItem *item);
+    /** @brief Number of render processes used for a segmented render. */
+    int segmentProcesses() const;
+    /** @brief Build the list of segments (in-out,in-out...) used to render a zone in parallel, empty if the zone is too short. */
+    QString segmentList(int in, int out, double fps) const;
     bool saveProfile(QDomElement newprofile);
     /** @brief Create a rendering profile from MLT preset. */
     QTreeWidgetItem *loadFromMltPreset(const QString &groupName, const QString &path, const QString &profileName);
@@ -0,0 +1,446 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "documentupgrader.h"
+#include "effectslist/effectslist.h"
+#include "kdenlive_debug.h"
+
+#include <mlt++/Mlt.h>
+#include <QLocale>
+#include <QSet>
+#include <cmath>
+
+DocumentUpgrader::DocumentUpgrader(const QDomDocument &doc, double version, Pass pass) :
+    m_doc(doc),
+    m_version(version),
+    m_pass(pass),
+    m_profileWidth(720),
+    m_profileHeight(576),
+    m_sumAudioMix(false),
+    m_blackFound(false)
+{
+    // These filters were "animated" by adding several instances of the filter, each one having a start and end tag
+    m_keyframeFilters.insert(QStringLiteral("volume"), QStringList() << QStringLiteral("gain") << QStringLiteral("end") << QStringLiteral("level"));
+    m_keyframeFilters.insert(QStringLiteral("brightness"), QStringList() << QStringLiteral("start") << QStringLiteral("end") << QStringLiteral("level"));
+}
+
+void DocumentUpgrader::setProfileSize(int width, int height)
+{
+    m_profileWidth = width;
+    m_profileHeight = height;
+}
+
+void DocumentUpgrader::setSumAudioMix(bool available)
+{
+    m_sumAudioMix = available;
+}
+
+const QVector<QDomElement> &DocumentUpgrader::producers() const
+{
+    return m_producers;
+}
+
+const QVector<QDomElement> &DocumentUpgrader::entries() const
+{
+    return m_entries;
+}
+
+void DocumentUpgrader::run()
+{
+    m_producers.clear();
+    m_entries.clear();
+    m_slowmoIds.clear();
+    m_blackFound = false;
+    QDomElement element = m_doc.documentElement();
+    while (!element.isNull()) {
+        const QString tag = element.tagName();
+        if (tag == QLatin1String("producer")) {
+            m_producers << element;
+            upgradeProducer(element);
+        } else if (tag == QLatin1String("entry")) {
+            m_entries << element;
+            upgradeEntry(element);
+        } else if (tag == QLatin1String("filter")) {
+            upgradeFilter(element);
+        } else if (tag == QLatin1String("transition")) {
+            upgradeTransition(element);
+        }
+        // Next element in document order, computed after the conversion since
+        // it can remove children. Properties only contain text.
+        QDomElement next;
+        if (tag != QLatin1String("property")) {
+            next = element.firstChildElement();
+        }
+        QDomNode node = element;
+        while (next.isNull() && !node.isNull()) {
+            next = node.nextSiblingElement();
+            node = node.parentNode();
+        }
+        element = next;
+    }
+    if (!m_slowmoIds.isEmpty()) {
+        // Entries can appear before the producers they use, rename them once all producers are known
+        for (QDomElement &entry : m_entries) {
+            const QString entryId = entry.attribute(QStringLiteral("producer"));
+            if (m_slowmoIds.contains(entryId)) {
+                entry.setAttribute(QStringLiteral("producer"), entryId + QStringLiteral(":1"));
+            }
+        }
+    }
+}
+
+void DocumentUpgrader::upgradeProducer(QDomElement &prod)
+{
+    if (m_pass == LegacyPass) {
+        if (m_version <= 0.86) {
+            // Make sure we don't have avformat-novalidate producers, since it caused crashes
+            if (EffectsList::property(prod, QStringLiteral("mlt_service")) == QLatin1String("avformat-novalidate")) {
+                EffectsList::setProperty(prod, QStringLiteral("mlt_service"), QStringLiteral("avformat"));
+            }
+        }
+        return;
+    }
+    if (m_version < 0.94) {
+        // convert slowmotion producers
+        const QString id = prod.attribute(QStringLiteral("id"));
+        if (id.startsWith(QLatin1String("slowmotion")) && EffectsList::property(prod, QStringLiteral("mlt_service")) == QLatin1String("framebuffer")) {
+            // convert to new timewarp producer
+            prod.setAttribute(QStringLiteral("id"), id + QStringLiteral(":1"));
+            m_slowmoIds << id;
+            EffectsList::setProperty(prod, QStringLiteral("mlt_service"), QStringLiteral("timewarp"));
+            QString resource = EffectsList::property(prod, QStringLiteral("resource"));
+            EffectsList::setProperty(prod, QStringLiteral("warp_resource"), resource.section(QLatin1Char('?'), 0, 0));
+            EffectsList::setProperty(prod, QStringLiteral("warp_speed"), resource.section(QLatin1Char('?'), 1).section(QLatin1Char(':'), 0, 0));
+            EffectsList::setProperty(prod, QStringLiteral("resource"), resource.section(QLatin1Char('?'), 1) + QLatin1Char(':') + resource.section(QLatin1Char('?'), 0, 0));
+            EffectsList::setProperty(prod, QStringLiteral("audio_index"), QStringLiteral("-1"));
+        }
+    }
+    if (m_version < 0.95 && !m_blackFound) {
+        // Only the first black producer is the black track
+        if (prod.attribute(QStringLiteral("id")).section(QLatin1Char('_'), 0, 0) == QLatin1String("black")) {
+            EffectsList::setProperty(prod, QStringLiteral("set.test_audio"), QStringLiteral("0"));
+            m_blackFound = true;
+        }
+    }
+    if (m_version < 0.96) {
+        // Check image sequences with buggy begin frame number
+        const QString service = EffectsList::property(prod, QStringLiteral("mlt_service"));
+        if (service == QLatin1String("pixbuf") || service == QLatin1String("qimage")) {
+            QString resource = EffectsList::property(prod, QStringLiteral("resource"));
+            if (resource.contains(QStringLiteral("?begin:"))) {
+                resource.replace(QStringLiteral("?begin:"), QStringLiteral("?begin="));
+                EffectsList::setProperty(prod, QStringLiteral("resource"), resource);
+            }
+        }
+    }
+}
+
+void DocumentUpgrader::upgradeEntry(QDomElement &entry)
+{
+    if (m_pass == LegacyPass || m_version >= 0.93) {
+        return;
+    }
+    // convert old keyframe filters to animated
+    // We convert by parsing the start and end tags vor values and adding all to the new animated parameter
+    QDomNodeList effects = entry.elementsByTagName(QStringLiteral("filter"));
+    QStringList parsedIds;
+    for (int j = 0; j < effects.count(); j++) {
+        QDomElement eff = effects.at(j).toElement();
+        QString id = EffectsList::property(eff, QStringLiteral("kdenlive_id"));
+        if (m_keyframeFilters.contains(id) && !parsedIds.contains(id)) {
+            parsedIds << id;
+            QMap<int, double> values;
+            QStringList conversionParams = m_keyframeFilters.value(id);
+            int offset = eff.attribute(QStringLiteral("in")).toInt();
+            int out = eff.attribute(QStringLiteral("out")).toInt();
+            convertKeyframeEffect(eff, conversionParams, values, offset);
+            EffectsList::removeProperty(eff, conversionParams.at(0));
+            EffectsList::removeProperty(eff, conversionParams.at(1));
+            for (int k = j + 1; k < effects.count(); k++) {
+                QDomElement subEffect = effects.at(k).toElement();
+                QString subId = EffectsList::property(subEffect, QStringLiteral("kdenlive_id"));
+                if (subId == id) {
+                    convertKeyframeEffect(subEffect, conversionParams, values, offset);
+                    out = subEffect.attribute(QStringLiteral("out")).toInt();
+                    entry.removeChild(subEffect);
+                    k--;
+                }
+            }
+            QStringList parsedValues;
+            QLocale locale;
+            QMapIterator<int, double> l(values);
+            if (id == QLatin1String("volume")) {
+                // convert old volume range (0-300) to new dB values (-60-60)
+                while (l.hasNext()) {
+                    l.next();
+                    double v = l.value();
+                    if (v <= 0) {
+                        v = -60;
+                    } else {
+                        v = log10(v) * 20;
+                    }
+                    parsedValues << QString::number(l.key()) + QLatin1Char('=') + locale.toString(v);
+                }
+            } else {
+                while (l.hasNext()) {
+                    l.next();
+                    parsedValues << QString::number(l.key()) + QLatin1Char('=') + locale.toString(l.value());
+                }
+            }
+            EffectsList::setProperty(eff, conversionParams.at(2), parsedValues.join(QLatin1Char(';')));
+            eff.setAttribute(QStringLiteral("out"), out);
+        }
+    }
+}
+
+void DocumentUpgrader::upgradeFilter(QDomElement &effect)
+{
+    if (m_pass != LegacyPass || m_version > 0.85) {
+        return;
+    }
+    // update the LADSPA effects to use the new ladspa.id format instead of external xml file
+    if (EffectsList::property(effect, QStringLiteral("mlt_service")) != QLatin1String("ladspa")) {
+        return;
+    }
+    QStringList info = getInfoFromEffectName(EffectsList::property(effect, QStringLiteral("kdenlive_id")));
+    if (info.isEmpty()) {
+        return;
+    }
+    // info contains the correct ladspa.id from kdenlive effect name, and a list of parameter's old and new names
+    EffectsList::setProperty(effect, QStringLiteral("kdenlive_id"), info.at(0));
+    EffectsList::setProperty(effect, QStringLiteral("tag"), info.at(0));
+    EffectsList::setProperty(effect, QStringLiteral("mlt_service"), info.at(0));
+    EffectsList::removeProperty(effect, QStringLiteral("src"));
+    for (int j = 1; j < info.size(); ++j) {
+        QString value = EffectsList::property(effect, info.at(j).section(QLatin1Char('='), 0, 0));
+        if (!value.isEmpty()) {
+            // update parameter name
+            EffectsList::renameProperty(effect, info.at(j).section(QLatin1Char('='), 0, 0), info.at(j).section(QLatin1Char('='), 1, 1));
+        }
+    }
+}
+
+void DocumentUpgrader::upgradeTransition(QDomElement &trans)
+{
+    if (m_pass == LegacyPass) {
+        if (m_version <= 0.86) {
+            // There was a mistake in Geometry transitions where the last keyframe was created one frame after the end of transition, so fix it and move last keyframe to real end of transition
+            int out = trans.attribute(QStringLiteral("out")).toInt() - trans.attribute(QStringLiteral("in")).toInt();
+            QString geom = EffectsList::property(trans, QStringLiteral("geometry"));
+            Mlt::Geometry *g = new Mlt::Geometry(geom.toUtf8().data(), out, m_profileWidth, m_profileHeight);
+            Mlt::GeometryItem item;
+            if (g->next_key(&item, out) == 0) {
+                // We have a keyframe just after last frame, try to move it to last frame
+                if (item.frame() == out + 1) {
+                    item.frame(out);
+                    g->insert(item);
+                    g->remove(out + 1);
+                    EffectsList::setProperty(trans, QStringLiteral("geometry"), QString::fromLatin1(g->serialise()));
+                }
+            }
+            delete g;
+        }
+        return;
+    }
+    if (m_version < 0.92) {
+        // Luma transition used for wipe is deprecated, we now use a composite, convert
+        if (EffectsList::property(trans, QStringLiteral("kdenlive_id")) == QLatin1String("luma")) {
+            EffectsList::setProperty(trans, QStringLiteral("kdenlive_id"), QStringLiteral("wipe"));
+            EffectsList::setProperty(trans, QStringLiteral("mlt_service"), QStringLiteral("composite"));
+            bool reverse = EffectsList::property(trans, QStringLiteral("reverse")).toInt();
+            EffectsList::setProperty(trans, QStringLiteral("luma_invert"), EffectsList::property(trans, QStringLiteral("invert")));
+            EffectsList::setProperty(trans, QStringLiteral("luma"), EffectsList::property(trans, QStringLiteral("resource")));
+            EffectsList::removeProperty(trans, QStringLiteral("invert"));
+            EffectsList::removeProperty(trans, QStringLiteral("reverse"));
+            EffectsList::removeProperty(trans, QStringLiteral("resource"));
+            if (reverse) {
+                EffectsList::setProperty(trans, QStringLiteral("geometry"), QStringLiteral("0%/0%:100%x100%:100;-1=0%/0%:100%x100%:0"));
+            } else {
+                EffectsList::setProperty(trans, QStringLiteral("geometry"), QStringLiteral("0%/0%:100%x100%:0;-1=0%/0%:100%x100%:100"));
+            }
+            EffectsList::setProperty(trans, QStringLiteral("aligned"), QStringLiteral("0"));
+            EffectsList::setProperty(trans, QStringLiteral("fill"), QStringLiteral("1"));
+        }
+    }
+    if (m_version < 0.96 && m_sumAudioMix) {
+        if (EffectsList::property(trans, QStringLiteral("mlt_service")) == QLatin1String("mix")) {
+            EffectsList::renameProperty(trans, QStringLiteral("combine"), QStringLiteral("sum"));
+        }
+    }
+}
+
+void DocumentUpgrader::convertKeyframeEffect(const QDomElement &effect, const QStringList &params, QMap<int, double> &values, int offset)
+{
+    QLocale locale;
+    int in = effect.attribute(QStringLiteral("in")).toInt() - offset;
+    values.insert(in, locale.toDouble(EffectsList::property(effect, params.at(0))));
+    QString endValue = EffectsList::property(effect, params.at(1));
+    if (!endValue.isEmpty()) {
+        int out = effect.attribute(QStringLiteral("out")).toInt() - offset;
+        values.insert(out, locale.toDouble(endValue));
+    }
+}
+
+QStringList DocumentUpgrader::getInfoFromEffectName(const QString &oldName)
+{
+    QStringList info;
+    // Returns a list to convert old Kdenlive ladspa effects
+    if (oldName == QLatin1String("pitch_shift")) {
+        info << QStringLiteral("ladspa.1433");
+        info << QStringLiteral("pitch=0");
+    } else if (oldName == QLatin1String("vinyl")) {
+        info << QStringLiteral("ladspa.1905");
+        info << QStringLiteral("year=0");
+        info << QStringLiteral("rpm=1");
+        info << QStringLiteral("warping=2");
+        info << QStringLiteral("crackle=3");
+        info << QStringLiteral("wear=4");
+    } else if (oldName == QLatin1String("room_reverb")) {
+        info << QStringLiteral("ladspa.1216");
+        info << QStringLiteral("room=0");
+        info << QStringLiteral("delay=1");
+        info << QStringLiteral("damp=2");
+    } else if (oldName == QLatin1String("reverb")) {
+        info << QStringLiteral("ladspa.1423");
+        info << QStringLiteral("room=0");
+        info << QStringLiteral("damp=1");
+    } else if (oldName == QLatin1String("rate_scale")) {
+        info << QStringLiteral("ladspa.1417");
+        info << QStringLiteral("rate=0");
+    } else if (oldName == QLatin1String("pitch_scale")) {
+        info << QStringLiteral("ladspa.1193");
+        info << QStringLiteral("coef=0");
+    } else if (oldName == QLatin1String("phaser")) {
+        info << QStringLiteral("ladspa.1217");
+        info << QStringLiteral("rate=0");
+        info << QStringLiteral("depth=1");
+        info << QStringLiteral("feedback=2");
+        info << QStringLiteral("spread=3");
+    } else if (oldName == QLatin1String("limiter")) {
+        info << QStringLiteral("ladspa.1913");
+        info << QStringLiteral("gain=0");
+        info << QStringLiteral("limit=1");
+        info << QStringLiteral("release=2");
+    } else if (oldName == QLatin1String("equalizer_15")) {
+        info << QStringLiteral("ladspa.1197");
+        info << QStringLiteral("1=0");
+        info << QStringLiteral("2=1");
+        info << QStringLiteral("3=2");
+        info << QStringLiteral("4=3");
+        info << QStringLiteral("5=4");
+        info << QStringLiteral("6=5");
+        info << QStringLiteral("7=6");
+        info << QStringLiteral("8=7");
+        info << QStringLiteral("9=8");
+        info << QStringLiteral("10=9");
+        info << QStringLiteral("11=10");
+        info << QStringLiteral("12=11");
+        info << QStringLiteral("13=12");
+        info << QStringLiteral("14=13");
+        info << QStringLiteral("15=14");
+    } else if (oldName == QLatin1String("equalizer")) {
+        info << QStringLiteral("ladspa.1901");
+        info << QStringLiteral("logain=0");
+        info << QStringLiteral("midgain=1");
+        info << QStringLiteral("higain=2");
+    } else if (oldName == QLatin1String("declipper")) {
+        info << QStringLiteral("ladspa.1195");
+    }
+    return info;
+}
+
+// static
+bool DocumentUpgrader::checkOrphanedProducers(QDomDocument &doc, const QVector<QDomElement> &producers, const QVector<QDomElement> &entries)
+{
+    bool modified = false;
+    QDomElement mlt = doc.firstChildElement(QStringLiteral("mlt"));
+    QDomElement main = mlt.firstChildElement(QStringLiteral("playlist"));
+    QSet<QString> binProducers;
+    for (QDomElement mltprod = main.firstChildElement(QStringLiteral("entry")); !mltprod.isNull(); mltprod = mltprod.nextSiblingElement(QStringLiteral("entry"))) {
+        binProducers << mltprod.attribute(QStringLiteral("producer"));
+    }
+
+    QSet<QString> allProducers;
+    for (const QDomElement &prod : producers) {
+        allProducers << prod.attribute(QStringLiteral("id"));
+    }
+
+    QDomDocumentFragment frag = doc.createDocumentFragment();
+    QDomDocumentFragment trackProds = doc.createDocumentFragment();
+    for (QDomElement prod : producers) {
+        if (prod.parentNode().isDocumentFragment()) {
+            // Already replaced
+            continue;
+        }
+        QString id = prod.attribute(QStringLiteral("id")).section(QLatin1Char('_'), 0, 0);
+        if (id.startsWith(QLatin1String("slowmotion")) || id == QLatin1String("black")) {
+            continue;
+        }
+        if (!binProducers.contains(id)) {
+            QString binId = EffectsList::property(prod, QStringLiteral("kdenlive:binid"));
+            if (!binId.isEmpty() && binProducers.contains(binId)) {
+                continue;
+            }
+            qCWarning(KDENLIVE_LOG) << " ///////// WARNING, FOUND UNKNOWN PRODUDER: " << id << " ----------------";
+            // This producer is unknown to Bin
+            QString service = EffectsList::property(prod, QStringLiteral("mlt_service"));
+            QString distinctiveTag(QStringLiteral("resource"));
+            if (service == QLatin1String("kdenlivetitle")) {
+                distinctiveTag = QStringLiteral("xmldata");
+            }
+            QString orphanValue = EffectsList::property(prod, distinctiveTag);
+            for (const QDomElement &binProd : producers) {
+                // Search for a similar producer
+                if (binProd == prod || binProd.parentNode().isDocumentFragment()) {
+                    continue;
+                }
+                binId = binProd.attribute(QStringLiteral("id")).section(QLatin1Char('_'), 0, 0);
+                if (service != QLatin1String("timewarp") && (binId.startsWith(QLatin1String("slowmotion")) || !binProducers.contains(binId))) {
+                    continue;
+                }
+                QString binService = EffectsList::property(binProd, QStringLiteral("mlt_service"));
+                qCDebug(KDENLIVE_LOG) << " / /LKNG FOR: " << service << " / " << orphanValue << ", checking: " << binProd.attribute(QStringLiteral("id"));
+                if (service != binService) {
+                    continue;
+                }
+                QString binValue = EffectsList::property(binProd, distinctiveTag);
+                if (binValue == orphanValue) {
+                    // Found probable source producer, replace
+                    frag.appendChild(prod);
+                    for (QDomElement entry : entries) {
+                        if (entry.attribute(QStringLiteral("producer")) == id) {
+                            QString entryId = binId;
+                            if (service.contains(QStringLiteral("avformat")) || service == QLatin1String("xml") || service == QLatin1String("consumer")) {
+                                // We must use track producer, find track for this entry
+                                QString trackPlaylist = entry.parentNode().toElement().attribute(QStringLiteral("id"));
+                                entryId.append(QLatin1Char('_') + trackPlaylist);
+                            }
+                            if (!allProducers.contains(entryId)) {
+                                // The track producer does not exist, create a clone for it
+                                QDomElement cloned = binProd.cloneNode(true).toElement();
+                                cloned.setAttribute(QStringLiteral("id"), entryId);
+                                trackProds.appendChild(cloned);
+                                allProducers << entryId;
+                            }
+                            entry.setAttribute(QStringLiteral("producer"), entryId);
+                            modified = true;
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    if (!trackProds.isNull()) {
+        QDomNode firstProd = doc.firstChildElement(QStringLiteral("producer"));
+        mlt.insertBefore(trackProds, firstProd);
+    }
+    return modified;
+}
@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef DOCUMENTUPGRADER_H
+#define DOCUMENTUPGRADER_H
+
+#include <QDomDocument>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @class DocumentUpgrader
+ * @brief Converts the producers, entries, filters and transitions of an older project document.
+ *
+ * The document is walked once. Each element only goes through the conversions
+ * of its type that are needed for the version the document was saved with,
+ * instead of querying the whole document again for every version step.
+ * Producers and entries met during the walk are indexed, so that the checks
+ * done after upgrading do not have to walk the document again.
+ *
+ * Conversions that restructure the document (Kdenlive < 0.91) are done by
+ * DocumentValidator before running the upgrader. The conversions of documents
+ * older than 0.87 expect the document as it was before that restructuring, so
+ * they are done in a separate legacy pass, keeping the original version order.
+ */
+class DocumentUpgrader
+{
+public:
+    enum Pass {
+        /** @brief Conversions of documents older than 0.87, run before the document is restructured */
+        LegacyPass,
+        /** @brief All other conversions, run on the restructured document */
+        ElementPass
+    };
+    /** @param version the version of the document, conversions for later versions are skipped
+     *  @param pass the conversions to run */
+    DocumentUpgrader(const QDomDocument &doc, double version, Pass pass = ElementPass);
+    /** @brief Profile size, used to convert geometry transitions of documents older than 0.87 */
+    void setProfileSize(int width, int height);
+    /** @brief Set if the MLT mix transition supports summing audio (renames its combine parameter) */
+    void setSumAudioMix(bool available);
+    /** @brief Walk the document, converting its elements and indexing producers and entries */
+    void run();
+    /** @brief The producer elements, in document order */
+    const QVector<QDomElement> &producers() const;
+    /** @brief The entry elements, in document order */
+    const QVector<QDomElement> &entries() const;
+    /** @brief Point the entries using producers unknown to the Bin to a matching Bin producer
+     *  @param producers the producer elements, as indexed by run()
+     *  @param entries the entry elements, as indexed by run()
+     *  @return true if the document was modified */
+    static bool checkOrphanedProducers(QDomDocument &doc, const QVector<QDomElement> &producers, const QVector<QDomElement> &entries);
+
+private:
+    QDomDocument m_doc;
+    double m_version;
+    Pass m_pass;
+    int m_profileWidth;
+    int m_profileHeight;
+    bool m_sumAudioMix;
+    QVector<QDomElement> m_producers;
+    QVector<QDomElement> m_entries;
+    /** @brief Kdenlive ids of the filters that were animated with several instances -> start, end and animated parameter */
+    QMap<QString, QStringList> m_keyframeFilters;
+    /** @brief Set once the black track producer was found */
+    bool m_blackFound;
+    /** @brief Old slowmotion producers that were converted to timewarp */
+    QStringList m_slowmoIds;
+
+    void upgradeProducer(QDomElement &prod);
+    void upgradeEntry(QDomElement &entry);
+    void upgradeFilter(QDomElement &effect);
+    void upgradeTransition(QDomElement &trans);
+    void convertKeyframeEffect(const QDomElement &effect, const QStringList &params, QMap<int, double> &values, int offset);
+    static QStringList getInfoFromEffectName(const QString &oldName);
+};
+
+#endif
@@ -18,6 +18,7 @@
  ***************************************************************************/
 
 #include "documentvalidator.h"
+#include "documentupgrader.h"
 
 #include "definitions.h"
 #include "effectslist/initeffects.h"
@@ -344,6 +345,7 @@ bool DocumentValidator::upgrade(double version, const double currentVersion)
 
     // No conversion needed
     if (qAbs(version - currentVersion) < 0.001) {
+        upgradeElements(currentVersion, 0, 0);
         return true;
     }
 
@@ -371,6 +373,9 @@ bool DocumentValidator::upgrade(double version, const double currentVersion)
         infoXml.setAttribute(QStringLiteral("upgraded"), QStringLiteral("1"));
     }
     m_doc.documentElement().setAttribute(QStringLiteral("upgraded"), QStringLiteral("1"));
+    // Profile size, if none is found use PAL
+    int profileWidth = 720;
+    int profileHeight = 576;
 
     if (version <= 0.81) {
         // Add the tracks information
@@ -524,49 +529,8 @@ bool DocumentValidator::upgrade(double version, const double currentVersion)
             }
         }
     }
-    if (version <= 0.85) {
-        // update the LADSPA effects to use the new ladspa.id format instead of external xml file
-        QDomNodeList effectNodes = m_doc.elementsByTagName(QStringLiteral("filter"));
-        for (int i = 0; i < effectNodes.count(); ++i) {
-            QDomElement effect = effectNodes.at(i).toElement();
-            if (EffectsList::property(effect, QStringLiteral("mlt_service")) == QLatin1String("ladspa")) {
-                // Needs to be converted
-                QStringList info = getInfoFromEffectName(EffectsList::property(effect, QStringLiteral("kdenlive_id")));
-                if (info.isEmpty()) {
-                    continue;
-                }
-                // info contains the correct ladspa.id from kdenlive effect name, and a list of parameter's old and new names
-                EffectsList::setProperty(effect, QStringLiteral("kdenlive_id"), info.at(0));
-                EffectsList::setProperty(effect, QStringLiteral("tag"), info.at(0));
-                EffectsList::setProperty(effect, QStringLiteral("mlt_service"), info.at(0));
-                EffectsList::removeProperty(effect, QStringLiteral("src"));
-                for (int j = 1; j < info.size(); ++j) {
-                    QString value = EffectsList::property(effect, info.at(j).section(QLatin1Char('='), 0, 0));
-                    if (!value.isEmpty()) {
-                        // update parameter name
-                        EffectsList::renameProperty(effect, info.at(j).section(QLatin1Char('='), 0, 0), info.at(j).section(QLatin1Char('='), 1, 1));
-                    }
-                }
-            }
-        }
-    }
-
     if (version <= 0.86) {
-        // Make sure we don't have avformat-novalidate producers, since it caused crashes
-        QDomNodeList producers = m_doc.elementsByTagName(QStringLiteral("producer"));
-        int max = producers.count();
-        for (int i = 0; i < max; ++i) {
-            QDomElement prod = producers.at(i).toElement();
-            if (EffectsList::property(prod, QStringLiteral("mlt_service")) == QLatin1String("avformat-novalidate")) {
-                EffectsList::setProperty(prod, QStringLiteral("mlt_service"), QStringLiteral("avformat"));
-            }
-        }
-
-        // There was a mistake in Geometry transitions where the last keyframe was created one frame after the end of transition, so fix it and move last keyframe to real end of transition
-
-        // Get profile info (width / height)
-        int profileWidth;
-        int profileHeight;
+        // Get profile info (width / height), used to fix Geometry transitions
         QDomElement profile = m_doc.firstChildElement(QStringLiteral("profile"));
         if (profile.isNull()) {
             profile = infoXml.firstChildElement(QStringLiteral("profileinfo"));
@@ -579,33 +543,15 @@ bool DocumentValidator::upgrade(double version, const double currentVersion)
                 mlt.insertBefore(pr, firstProd);
             }
         }
-        if (profile.isNull()) {
-            // could not find profile info, set PAL
-            profileWidth = 720;
-            profileHeight = 576;
-        } else {
+        if (!profile.isNull()) {
             profileWidth = profile.attribute(QStringLiteral("width")).toInt();
             profileHeight = profile.attribute(QStringLiteral("height")).toInt();
         }
-        QDomNodeList transitions = m_doc.elementsByTagName(QStringLiteral("transition"));
-        max = transitions.count();
-        for (int i = 0; i < max; ++i) {
-            QDomElement trans = transitions.at(i).toElement();
-            int out = trans.attribute(QStringLiteral("out")).toInt() - trans.attribute(QStringLiteral("in")).toInt();
-            QString geom = EffectsList::property(trans, QStringLiteral("geometry"));
-            Mlt::Geometry *g = new Mlt::Geometry(geom.toUtf8().data(), out, profileWidth, profileHeight);
-            Mlt::GeometryItem item;
-            if (g->next_key(&item, out) == 0) {
-                // We have a keyframe just after last frame, try to move it to last frame
-                if (item.frame() == out + 1) {
-                    item.frame(out);
-                    g->insert(item);
-                    g->remove(out + 1);
-                    EffectsList::setProperty(trans, QStringLiteral("geometry"), QString::fromLatin1(g->serialise()));
-                }
-            }
-            delete g;
-        }
+        // LADSPA, avformat-novalidate and geometry conversions expect the document
+        // as it was before the 0.87 and 0.88 steps, so keep them in version order
+        DocumentUpgrader legacy(m_doc, version, DocumentUpgrader::LegacyPass);
+        legacy.setProfileSize(profileWidth, profileHeight);
+        legacy.run();
     }
 
     if (version <= 0.87) {
@@ -1019,193 +965,21 @@ bool DocumentValidator::upgrade(double version, const double currentVersion)
         }
     }
 
-    if (version < 0.92) {
-        // Luma transition used for wipe is deprecated, we now use a composite, convert
-        QDomNodeList transitionList = m_doc.elementsByTagName(QStringLiteral("transition"));
-        QDomElement trans;
-        for (int i = 0; i < transitionList.count(); i++) {
-            trans = transitionList.at(i).toElement();
-            QString id = EffectsList::property(trans, QStringLiteral("kdenlive_id"));
-            if (id == QLatin1String("luma")) {
-                EffectsList::setProperty(trans, QStringLiteral("kdenlive_id"), QStringLiteral("wipe"));
-                EffectsList::setProperty(trans, QStringLiteral("mlt_service"), QStringLiteral("composite"));
-                bool reverse = EffectsList::property(trans, QStringLiteral("reverse")).toInt();
-                EffectsList::setProperty(trans, QStringLiteral("luma_invert"), EffectsList::property(trans, QStringLiteral("invert")));
-                EffectsList::setProperty(trans, QStringLiteral("luma"), EffectsList::property(trans, QStringLiteral("resource")));
-                EffectsList::removeProperty(trans, QStringLiteral("invert"));
-                EffectsList::removeProperty(trans, QStringLiteral("reverse"));
-                EffectsList::removeProperty(trans, QStringLiteral("resource"));
-                if (reverse) {
-                    EffectsList::setProperty(trans, QStringLiteral("geometry"), QStringLiteral("0%/0%:100%x100%:100;-1=0%/0%:100%x100%:0"));
-                } else {
-                    EffectsList::setProperty(trans, QStringLiteral("geometry"), QStringLiteral("0%/0%:100%x100%:0;-1=0%/0%:100%x100%:100"));
-                }
-                EffectsList::setProperty(trans, QStringLiteral("aligned"), QStringLiteral("0"));
-                EffectsList::setProperty(trans, QStringLiteral("fill"), QStringLiteral("1"));
-            }
-        }
-    }
-
-    if (version < 0.93) {
-        // convert old keyframe filters to animated
-        // these filters were "animated" by adding several instance of the filter, each one having a start and end tag.
-        // We convert by parsing the start and end tags vor values and adding all to the new animated parameter
-        QMap<QString, QStringList> keyframeFilterToConvert;
-        keyframeFilterToConvert.insert(QStringLiteral("volume"), QStringList() << QStringLiteral("gain") << QStringLiteral("end") << QStringLiteral("level"));
-        keyframeFilterToConvert.insert(QStringLiteral("brightness"), QStringList() << QStringLiteral("start") << QStringLiteral("end") << QStringLiteral("level"));
-
-        QDomNodeList entries = m_doc.elementsByTagName(QStringLiteral("entry"));
-        for (int i = 0; i < entries.count(); i++) {
-            QDomNode entry = entries.at(i);
-            QDomNodeList effects = entry.toElement().elementsByTagName(QStringLiteral("filter"));
-            QStringList parsedIds;
-            for (int j = 0; j < effects.count(); j++) {
-                QDomElement eff = effects.at(j).toElement();
-                QString id = EffectsList::property(eff, QStringLiteral("kdenlive_id"));
-                if (keyframeFilterToConvert.contains(id) && !parsedIds.contains(id)) {
-                    parsedIds << id;
-                    QMap<int, double> values;
-                    QStringList conversionParams = keyframeFilterToConvert.value(id);
-                    int offset = eff.attribute(QStringLiteral("in")).toInt();
-                    int out = eff.attribute(QStringLiteral("out")).toInt();
-                    convertKeyframeEffect(eff, conversionParams, values, offset);
-                    EffectsList::removeProperty(eff, conversionParams.at(0));
-                    EffectsList::removeProperty(eff, conversionParams.at(1));
-                    for (int k = j + 1; k < effects.count(); k++) {
-                        QDomElement subEffect = effects.at(k).toElement();
-                        QString subId = EffectsList::property(subEffect, QStringLiteral("kdenlive_id"));
-                        if (subId == id) {
-                            convertKeyframeEffect(subEffect, conversionParams, values, offset);
-                            out = subEffect.attribute(QStringLiteral("out")).toInt();
-                            entry.removeChild(subEffect);
-                            k--;
-                        }
-                    }
-                    QStringList parsedValues;
-                    QLocale locale;
-                    QMapIterator<int, double> l(values);
-                    if (id == QLatin1String("volume")) {
-                        // convert old volume range (0-300) to new dB values (-60-60)
-                        while (l.hasNext()) {
-                            l.next();
-                            double v = l.value();
-                            if (v <= 0) {
-                                v = -60;
-                            } else {
-                                v = log10(v) * 20;
-                            }
-                            parsedValues << QString::number(l.key()) + QLatin1Char('=') + locale.toString(v);
-                        }
-                    } else {
-                        while (l.hasNext()) {
-                            l.next();
-                            parsedValues << QString::number(l.key()) + QLatin1Char('=') + locale.toString(l.value());
-                        }
-                    }
-                    EffectsList::setProperty(eff, conversionParams.at(2), parsedValues.join(QLatin1Char(';')));
-                    //EffectsList::setProperty(eff, QStringLiteral("kdenlive:sync_in_out"), QStringLiteral("1"));
-                    eff.setAttribute(QStringLiteral("out"), out);
-                }
-            }
-        }
-    }
-
-    if (version < 0.94) {
-        // convert slowmotion effects/producers
-        QDomNodeList producers = m_doc.elementsByTagName(QStringLiteral("producer"));
-        int max = producers.count();
-        QStringList slowmoIds;
-        for (int i = 0; i < max; ++i) {
-            QDomElement prod = producers.at(i).toElement();
-            QString id = prod.attribute(QStringLiteral("id"));
-            if (id.startsWith(QLatin1String("slowmotion"))) {
-                QString service = EffectsList::property(prod, QStringLiteral("mlt_service"));
-                if (service == QLatin1String("framebuffer")) {
-                    // convert to new timewarp producer
-                    prod.setAttribute(QStringLiteral("id"), id + QStringLiteral(":1"));
-                    slowmoIds << id;
-                    EffectsList::setProperty(prod, QStringLiteral("mlt_service"), QStringLiteral("timewarp"));
-                    QString resource = EffectsList::property(prod, QStringLiteral("resource"));
-                    EffectsList::setProperty(prod, QStringLiteral("warp_resource"), resource.section(QLatin1Char('?'), 0, 0));
-                    EffectsList::setProperty(prod, QStringLiteral("warp_speed"), resource.section(QLatin1Char('?'), 1).section(QLatin1Char(':'), 0, 0));
-                    EffectsList::setProperty(prod, QStringLiteral("resource"), resource.section(QLatin1Char('?'), 1) + QLatin1Char(':') + resource.section(QLatin1Char('?'), 0, 0));
-                    EffectsList::setProperty(prod, QStringLiteral("audio_index"), QStringLiteral("-1"));
-                }
-            }
-        }
-        if (!slowmoIds.isEmpty()) {
-            producers = m_doc.elementsByTagName(QStringLiteral("entry"));
-            max = producers.count();
-            for (int i = 0; i < max; ++i) {
-                QDomElement prod = producers.at(i).toElement();
-                QString entryId = prod.attribute(QStringLiteral("producer"));
-                if (slowmoIds.contains(entryId)) {
-                    prod.setAttribute(QStringLiteral("producer"), entryId + QStringLiteral(":1"));
-                }
-            }
-        }
-        //qCDebug(KDENLIVE_LOG)<<"------------------------\n"<<m_doc.toString();
-    }
-    if (version < 0.95) {
-        // convert slowmotion effects/producers
-        QDomNodeList producers = m_doc.elementsByTagName(QStringLiteral("producer"));
-        int max = producers.count();
-        for (int i = 0; i < max; ++i) {
-            QDomElement prod = producers.at(i).toElement();
-            if (prod.isNull()) {
-                continue;
-            }
-            QString id = prod.attribute(QStringLiteral("id")).section(QLatin1Char('_'), 0, 0);
-            if (id == QLatin1String("black")) {
-                EffectsList::setProperty(prod, QStringLiteral("set.test_audio"), QStringLiteral("0"));
-                break;
-            }
-        }
-    }
-    if (version < 0.96) {
-        // Check image sequences with buggy begin frame number
-        QDomNodeList producers = m_doc.elementsByTagName(QStringLiteral("producer"));
-        int max = producers.count();
-        for (int i = 0; i < max; ++i) {
-            QDomElement prod = producers.at(i).toElement();
-            if (prod.isNull()) continue;
-            const QString service = EffectsList::property(prod, QStringLiteral("mlt_service"));
-            if (service == QLatin1String("pixbuf") || service == QLatin1String("qimage")) {
-                QString resource = EffectsList::property(prod, QStringLiteral("resource"));
-                if (resource.contains(QStringLiteral("?begin:"))) {
-                    resource.replace(QStringLiteral("?begin:"), QStringLiteral("?begin="));
-                    EffectsList::setProperty(prod, QStringLiteral("resource"), resource);
-                }
-            }
-        }
-        if (TransitionHandler::sumAudioMixAvailable()) {
-            QDomNodeList transitions = m_doc.elementsByTagName(QStringLiteral("transition"));
-            max = transitions.count();
-            for (int i = 0; i < max; ++i) {
-                QDomElement trans = transitions.at(i).toElement();
-                if (trans.isNull()) continue;
-                const QString service = EffectsList::property(trans, QStringLiteral("mlt_service"));
-                if (service == QLatin1String("mix")) {
-                    EffectsList::renameProperty(trans, QStringLiteral("combine"), QStringLiteral("sum"));
-                }
-            }
-        }
-    }
+    // Conversions of single elements are done in one pass over the document
+    upgradeElements(version, profileWidth, profileHeight);
 
     m_modified = true;
     return true;
 }
 
-void DocumentValidator::convertKeyframeEffect(const QDomElement &effect, const QStringList &params, QMap<int, double> &values, int offset)
+void DocumentValidator::upgradeElements(double version, int profileWidth, int profileHeight)
 {
-    QLocale locale;
-    int in = effect.attribute(QStringLiteral("in")).toInt() - offset;
-    values.insert(in, locale.toDouble(EffectsList::property(effect, params.at(0))));
-    QString endValue = EffectsList::property(effect, params.at(1));
-    if (!endValue.isEmpty()) {
-        int out = effect.attribute(QStringLiteral("out")).toInt() - offset;
-        values.insert(out, locale.toDouble(endValue));
-    }
+    DocumentUpgrader upgrader(m_doc, version);
+    upgrader.setProfileSize(profileWidth, profileHeight);
+    upgrader.setSumAudioMix(version < 0.96 && TransitionHandler::sumAudioMixAvailable());
+    upgrader.run();
+    m_producers = upgrader.producers();
+    m_entries = upgrader.entries();
 }
 
 void DocumentValidator::updateProducerInfo(const QDomElement &prod, const QDomElement &source)
@@ -1244,74 +1018,6 @@ void DocumentValidator::updateProducerInfo(const QDomElement &prod, const QDomEl
     }
 }
 
-QStringList DocumentValidator::getInfoFromEffectName(const QString &oldName)
-{
-    QStringList info;
-    // Returns a list to convert old Kdenlive ladspa effects
-    if (oldName == QLatin1String("pitch_shift")) {
-        info << QStringLiteral("ladspa.1433");
-        info << QStringLiteral("pitch=0");
-    } else if (oldName == QLatin1String("vinyl")) {
-        info << QStringLiteral("ladspa.1905");
-        info << QStringLiteral("year=0");
-        info << QStringLiteral("rpm=1");
-        info << QStringLiteral("warping=2");
-        info << QStringLiteral("crackle=3");
-        info << QStringLiteral("wear=4");
-    } else if (oldName == QLatin1String("room_reverb")) {
-        info << QStringLiteral("ladspa.1216");
-        info << QStringLiteral("room=0");
-        info << QStringLiteral("delay=1");
-        info << QStringLiteral("damp=2");
-    } else if (oldName == QLatin1String("reverb")) {
-        info << QStringLiteral("ladspa.1423");
-        info << QStringLiteral("room=0");
-        info << QStringLiteral("damp=1");
-    } else if (oldName == QLatin1String("rate_scale")) {
-        info << QStringLiteral("ladspa.1417");
-        info << QStringLiteral("rate=0");
-    } else if (oldName == QLatin1String("pitch_scale")) {
-        info << QStringLiteral("ladspa.1193");
-        info << QStringLiteral("coef=0");
-    } else if (oldName == QLatin1String("phaser")) {
-        info << QStringLiteral("ladspa.1217");
-        info << QStringLiteral("rate=0");
-        info << QStringLiteral("depth=1");
-        info << QStringLiteral("feedback=2");
-        info << QStringLiteral("spread=3");
-    } else if (oldName == QLatin1String("limiter")) {
-        info << QStringLiteral("ladspa.1913");
-        info << QStringLiteral("gain=0");
-        info << QStringLiteral("limit=1");
-        info << QStringLiteral("release=2");
-    } else if (oldName == QLatin1String("equalizer_15")) {
-        info << QStringLiteral("ladspa.1197");
-        info << QStringLiteral("1=0");
-        info << QStringLiteral("2=1");
-        info << QStringLiteral("3=2");
-        info << QStringLiteral("4=3");
-        info << QStringLiteral("5=4");
-        info << QStringLiteral("6=5");
-        info << QStringLiteral("7=6");
-        info << QStringLiteral("8=7");
-        info << QStringLiteral("9=8");
-        info << QStringLiteral("10=9");
-        info << QStringLiteral("11=10");
-        info << QStringLiteral("12=11");
-        info << QStringLiteral("13=12");
-        info << QStringLiteral("14=13");
-        info << QStringLiteral("15=14");
-    } else if (oldName == QLatin1String("equalizer")) {
-        info << QStringLiteral("ladspa.1901");
-        info << QStringLiteral("logain=0");
-        info << QStringLiteral("midgain=1");
-        info << QStringLiteral("higain=2");
-    } else if (oldName == QLatin1String("declipper")) {
-        info << QStringLiteral("ladspa.1195");
-    }
-    return info;
-}
-
 QString DocumentValidator::colorToString(const QColor &c)
 {
     QString ret = QStringLiteral("%1,%2,%3,%4");
@@ -1460,99 +1166,9 @@ QString DocumentValidator::factorizeGeomValue(const QString &value, double facto
 
 void DocumentValidator::checkOrphanedProducers()
 {
-    QDomElement mlt = m_doc.firstChildElement(QStringLiteral("mlt"));
-    QDomElement main = mlt.firstChildElement(QStringLiteral("playlist"));
-    QDomNodeList bin_producers = main.childNodes();
-    QStringList binProducers;
-    for (int k = 0; k < bin_producers.count(); k++) {
-        QDomElement mltprod = bin_producers.at(k).toElement();
-        if (mltprod.tagName() != QLatin1String("entry")) {
-            continue;
-        }
-        binProducers << mltprod.attribute(QStringLiteral("producer"));
-    }
-
-    QDomNodeList producers = m_doc.elementsByTagName(QStringLiteral("producer"));
-    int max = producers.count();
-    QStringList allProducers;
-    for (int i = 0; i < max; ++i) {
-        QDomElement prod = producers.at(i).toElement();
-        if (prod.isNull()) {
-            continue;
-        }
-        allProducers << prod.attribute(QStringLiteral("id"));
-    }
-
-    QDomDocumentFragment frag = m_doc.createDocumentFragment();
-    QDomDocumentFragment trackProds = m_doc.createDocumentFragment();
-    for (int i = 0; i < max; ++i) {
-        QDomElement prod = producers.at(i).toElement();
-        if (prod.isNull()) {
-            continue;
-        }
-        QString id = prod.attribute(QStringLiteral("id")).section(QLatin1Char('_'), 0, 0);
-        if (id.startsWith(QLatin1String("slowmotion")) || id == QLatin1String("black")) {
-            continue;
-        }
-        if (!binProducers.contains(id)) {
-            QString binId = EffectsList::property(prod, QStringLiteral("kdenlive:binid"));
-            if (!binId.isEmpty() && binProducers.contains(binId)) {
-                continue;
-            }
-            qCWarning(KDENLIVE_LOG) << " ///////// WARNING, FOUND UNKNOWN PRODUDER: " << id << " ----------------";
-            // This producer is unknown to Bin
-            QString service = EffectsList::property(prod, QStringLiteral("mlt_service"));
-            QString distinctiveTag(QStringLiteral("resource"));
-            if (service == QLatin1String("kdenlivetitle")) {
-                distinctiveTag = QStringLiteral("xmldata");
-            }
-            QString orphanValue = EffectsList::property(prod, distinctiveTag);
-            for (int j = 0; j < max; j++) {
-                // Search for a similar producer
-                QDomElement binProd = producers.at(j).toElement();
-                binId = binProd.attribute(QStringLiteral("id")).section(QLatin1Char('_'), 0, 0);
-                if (service != QLatin1String("timewarp") && (binId.startsWith(QLatin1String("slowmotion")) || !binProducers.contains(binId))) {
-                    continue;
-                }
-                QString binService = EffectsList::property(binProd, QStringLiteral("mlt_service"));
-                qCDebug(KDENLIVE_LOG) << " / /LKNG FOR: " << service << " / " << orphanValue << ", checking: " << binProd.attribute(QStringLiteral("id"));
-                if (service != binService) {
-                    continue;
-                }
-                QString binValue = EffectsList::property(binProd, distinctiveTag);
-                if (binValue == orphanValue) {
-                    // Found probable source producer, replace
-                    frag.appendChild(prod);
-                    i--;
-                    QDomNodeList entries = m_doc.elementsByTagName(QStringLiteral("entry"));
-                    for (int k = 0; k < entries.count(); k++) {
-                        QDomElement entry = entries.at(k).toElement();
-                        if (entry.attribute(QStringLiteral("producer")) == id) {
-                            QString entryId = binId;
-                            if (service.contains(QStringLiteral("avformat")) || service == QLatin1String("xml") || service == QLatin1String("consumer")) {
-                                // We must use track producer, find track for this entry
-                                QString trackPlaylist = entry.parentNode().toElement().attribute(QStringLiteral("id"));
-                                entryId.append(QLatin1Char('_') + trackPlaylist);
-                            }
-                            if (!allProducers.contains(entryId)) {
-                                // The track producer does not exist, create a clone for it
-                                QDomElement cloned = binProd.cloneNode(true).toElement();
-                                cloned.setAttribute(QStringLiteral("id"), entryId);
-                                trackProds.appendChild(cloned);
-                                allProducers << entryId;
-                            }
-                            entry.setAttribute(QStringLiteral("producer"), entryId);
-                            m_modified = true;
-                        }
-                    }
-                    continue;
-                }
-            }
-        }
-    }
-    if (!trackProds.isNull()) {
-        QDomNode firstProd = m_doc.firstChildElement(QStringLiteral("producer"));
-        mlt.insertBefore(trackProds, firstProd);
+    // Producers and entries were indexed while upgrading
+    if (DocumentUpgrader::checkOrphanedProducers(m_doc, m_producers, m_entries)) {
+        m_modified = true;
     }
 }
 
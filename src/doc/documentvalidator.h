@@ -25,6 +25,7 @@
 
 #include <QUrl>
 #include <QMap>
+#include <QVector>
 
 class DocumentValidator
 {
@@ -41,18 +42,21 @@ private:
     QDomDocument m_doc;
     QUrl m_url;
     bool m_modified;
+    /** @brief Producer and entry elements, indexed when upgrading */
+    QVector<QDomElement> m_producers;
+    QVector<QDomElement> m_entries;
     /** @brief Upgrade from a previous Kdenlive document version. */
     bool upgrade(double version, const double currentVersion);
+    /** @brief Convert producers, entries, filters and transitions in a single pass (see DocumentUpgrader), indexing them. */
+    void upgradeElements(double version, int profileWidth, int profileHeight);
     /** @brief Pass producer properties from previous Kdenlive versions. */
     void updateProducerInfo(const QDomElement &prod, const QDomElement &source);
-    /** @brief Make sur we don't have orphaned producers (that are not in Bin). */
+    /** @brief Make sur we don't have orphaned producers (that are not in Bin), see DocumentUpgrader::checkOrphanedProducers. */
     void checkOrphanedProducers();
-    QStringList getInfoFromEffectName(const QString &oldName);
     QString colorToString(const QColor &c);
     QString factorizeGeomValue(const QString &value, double factor);
     /** @brief Kdenlive <= 0.9.10 saved title clip item position/opacity with locale which was wrong, fix. */
     void fixTitleProducerLocale(QDomElement &producer);
-    void convertKeyframeEffect(const QDomElement &effect, const QStringList &params, QMap<int, double> &values, int offset);
 };
 
 #endif
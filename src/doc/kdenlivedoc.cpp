@@ -40,6 +40,8 @@
 #include "utils/KoIconUtils.h"
 #include "mltcontroller/bincontroller.h"
 #include "mltcontroller/effectscontroller.h"
+#include "effectslist/compacteffect.h"
+#include "undomemory.h"
 #include "timeline/transitionhandler.h"
 
 #include <KMessageBox>
@@ -62,22 +64,99 @@
 #include <KJobWidgets/KJobWidgets>
 #include <QStandardPaths>
 
+#include <limits>
 #include <locale>
 #ifdef Q_OS_MAC
 #include <xlocale.h>
 #endif
 
-DocUndoStack::DocUndoStack(QUndoGroup *parent) : QUndoStack(parent)
+// Average memory used by an undo command, estimated from the previous commands
+static qint64 s_commandCost = 64 * 1024;
+
+DocUndoStack::DocUndoStack(QUndoGroup *parent) : QUndoStack(parent),
+    m_memoryBudget(0),
+    m_trimmed(false)
 {
 }
 
 //TODO: custom undostack everywhere do that
 void DocUndoStack::push(QUndoCommand *cmd)
 {
+    if (m_commandSizes.count() != count()) {
+        // The stack was changed outside of push (clear, macro)
+        m_commandSizes.clear();
+        for (int i = 0; i < count(); ++i) {
+            m_commandSizes << UndoMemory::commandSize(command(i));
+        }
+    }
+    if (count() == 0) {
+        updateUndoLimit();
+    }
     if (index() < count()) {
         emit invalidate();
     }
+    const int base = index();
+    m_commandSizes.resize(base);
     QUndoStack::push(cmd);
+    if (count() > 0 && command(count() - 1) == cmd) {
+        m_commandSizes << UndoMemory::commandSize(cmd);
+        const int dropped = m_commandSizes.count() - count();
+        if (dropped > 0) {
+            // Oldest commands deleted by the undo limit
+            m_commandSizes.remove(0, dropped);
+            if (!m_trimmed) {
+                m_trimmed = true;
+                emit historyTrimmed();
+            }
+        }
+    } else if (count() == base && base > 0) {
+        // Merged into the previous command
+        m_commandSizes[base - 1] = UndoMemory::commandSize(command(base - 1));
+    }
+    if (count() > 0) {
+        s_commandCost = qMax((qint64) 1, memoryUsage() / count());
+    }
+}
+
+void DocUndoStack::updateUndoLimit()
+{
+    // QUndoStack deletes its oldest commands above the undo limit, but the
+    // limit can only be changed on an empty stack. So it is derived from the
+    // budget and the average command cost seen so far each time the stack is
+    // empty, the memory used is approximately bounded.
+    if (count() > 0) {
+        return;
+    }
+    if (m_memoryBudget > 0) {
+        setUndoLimit((int) qBound((qint64) 1, m_memoryBudget / s_commandCost, (qint64) std::numeric_limits<int>::max()));
+    } else {
+        setUndoLimit(0);
+    }
+}
+
+qint64 DocUndoStack::memoryUsage() const
+{
+    qint64 usage = CompactEffect::allocatedMemory();
+    for (qint64 size : m_commandSizes) {
+        usage += size;
+    }
+    return usage;
+}
+
+void DocUndoStack::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+    updateUndoLimit();
+}
+
+bool DocUndoStack::isTrimmed() const
+{
+    return m_trimmed;
+}
+
+void DocUndoStack::resetTrimmed()
+{
+    m_trimmed = false;
 }
 
 const double DOCUMENTVERSION = 0.96;
@@ -109,8 +188,9 @@ KdenliveDoc::KdenliveDoc(const QUrl &url, const QString &projectFolder, QUndoGro
     connect(m_clipManager, SIGNAL(displayMessage(QString, int)), parent, SLOT(slotGotProgressInfo(QString, int)));
     connect(this, SIGNAL(updateCompositionMode(int)), parent, SLOT(slotUpdateCompositeAction(int)));
     bool success = false;
+    m_commandStack->setMemoryBudget((qint64) KdenliveSettings::undo_memorybudget() * 1024 * 1024);
     connect(m_commandStack, &QUndoStack::indexChanged, this, &KdenliveDoc::slotModified);
-    connect(m_commandStack, &DocUndoStack::invalidate, this, &KdenliveDoc::checkPreviewStack);
+    connect(m_commandStack, &DocUndoStack::historyTrimmed, this, &KdenliveDoc::slotHistoryTrimmed);
     connect(m_render, &Render::setDocumentNotes, this, &KdenliveDoc::slotSetDocumentNotes);
     connect(pCore->producerQueue(), &ProducerQueue::switchProfile, this, &KdenliveDoc::switchProfile);
     //connect(m_commandStack, SIGNAL(cleanChanged(bool)), this, SLOT(setModified(bool)));
@@ -896,7 +976,13 @@ void KdenliveDoc::setUrl(const QUrl &url)
 
 void KdenliveDoc::slotModified()
 {
-    setModified(m_commandStack->isClean() == false);
+    // Once history was dropped, the clean state cannot be reached again by undoing
+    setModified(m_commandStack->isClean() == false || m_commandStack->isTrimmed());
+}
+
+void KdenliveDoc::slotHistoryTrimmed()
+{
+    displayMessage(i18n("Oldest undo steps were dropped to stay within the undo memory limit"), InformationMessage);
 }
 
 void KdenliveDoc::setModified(bool mod)
@@ -905,6 +991,10 @@ void KdenliveDoc::setModified(bool mod)
     if (m_autosave && mod && KdenliveSettings::crashrecovery()) {
         emit startAutoSave();
     }
+    if (!mod) {
+        // Saved, the current state is the reference again
+        m_commandStack->resetTrimmed();
+    }
     if (mod == m_modified) {
         return;
     }
@@ -1740,12 +1830,6 @@ void KdenliveDoc::selectPreviewProfile()
     }
 }
 
-void KdenliveDoc::checkPreviewStack()
-{
-    // A command was pushed in the middle of the stack, remove all cached data from last undos
-    emit removeInvalidUndo(m_commandStack->count());
-}
-
 void KdenliveDoc::saveMltPlaylist(const QString &fileName)
 {
     m_render->preparePreviewRendering(fileName);
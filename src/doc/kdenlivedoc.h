@@ -32,6 +32,7 @@
 #include <QObject>
 #include <QTimer>
 #include <QUrl>
+#include <QVector>
 
 #include <kautosavefile.h>
 #include <KDirWatch>
@@ -67,8 +68,27 @@ class DocUndoStack: public QUndoStack
 public:
     explicit DocUndoStack(QUndoGroup *parent = nullptr);
     void push(QUndoCommand *cmd);
+    /** @brief Approximate memory used by the undo commands and the effect states they store, in bytes */
+    qint64 memoryUsage() const;
+    /** @brief Maximum memory for the undo history in bytes, 0 for no limit
+     *
+     * The oldest commands are dropped above a number of commands fitting the budget,
+     * which can only be changed while the stack is empty. */
+    void setMemoryBudget(qint64 bytes);
+    /** @brief True if old commands were dropped since the last resetTrimmed() */
+    bool isTrimmed() const;
+    void resetTrimmed();
+private:
+    qint64 m_memoryBudget;
+    bool m_trimmed;
+    /** @brief Memory reported by each command of the stack */
+    QVector<qint64> m_commandSizes;
+    /** @brief Set the undo limit from the memory budget, if the stack is empty */
+    void updateUndoLimit();
 signals:
     void invalidate();
+    /** @brief The oldest commands were dropped to stay within the memory budget */
+    void historyTrimmed();
 };
 
 class KdenliveDoc: public QObject
@@ -239,11 +259,10 @@ private slots:
     void slotClipMissing(const QString &path);
     void slotProcessModifiedClips();
     void slotModified();
+    void slotHistoryTrimmed();
     void slotSetDocumentNotes(const QString &notes);
     void switchProfile(MltVideoProfile profile, const QString &id, const QDomElement &xml);
     void slotSwitchProfile();
-    /** @brief Check if we did a new action invalidating more recent undo items. */
-    void checkPreviewStack();
 
 signals:
     void resetProjectList();
@@ -262,8 +281,6 @@ signals:
     void reloadEffects();
     /** @brief Fps was changed, update timeline (changed = 1 means no change) */
     void updateFps(double changed);
-    /** @brief If a command is pushed when we are in the middle of undo stack, invalidate further undo history */
-    void removeInvalidUndo(int ix);
     /** @brief Update compositing info */
     void updateCompositionMode(int);
 };
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "kthumb.h"
 #include "kdenlivesettings.h"
+#include "lib/video/colorConversion.h"
 
 #include <mlt++/Mlt.h>
 
@@ -84,6 +85,24 @@ QImage KThumb::getFrame(Mlt::Producer *producer, int framepos, int displayWidth,
     return p;
 }
 
+/** @brief Returns true if the frame comes from a video decoded without alpha channel,
+ *  in which case fetching yuv422 and converting it ourselves is faster than rgb24a. */
+static bool isOpaqueVideoFrame(Mlt::Frame *frame)
+{
+    Mlt::Producer *producer = frame->get_original_producer();
+    if (producer == nullptr) {
+        return false;
+    }
+    bool opaque = false;
+    if (producer->is_valid() && QString::fromLatin1(producer->get("mlt_service")).startsWith(QLatin1String("avformat"))) {
+        const QString key = QStringLiteral("meta.media.%1.codec.pix_fmt").arg(producer->get_int("video_index"));
+        const QString pixFormat = QString::fromLatin1(producer->get(key.toUtf8().constData()));
+        opaque = pixFormat.startsWith(QLatin1String("yuv")) && !pixFormat.startsWith(QLatin1String("yuva"));
+    }
+    delete producer;
+    return opaque;
+}
+
 //static
 QImage KThumb::getFrame(Mlt::Frame *frame, int width, int height, bool forceRescale)
 {
@@ -94,12 +113,19 @@ QImage KThumb::getFrame(Mlt::Frame *frame, int width, int height, bool forceResc
     }
     int ow = forceRescale ? 0 : width;
     int oh = forceRescale ? 0 : height;
-    mlt_image_format format = mlt_image_rgb24a;
+    const bool yuvSource = isOpaqueVideoFrame(frame);
+    mlt_image_format format = yuvSource ? mlt_image_yuv422 : mlt_image_rgb24a;
     ow += ow % 2;
     const uchar *imagedata = frame->get_image(format, ow, oh);
     if (imagedata) {
         QImage image(ow, oh, QImage::Format_RGBA8888);
-        memcpy(image.bits(), imagedata, ow * oh * 4);
+        if (format == mlt_image_yuv422) {
+            const int colorspace = frame->get_int("colorspace");
+            ColorConversion::convertPacked(ColorConversion::Yuyv, imagedata, ow * 2, ColorConversion::Rgba, image.bits(), image.bytesPerLine(), ow, oh,
+                                           ColorConversion::matrixForColorspace(colorspace));
+        } else {
+            memcpy(image.bits(), imagedata, ow * oh * 4);
+        }
         if (!image.isNull()) {
             if (ow > (2 * width)) {
                 // there was a scaling problem, do it manually
@@ -0,0 +1,55 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "undomemory.h"
+
+#include <QDomNamedNodeMap>
+#include <QDomNode>
+#include <QUndoCommand>
+
+// Bookkeeping of a DOM node, besides its strings
+static const int NodeOverhead = 64;
+
+UndoMemory::~UndoMemory()
+{
+}
+
+// static
+qint64 UndoMemory::nodeSize(const QDomNode &node)
+{
+    if (node.isNull()) {
+        return 0;
+    }
+    // QString stores 2 bytes per character
+    qint64 size = NodeOverhead + 2 * (node.nodeName().size() + node.nodeValue().size());
+    const QDomNamedNodeMap attributes = node.attributes();
+    for (int i = 0; i < attributes.count(); ++i) {
+        const QDomNode attribute = attributes.item(i);
+        size += NodeOverhead + 2 * (attribute.nodeName().size() + attribute.nodeValue().size());
+    }
+    for (QDomNode child = node.firstChild(); !child.isNull(); child = child.nextSibling()) {
+        size += nodeSize(child);
+    }
+    return size;
+}
+
+// static
+qint64 UndoMemory::commandSize(const QUndoCommand *command)
+{
+    qint64 size = sizeof(QUndoCommand) + 2 * command->text().size();
+    const UndoMemory *memory = dynamic_cast<const UndoMemory *>(command);
+    if (memory) {
+        size += memory->memorySize();
+    }
+    for (int i = 0; i < command->childCount(); ++i) {
+        size += commandSize(command->child(i));
+    }
+    return size;
+}
@@ -0,0 +1,39 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef UNDOMEMORY_H
+#define UNDOMEMORY_H
+
+#include <QtGlobal>
+
+class QDomNode;
+class QUndoCommand;
+
+/**
+ * @class UndoMemory
+ * @brief Implemented by undo commands keeping xml data, so that it counts in the undo memory budget.
+ *
+ * Compact effect states are accounted globally by CompactEffect and must not
+ * be counted again by the commands.
+ */
+class UndoMemory
+{
+public:
+    virtual ~UndoMemory();
+    /** @brief Approximate memory used by the xml kept by the command, in bytes */
+    virtual qint64 memorySize() const = 0;
+
+    /** @brief Approximate memory used by a DOM node and its children, in bytes */
+    static qint64 nodeSize(const QDomNode &node);
+    /** @brief Memory reported by a command and its children, in bytes */
+    static qint64 commandSize(const QUndoCommand *command);
+};
+
+#endif
@@ -0,0 +1,343 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "compacteffect.h"
+
+#include <QAtomicInteger>
+#include <QCryptographicHash>
+#include <QDomDocument>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QWeakPointer>
+#include <algorithm>
+
+struct CompactEffect::Definition {
+    QByteArray key;
+    /** @brief The effect without its attributes and parameter values */
+    QDomDocument document;
+    int parameters;
+    qint64 size;
+};
+
+static QAtomicInteger<qint64> s_allocated(0);
+static QMutex s_poolMutex;
+static QHash<QByteArray, QWeakPointer<const CompactEffect::Definition> > s_pool;
+
+// Parameter attributes changed by edits, kept in each state instead of the definition
+static const char *const s_stateAttributes[] = {"value", "keyframes", "intimeline", "active_keyframe"};
+static const int StateAttributeCount = sizeof(s_stateAttributes) / sizeof(s_stateAttributes[0]);
+
+static bool isStateAttribute(const QString &name)
+{
+    for (int i = 0; i < StateAttributeCount; ++i) {
+        if (name == QLatin1String(s_stateAttributes[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Approximate heap size of a string
+static qint64 stringSize(const QString &text)
+{
+    return sizeof(QString) + 24 + text.size() * sizeof(QChar);
+}
+
+// Text describing everything interned in the definition of an effect
+static void describe(const QDomNode &node, bool root, QString &out)
+{
+    if (node.isElement()) {
+        const QDomElement element = node.toElement();
+        const QString tag = element.tagName();
+        out.append(QLatin1Char('<')).append(tag);
+        if (!root) {
+            const QDomNamedNodeMap attributes = element.attributes();
+            QStringList names;
+            for (int i = 0; i < attributes.count(); ++i) {
+                names << attributes.item(i).nodeName();
+            }
+            names.sort();
+            for (const QString &name : names) {
+                if (tag == QLatin1String("parameter") && isStateAttribute(name)) {
+                    continue;
+                }
+                out.append(QLatin1Char(' ')).append(name).append(QStringLiteral("=\"")).append(element.attribute(name).toHtmlEscaped()).append(QLatin1Char('"'));
+            }
+        }
+        out.append(QLatin1Char('>'));
+        for (QDomNode child = node.firstChild(); !child.isNull(); child = child.nextSibling()) {
+            describe(child, false, out);
+        }
+        out.append(QStringLiteral("</>"));
+    } else if (node.isText()) {
+        out.append(node.nodeValue().toHtmlEscaped());
+    }
+}
+
+CompactEffect::CompactEffect() :
+    m_size(0)
+{
+}
+
+CompactEffect::CompactEffect(const QDomElement &effect) :
+    m_size(0)
+{
+    if (effect.isNull()) {
+        return;
+    }
+    m_definition = intern(effect);
+    const QDomNamedNodeMap attributes = effect.attributes();
+    m_attributes.reserve(attributes.count());
+    for (int i = 0; i < attributes.count(); ++i) {
+        const QDomNode attribute = attributes.item(i);
+        m_attributes << Attribute(attribute.nodeName(), attribute.nodeValue());
+    }
+    // Sorted so that states can be compared
+    std::sort(m_attributes.begin(), m_attributes.end());
+    const QDomNodeList parameters = effect.elementsByTagName(QStringLiteral("parameter"));
+    const int count = parameters.count();
+    m_values.resize(count * StateAttributeCount);
+    m_hasValue.resize(count * StateAttributeCount);
+    for (int i = 0; i < count; ++i) {
+        const QDomElement parameter = parameters.item(i).toElement();
+        for (int j = 0; j < StateAttributeCount; ++j) {
+            const QString name = QLatin1String(s_stateAttributes[j]);
+            if (parameter.hasAttribute(name)) {
+                m_values[i * StateAttributeCount + j] = parameter.attribute(name);
+                m_hasValue.setBit(i * StateAttributeCount + j);
+            }
+        }
+    }
+    updateSize();
+}
+
+CompactEffect::CompactEffect(const CompactEffect &other) :
+    m_definition(other.m_definition),
+    m_attributes(other.m_attributes),
+    m_values(other.m_values),
+    m_hasValue(other.m_hasValue),
+    m_size(other.m_size)
+{
+    s_allocated.fetchAndAddRelaxed(m_size);
+}
+
+CompactEffect &CompactEffect::operator=(const CompactEffect &other)
+{
+    if (this != &other) {
+        s_allocated.fetchAndAddRelaxed(other.m_size - m_size);
+        m_definition = other.m_definition;
+        m_attributes = other.m_attributes;
+        m_values = other.m_values;
+        m_hasValue = other.m_hasValue;
+        m_size = other.m_size;
+    }
+    return *this;
+}
+
+CompactEffect::~CompactEffect()
+{
+    s_allocated.fetchAndAddRelaxed(-m_size);
+}
+
+bool CompactEffect::isNull() const
+{
+    return !m_definition;
+}
+
+QDomElement CompactEffect::toElement() const
+{
+    if (isNull()) {
+        return QDomElement();
+    }
+    QDomDocument doc;
+    QDomElement effect = doc.importNode(m_definition->document.documentElement(), true).toElement();
+    doc.appendChild(effect);
+    for (const Attribute &attribute : m_attributes) {
+        effect.setAttribute(attribute.first, attribute.second);
+    }
+    const QDomNodeList parameters = effect.elementsByTagName(QStringLiteral("parameter"));
+    const int count = qMin(parameters.count(), m_values.count() / StateAttributeCount);
+    for (int i = 0; i < count; ++i) {
+        QDomElement parameter = parameters.item(i).toElement();
+        for (int j = 0; j < StateAttributeCount; ++j) {
+            if (m_hasValue.testBit(i * StateAttributeCount + j)) {
+                parameter.setAttribute(QLatin1String(s_stateAttributes[j]), m_values.at(i * StateAttributeCount + j));
+            }
+        }
+    }
+    return effect;
+}
+
+qint64 CompactEffect::memorySize() const
+{
+    return m_size;
+}
+
+CompactEffectDelta CompactEffect::diff(const CompactEffect &base) const
+{
+    CompactEffectDelta delta;
+    if (isNull() || base.m_definition != m_definition) {
+        delta.m_full = QSharedPointer<CompactEffect>(new CompactEffect(*this));
+        return delta;
+    }
+    for (int i = 0; i < m_values.count(); ++i) {
+        const bool hasValue = m_hasValue.testBit(i);
+        if (hasValue != base.m_hasValue.testBit(i) || (hasValue && m_values.at(i) != base.m_values.at(i))) {
+            CompactEffectDelta::Change change;
+            change.index = i;
+            change.hasValue = hasValue;
+            change.value = m_values.at(i);
+            delta.m_changes << change;
+        }
+    }
+    if (m_attributes != base.m_attributes) {
+        delta.m_attributes = m_attributes;
+        delta.m_attributesChanged = true;
+    }
+    delta.updateSize();
+    return delta;
+}
+
+qint64 CompactEffect::allocatedMemory()
+{
+    return s_allocated.load();
+}
+
+void CompactEffect::updateSize()
+{
+    // Values are implicitly shared between states, so this is an upper bound
+    qint64 size = sizeof(CompactEffect) + m_hasValue.size() / 8;
+    for (const Attribute &attribute : m_attributes) {
+        size += stringSize(attribute.first) + stringSize(attribute.second);
+    }
+    for (int i = 0; i < m_values.count(); ++i) {
+        size += m_hasValue.testBit(i) ? stringSize(m_values.at(i)) : sizeof(QString);
+    }
+    s_allocated.fetchAndAddRelaxed(size - m_size);
+    m_size = size;
+}
+
+QSharedPointer<const CompactEffect::Definition> CompactEffect::intern(const QDomElement &effect)
+{
+    QString description;
+    describe(effect, true, description);
+    const QByteArray key = QCryptographicHash::hash(description.toUtf8(), QCryptographicHash::Md5);
+    QMutexLocker lock(&s_poolMutex);
+    QSharedPointer<const Definition> definition = s_pool.value(key).toStrongRef();
+    if (definition) {
+        return definition;
+    }
+    Definition *created = new Definition;
+    created->key = key;
+    QDomElement root = created->document.importNode(effect, true).toElement();
+    created->document.appendChild(root);
+    const QDomNamedNodeMap attributes = root.attributes();
+    while (attributes.count() > 0) {
+        root.removeAttribute(attributes.item(0).nodeName());
+    }
+    const QDomNodeList parameters = root.elementsByTagName(QStringLiteral("parameter"));
+    created->parameters = parameters.count();
+    for (int i = 0; i < created->parameters; ++i) {
+        QDomElement parameter = parameters.item(i).toElement();
+        for (int j = 0; j < StateAttributeCount; ++j) {
+            parameter.removeAttribute(QLatin1String(s_stateAttributes[j]));
+        }
+    }
+    // DOM nodes take a few times the size of their text
+    created->size = description.size() * sizeof(QChar) * 4;
+    s_allocated.fetchAndAddRelaxed(created->size);
+    definition = QSharedPointer<const Definition>(created, &CompactEffect::releaseDefinition);
+    s_pool.insert(key, definition);
+    return definition;
+}
+
+void CompactEffect::releaseDefinition(Definition *definition)
+{
+    s_allocated.fetchAndAddRelaxed(-definition->size);
+    s_poolMutex.lock();
+    if (s_pool.value(definition->key).isNull()) {
+        s_pool.remove(definition->key);
+    }
+    s_poolMutex.unlock();
+    delete definition;
+}
+
+CompactEffectDelta::CompactEffectDelta() :
+    m_attributesChanged(false),
+    m_size(0)
+{
+}
+
+CompactEffectDelta::CompactEffectDelta(const CompactEffectDelta &other) :
+    m_changes(other.m_changes),
+    m_attributes(other.m_attributes),
+    m_attributesChanged(other.m_attributesChanged),
+    m_full(other.m_full),
+    m_size(other.m_size)
+{
+    s_allocated.fetchAndAddRelaxed(m_size);
+}
+
+CompactEffectDelta &CompactEffectDelta::operator=(const CompactEffectDelta &other)
+{
+    if (this != &other) {
+        s_allocated.fetchAndAddRelaxed(other.m_size - m_size);
+        m_changes = other.m_changes;
+        m_attributes = other.m_attributes;
+        m_attributesChanged = other.m_attributesChanged;
+        m_full = other.m_full;
+        m_size = other.m_size;
+    }
+    return *this;
+}
+
+CompactEffectDelta::~CompactEffectDelta()
+{
+    s_allocated.fetchAndAddRelaxed(-m_size);
+}
+
+CompactEffect CompactEffectDelta::apply(const CompactEffect &base) const
+{
+    if (m_full) {
+        return *m_full;
+    }
+    CompactEffect result(base);
+    for (const Change &change : m_changes) {
+        if (change.index >= result.m_values.count()) {
+            continue;
+        }
+        result.m_values[change.index] = change.value;
+        result.m_hasValue.setBit(change.index, change.hasValue);
+    }
+    if (m_attributesChanged) {
+        result.m_attributes = m_attributes;
+    }
+    result.updateSize();
+    return result;
+}
+
+qint64 CompactEffectDelta::memorySize() const
+{
+    return m_size + (m_full ? m_full->memorySize() : 0);
+}
+
+void CompactEffectDelta::updateSize()
+{
+    qint64 size = sizeof(CompactEffectDelta);
+    for (const Change &change : m_changes) {
+        size += sizeof(Change) + stringSize(change.value);
+    }
+    for (const CompactEffect::Attribute &attribute : m_attributes) {
+        size += stringSize(attribute.first) + stringSize(attribute.second);
+    }
+    s_allocated.fetchAndAddRelaxed(size - m_size);
+    m_size = size;
+}
@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef COMPACTEFFECT_H
+#define COMPACTEFFECT_H
+
+#include <QBitArray>
+#include <QDomElement>
+#include <QPair>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class CompactEffectDelta;
+
+/**
+ * @class CompactEffect
+ * @brief Compact copy of an effect or transition xml, used to store undo history.
+ *
+ * Everything but the attributes of the effect element and the values of its
+ * parameters (names, descriptions, parameter definitions) is interned in a
+ * definition shared by all states of the same effect. A state only keeps its
+ * attributes and the parameter attributes changed by edits (value, keyframes,
+ * ...), and a state close to another one can be stored as the few values that
+ * differ (see CompactEffectDelta).
+ *
+ * The memory used by all compact effects is accounted in allocatedMemory().
+ */
+class CompactEffect
+{
+public:
+    CompactEffect();
+    explicit CompactEffect(const QDomElement &effect);
+    CompactEffect(const CompactEffect &other);
+    CompactEffect &operator=(const CompactEffect &other);
+    ~CompactEffect();
+
+    bool isNull() const;
+    /** @brief Rebuild the effect xml, in a new document */
+    QDomElement toElement() const;
+    /** @brief Bytes used by this state, its definition is counted once for all states sharing it */
+    qint64 memorySize() const;
+    /** @brief Returns the changes that turn base into this state */
+    CompactEffectDelta diff(const CompactEffect &base) const;
+
+    /** @brief Bytes used by all compact effects, deltas and interned definitions */
+    static qint64 allocatedMemory();
+
+    /** @brief Interned part of an effect, shared by its states */
+    struct Definition;
+
+private:
+    friend class CompactEffectDelta;
+    typedef QPair<QString, QString> Attribute;
+
+    QSharedPointer<const Definition> m_definition;
+    QVector<Attribute> m_attributes;
+    /** @brief Edited attributes of each parameter in document order, valid if the matching bit of m_hasValue is set */
+    QVector<QString> m_values;
+    QBitArray m_hasValue;
+    qint64 m_size;
+
+    void updateSize();
+    static QSharedPointer<const Definition> intern(const QDomElement &effect);
+    static void releaseDefinition(Definition *definition);
+};
+
+/**
+ * @class CompactEffectDelta
+ * @brief Changes between two states of an effect, in the parameter values and attributes.
+ */
+class CompactEffectDelta
+{
+public:
+    CompactEffectDelta();
+    CompactEffectDelta(const CompactEffectDelta &other);
+    CompactEffectDelta &operator=(const CompactEffectDelta &other);
+    ~CompactEffectDelta();
+
+    /** @brief Returns base with the changes applied */
+    CompactEffect apply(const CompactEffect &base) const;
+    qint64 memorySize() const;
+
+private:
+    friend class CompactEffect;
+    struct Change {
+        int index;
+        bool hasValue;
+        QString value;
+    };
+    QVector<Change> m_changes;
+    QVector<CompactEffect::Attribute> m_attributes;
+    bool m_attributesChanged;
+    /** @brief Whole target state, used when it does not share the base definition */
+    QSharedPointer<CompactEffect> m_full;
+    qint64 m_size;
+
+    void updateSize();
+};
+
+#endif
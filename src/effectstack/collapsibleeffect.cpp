@@ -50,6 +50,9 @@ CollapsibleEffect::CollapsibleEffect(const QDomElement &effect, const QDomElemen
     m_paramWidget(nullptr),
     m_effect(effect),
     m_itemInfo(info),
+    m_metaInfo(metaInfo),
+    m_range(-1, -1),
+    m_position(-1),
     m_original_effect(original_effect),
     m_isMovable(true),
     m_animation(nullptr),
@@ -170,18 +173,7 @@ CollapsibleEffect::CollapsibleEffect(const QDomElement &effect, const QDomElemen
     connect(buttonDown, &QAbstractButton::clicked, this, &CollapsibleEffect::slotEffectDown);
     connect(buttonDel, &QAbstractButton::clicked, this, &CollapsibleEffect::slotDeleteEffect);
 
-    Q_FOREACH (QSpinBox *sp, findChildren<QSpinBox *>()) {
-        sp->installEventFilter(this);
-        sp->setFocusPolicy(Qt::StrongFocus);
-    }
-    Q_FOREACH (KComboBox *cb, findChildren<KComboBox *>()) {
-        cb->installEventFilter(this);
-        cb->setFocusPolicy(Qt::StrongFocus);
-    }
-    Q_FOREACH (QProgressBar *cb, findChildren<QProgressBar *>()) {
-        cb->installEventFilter(this);
-        cb->setFocusPolicy(Qt::StrongFocus);
-    }
+    installWheelFilters();
     m_animation = new QTimeLine(200, this); //duration matches to match kmessagewidget
     connect(m_animation, &QTimeLine::valueChanged, this, &CollapsibleEffect::setWidgetHeight);
     connect(m_animation, &QTimeLine::stateChanged, this, [this](QTimeLine::State state) {
@@ -202,7 +194,25 @@ CollapsibleEffect::~CollapsibleEffect()
 
 void CollapsibleEffect::setWidgetHeight(qreal value)
 {
-    widgetFrame->setFixedHeight(m_paramWidget->contentHeight() * value);
+    if (m_paramWidget) {
+        widgetFrame->setFixedHeight(m_paramWidget->contentHeight() * value);
+    }
+}
+
+void CollapsibleEffect::installWheelFilters()
+{
+    Q_FOREACH (QSpinBox *sp, findChildren<QSpinBox *>()) {
+        sp->installEventFilter(this);
+        sp->setFocusPolicy(Qt::StrongFocus);
+    }
+    Q_FOREACH (KComboBox *cb, findChildren<KComboBox *>()) {
+        cb->installEventFilter(this);
+        cb->setFocusPolicy(Qt::StrongFocus);
+    }
+    Q_FOREACH (QProgressBar *cb, findChildren<QProgressBar *>()) {
+        cb->installEventFilter(this);
+        cb->setFocusPolicy(Qt::StrongFocus);
+    }
 }
 
 void CollapsibleEffect::slotCreateGroup()
@@ -285,10 +295,7 @@ QDomElement CollapsibleEffect::effectForSave() const
 {
     QDomElement effect = m_effect.cloneNode().toElement();
     effect.removeAttribute(QStringLiteral("kdenlive_ix"));
-    if (m_paramWidget) {
-        int in = m_paramWidget->range().x();
-        EffectsController::offsetKeyframes(in, effect);
-    }
+    EffectsController::offsetKeyframes(rangeStart(), effect);
     return effect;
 }
 
@@ -306,6 +313,9 @@ void CollapsibleEffect::setActive(bool activate)
 {
     decoframe->setProperty("active", activate);
     decoframe->setStyleSheet(decoframe->styleSheet());
+    if (activate) {
+        ensureParamWidget();
+    }
     if (m_paramWidget) {
         m_paramWidget->connectMonitor(activate);
     }
@@ -349,6 +359,10 @@ void CollapsibleEffect::slotDisable(bool disable, bool emitInfo)
         widgetFrame->setEnabled(!disable);
     }
     if (emitInfo) {
+        if (!disable) {
+            // The monitor scene depends on the parameters
+            ensureParamWidget();
+        }
         emit effectStateChanged(disable, effectIndex(), needsMonitorEffectScene());
     }
 }
@@ -390,10 +404,7 @@ void CollapsibleEffect::slotSaveEffect()
     effect.removeAttribute(QStringLiteral("kdenlive_ix"));
     effect.setAttribute(QStringLiteral("id"), name);
     effect.setAttribute(QStringLiteral("type"), QStringLiteral("custom"));
-    if (m_paramWidget) {
-        int in = m_paramWidget->range().x();
-        EffectsController::offsetKeyframes(in, effect);
-    }
+    EffectsController::offsetKeyframes(rangeStart(), effect);
     QDomElement effectname = effect.firstChildElement(QStringLiteral("name"));
     effect.removeChild(effectname);
     effectname = doc.createElement(QStringLiteral("name"));
@@ -421,6 +432,9 @@ void CollapsibleEffect::slotResetEffect()
 void CollapsibleEffect::slotSwitch()
 {
     bool expand = !widgetFrame->isVisible();
+    if (expand) {
+        ensureParamWidget();
+    }
     widgetFrame->setVisible(true);
     slotShow(expand);
     m_animation->setDirection(expand ? QTimeLine::Forward : QTimeLine::Backward);
@@ -531,6 +545,9 @@ void CollapsibleEffect::setupWidget(const ItemInfo &info, EffectMetaInfo *metaIn
     }
     delete m_paramWidget;
     m_paramWidget = nullptr;
+    m_itemInfo = info;
+    m_metaInfo = metaInfo;
+    m_range = QPoint(-1, -1);
 
     if (m_effect.attribute(QStringLiteral("tag")) == QLatin1String("region")) {
         m_regionEffect = true;
@@ -553,22 +570,46 @@ void CollapsibleEffect::setupWidget(const ItemInfo &info, EffectMetaInfo *metaIn
             vbox->addWidget(coll);
             //p = new ParameterContainer(effects.at(i).toElement(), info, isEffect, container);
         }
+        connectParamWidget();
     } else {
-        m_paramWidget = new ParameterContainer(m_effect, info, metaInfo, widgetFrame);
-        connect(m_paramWidget, &ParameterContainer::disableCurrentFilter, this, &CollapsibleEffect::slotDisableEffect);
-        connect(m_paramWidget, &ParameterContainer::importKeyframes, this, &CollapsibleEffect::importKeyframes);
         if (m_effect.firstChildElement(QStringLiteral("parameter")).isNull()) {
             // Effect has no parameter, don't allow expand
             collapseButton->setEnabled(false);
             collapseButton->setVisible(false);
             widgetFrame->setVisible(false);
         }
+        // Parameters of a collapsed effect are only created when it is expanded or selected
+        if (!collapseButton->isEnabled() || !m_info.isCollapsed) {
+            ensureParamWidget();
+        }
     }
     if (collapseButton->isEnabled() && m_info.isCollapsed) {
         widgetFrame->setVisible(false);
         collapseButton->setArrowType(Qt::RightArrow);
 
     }
+}
+
+void CollapsibleEffect::ensureParamWidget()
+{
+    if (m_paramWidget || m_effect.isNull()) {
+        return;
+    }
+    m_paramWidget = new ParameterContainer(m_effect, m_itemInfo, m_metaInfo, widgetFrame);
+    connect(m_paramWidget, &ParameterContainer::disableCurrentFilter, this, &CollapsibleEffect::slotDisableEffect);
+    connect(m_paramWidget, &ParameterContainer::importKeyframes, this, &CollapsibleEffect::importKeyframes);
+    connectParamWidget();
+    if (m_range.x() >= 0) {
+        m_paramWidget->setRange(m_range.x(), m_range.y());
+    }
+    if (m_position >= 0) {
+        emit syncEffectsPos(m_position);
+    }
+    installWheelFilters();
+}
+
+void CollapsibleEffect::connectParamWidget()
+{
     connect(m_paramWidget, &ParameterContainer::parameterChanged, this, &CollapsibleEffect::parameterChanged);
 
     connect(m_paramWidget, &ParameterContainer::startFilterJob, this, &CollapsibleEffect::startFilterJob);
@@ -579,6 +620,36 @@ void CollapsibleEffect::setupWidget(const ItemInfo &info, EffectMetaInfo *metaIn
     connect(m_paramWidget, &ParameterContainer::importClipKeyframes, this, &CollapsibleEffect::prepareImportClipKeyframes);
 }
 
+void CollapsibleEffect::updateEffect(const QDomElement &effect, const QDomElement &original_effect, const ItemInfo &info, EffectMetaInfo *metaInfo, bool canMoveUp, bool lastEffect)
+{
+    m_effect = effect;
+    m_original_effect = original_effect;
+    m_info.fromString(effect.attribute(QStringLiteral("kdenlive_info")));
+    buttonUp->setEnabled(canMoveUp);
+    buttonDown->setEnabled(!lastEffect);
+    bool disabled = m_effect.attribute(QStringLiteral("disable")) == QLatin1String("1");
+    title->setEnabled(!disabled);
+    m_enabledButton->setActive(disabled);
+    if (!disabled || KdenliveSettings::disable_effect_parameters()) {
+        widgetFrame->setEnabled(!disabled);
+    }
+    // An interrupted animation leaves a fixed height on the frame
+    m_animation->stop();
+    widgetFrame->setMinimumHeight(0);
+    widgetFrame->setMaximumHeight(QWIDGETSIZE_MAX);
+    if (collapseButton->isEnabled()) {
+        widgetFrame->setVisible(!m_info.isCollapsed);
+        collapseButton->setArrowType(m_info.isCollapsed ? Qt::RightArrow : Qt::DownArrow);
+    }
+    if (m_paramWidget && !m_regionEffect && m_paramWidget->updateValues(m_effect, info, metaInfo)) {
+        // Same effect and parameters, only the values were updated
+        m_itemInfo = info;
+        m_metaInfo = metaInfo;
+        return;
+    }
+    setupWidget(info, metaInfo);
+}
+
 void CollapsibleEffect::slotDisableEffect(bool disable)
 {
     title->setEnabled(!disable);
@@ -594,7 +665,9 @@ bool CollapsibleEffect::isGroup() const
 
 void CollapsibleEffect::updateTimecodeFormat()
 {
-    m_paramWidget->updateTimecodeFormat();
+    if (m_paramWidget) {
+        m_paramWidget->updateTimecodeFormat();
+    }
     if (!m_subParamWidgets.isEmpty()) {
         // we have a group
         for (int i = 0; i < m_subParamWidgets.count(); ++i) {
@@ -611,6 +684,7 @@ void CollapsibleEffect::slotUpdateRegionEffectParams(const QDomElement &/*old*/,
 
 void CollapsibleEffect::slotSyncEffectsPos(int pos)
 {
+    m_position = pos;
     emit syncEffectsPos(pos);
 }
 
@@ -620,7 +694,7 @@ void CollapsibleEffect::dragEnterEvent(QDragEnterEvent *event)
         frame->setProperty("target", true);
         frame->setStyleSheet(frame->styleSheet());
         event->acceptProposedAction();
-    } else if (m_paramWidget->doesAcceptDrops() && event->mimeData()->hasFormat(QStringLiteral("kdenlive/geometry")) && event->source()->objectName() != QStringLiteral("ParameterContainer")) {
+    } else if (m_paramWidget && m_paramWidget->doesAcceptDrops() && event->mimeData()->hasFormat(QStringLiteral("kdenlive/geometry")) && event->source()->objectName() != QStringLiteral("ParameterContainer")) {
         event->setDropAction(Qt::CopyAction);
         event->setAccepted(true);
     } else {
@@ -737,11 +811,27 @@ MonitorSceneType CollapsibleEffect::needsMonitorEffectScene() const
 
 void CollapsibleEffect::setRange(int inPoint, int outPoint)
 {
-    m_paramWidget->setRange(inPoint, outPoint);
+    if (m_paramWidget) {
+        m_paramWidget->setRange(inPoint, outPoint);
+    } else {
+        m_range = QPoint(inPoint, outPoint);
+    }
+}
+
+int CollapsibleEffect::rangeStart() const
+{
+    if (m_paramWidget) {
+        return m_paramWidget->range().x();
+    }
+    if (m_range.x() >= 0) {
+        return m_range.x();
+    }
+    return m_itemInfo.cropStart.frames(KdenliveSettings::project_fps());
 }
 
 void CollapsibleEffect::setKeyframes(const QString &tag, const QString &keyframes)
 {
+    ensureParamWidget();
     m_paramWidget->setKeyframes(tag, keyframes);
 }
 
@@ -53,6 +53,8 @@ public:
     bool eventFilter(QObject *o, QEvent *e) Q_DECL_OVERRIDE;
     /** @brief Update effect GUI to reflect parameted changes. */
     void updateWidget(const ItemInfo &info, const QDomElement &effect, EffectMetaInfo *metaInfo);
+    /** @brief Reuse this widget to display another instance of the same effect. */
+    void updateEffect(const QDomElement &effect, const QDomElement &original_effect, const ItemInfo &info, EffectMetaInfo *metaInfo, bool canMoveUp, bool lastEffect);
     /** @brief Returns effect xml. */
     QDomElement effect() const;
     /** @brief Returns effect xml with keyframe offset for saving. */
@@ -116,6 +118,11 @@ private:
     QList<CollapsibleEffect *> m_subParamWidgets;
     QDomElement m_effect;
     ItemInfo m_itemInfo;
+    EffectMetaInfo *m_metaInfo;
+    /** @brief Clip range received before the parameter widget was created, x is -1 if none. */
+    QPoint m_range;
+    /** @brief Last synced timeline position, -1 if none. */
+    int m_position;
     QDomElement m_original_effect;
     QList<QDomElement> m_subEffects;
     QMenu *m_menu;
@@ -132,6 +139,13 @@ private:
     QPixmap m_iconPix;
     /** @brief Check if collapsed state changed and inform MLT. */
     void updateCollapsedState();
+    /** @brief Create the parameter widget if it was not created yet (effect collapsed and never selected). */
+    void ensureParamWidget();
+    void connectParamWidget();
+    /** @brief Install event filter on the parameter widgets so that scrolling does not change their value. */
+    void installWheelFilters();
+    /** @brief Returns the clip in point used to offset keyframes. */
+    int rangeStart() const;
 
 protected:
     void mouseDoubleClickEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
@@ -41,6 +41,7 @@
 #include <QScrollBar>
 #include <QDrag>
 #include <QMimeData>
+#include <QMultiHash>
 
 EffectStackView2::EffectStackView2(Monitor *projectMonitor, QWidget *parent) :
     QWidget(parent),
@@ -294,6 +295,25 @@ void EffectStackView2::slotTrackItemSelected(int ix, const TrackInfo &info, Moni
     setupListView();
 }
 
+bool EffectStackView2::canReuseEffectWidgets() const
+{
+    // Groups and regions contain other widgets, the stack is rebuilt for them
+    for (CollapsibleEffect *effect : m_effects) {
+        if (effect->groupIndex() >= 0 || effect->effect().attribute(QStringLiteral("tag")) == QLatin1String("region")) {
+            return false;
+        }
+    }
+    for (int i = 0; i < m_currentEffectList.count(); ++i) {
+        const QDomElement effect = m_currentEffectList.at(i);
+        EffectInfo effectInfo;
+        effectInfo.fromString(effect.attribute(QStringLiteral("kdenlive_info")));
+        if (effectInfo.groupIndex >= 0 || effect.attribute(QStringLiteral("tag")) == QLatin1String("region")) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void EffectStackView2::setupListView()
 {
     blockSignals(true);
@@ -302,30 +322,47 @@ void EffectStackView2::setupListView()
     m_draggedEffect = nullptr;
     m_draggedGroup = nullptr;
     disconnect(m_effectMetaInfo.monitor, &Monitor::renderPosition, this, &EffectStackView2::slotRenderPos);
-    QWidget *view = m_effect->container->takeWidget();
-    if (view) {
-        /*QList<CollapsibleEffect *> allChildren = view->findChildren<CollapsibleEffect *>();
-        qCDebug(KDENLIVE_LOG)<<" * * *FOUND CHLD: "<<allChildren.count();
-        foreach(CollapsibleEffect *eff, allChildren) {
-            eff->setEnabled(false);
-        }*/
-        //delete view;
-        view->setEnabled(false);
-        view->setHidden(true);
-        view->deleteLater();
+    QWidget *view = m_effect->container->widget();
+    QVBoxLayout *vbox1 = nullptr;
+    // Current effect widgets by effect id, reused for the effects of the new stack
+    QMultiHash<QString, CollapsibleEffect *> unusedEffects;
+    if (view && canReuseEffectWidgets()) {
+        vbox1 = static_cast<QVBoxLayout *>(view->layout());
+        while (QLayoutItem *item = vbox1->takeAt(0)) {
+            delete item;
+        }
+        for (CollapsibleEffect *effect : m_effects) {
+            unusedEffects.insert(effect->effect().attribute(QStringLiteral("id")), effect);
+        }
+    } else {
+        view = m_effect->container->takeWidget();
+        if (view) {
+            /*QList<CollapsibleEffect *> allChildren = view->findChildren<CollapsibleEffect *>();
+            qCDebug(KDENLIVE_LOG)<<" * * *FOUND CHLD: "<<allChildren.count();
+            foreach(CollapsibleEffect *eff, allChildren) {
+                eff->setEnabled(false);
+            }*/
+            //delete view;
+            view->setEnabled(false);
+            view->setHidden(true);
+            view->deleteLater();
+        }
+        view = nullptr;
     }
     m_effects.clear();
     m_groupIndex = 0;
     blockSignals(false);
-    view = new QWidget(this);
-    QPalette p = qApp->palette();
-    p.setBrush(QPalette::Window, QBrush(Qt::transparent));
-    view->setPalette(p);
-    m_effect->container->setWidget(view);
+    if (!view) {
+        view = new QWidget(this);
+        QPalette p = qApp->palette();
+        p.setBrush(QPalette::Window, QBrush(Qt::transparent));
+        view->setPalette(p);
+        m_effect->container->setWidget(view);
 
-    QVBoxLayout *vbox1 = new QVBoxLayout(view);
-    vbox1->setContentsMargins(0, 0, 0, 0);
-    vbox1->setSpacing(0);
+        vbox1 = new QVBoxLayout(view);
+        vbox1->setContentsMargins(0, 0, 0, 0);
+        vbox1->setSpacing(0);
+    }
 
     int effectsCount = m_currentEffectList.count();
     m_effect->effectCompare->setEnabled(effectsCount > 0);
@@ -400,24 +437,37 @@ void EffectStackView2::setupListView()
         if (i == 0 || m_currentEffectList.at(i - 1).attribute(QStringLiteral("id")) == QLatin1String("speed")) {
             canMoveUp = false;
         }
-        CollapsibleEffect *currentEffect = new CollapsibleEffect(d, m_currentEffectList.at(i), info, &m_effectMetaInfo, canMoveUp, i == effectsCount - 1, view);
+        CollapsibleEffect *currentEffect = nullptr;
+        QMultiHash<QString, CollapsibleEffect *>::iterator unused = unusedEffects.find(d.attribute(QStringLiteral("id")));
+        if (unused != unusedEffects.end()) {
+            currentEffect = unused.value();
+            unusedEffects.erase(unused);
+            currentEffect->updateEffect(d, m_currentEffectList.at(i), info, &m_effectMetaInfo, canMoveUp, i == effectsCount - 1);
+        } else {
+            currentEffect = new CollapsibleEffect(d, m_currentEffectList.at(i), info, &m_effectMetaInfo, canMoveUp, i == effectsCount - 1, view);
+            connectEffect(currentEffect);
+        }
         isSelected = currentEffect->effectIndex() == activeEffectIndex();
+        int position = (m_effectMetaInfo.monitor->position() - (m_status == TIMELINE_CLIP ? m_clipref->startPos() : GenTime())).frames(KdenliveSettings::project_fps());
+        currentEffect->slotSyncEffectsPos(position);
+        // Activating creates the parameters of a collapsed effect, needed for its monitor scene
+        currentEffect->setActive(isSelected);
         if (isSelected) {
             m_monitorSceneWanted = currentEffect->needsMonitorEffectScene();
             selectedCollapsibleEffect = currentEffect;
             // show monitor scene if necessary
             m_effectMetaInfo.monitor->slotShowEffectScene(m_monitorSceneWanted);
         }
-        int position = (m_effectMetaInfo.monitor->position() - (m_status == TIMELINE_CLIP ? m_clipref->startPos() : GenTime())).frames(KdenliveSettings::project_fps());
-        currentEffect->slotSyncEffectsPos(position);
-        currentEffect->setActive(isSelected);
         m_effects.append(currentEffect);
         if (group) {
             group->addGroupEffect(currentEffect);
         } else {
             vbox1->addWidget(currentEffect);
         }
-        connectEffect(currentEffect);
+    }
+    for (CollapsibleEffect *effect : unusedEffects) {
+        effect->setHidden(true);
+        effect->deleteLater();
     }
 
     if (selectedCollapsibleEffect) {
@@ -145,6 +145,8 @@ private:
 
     /** @brief Sets the list of effects according to the clip's effect list. */
     void setupListView();
+    /** @brief Returns true if the displayed effect widgets can be reused for the new effect list (no groups or regions). */
+    bool canReuseEffectWidgets() const;
 
     /** @brief Build the drag info and start it. */
     void startDrag();
@@ -1193,6 +1193,98 @@ void ParameterContainer::updateParameter(const QString &key, const QString &valu
     m_effect.setAttribute(key, value);
 }
 
+bool ParameterContainer::updateValues(const QDomElement &effect, const ItemInfo &info, EffectMetaInfo *metaInfo)
+{
+    const QString id = m_effect.attribute(QStringLiteral("id"));
+    if (effect.attribute(QStringLiteral("id")) != id || id == QLatin1String("movit.lift_gamma_gain") || id == QLatin1String("lift_gamma_gain")
+        || id == QLatin1String("avfilter.selectivecolor")) {
+        return false;
+    }
+    // Conditional widgets and keyframe sync depend on the values, rebuild them
+    if (effect.hasAttribute(QStringLiteral("condition")) || effect.hasAttribute(QStringLiteral("sync_in_out"))) {
+        return false;
+    }
+    // Check that both effects have the same parameters, with widgets that can be updated
+    static const QStringList simpleTypes = QStringList() << QStringLiteral("fixed") << QStringLiteral("double") << QStringLiteral("constant") << QStringLiteral("list")
+                                           << QStringLiteral("bool") << QStringLiteral("switch") << QStringLiteral("color") << QStringLiteral("url")
+                                           << QStringLiteral("keywords") << QStringLiteral("fontfamily") << QStringLiteral("filterjob");
+    QDomElement current = m_effect.firstChildElement(QStringLiteral("parameter"));
+    QDomElement pa = effect.firstChildElement(QStringLiteral("parameter"));
+    for (; !current.isNull() && !pa.isNull(); current = current.nextSiblingElement(QStringLiteral("parameter")), pa = pa.nextSiblingElement(QStringLiteral("parameter"))) {
+        const QString type = pa.attribute(QStringLiteral("type"));
+        if (!simpleTypes.contains(type) || type != current.attribute(QStringLiteral("type")) || pa.attribute(QStringLiteral("name")) != current.attribute(QStringLiteral("name"))
+            || pa.attribute(QStringLiteral("paramlist")) != current.attribute(QStringLiteral("paramlist"))
+            || pa.attribute(QStringLiteral("min")) != current.attribute(QStringLiteral("min")) || pa.attribute(QStringLiteral("max")) != current.attribute(QStringLiteral("max"))) {
+            return false;
+        }
+        // Bounds relative to the frame size (%width, ...) depend on the clip, evaluate them again
+        if (pa.attribute(QStringLiteral("min")).contains(QLatin1Char('%')) || pa.attribute(QStringLiteral("max")).contains(QLatin1Char('%'))) {
+            return false;
+        }
+    }
+    if (!current.isNull() || !pa.isNull()) {
+        return false;
+    }
+
+    QLocale locale;
+    locale.setNumberOptions(QLocale::OmitGroupSeparator);
+    for (pa = effect.firstChildElement(QStringLiteral("parameter")); !pa.isNull(); pa = pa.nextSiblingElement(QStringLiteral("parameter"))) {
+        const QString type = pa.attribute(QStringLiteral("type"));
+        QDomElement na = pa.firstChildElement(QStringLiteral("name"));
+        QString paramName = na.isNull() ? pa.attribute(QStringLiteral("name")) : i18n(na.text().toUtf8().data());
+        QString value = pa.attribute(QStringLiteral("value")).isNull() ?
+                        pa.attribute(QStringLiteral("default")) : pa.attribute(QStringLiteral("value"));
+        QWidget *widget = m_valueItems.value(paramName);
+        if (!widget) {
+            continue;
+        }
+        // Showing the values must not be reported as a parameter change
+        if (type == QLatin1String("double") || type == QLatin1String("constant")) {
+            DoubleParameterWidget *doubleparam = static_cast<DoubleParameterWidget *>(widget);
+            QSignalBlocker blocker(doubleparam);
+            doubleparam->setValue(locale.toDouble(value));
+        } else if (type == QLatin1String("list")) {
+            ListParamWidget *lswid = static_cast<ListParamWidget *>(widget);
+            QSignalBlocker blocker(lswid);
+            if (!lswid->setValue(value)) {
+                return false;
+            }
+        } else if (type == QLatin1String("bool")) {
+            BoolParamWidget *bwid = static_cast<BoolParamWidget *>(widget);
+            QSignalBlocker blocker(bwid);
+            bwid->setValue(value.toInt() == 1);
+        } else if (type == QLatin1String("switch")) {
+            BoolParamWidget *bwid = static_cast<BoolParamWidget *>(widget);
+            QSignalBlocker blocker(bwid);
+            bwid->setValue(value == pa.attribute(QStringLiteral("max")));
+        } else if (type == QLatin1String("color")) {
+            if (pa.hasAttribute(QStringLiteral("paramprefix"))) {
+                value.remove(0, pa.attribute(QStringLiteral("paramprefix")).size());
+            }
+            if (value.startsWith('#')) {
+                value = value.replace('#', QLatin1String("0x"));
+            }
+            ChooseColorWidget *choosecolor = static_cast<ChooseColorWidget *>(widget);
+            QSignalBlocker blocker(choosecolor);
+            choosecolor->setValue(value);
+        } else if (type == QLatin1String("url")) {
+            static_cast<Urlval *>(widget)->urlwidget->setUrl(QUrl(value));
+        } else if (type == QLatin1String("keywords")) {
+            static_cast<Keywordval *>(widget)->lineeditwidget->setText(value);
+        } else if (type == QLatin1String("fontfamily")) {
+            QFontComboBox *fontfamily = static_cast<Fontval *>(widget)->fontfamilywidget;
+            QSignalBlocker blocker(fontfamily);
+            fontfamily->setCurrentFont(QFont(value));
+        }
+    }
+    m_effect = effect;
+    m_info = info;
+    m_metaInfo = metaInfo;
+    m_in = info.cropStart.frames(KdenliveSettings::project_fps());
+    m_out = (info.cropStart + info.cropDuration).frames(KdenliveSettings::project_fps()) - 1;
+    return true;
+}
+
 void ParameterContainer::slotStartFilterJobAction()
 {
     if (m_conditionParameter) {
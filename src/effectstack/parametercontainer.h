@@ -82,6 +82,9 @@ public:
     ~ParameterContainer();
     void updateTimecodeFormat();
     void updateParameter(const QString &key, const QString &value);
+    /** @brief Show the values of another instance of the effect without rebuilding the widgets.
+     *  @return false if the effect or its parameters differ, or use widgets that cannot be updated */
+    bool updateValues(const QDomElement &effect, const ItemInfo &info, EffectMetaInfo *metaInfo);
     /** @brief Returns true of this effect requires an on monitor adjustable effect scene. */
     MonitorSceneType needsMonitorEffectScene() const;
     /** @brief Set keyframes for this param. */
@@ -55,3 +55,8 @@ bool BoolParamWidget::getValue()
 {
     return m_checkBox->isChecked();
 }
+
+void BoolParamWidget::setValue(bool checked)
+{
+    m_checkBox->setChecked(checked);
+}
@@ -48,6 +48,11 @@ public:
      */
     bool getValue();
 
+    /** @brief Set the check state of the parameter
+        @param checked Boolean indicating wether the checkbox should be checked
+    */
+    void setValue(bool checked);
+
 public slots:
     /** @brief Toggle the comments on or off    */
     void slotShowComment(bool) Q_DECL_OVERRIDE;
@@ -134,6 +134,11 @@ void ChooseColorWidget::setColor(const QColor &color)
     m_button->setColor(color);
 }
 
+void ChooseColorWidget::setValue(const QString &color)
+{
+    m_button->setColor(stringToColor(color));
+}
+
 void ChooseColorWidget::slotColorModified(const QColor &color)
 {
     blockSignals(true);
@@ -47,6 +47,8 @@ public:
 
     /** @brief Gets the chosen color. */
     QString getColor() const;
+    /** @brief Sets the chosen color from its string form (see getColor). */
+    void setValue(const QString &color);
 
 private:
     KColorButton *m_button;
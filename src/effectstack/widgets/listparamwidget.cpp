@@ -79,3 +79,13 @@ QString ListParamWidget::getValue()
 {
     return m_list->itemData(m_list->currentIndex()).toString();
 }
+
+bool ListParamWidget::setValue(const QString &value)
+{
+    int index = m_list->findData(value);
+    if (index < 0) {
+        return false;
+    }
+    m_list->setCurrentIndex(index);
+    return true;
+}
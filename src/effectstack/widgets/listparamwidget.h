@@ -74,6 +74,12 @@ public:
      */
     QString getValue();
 
+    /** @brief Select the element having the given value
+        @param value Underlying value of the target element
+        @return false if no element has this value
+    */
+    bool setValue(const QString &value);
+
 public slots:
     /** @brief Toggle the comments on or off    */
     void slotShowComment(bool) Q_DECL_OVERRIDE;
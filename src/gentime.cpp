@@ -17,39 +17,46 @@
 
 #include "gentime.h"
 
-double GenTime::s_delta = 0.00001;
+const qint64 GenTime::TicksPerSecond;
 
-GenTime::GenTime()
+GenTime::GenTime() :
+    m_ticks(0)
 {
-    m_time = 0.0;
 }
 
-GenTime::GenTime(double seconds)
+GenTime::GenTime(double seconds) :
+    m_ticks(std::llround(seconds * TicksPerSecond))
 {
-    m_time = seconds;
 }
 
-GenTime::GenTime(int frames, double framesPerSecond)
+GenTime::GenTime(int frames, double framesPerSecond) :
+    m_ticks(std::llround(frames * TicksPerSecond / framesPerSecond))
 {
-    m_time = (double) frames / framesPerSecond;
+}
+
+GenTime GenTime::fromTicks(qint64 ticks)
+{
+    GenTime time;
+    time.m_ticks = ticks;
+    return time;
 }
 
 double GenTime::seconds() const
 {
-    return m_time;
+    return (double) m_ticks / TicksPerSecond;
 }
 
 double GenTime::ms() const
 {
-    return m_time * 1000;
+    return (double) m_ticks * 1000 / TicksPerSecond;
 }
 
 double GenTime::frames(double framesPerSecond) const
 {
-    return floor(m_time * framesPerSecond + 0.5);
+    return floor((double) m_ticks * framesPerSecond / TicksPerSecond + 0.5);
 }
 
 QString GenTime::toString() const
 {
-    return QStringLiteral("%1 s").arg(m_time, 0, 'f', 2);
+    return QStringLiteral("%1 s").arg(seconds(), 0, 'f', 2);
 }
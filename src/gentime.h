@@ -18,18 +18,28 @@
 #ifndef GENTIME_H
 #define GENTIME_H
 
+#include <QHash>
 #include <QString>
 #include <cmath>
 
 /**
  * @class GenTime
  * @brief Encapsulates a time, which can be set in various forms and outputted in various forms.
+ *
+ * The time is stored as an integer count of ticks of 1/TicksPerSecond second.
+ * The timebase is a multiple of the frame duration of every usual frame rate,
+ * including the 1000/1001 NTSC rates, and of the usual audio sample rates, so
+ * frame positions are represented exactly: comparisons do not need a rounding
+ * delta, and times can be hashed and sorted like integers.
  * @author Jason Wood
  */
 
 class GenTime
 {
 public:
+    /** @brief Number of ticks per second: 2^7 * 3^2 * 5^4 * 7^2, divisible by 24000, 30000, 60000, 48000 and 44100 */
+    static const qint64 TicksPerSecond = 35280000;
+
     /** @brief Creates a GenTime object, with a time of 0 seconds. */
     GenTime();
 
@@ -39,6 +49,9 @@ public:
     /** @brief Creates a GenTime object, by passing number of frames and how many frames per second. */
     GenTime(int frames, double framesPerSecond);
 
+    /** @brief Creates a GenTime object from a number of ticks. */
+    static GenTime fromTicks(qint64 ticks);
+
     /** @brief Gets the time, in seconds. */
     double seconds() const;
 
@@ -49,6 +62,12 @@ public:
     * @param framesPerSecond Number of frames per second */
     double frames(double framesPerSecond) const;
 
+    /** @brief Gets the exact time, in ticks of 1/TicksPerSecond second. */
+    qint64 ticks() const
+    {
+        return m_ticks;
+    }
+
     QString toString() const;
 
     /*
@@ -58,83 +77,85 @@ public:
     /// Unary minus
     GenTime operator -()
     {
-        return GenTime(-m_time);
+        return fromTicks(-m_ticks);
     }
 
     /// Addition
     GenTime &operator+=(GenTime op)
     {
-        m_time += op.m_time;
+        m_ticks += op.m_ticks;
         return *this;
     }
 
     /// Subtraction
     GenTime &operator-=(GenTime op)
     {
-        m_time -= op.m_time;
+        m_ticks -= op.m_ticks;
         return *this;
     }
 
     /** @brief Adds two GenTimes. */
     GenTime operator+(GenTime op) const
     {
-        return GenTime(m_time + op.m_time);
+        return fromTicks(m_ticks + op.m_ticks);
     }
 
     /** @brief Subtracts one genTime from another. */
     GenTime operator-(GenTime op) const
     {
-        return GenTime(m_time - op.m_time);
+        return fromTicks(m_ticks - op.m_ticks);
     }
 
     /** @brief Multiplies one GenTime by a double value, returning a GenTime. */
     GenTime operator*(double op) const
     {
-        return GenTime(m_time * op);
+        return fromTicks(std::llround(m_ticks * op));
     }
 
     /** @brief Divides one GenTime by a double value, returning a GenTime. */
     GenTime operator/(double op) const
     {
-        return GenTime(m_time / op);
+        return fromTicks(std::llround(m_ticks / op));
     }
 
     bool operator<(GenTime op) const
     {
-        return m_time + s_delta < op.m_time;
+        return m_ticks < op.m_ticks;
     }
 
     bool operator>(GenTime op) const
     {
-        return m_time > op.m_time + s_delta;
+        return m_ticks > op.m_ticks;
     }
 
     bool operator>=(GenTime op) const
     {
-        return m_time + s_delta >= op.m_time;
+        return m_ticks >= op.m_ticks;
     }
 
     bool operator<=(GenTime op) const
     {
-        return m_time <= op.m_time + s_delta;
+        return m_ticks <= op.m_ticks;
     }
 
     bool operator==(GenTime op) const
     {
-        return fabs(m_time - op.m_time) < s_delta;
+        return m_ticks == op.m_ticks;
     }
 
     bool operator!=(GenTime op) const
     {
-        return fabs(m_time - op.m_time) >= s_delta;
+        return m_ticks != op.m_ticks;
     }
 
 private:
-    /** Holds the time in seconds for this object. */
-    double m_time;
-
-    /** A delta value that is used to get around floating point rounding issues. */
-    static double s_delta;
+    /** Holds the time in ticks for this object. */
+    qint64 m_ticks;
 };
 
+inline uint qHash(const GenTime &time, uint seed = 0)
+{
+    return qHash(time.ticks(), seed);
+}
+
 #endif
@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "audioBlock.h"
+
+AudioBlock::AudioBlock() :
+    m_data(nullptr),
+    m_frequency(0),
+    m_channels(0),
+    m_samples(0)
+{
+}
+
+AudioBlock::AudioBlock(const SharedFrame &frame) :
+    m_data(nullptr),
+    m_frequency(0),
+    m_channels(0),
+    m_samples(0)
+{
+    if (!frame.is_valid() || frame.get_audio_format() != mlt_audio_s16) {
+        return;
+    }
+    m_data = frame.get_audio();
+    if (m_data == nullptr || frame.get_audio_samples() <= 0 || frame.get_audio_channels() <= 0) {
+        m_data = nullptr;
+        return;
+    }
+    m_frame = frame;
+    m_frequency = frame.get_audio_frequency();
+    m_channels = frame.get_audio_channels();
+    m_samples = frame.get_audio_samples();
+}
+
+AudioBlock AudioBlock::fromFrame(Mlt::Frame &frame)
+{
+    if (!frame.is_valid()) {
+        return AudioBlock();
+    }
+    // Request the frame's own layout, MLT then only converts the sample format if needed
+    mlt_audio_format format = mlt_audio_s16;
+    int frequency = frame.get_int("audio_frequency");
+    int channels = frame.get_int("audio_channels");
+    int samples = frame.get_int("audio_samples");
+    if (frame.get_audio(format, frequency, channels, samples) == nullptr) {
+        return AudioBlock();
+    }
+    return AudioBlock(SharedFrame(frame));
+}
+
+bool AudioBlock::isValid() const
+{
+    return m_data != nullptr;
+}
+
+int AudioBlock::frequency() const
+{
+    return m_frequency;
+}
+
+int AudioBlock::channels() const
+{
+    return m_channels;
+}
+
+int AudioBlock::samples() const
+{
+    return m_samples;
+}
+
+int AudioBlock::size() const
+{
+    return m_samples * m_channels;
+}
+
+const qint16 *AudioBlock::data() const
+{
+    return m_data;
+}
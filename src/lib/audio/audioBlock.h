@@ -0,0 +1,66 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef AUDIOBLOCK_H
+#define AUDIOBLOCK_H
+
+#include "monitor/scopes/sharedframe.h"
+
+#include <QMetaType>
+
+/**
+  A block of interleaved 16 bit audio samples handed to the audio scopes.
+
+  The samples are not copied: the block keeps a reference to the MLT frame
+  owning them, whose audio buffer already comes from MLT's memory pool and
+  is released with the last reference to the frame. Copying a block, or
+  queuing it through a signal, only increments that reference count, so the
+  same samples can be read by any number of scopes in any thread.
+
+  The block carries the sample rate and channel count of the frame, so
+  multichannel audio is analysed with its real layout.
+ */
+class AudioBlock
+{
+public:
+    AudioBlock();
+    /** @brief Wraps the audio of a frame, which must already hold 16 bit samples */
+    explicit AudioBlock(const SharedFrame &frame);
+    /** @brief Fetches the audio of a frame as 16 bit samples, keeping its own sample rate and channel layout */
+    static AudioBlock fromFrame(Mlt::Frame &frame);
+
+    bool isValid() const;
+    int frequency() const;
+    int channels() const;
+    /** @brief Number of samples per channel */
+    int samples() const;
+    /** @brief Number of values in the block, samples() * channels() */
+    int size() const;
+    const qint16 *data() const;
+    inline qint16 at(int index) const
+    {
+        return m_data[index];
+    }
+    inline qint16 operator[](int index) const
+    {
+        return m_data[index];
+    }
+
+private:
+    SharedFrame m_frame;
+    const qint16 *m_data;
+    int m_frequency;
+    int m_channels;
+    int m_samples;
+};
+
+Q_DECLARE_METATYPE(AudioBlock)
+
+#endif
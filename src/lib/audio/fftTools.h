@@ -13,7 +13,7 @@
 
 #include <QVector>
 #include <QHash>
-#include "../../definitions.h"
+#include "audioBlock.h"
 #include "../external/kiss_fft/tools/kiss_fftr.h"
 
 class FFTTools
@@ -54,7 +54,7 @@ public:
         * freqSpectrum has to be of size windowSize/2
         For windowType and param see the FFTTools::window() function above.
     */
-    void fftNormalized(const audioShortVector &audioFrame, const uint channel, const uint numChannels, float *freqSpectrum,
+    void fftNormalized(const AudioBlock &audioFrame, const uint channel, const uint numChannels, float *freqSpectrum,
                        const WindowType windowType, const uint windowSize, const float param = 0);
 
     /** This is linear interpolation with the special property that it preserves peaks, which is required
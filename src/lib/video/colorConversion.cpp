@@ -0,0 +1,438 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "colorConversion.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define KDENLIVE_X86_SIMD 1
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace ColorConversion
+{
+
+namespace
+{
+const int Shift = 13;
+const int Round = 1 << (Shift - 1);
+
+/* Limited range YUV to full range RGB, scaled by 2^13:
+   Y gain, V to red, U to green, V to green, U to blue. */
+struct Coefficients {
+    int y;
+    int rv;
+    int gu;
+    int gv;
+    int bu;
+};
+
+const Coefficients coefficients[2] = {
+    {9539, 13075, -3209, -6660, 16525}, // BT.601
+    {9539, 14686, -1747, -4366, 17305}  // BT.709
+};
+
+inline uint8_t clampByte(int value)
+{
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+inline int bytesPerPixel(DestFormat format)
+{
+    return (format == Rgba || format == Bgra) ? 4 : 3;
+}
+
+inline bool swapRedBlue(DestFormat format)
+{
+    return format == Bgr24 || format == Bgra;
+}
+
+inline void writePixel(uint8_t *dest, DestFormat format, const Coefficients &c, int y, int u, int v)
+{
+    y = (y - 16) * c.y;
+    u -= 128;
+    v -= 128;
+    const uint8_t r = clampByte((y + c.rv * v + Round) >> Shift);
+    const uint8_t g = clampByte((y + c.gu * u + c.gv * v + Round) >> Shift);
+    const uint8_t b = clampByte((y + c.bu * u + Round) >> Shift);
+    if (swapRedBlue(format)) {
+        dest[0] = b;
+        dest[2] = r;
+    } else {
+        dest[0] = r;
+        dest[2] = b;
+    }
+    dest[1] = g;
+    if (bytesPerPixel(format) == 4) {
+        dest[3] = 255;
+    }
+}
+
+void packedRowScalar(PackedFormat format, const uint8_t *src, DestFormat destFormat, uint8_t *dest, int x, int width, const Coefficients &c)
+{
+    const int bpp = bytesPerPixel(destFormat);
+    const int yOffset = format == Uyvy ? 1 : 0;
+    const int uOffset = format == Uyvy ? 0 : 1;
+    for (; x < width; x += 2) {
+        const uint8_t *pair = src + x * 2;
+        const int u = pair[uOffset];
+        const int v = pair[uOffset + 2];
+        writePixel(dest + x * bpp, destFormat, c, pair[yOffset], u, v);
+        if (x + 1 < width) {
+            writePixel(dest + (x + 1) * bpp, destFormat, c, pair[yOffset + 2], u, v);
+        }
+    }
+}
+
+void planarRowScalar(const uint8_t *y, const uint8_t *u, const uint8_t *v, DestFormat destFormat, uint8_t *dest, int x, int width, const Coefficients &c)
+{
+    const int bpp = bytesPerPixel(destFormat);
+    for (; x < width; ++x) {
+        writePixel(dest + x * bpp, destFormat, c, y[x], u[x / 2], v[x / 2]);
+    }
+}
+
+#ifdef KDENLIVE_X86_SIMD
+
+inline __m128i pairConstant(int low, int high)
+{
+    return _mm_set1_epi32(static_cast<int>((static_cast<uint32_t>(high) << 16) | (static_cast<uint32_t>(low) & 0xffff)));
+}
+
+/* Multiplies 8 pixels of 16 bit (y - 16, u - 128, v - 128) and returns the
+   saturated red, green and blue bytes in the low half of each register. */
+inline void convert8Sse2(__m128i y, __m128i u, __m128i v, const Coefficients &c, __m128i &r, __m128i &g, __m128i &b)
+{
+    const __m128i round = _mm_set1_epi32(Round);
+    const __m128i yv = pairConstant(c.y, c.rv);
+    const __m128i yuG = pairConstant(c.y, c.gu);
+    const __m128i vRound = pairConstant(c.gv, Round);
+    const __m128i yuB = pairConstant(c.y, c.bu);
+    const __m128i one = _mm_set1_epi16(1);
+
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y, v), yv), round);
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y, v), yv), round);
+    const __m128i r16 = _mm_packs_epi32(_mm_srai_epi32(lo, Shift), _mm_srai_epi32(hi, Shift));
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y, u), yuG), _mm_madd_epi16(_mm_unpacklo_epi16(v, one), vRound));
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y, u), yuG), _mm_madd_epi16(_mm_unpackhi_epi16(v, one), vRound));
+    const __m128i g16 = _mm_packs_epi32(_mm_srai_epi32(lo, Shift), _mm_srai_epi32(hi, Shift));
+
+    lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(y, u), yuB), round);
+    hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(y, u), yuB), round);
+    const __m128i b16 = _mm_packs_epi32(_mm_srai_epi32(lo, Shift), _mm_srai_epi32(hi, Shift));
+
+    r = _mm_packus_epi16(r16, r16);
+    g = _mm_packus_epi16(g16, g16);
+    b = _mm_packus_epi16(b16, b16);
+}
+
+inline void store8Sse2(__m128i r, __m128i g, __m128i b, DestFormat destFormat, uint8_t *dest)
+{
+    const bool swap = swapRedBlue(destFormat);
+    const __m128i first = _mm_unpacklo_epi8(swap ? b : r, g);
+    const __m128i second = _mm_unpacklo_epi8(swap ? r : b, _mm_set1_epi8(static_cast<char>(0xff)));
+    const __m128i lo = _mm_unpacklo_epi16(first, second);
+    const __m128i hi = _mm_unpackhi_epi16(first, second);
+    if (bytesPerPixel(destFormat) == 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 16), hi);
+        return;
+    }
+    // SSE2 has no byte shuffle, drop the alpha bytes in scalar code
+    uint8_t buffer[32];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer + 16), hi);
+    for (int i = 0; i < 8; ++i) {
+        memcpy(dest + i * 3, buffer + i * 4, 3);
+    }
+}
+
+void convertPackedSse2(PackedFormat format, const uint8_t *src, int srcStride, DestFormat destFormat, uint8_t *dest, int destStride, int width, int height, const Coefficients &c)
+{
+    const int bpp = bytesPerPixel(destFormat);
+    const __m128i lowBytes = _mm_set1_epi16(0xff);
+    const __m128i yOffset = _mm_set1_epi16(16);
+    const __m128i uvOffset = _mm_set1_epi16(128);
+    const int simdWidth = width & ~7;
+    for (int row = 0; row < height; ++row) {
+        const uint8_t *s = src + row * srcStride;
+        uint8_t *d = dest + row * destStride;
+        for (int x = 0; x < simdWidth; x += 8) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + x * 2));
+            __m128i y;
+            __m128i uv;
+            if (format == Uyvy) {
+                y = _mm_srli_epi16(pixels, 8);
+                uv = _mm_and_si128(pixels, lowBytes);
+            } else {
+                y = _mm_and_si128(pixels, lowBytes);
+                uv = _mm_srli_epi16(pixels, 8);
+            }
+            // uv holds u0 v0 u1 v1 ..., duplicate each chroma sample for its 2 pixels
+            __m128i u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+            __m128i v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+            __m128i r, g, b;
+            convert8Sse2(_mm_sub_epi16(y, yOffset), _mm_sub_epi16(u, uvOffset), _mm_sub_epi16(v, uvOffset), c, r, g, b);
+            store8Sse2(r, g, b, destFormat, d + x * bpp);
+        }
+        packedRowScalar(format, s, destFormat, d, simdWidth, width, c);
+    }
+}
+
+void convertYuv420pSse2(const uint8_t *y, int yStride, const uint8_t *u, int uStride, const uint8_t *v, int vStride, DestFormat destFormat, uint8_t *dest,
+                        int destStride, int width, int height, const Coefficients &c)
+{
+    const int bpp = bytesPerPixel(destFormat);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yOffset = _mm_set1_epi16(16);
+    const __m128i uvOffset = _mm_set1_epi16(128);
+    const int simdWidth = width & ~7;
+    for (int row = 0; row < height; ++row) {
+        const uint8_t *ys = y + row * yStride;
+        const uint8_t *us = u + (row / 2) * uStride;
+        const uint8_t *vs = v + (row / 2) * vStride;
+        uint8_t *d = dest + row * destStride;
+        for (int x = 0; x < simdWidth; x += 8) {
+            int32_t chroma;
+            const __m128i luma = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(ys + x)), zero);
+            memcpy(&chroma, us + x / 2, 4);
+            __m128i uu = _mm_cvtsi32_si128(chroma);
+            memcpy(&chroma, vs + x / 2, 4);
+            __m128i vv = _mm_cvtsi32_si128(chroma);
+            uu = _mm_unpacklo_epi8(_mm_unpacklo_epi8(uu, uu), zero);
+            vv = _mm_unpacklo_epi8(_mm_unpacklo_epi8(vv, vv), zero);
+            __m128i r, g, b;
+            convert8Sse2(_mm_sub_epi16(luma, yOffset), _mm_sub_epi16(uu, uvOffset), _mm_sub_epi16(vv, uvOffset), c, r, g, b);
+            store8Sse2(r, g, b, destFormat, d + x * bpp);
+        }
+        planarRowScalar(ys, us, vs, destFormat, d, simdWidth, width, c);
+    }
+}
+
+AVX2_TARGET inline __m256i pairConstant256(int low, int high)
+{
+    return _mm256_set1_epi32(static_cast<int>((static_cast<uint32_t>(high) << 16) | (static_cast<uint32_t>(low) & 0xffff)));
+}
+
+/* Same as convert8Sse2 on 16 pixels. Each 128 bit lane holds 8 pixels and
+   the result bytes are in the low half of each lane. */
+AVX2_TARGET inline void convert16Avx2(__m256i y, __m256i u, __m256i v, const Coefficients &c, __m256i &r, __m256i &g, __m256i &b)
+{
+    const __m256i round = _mm256_set1_epi32(Round);
+    const __m256i yv = pairConstant256(c.y, c.rv);
+    const __m256i yuG = pairConstant256(c.y, c.gu);
+    const __m256i vRound = pairConstant256(c.gv, Round);
+    const __m256i yuB = pairConstant256(c.y, c.bu);
+    const __m256i one = _mm256_set1_epi16(1);
+
+    __m256i lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(y, v), yv), round);
+    __m256i hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(y, v), yv), round);
+    const __m256i r16 = _mm256_packs_epi32(_mm256_srai_epi32(lo, Shift), _mm256_srai_epi32(hi, Shift));
+
+    lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(y, u), yuG), _mm256_madd_epi16(_mm256_unpacklo_epi16(v, one), vRound));
+    hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(y, u), yuG), _mm256_madd_epi16(_mm256_unpackhi_epi16(v, one), vRound));
+    const __m256i g16 = _mm256_packs_epi32(_mm256_srai_epi32(lo, Shift), _mm256_srai_epi32(hi, Shift));
+
+    lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(y, u), yuB), round);
+    hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(y, u), yuB), round);
+    const __m256i b16 = _mm256_packs_epi32(_mm256_srai_epi32(lo, Shift), _mm256_srai_epi32(hi, Shift));
+
+    r = _mm256_packus_epi16(r16, r16);
+    g = _mm256_packus_epi16(g16, g16);
+    b = _mm256_packus_epi16(b16, b16);
+}
+
+AVX2_TARGET inline void store16Avx2(__m256i r, __m256i g, __m256i b, DestFormat destFormat, uint8_t *dest)
+{
+    const bool swap = swapRedBlue(destFormat);
+    const __m256i first = _mm256_unpacklo_epi8(swap ? b : r, g);
+    const __m256i second = _mm256_unpacklo_epi8(swap ? r : b, _mm256_set1_epi8(static_cast<char>(0xff)));
+    const __m256i lo = _mm256_unpacklo_epi16(first, second);
+    const __m256i hi = _mm256_unpackhi_epi16(first, second);
+    // lo holds pixels 0-3 and 8-11, hi pixels 4-7 and 12-15
+    const __m256i pixels0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+    const __m256i pixels8 = _mm256_permute2x128_si256(lo, hi, 0x31);
+    if (bytesPerPixel(destFormat) == 4) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), pixels0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + 32), pixels8);
+        return;
+    }
+    // Pack each lane of 4 pixels to 12 bytes, the last 4 bytes are overwritten by the next store
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256i packed0 = _mm256_shuffle_epi8(pixels0, pack);
+    const __m256i packed8 = _mm256_shuffle_epi8(pixels8, pack);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm256_castsi256_si128(packed0));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 12), _mm256_extracti128_si256(packed0, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 24), _mm256_castsi256_si128(packed8));
+    const __m128i last = _mm256_extracti128_si256(packed8, 1);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dest + 36), last);
+    const int32_t tail = _mm_cvtsi128_si32(_mm_srli_si128(last, 8));
+    memcpy(dest + 44, &tail, 4);
+}
+
+AVX2_TARGET void convertPackedAvx2(PackedFormat format, const uint8_t *src, int srcStride, DestFormat destFormat, uint8_t *dest, int destStride, int width, int height,
+                                   const Coefficients &c)
+{
+    const int bpp = bytesPerPixel(destFormat);
+    const __m256i lowBytes = _mm256_set1_epi16(0xff);
+    const __m256i yOffset = _mm256_set1_epi16(16);
+    const __m256i uvOffset = _mm256_set1_epi16(128);
+    const int simdWidth = width & ~15;
+    for (int row = 0; row < height; ++row) {
+        const uint8_t *s = src + row * srcStride;
+        uint8_t *d = dest + row * destStride;
+        for (int x = 0; x < simdWidth; x += 16) {
+            const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x * 2));
+            __m256i y;
+            __m256i uv;
+            if (format == Uyvy) {
+                y = _mm256_srli_epi16(pixels, 8);
+                uv = _mm256_and_si256(pixels, lowBytes);
+            } else {
+                y = _mm256_and_si256(pixels, lowBytes);
+                uv = _mm256_srli_epi16(pixels, 8);
+            }
+            __m256i u = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+            __m256i v = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+            __m256i r, g, b;
+            convert16Avx2(_mm256_sub_epi16(y, yOffset), _mm256_sub_epi16(u, uvOffset), _mm256_sub_epi16(v, uvOffset), c, r, g, b);
+            store16Avx2(r, g, b, destFormat, d + x * bpp);
+        }
+        packedRowScalar(format, s, destFormat, d, simdWidth, width, c);
+    }
+}
+
+AVX2_TARGET void convertYuv420pAvx2(const uint8_t *y, int yStride, const uint8_t *u, int uStride, const uint8_t *v, int vStride, DestFormat destFormat, uint8_t *dest,
+                                    int destStride, int width, int height, const Coefficients &c)
+{
+    const int bpp = bytesPerPixel(destFormat);
+    const __m256i yOffset = _mm256_set1_epi16(16);
+    const __m256i uvOffset = _mm256_set1_epi16(128);
+    const int simdWidth = width & ~15;
+    for (int row = 0; row < height; ++row) {
+        const uint8_t *ys = y + row * yStride;
+        const uint8_t *us = u + (row / 2) * uStride;
+        const uint8_t *vs = v + (row / 2) * vStride;
+        uint8_t *d = dest + row * destStride;
+        for (int x = 0; x < simdWidth; x += 16) {
+            const __m256i luma = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ys + x)));
+            __m128i uu = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(us + x / 2));
+            __m128i vv = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(vs + x / 2));
+            const __m256i u16 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(uu, uu));
+            const __m256i v16 = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(vv, vv));
+            __m256i r, g, b;
+            convert16Avx2(_mm256_sub_epi16(luma, yOffset), _mm256_sub_epi16(u16, uvOffset), _mm256_sub_epi16(v16, uvOffset), c, r, g, b);
+            store16Avx2(r, g, b, destFormat, d + x * bpp);
+        }
+        planarRowScalar(ys, us, vs, destFormat, d, simdWidth, width, c);
+    }
+}
+
+#endif
+
+Implementation resolve(Implementation implementation)
+{
+    if (implementation == Auto || !isSupported(implementation)) {
+        return bestImplementation();
+    }
+    return implementation;
+}
+
+} // namespace
+
+Implementation bestImplementation()
+{
+#ifdef KDENLIVE_X86_SIMD
+    static const Implementation best = __builtin_cpu_supports("avx2") ? Avx2 : Sse2;
+    return best;
+#else
+    return Scalar;
+#endif
+}
+
+bool isSupported(Implementation implementation)
+{
+    switch (implementation) {
+    case Auto:
+    case Scalar:
+        return true;
+#ifdef KDENLIVE_X86_SIMD
+    case Sse2:
+        return true;
+    case Avx2:
+        return bestImplementation() == Avx2;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *implementationName(Implementation implementation)
+{
+    switch (resolve(implementation)) {
+    case Sse2:
+        return "SSE2";
+    case Avx2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+Matrix matrixForColorspace(int colorspace)
+{
+    return colorspace == 709 ? Rec709 : Rec601;
+}
+
+void convertPacked(PackedFormat format, const uint8_t *src, int srcStride, DestFormat destFormat, uint8_t *dest, int destStride, int width, int height, Matrix matrix,
+                   Implementation implementation)
+{
+    const Coefficients &c = coefficients[matrix];
+    switch (resolve(implementation)) {
+#ifdef KDENLIVE_X86_SIMD
+    case Avx2:
+        convertPackedAvx2(format, src, srcStride, destFormat, dest, destStride, width, height, c);
+        return;
+    case Sse2:
+        convertPackedSse2(format, src, srcStride, destFormat, dest, destStride, width, height, c);
+        return;
+#endif
+    default:
+        for (int row = 0; row < height; ++row) {
+            packedRowScalar(format, src + row * srcStride, destFormat, dest + row * destStride, 0, width, c);
+        }
+    }
+}
+
+void convertYuv420p(const uint8_t *y, int yStride, const uint8_t *u, int uStride, const uint8_t *v, int vStride, DestFormat destFormat, uint8_t *dest, int destStride,
+                    int width, int height, Matrix matrix, Implementation implementation)
+{
+    const Coefficients &c = coefficients[matrix];
+    switch (resolve(implementation)) {
+#ifdef KDENLIVE_X86_SIMD
+    case Avx2:
+        convertYuv420pAvx2(y, yStride, u, uStride, v, vStride, destFormat, dest, destStride, width, height, c);
+        return;
+    case Sse2:
+        convertYuv420pSse2(y, yStride, u, uStride, v, vStride, destFormat, dest, destStride, width, height, c);
+        return;
+#endif
+    default:
+        for (int row = 0; row < height; ++row) {
+            planarRowScalar(y + row * yStride, u + (row / 2) * uStride, v + (row / 2) * vStride, destFormat, dest + row * destStride, 0, width, c);
+        }
+    }
+}
+
+} // namespace ColorConversion
@@ -0,0 +1,75 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef COLORCONVERSION_H
+#define COLORCONVERSION_H
+
+#include <cstdint>
+
+/**
+  Conversion of limited range YUV images to 8 bit RGB.
+
+  All implementations use the same fixed point arithmetic (13 bit
+  coefficients, 32 bit accumulators), so the SSE2 and AVX2 kernels
+  produce exactly the same bytes as the scalar one. The fastest
+  implementation supported by the running CPU is picked unless one is
+  requested explicitly, which is only useful for benchmarks and checks.
+
+  Rows are independent: widths do not need to be a multiple of the
+  vector size, the remaining pixels of each row go through the scalar
+  code. With an odd width, packed rows still hold whole pixel pairs and
+  chroma planes hold (width + 1) / 2 samples per row.
+ */
+namespace ColorConversion
+{
+enum Matrix {
+    Rec601 = 0,
+    Rec709
+};
+
+/** @brief 4:2:2 packed layouts. MLT's mlt_image_yuv422 is Yuyv. */
+enum PackedFormat {
+    Uyvy = 0,
+    Yuyv
+};
+
+/** @brief Destination byte order. Bgra matches QImage::Format_RGB32 on little endian machines. */
+enum DestFormat {
+    Rgb24 = 0,
+    Rgba,
+    Bgr24,
+    Bgra
+};
+
+enum Implementation {
+    Auto = 0,
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+/** @brief Returns the fastest implementation usable on this CPU. */
+Implementation bestImplementation();
+bool isSupported(Implementation implementation);
+const char *implementationName(Implementation implementation);
+
+/** @brief Returns the matrix matching an MLT profile colorspace (601, 709). */
+Matrix matrixForColorspace(int colorspace);
+
+/** @brief Converts a 4:2:2 packed image. Strides are in bytes. */
+void convertPacked(PackedFormat format, const uint8_t *src, int srcStride, DestFormat destFormat, uint8_t *dest, int destStride, int width, int height,
+                   Matrix matrix = Rec601, Implementation implementation = Auto);
+
+/** @brief Converts a 4:2:0 planar image. Chroma planes have half the width and height of the luma plane. */
+void convertYuv420p(const uint8_t *y, int yStride, const uint8_t *u, int uStride, const uint8_t *v, int vStride, DestFormat destFormat, uint8_t *dest,
+                    int destStride, int width, int height, Matrix matrix = Rec601, Implementation implementation = Auto);
+}
+
+#endif
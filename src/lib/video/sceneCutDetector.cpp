@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "sceneCutDetector.h"
+
+#include <mlt++/Mlt.h>
+#include <cstdlib>
+
+SceneCutDetector::SceneCutDetector(double threshold, int minSceneLength) :
+    m_threshold(threshold),
+    m_minSceneLength(minSceneLength),
+    m_sceneLength(0),
+    m_isCut(false),
+    m_hasPrevious(false),
+    m_histogram(HistogramBins, 0),
+    m_previousHistogram(HistogramBins, 0),
+    m_grid(GridSize * GridSize, 0),
+    m_previousGrid(GridSize * GridSize, 0)
+{
+}
+
+void SceneCutDetector::setThreshold(double threshold)
+{
+    m_threshold = threshold;
+}
+
+double SceneCutDetector::threshold() const
+{
+    return m_threshold;
+}
+
+void SceneCutDetector::setMinSceneLength(int frames)
+{
+    m_minSceneLength = frames;
+}
+
+void SceneCutDetector::reset()
+{
+    m_hasPrevious = false;
+    m_isCut = false;
+    m_sceneLength = 0;
+}
+
+bool SceneCutDetector::isCut() const
+{
+    return m_isCut;
+}
+
+double SceneCutDetector::addFrame(const uchar *luma, int width, int height, int lumaStep, int stride)
+{
+    m_isCut = false;
+    if (luma == nullptr || width < GridSize || height < GridSize) {
+        return -1;
+    }
+    m_histogram.swap(m_previousHistogram);
+    m_grid.swap(m_previousGrid);
+    m_histogram.fill(0);
+    m_grid.fill(0);
+    int *histogram = m_histogram.data();
+    int *grid = m_grid.data();
+    // Every second line and column is enough to classify a frame
+    for (int y = 0; y < height; y += 2) {
+        const uchar *line = luma + y * stride;
+        int *gridLine = grid + (y * GridSize / height) * GridSize;
+        for (int x = 0; x < width; x += 2) {
+            const int value = line[x * lumaStep];
+            histogram[value * HistogramBins / 256]++;
+            gridLine[x * GridSize / width] += value;
+        }
+    }
+    const int samples = ((height + 1) / 2) * ((width + 1) / 2);
+    // Turn block sums into averages
+    const int blockSamples = qMax(1, samples / (GridSize * GridSize));
+    for (int i = 0; i < GridSize * GridSize; ++i) {
+        grid[i] /= blockSamples;
+    }
+    if (!m_hasPrevious) {
+        m_hasPrevious = true;
+        // No known cut before this frame, so the next one may already start a scene
+        m_sceneLength = m_minSceneLength;
+        return -1;
+    }
+    const int *previousHistogram = m_previousHistogram.constData();
+    const int *previousGrid = m_previousGrid.constData();
+    int histogramDiff = 0;
+    for (int i = 0; i < HistogramBins; ++i) {
+        histogramDiff += abs(histogram[i] - previousHistogram[i]);
+    }
+    int sad = 0;
+    for (int i = 0; i < GridSize * GridSize; ++i) {
+        sad += abs(grid[i] - previousGrid[i]);
+    }
+    // Histogram difference is at most 2 * samples, block SAD at most 255 per block
+    const double score = (histogramDiff / (2.0 * samples) + sad / (255.0 * GridSize * GridSize)) / 2;
+    m_sceneLength++;
+    if (score >= m_threshold && m_sceneLength >= m_minSceneLength) {
+        m_isCut = true;
+        m_sceneLength = 0;
+    }
+    return score;
+}
+
+QVector<int> SceneCutDetector::analyse(Mlt::Producer &producer, int in, int out, const FrameCallback &callback)
+{
+    QVector<int> cuts;
+    reset();
+    producer.set_speed(0);
+    for (int pos = in; pos <= out; ++pos) {
+        producer.seek(pos);
+        Mlt::Frame *frame = producer.get_frame();
+        if (frame == nullptr || !frame->is_valid()) {
+            delete frame;
+            break;
+        }
+        // We only need a rough picture, use the fastest scaling and deinterlacing
+        frame->set("rescale.interp", "nearest");
+        frame->set("deinterlace_method", "onefield");
+        mlt_image_format format = mlt_image_yuv422;
+        int width = 0;
+        int height = 0;
+        const uchar *image = frame->get_image(format, width, height);
+        double score = -1;
+        if (image != nullptr && format == mlt_image_yuv422) {
+            score = addFrame(image, width, height, 2, width * 2);
+        } else {
+            reset();
+        }
+        delete frame;
+        if (m_isCut) {
+            cuts << pos;
+        }
+        if (callback && !callback(pos, m_isCut, score)) {
+            break;
+        }
+    }
+    return cuts;
+}
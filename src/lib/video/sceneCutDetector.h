@@ -0,0 +1,83 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef SCENECUTDETECTOR_H
+#define SCENECUTDETECTOR_H
+
+#include <QVector>
+#include <functional>
+
+namespace Mlt
+{
+class Producer;
+}
+
+/**
+  Detects hard cuts between consecutive frames.
+
+  Each frame is reduced to a luma histogram and a small grid of
+  block averages. The score of a frame is the mean of the normalized
+  histogram difference and the normalized block SAD against the
+  previous frame, so it stays in the 0..1 range. A cut is reported
+  when the score reaches the threshold and the previous cut is at
+  least minSceneLength frames away.
+  */
+class SceneCutDetector
+{
+public:
+    /// Number of luma histogram bins
+    static const int HistogramBins = 32;
+    /// The block grid is GridSize x GridSize
+    static const int GridSize = 16;
+
+    explicit SceneCutDetector(double threshold = 0.3, int minSceneLength = 12);
+
+    void setThreshold(double threshold);
+    double threshold() const;
+    void setMinSceneLength(int frames);
+
+    /// Forget the previous frame, the next frame will not be compared.
+    void reset();
+
+    /**
+      Analyses a frame. luma points to the first luma sample, lumaStep is the
+      distance in bytes between two luma samples of a line (2 for packed yuv422,
+      1 for planar formats) and stride the distance between two lines.
+      Returns the cut score against the previous frame, or -1 if there was none.
+      */
+    double addFrame(const uchar *luma, int width, int height, int lumaStep, int stride);
+
+    /// Returns true if the last frame passed to addFrame starts a new scene.
+    bool isCut() const;
+
+    /// Called for each analysed frame, return false to stop processing.
+    typedef std::function<bool(int position, bool cut, double score)> FrameCallback;
+
+    /**
+      Fetches and analyses frames [in, out] of producer, whose profile should
+      have a small frame size for speed. Returns the detected cuts as frame
+      positions; frame in is only used as reference and never reported.
+      */
+    QVector<int> analyse(Mlt::Producer &producer, int in, int out, const FrameCallback &callback = FrameCallback());
+
+private:
+    double m_threshold;
+    int m_minSceneLength;
+    /// Frames since the last cut, or since reset()
+    int m_sceneLength;
+    bool m_isCut;
+    bool m_hasPrevious;
+    QVector<int> m_histogram;
+    QVector<int> m_previousHistogram;
+    QVector<int> m_grid;
+    QVector<int> m_previousGrid;
+};
+
+#endif // SCENECUTDETECTOR_H
@@ -111,6 +111,8 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QScreen>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 static const char version[] = KDENLIVE_VERSION;
 namespace Mlt
@@ -140,6 +142,21 @@ static QString defaultStyle(const char *fallback = nullptr)
     return cg.readEntry("widgetStyle", fallback);
 }
 
+// stem files are named after their track, make sure two stems never share a file
+static QString uniqueStemName(const QStringList &names, const QString &name)
+{
+    QStringList fileNames;
+    for (const QString &existing : names) {
+        fileNames << QString(existing).replace(QLatin1Char(' '), QLatin1Char('_'));
+    }
+    QString result = name;
+    int suffix = 2;
+    while (fileNames.contains(QString(result).replace(QLatin1Char(' '), QLatin1Char('_')), Qt::CaseInsensitive)) {
+        result = name + QLatin1Char('_') + QString::number(suffix++);
+    }
+    return result;
+}
+
 MainWindow::MainWindow(QWidget *parent) :
     KXmlGuiWindow(parent),
     m_timelineArea(nullptr),
@@ -1849,6 +1866,13 @@ void MainWindow::setRenderingProgress(const QString &url, int progress)
     }
 }
 
+void MainWindow::setRenderingStats(const QString &url, const QString &stats)
+{
+    if (m_renderWidget) {
+        m_renderWidget->setRenderStats(url, QJsonDocument::fromJson(stats.toUtf8()).object());
+    }
+}
+
 void MainWindow::setRenderingFinished(const QString &url, int status, const QString &error)
 {
     emit setRenderProgress(100);
@@ -2173,6 +2197,9 @@ void MainWindow::updateConfiguration()
         pCore->projectManager()->currentTimeline()->projectView()->checkAutoScroll();
         pCore->projectManager()->currentTimeline()->checkTrackHeight();
     }
+    if (pCore->projectManager()->current()) {
+        pCore->projectManager()->current()->commandStack()->setMemoryBudget((qint64) KdenliveSettings::undo_memorybudget() * 1024 * 1024);
+    }
     m_buttonAudioThumbs->setChecked(KdenliveSettings::audiothumbnails());
     m_buttonVideoThumbs->setChecked(KdenliveSettings::videothumbnails());
     m_buttonShowMarkers->setChecked(KdenliveSettings::showmarkers());
@@ -3230,18 +3257,11 @@ void MainWindow::buildDynamicActions()
         }
         delete filter;
     }
-    filter = Mlt::Factory::filter(profile, (char*)"motion_est");
-    if (filter) {
-        if (filter->is_valid()) {
-            QAction *action = new QAction(i18n("Automatic scene split"), m_extraFactory->actionCollection());
-            QStringList stabJob;
-            stabJob << QString::number((int) AbstractClipJob::FILTERCLIPJOB) << QStringLiteral("motion_est");
-            action->setData(stabJob);
-            ts->addAction(action->text(), action);
-            connect(action, &QAction::triggered, pCore->bin(), &Bin::slotStartClipJob);
-        }
-        delete filter;
-    }
+    // Scene detection decodes frames itself and does not depend on an MLT filter
+    QAction *sceneAction = new QAction(i18n("Automatic scene split"), m_extraFactory->actionCollection());
+    sceneAction->setData(QStringList() << QString::number((int) AbstractClipJob::SCENEDETECTJOB));
+    ts->addAction(sceneAction->text(), sceneAction);
+    connect(sceneAction, &QAction::triggered, pCore->bin(), &Bin::slotStartClipJob);
     if (KdenliveSettings::producerslist().contains(QStringLiteral("timewarp"))) {
         QAction *action = new QAction(i18n("Duplicate clip with speed change"), m_extraFactory->actionCollection());
         QStringList stabJob;
@@ -3572,24 +3592,51 @@ void MainWindow::slotPrepareRendering(bool scriptExport, bool zoneOnly, const QS
             // add only tracks to render list that are not muted and have audio
             if (track && !track->info().isMute && track->hasAudio()) {
                 QDomDocument docCopy = doc.cloneNode(true).toDocument();
-                QString trackName = track->info().trackName;
+                QString trackName = uniqueStemName(trackNames, track->info().trackName);
 
                 // save track name
                 trackNames << trackName;
                 qCDebug(KDENLIVE_LOG) << "Track-Name: " << trackName;
 
                 // create stem export doc content
+                QMap<QString, QDomElement> playlistElements;
+                QDomNodeList playlistNodes = docCopy.elementsByTagName(QStringLiteral("playlist"));
+                for (int j = 0; j < playlistNodes.count(); j++) {
+                    QDomElement pl = playlistNodes.at(j).toElement();
+                    playlistElements.insert(pl.attribute(QStringLiteral("id")), pl);
+                }
                 QDomNodeList tracks = docCopy.elementsByTagName(QStringLiteral("track"));
                 for (int j = 0; j < allTracksCount; j++) {
                     if (j != i) {
                         // mute other tracks
-                        tracks.at(j).toElement().setAttribute(QStringLiteral("hide"), QStringLiteral("both"));
+                        QDomElement trackElement = tracks.at(j).toElement();
+                        trackElement.setAttribute(QStringLiteral("hide"), QStringLiteral("both"));
+                        if (j == 0) {
+                            // keep the black track, it defines the project length so that all stems line up
+                            continue;
+                        }
+                        // and empty them so that each stem only decodes its own sources
+                        QDomElement pl = playlistElements.value(trackElement.attribute(QStringLiteral("producer")));
+                        QDomElement child = pl.firstChildElement();
+                        while (!child.isNull()) {
+                            QDomElement next = child.nextSiblingElement();
+                            if (child.tagName() != QLatin1String("property")) {
+                                pl.removeChild(child);
+                            }
+                            child = next;
+                        }
                     }
                 }
                 docList << docCopy;
                 tracksCount++;
             }
         }
+        if (tracksCount > 0 && m_renderWidget->isStemFullMixEnabled()) {
+            // The unmodified document renders the mix of all tracks
+            trackNames << uniqueStemName(trackNames, i18nc("Name of the stem file containing all tracks", "mix"));
+            docList << doc;
+            tracksCount++;
+        }
     } else {
         docList << doc;
     }
@@ -0,0 +1,144 @@
+/*
+Copyright (C) 2018  Jean-Baptiste Mardelle <jb@kdenlive.org>
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "timelineeditbatch.h"
+
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QVector>
+
+TimelineEditBatch::TimelineEditBatch(Mlt::Tractor &tractor) :
+    m_tractor(tractor),
+    m_indexed(false)
+{
+}
+
+void TimelineEditBatch::shiftTrack(int track, int position, int duration)
+{
+    if (duration != 0) {
+        m_trackShifts.insert(track, {position, duration});
+    }
+}
+
+void TimelineEditBatch::shiftTransitions(int track, int position, int duration)
+{
+    if (duration != 0) {
+        m_transitionShifts.insert(track, {position, duration});
+    }
+}
+
+bool TimelineEditBatch::isEmpty() const
+{
+    return m_trackShifts.isEmpty() && m_transitionShifts.isEmpty();
+}
+
+void TimelineEditBatch::buildTransitionIndex()
+{
+    m_indexed = true;
+    mlt_service nextservice = mlt_service_get_producer(m_tractor.get_service());
+    while (nextservice != nullptr) {
+        mlt_properties properties = MLT_SERVICE_PROPERTIES(nextservice);
+        if (qstrcmp(mlt_properties_get(properties, "mlt_type"), "transition") != 0) {
+            break;
+        }
+        if (qstrcmp(mlt_properties_get(properties, "mlt_service"), "mix") != 0) {
+            mlt_transition tr = (mlt_transition) nextservice;
+            m_transitions.insert(mlt_transition_get_b_track(tr), {tr, (int) mlt_transition_get_in(tr), (int) mlt_transition_get_out(tr)});
+        }
+        nextservice = mlt_service_producer(nextservice);
+    }
+}
+
+qint64 TimelineEditBatch::apply()
+{
+    struct PlaylistEdit {
+        QSharedPointer<Mlt::Playlist> playlist;
+        int clipIndex;
+        int position;
+        int duration;
+        bool removeClip;
+    };
+
+    // Resolve everything before locking, the tractor is only read here
+    QVector<PlaylistEdit> playlistEdits;
+    playlistEdits.reserve(m_trackShifts.count());
+    for (auto it = m_trackShifts.constBegin(); it != m_trackShifts.constEnd(); ++it) {
+        QScopedPointer<Mlt::Producer> trackProducer(m_tractor.track(it.key()));
+        if (!trackProducer || !trackProducer->is_valid()) {
+            continue;
+        }
+        PlaylistEdit edit;
+        edit.playlist.reset(new Mlt::Playlist((mlt_playlist) trackProducer->get_service()));
+        edit.duration = it->duration;
+        edit.clipIndex = edit.playlist->get_clip_index_at(it->position);
+        edit.position = it->position;
+        edit.removeClip = false;
+        if (edit.duration < 0) {
+            if (!edit.playlist->is_blank(edit.clipIndex)) {
+                edit.clipIndex--;
+            }
+            edit.position = edit.playlist->clip_start(edit.clipIndex);
+            edit.removeClip = edit.playlist->clip_length(edit.clipIndex) + edit.duration == 0;
+        }
+        playlistEdits << edit;
+    }
+    QVector<TransitionInfo> transitionEdits;
+    if (!m_transitionShifts.isEmpty()) {
+        if (!m_indexed) {
+            buildTransitionIndex();
+        }
+        for (auto it = m_transitionShifts.constBegin(); it != m_transitionShifts.constEnd(); ++it) {
+            for (auto tr = m_transitions.find(it.key()); tr != m_transitions.end() && tr.key() == it.key(); ++tr) {
+                if (tr->out > it->position) {
+                    // The index keeps the positions the transition will have once applied
+                    tr->in += it->duration;
+                    tr->out += it->duration;
+                    transitionEdits.append(*tr);
+                }
+            }
+        }
+    }
+    m_trackShifts.clear();
+    m_transitionShifts.clear();
+    if (playlistEdits.isEmpty() && transitionEdits.isEmpty()) {
+        return 0;
+    }
+
+    QElapsedTimer lockTimer;
+    lockTimer.start();
+    m_tractor.lock();
+    for (const PlaylistEdit &edit : playlistEdits) {
+        if (edit.duration > 0) {
+            edit.playlist->insert_blank(edit.clipIndex, edit.duration - 1);
+        } else if (edit.removeClip) {
+            edit.playlist->remove(edit.clipIndex);
+        } else {
+            edit.playlist->remove_region(edit.position, -edit.duration);
+        }
+        edit.playlist->consolidate_blanks(0);
+    }
+    for (const TransitionInfo &info : transitionEdits) {
+        mlt_transition_set_in_and_out(info.transition, info.in, info.out);
+    }
+    m_tractor.unlock();
+    return lockTimer.nsecsElapsed() / 1000;
+}
@@ -0,0 +1,75 @@
+/*
+Copyright (C) 2018  Jean-Baptiste Mardelle <jb@kdenlive.org>
+This file is part of Kdenlive. See www.kdenlive.org.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of
+the License or (at your option) version 3 or any later version
+accepted by the membership of KDE e.V. (or its successor approved
+by the membership of KDE e.V.), which shall act as a proxy
+defined in Section 14 of version 3 of the license.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMELINEEDITBATCH_H
+#define TIMELINEEDITBATCH_H
+
+#include <mlt++/Mlt.h>
+#include <QMap>
+#include <QMultiHash>
+
+/**
+ * @class TimelineEditBatch
+ * @brief Collects space insertions and removals on the tracks of a tractor and applies them in one locked pass.
+ *
+ * Queued edits are resolved to playlist indexes and the transitions to move are
+ * looked up in an index of the tractor's transitions before taking the service
+ * lock, so that the lock is only held while the playlists and transitions are
+ * actually modified. The index is built by the first apply() moving transitions
+ * and kept up to date by the following ones. The caller must be the only thread
+ * modifying the tractor during the batch lifetime.
+ */
+
+class TimelineEditBatch
+{
+public:
+    explicit TimelineEditBatch(Mlt::Tractor &tractor);
+
+    /** @brief Queue the insertion (duration > 0) or removal (duration < 0) of blank space at position in a track
+     *  Only one shift is kept per track, a new one replaces the previous. */
+    void shiftTrack(int track, int position, int duration);
+    /** @brief Queue moving by duration the transitions of a track (b track) that end after position */
+    void shiftTransitions(int track, int position, int duration);
+    bool isEmpty() const;
+    /** @brief Apply the queued edits and clear the queue. Returns the time the service was locked, in microseconds */
+    qint64 apply();
+
+private:
+    struct Shift {
+        int position;
+        int duration;
+    };
+    struct TransitionInfo {
+        mlt_transition transition;
+        int in;
+        int out;
+    };
+    Mlt::Tractor &m_tractor;
+    QMap<int, Shift> m_trackShifts;
+    QMap<int, Shift> m_transitionShifts;
+    /** @brief Index of the tractor's transitions by b track, mix transitions are left out */
+    QMultiHash<int, TransitionInfo> m_transitions;
+    bool m_indexed;
+
+    void buildTransitionIndex();
+};
+
+#endif
@@ -21,6 +21,7 @@
 #define ABSTRACTMONITOR_H
 
 #include "definitions.h"
+#include "lib/audio/audioBlock.h"
 
 #include <stdint.h>
 
@@ -71,7 +72,7 @@ signals:
     void frameUpdated(const QImage &);
 
     /** @brief This signal contains the audio of the current frame. */
-    void audioSamplesSignal(const audioShortVector &, int, int, int);
+    void audioSamplesSignal(const AudioBlock &);
     /** @brief Scopes are ready to receive a new frame. */
     void scopesClear();
 };
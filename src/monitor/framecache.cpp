@@ -0,0 +1,127 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "framecache.h"
+
+// The whole frame is retained, count its audio buffer as well as its image
+static qint64 memorySize(const SharedFrame &frame)
+{
+    qint64 size = mlt_image_format_size(frame.get_image_format(), frame.get_image_width(), frame.get_image_height(), nullptr);
+    if (frame.get_audio() != nullptr) {
+        size += mlt_audio_format_size(frame.get_audio_format(), frame.get_audio_samples(), frame.get_audio_channels());
+    }
+    return size;
+}
+
+FrameCache::FrameCache() :
+    m_size(0),
+    m_maxSize(0),
+    m_hits(0),
+    m_misses(0)
+{
+}
+
+void FrameCache::setMaximumSize(int megaBytes)
+{
+    const qint64 maxSize = (qint64) qMax(0, megaBytes) * 1024 * 1024;
+    if (maxSize == m_maxSize) {
+        return;
+    }
+    m_maxSize = maxSize;
+    shrink(m_maxSize);
+}
+
+bool FrameCache::isEnabled() const
+{
+    return m_maxSize > 0;
+}
+
+void FrameCache::insert(const QString &source, const SharedFrame &frame)
+{
+    if (!isEnabled() || !frame.is_valid() || frame.get_image() == nullptr) {
+        return;
+    }
+    const Key key(source, frame.get_position());
+    QHash<Key, Entry>::iterator it = m_frames.find(key);
+    if (it != m_frames.end()) {
+        if (it->frame.get_image() == frame.get_image()) {
+            return;
+        }
+        // A newer rendering of this position replaces the cached one
+        m_usage.erase(it->usage);
+        m_size -= it->size;
+        m_frames.erase(it);
+    }
+    const qint64 frameSize = memorySize(frame);
+    if (frameSize > m_maxSize) {
+        return;
+    }
+    shrink(m_maxSize - frameSize);
+    Entry entry;
+    entry.frame = frame;
+    entry.size = frameSize;
+    entry.usage = m_usage.insert(m_usage.end(), key);
+    m_frames.insert(key, entry);
+    m_size += frameSize;
+}
+
+SharedFrame FrameCache::find(const QString &source, int position)
+{
+    if (!isEnabled()) {
+        return SharedFrame();
+    }
+    QHash<Key, Entry>::iterator it = m_frames.find(Key(source, position));
+    if (it == m_frames.end()) {
+        m_misses++;
+        return SharedFrame();
+    }
+    m_hits++;
+    // Move to most recently used
+    m_usage.erase(it->usage);
+    it->usage = m_usage.insert(m_usage.end(), it.key());
+    return it->frame;
+}
+
+void FrameCache::clear()
+{
+    m_frames.clear();
+    m_usage.clear();
+    m_size = 0;
+}
+
+int FrameCache::count() const
+{
+    return m_frames.count();
+}
+
+qint64 FrameCache::size() const
+{
+    return m_size;
+}
+
+int FrameCache::hitRate() const
+{
+    const int total = m_hits + m_misses;
+    return total == 0 ? 0 : 100 * m_hits / total;
+}
+
+void FrameCache::resetStatistics()
+{
+    m_hits = 0;
+    m_misses = 0;
+}
+
+void FrameCache::shrink(qint64 maxSize)
+{
+    while (m_size > maxSize && !m_usage.isEmpty()) {
+        const Key key = m_usage.takeFirst();
+        m_size -= m_frames.take(key).size;
+    }
+}
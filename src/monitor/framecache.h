@@ -0,0 +1,68 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include "scopes/sharedframe.h"
+
+#include <QHash>
+#include <QLinkedList>
+#include <QPair>
+#include <QString>
+
+/**
+  Memory bounded cache of frames already displayed by a monitor.
+
+  Frames are kept as decoded by the monitor (yuv420p at monitor
+  resolution), keyed by a producer identifier and a position. When the
+  total size of their images and audio exceeds the limit, the least
+  recently used frames are dropped. The cache is only used from the GUI thread.
+ */
+class FrameCache
+{
+public:
+    FrameCache();
+
+    /** @brief Sets the memory limit in MB, 0 disables the cache. */
+    void setMaximumSize(int megaBytes);
+    bool isEnabled() const;
+
+    void insert(const QString &source, const SharedFrame &frame);
+    /** @brief Returns the cached frame or an invalid frame, updates hit statistics. */
+    SharedFrame find(const QString &source, int position);
+    void clear();
+
+    int count() const;
+    /** @brief Memory used by the cached frames, images and audio, in bytes. */
+    qint64 size() const;
+    /** @brief Percentage of find() calls that returned a frame since the last reset. */
+    int hitRate() const;
+    void resetStatistics();
+
+private:
+    typedef QPair<QString, int> Key;
+    struct Entry {
+        SharedFrame frame;
+        qint64 size;
+        QLinkedList<Key>::iterator usage;
+    };
+    QHash<Key, Entry> m_frames;
+    /** @brief Keys from least to most recently used. */
+    QLinkedList<Key> m_usage;
+    qint64 m_size;
+    qint64 m_maxSize;
+    int m_hits;
+    int m_misses;
+
+    void shrink(qint64 maxSize);
+};
+
+#endif
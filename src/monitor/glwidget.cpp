@@ -86,6 +86,7 @@ GLWidget::GLWidget(int id, QObject *parent)
     , m_offscreenSurface(nullptr)
     , m_shareContext(nullptr)
     , m_audioWaveDisplayed(false)
+    , m_frameEpoch(1)
     , m_fbo(nullptr)
 {
     m_texture[0] = m_texture[1] = m_texture[2] = 0;
@@ -785,6 +786,23 @@ void GLWidget::resetDrops()
     }
 }
 
+void GLWidget::showCachedFrame(const SharedFrame &frame)
+{
+    if (m_frameRenderer) {
+        QMetaObject::invokeMethod(m_frameRenderer, "showSharedFrame", Qt::QueuedConnection, Q_ARG(SharedFrame, frame));
+    }
+}
+
+void GLWidget::invalidateFrames()
+{
+    m_frameEpoch.ref();
+}
+
+int GLWidget::frameEpoch() const
+{
+    return m_frameEpoch.load();
+}
+
 void GLWidget::createAudioOverlay(bool isAudio)
 {
     if (!m_consumer) {
@@ -1249,6 +1267,7 @@ void GLWidget::on_frame_show(mlt_consumer, void *self, mlt_frame frame_ptr)
     Mlt::Frame frame(frame_ptr);
     if (frame.get_int("rendered")) {
         GLWidget *widget = static_cast<GLWidget *>(self);
+        frame.set("kdenlive:epoch", widget->m_frameEpoch.load());
         int timeout = (widget->consumer()->get_int("real_time") > 0) ? 0 : 1000;
         if (widget->m_frameRenderer && widget->m_frameRenderer->semaphore()->tryAcquire(1, timeout)) {
             QMetaObject::invokeMethod(widget->m_frameRenderer, "showFrame", Qt::QueuedConnection, Q_ARG(Mlt::Frame, frame));
@@ -1369,9 +1388,41 @@ void FrameRenderer::showFrame(Mlt::Frame frame)
     // The frame is now done being modified and can be shared with the rest
     // of the application.
     emit frameDisplayed(m_displayFrame);
+    sendAudio();
     m_semaphore.release();
 }
 
+void FrameRenderer::sendAudio()
+{
+    if (sendAudioForAnalysis) {
+        // Audio scopes share the frame's samples
+        AudioBlock block(m_displayFrame);
+        if (block.isValid()) {
+            emit audioSamplesSignal(block);
+        }
+    }
+}
+
+void FrameRenderer::showSharedFrame(const SharedFrame &frame)
+{
+    m_displayFrame = frame;
+    if (m_context && m_context->isValid()) {
+        m_context->makeCurrent(m_surface);
+        QOpenGLFunctions *f = m_context->functions();
+        uploadTextures(m_context, m_displayFrame, m_renderTexture);
+        f->glBindTexture(GL_TEXTURE_2D, 0);
+        check_error(f);
+        f->glFinish();
+
+        for (int i = 0; i < 3; ++i) {
+            std::swap(m_renderTexture[i], m_displayTexture[i]);
+        }
+        emit textureReady(m_displayTexture[0], m_displayTexture[1], m_displayTexture[2]);
+        m_context->doneCurrent();
+    }
+    emit frameDisplayed(m_displayFrame);
+}
+
 void FrameRenderer::showGLFrame(Mlt::Frame frame)
 {
     if (m_context && m_context->isValid()) {
@@ -1410,6 +1461,7 @@ void FrameRenderer::showGLFrame(Mlt::Frame frame)
         // Save this frame for future use and to keep a reference to the GL Texture.
         m_frame = SharedFrame(frame);
         qSwap(m_frame, m_displayFrame);
+        sendAudio();
     }
     // The frame is now done being modified and can be shared with the rest
     // of the application.
@@ -1435,6 +1487,7 @@ void FrameRenderer::showGLNoSyncFrame(Mlt::Frame frame)
         // Save this frame for future use and to keep a reference to the GL Texture.
         m_frame = SharedFrame(frame);
         qSwap(m_frame, m_displayFrame);
+        sendAudio();
     }
 
     // The frame is now done being modified and can be shared with the rest
@@ -29,8 +29,10 @@
 #include <QMutex>
 #include <QThread>
 #include <QRect>
+#include <QAtomicInt>
 
 #include "scopes/sharedframe.h"
+#include "lib/audio/audioBlock.h"
 #include "definitions.h"
 
 class QOpenGLFunctions_3_2_Core;
@@ -113,6 +115,12 @@ public:
     void setAudioThumb(int channels = 0, const QVariantList &audioCache = QList<QVariant>());
     int droppedFrames() const;
     void resetDrops();
+    /** @brief Display a frame previously rendered by this monitor, without going through the consumer */
+    void showCachedFrame(const SharedFrame &frame);
+    /** @brief Mark all frames rendered until now as outdated, must be called when the producer changes */
+    void invalidateFrames();
+    /** @brief Identifier of the current frame generation, stored in each frame as kdenlive:epoch */
+    int frameEpoch() const;
 
 protected:
     void mouseReleaseEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
@@ -145,7 +153,7 @@ signals:
     void mouseSeek(int eventDelta, int modifiers);
     void startDrag();
     void analyseFrame(const QImage&);
-    void audioSamplesSignal(const audioShortVector &, int, int, int);
+    void audioSamplesSignal(const AudioBlock &);
     void showContextMenu(const QPoint &);
     void lockMonitor(bool);
     void passKeyEvent(QKeyEvent *);
@@ -187,6 +195,7 @@ private:
     QOffscreenSurface *m_offscreenSurface;
     QOpenGLContext *m_shareContext;
     bool m_audioWaveDisplayed;
+    QAtomicInt m_frameEpoch;
     static void on_frame_show(mlt_consumer, void *self, mlt_frame frame);
     static void on_gl_frame_show(mlt_consumer, void *self, mlt_frame frame_ptr);
     static void on_gl_nosync_frame_show(mlt_consumer, void *self, mlt_frame frame_ptr);
@@ -245,6 +254,7 @@ public:
     Q_INVOKABLE void showFrame(Mlt::Frame frame);
     Q_INVOKABLE void showGLFrame(Mlt::Frame frame);
     Q_INVOKABLE void showGLNoSyncFrame(Mlt::Frame frame);
+    Q_INVOKABLE void showSharedFrame(const SharedFrame &frame);
 
 public slots:
     void cleanup();
@@ -252,7 +262,7 @@ public slots:
 signals:
     void textureReady(GLuint yName, GLuint uName = 0, GLuint vName = 0);
     void frameDisplayed(const SharedFrame &frame);
-    void audioSamplesSignal(const audioShortVector &, int, int, int);
+    void audioSamplesSignal(const AudioBlock &);
 
 private:
     QSemaphore m_semaphore;
@@ -260,6 +270,8 @@ private:
     SharedFrame m_displayFrame;
     QOpenGLContext *m_context;
     QSurface *m_surface;
+    /** @brief Send the audio of the displayed frame to the audio scopes, if enabled */
+    void sendAudio();
 
 public:
     GLuint m_renderTexture[3];
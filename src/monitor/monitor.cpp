@@ -1737,6 +1737,7 @@ void Monitor::onFrameDisplayed(const SharedFrame &frame)
     m_monitorManager->frameDisplayed(frame);
     int position = frame.get_position();
     seekCursor(position);
+    render->storeFrame(frame);
     if (!render->checkFrameNumber(position)) {
         m_playAction->setActive(false);
     } else if (position >= m_length) {
@@ -2146,6 +2147,12 @@ void Monitor::prepareAudioThumb(int channels, QVariantList &audioCache)
 void Monitor::slotUpdateQmlTimecode(const QString &tc)
 {
     checkDrops(m_glMonitor->droppedFrames());
+    if (KdenliveSettings::monitor_cachestats()) {
+        const FrameCache &cache = render->frameCache();
+        m_qmlManager->setProperty(QStringLiteral("cacheInfo"), i18n("Cache: %1% hits, %2 frames, %3 MB", cache.hitRate(), cache.count(), cache.size() / 1048576));
+    } else {
+        m_qmlManager->setProperty(QStringLiteral("cacheInfo"), QString());
+    }
     m_glMonitor->rootObject()->setProperty("timecode", tc);
 }
 
@@ -0,0 +1,268 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "playbackprefetcher.h"
+
+#include <mlt++/Mlt.h>
+#include <QtConcurrent>
+#include <algorithm>
+
+// Source frames covered by a decoding batch, roughly one GOP of long GOP media
+static const int GopFrames = 16;
+// Ticks to wait for the first or last frame before giving up at the end of playback
+static const int MaxBoundTicks = 25;
+
+PlaybackPrefetcher::PlaybackPrefetcher(QObject *parent) :
+    QObject(parent),
+    m_producer(nullptr),
+    m_width(0),
+    m_height(0),
+    m_length(0),
+    m_speed(0),
+    m_clock(0),
+    m_displayed(0),
+    m_next(0),
+    m_epoch(0),
+    m_generation(0),
+    m_abort(false),
+    m_boundTicks(0)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &PlaybackPrefetcher::slotTick);
+}
+
+PlaybackPrefetcher::~PlaybackPrefetcher()
+{
+    stop();
+}
+
+bool PlaybackPrefetcher::usePrefetch(double speed)
+{
+    return speed < 0 || speed > 1;
+}
+
+void PlaybackPrefetcher::start(Mlt::Producer *producer, int width, int height, double fps, int position, double speed, int epoch)
+{
+    stop();
+    m_producer = producer;
+    m_width = width;
+    m_height = height;
+    m_length = producer->get_length();
+    m_speed = speed;
+    m_clock = position;
+    m_displayed = position;
+    m_next = position + step();
+    m_epoch = epoch;
+    m_generation++;
+    m_abort = false;
+    m_boundTicks = 0;
+    m_timer.start(qMax(1, qRound(1000.0 / fps)));
+    m_worker = QtConcurrent::run(this, &PlaybackPrefetcher::decodeFrames);
+}
+
+int PlaybackPrefetcher::stop()
+{
+    if (!isActive()) {
+        return m_displayed;
+    }
+    m_timer.stop();
+    m_mutex.lock();
+    m_abort = true;
+    m_wake.wakeAll();
+    m_mutex.unlock();
+    m_worker.waitForFinished();
+    m_frames.clear();
+    m_producer = nullptr;
+    return m_displayed;
+}
+
+bool PlaybackPrefetcher::isActive() const
+{
+    return m_producer != nullptr;
+}
+
+void PlaybackPrefetcher::setSpeed(double speed)
+{
+    QMutexLocker lock(&m_mutex);
+    m_speed = speed;
+    m_clock = m_displayed;
+    m_next = m_displayed + step();
+    m_boundTicks = 0;
+    m_wake.wakeAll();
+}
+
+double PlaybackPrefetcher::speed() const
+{
+    return m_speed;
+}
+
+int PlaybackPrefetcher::position() const
+{
+    return m_displayed;
+}
+
+void PlaybackPrefetcher::seek(int position)
+{
+    QMutexLocker lock(&m_mutex);
+    m_clock = position;
+    m_displayed = position;
+    m_next = position + step();
+    m_generation++;
+    m_boundTicks = 0;
+    m_frames.clear();
+    m_wake.wakeAll();
+}
+
+void PlaybackPrefetcher::invalidate(int epoch)
+{
+    QMutexLocker lock(&m_mutex);
+    m_epoch = epoch;
+    m_next = qRound(m_clock) + step();
+    m_generation++;
+    m_frames.clear();
+    m_wake.wakeAll();
+}
+
+int PlaybackPrefetcher::step() const
+{
+    if (m_speed < 0) {
+        return qMin(-1, qRound(m_speed));
+    }
+    return qMax(1, qRound(m_speed));
+}
+
+int PlaybackPrefetcher::batchSize() const
+{
+    return qMax(2, GopFrames / qAbs(step()));
+}
+
+void PlaybackPrefetcher::slotTick()
+{
+    m_mutex.lock();
+    m_clock += m_speed;
+    bool atBound = false;
+    if (m_clock <= 0) {
+        m_clock = 0;
+        atBound = true;
+    } else if (m_clock >= m_length - 1) {
+        m_clock = m_length - 1;
+        atBound = true;
+    }
+    const int target = qRound(m_clock);
+    const int direction = m_speed < 0 ? -1 : 1;
+    // Show the most advanced frame reached by the playhead, frames it passed are dropped
+    SharedFrame frame;
+    int framePosition = m_displayed;
+    QMap<int, SharedFrame>::iterator it = m_frames.begin();
+    while (it != m_frames.end()) {
+        const int pos = it.key();
+        if ((target - pos) * direction < 0) {
+            ++it;
+            continue;
+        }
+        if ((pos - framePosition) * direction > 0) {
+            frame = it.value();
+            framePosition = pos;
+        }
+        it = m_frames.erase(it);
+    }
+    m_wake.wakeAll();
+    m_mutex.unlock();
+
+    if (frame.is_valid()) {
+        m_displayed = framePosition;
+        emit showFrame(frame);
+    }
+    if (atBound) {
+        m_boundTicks++;
+        if (m_displayed == target || m_boundTicks > MaxBoundTicks) {
+            m_timer.stop();
+            emit finished(m_displayed);
+        }
+    }
+}
+
+void PlaybackPrefetcher::decodeFrames()
+{
+    QVector<int> batch;
+    while (true) {
+        m_mutex.lock();
+        while (!m_abort && m_frames.count() > batchSize()) {
+            m_wake.wait(&m_mutex);
+        }
+        if (m_abort) {
+            m_mutex.unlock();
+            return;
+        }
+        const int generation = m_generation;
+        const int epoch = m_epoch;
+        const int frameStep = step();
+        const int target = qRound(m_clock);
+        if ((m_next - target) * frameStep <= 0) {
+            // Decoding is late, skip to the frames the playhead has not reached yet
+            m_next = target + frameStep;
+        }
+        // Positions that will be displayed, the first or last frame is always included
+        batch.clear();
+        int pos = m_next;
+        while (batch.count() < batchSize() && pos >= 0 && pos < m_length) {
+            if (!m_frames.contains(pos)) {
+                batch << pos;
+            }
+            int nextPos = pos + frameStep;
+            if (nextPos < 0 && pos > 0) {
+                nextPos = 0;
+            } else if (nextPos >= m_length && pos < m_length - 1) {
+                nextPos = m_length - 1;
+            }
+            pos = nextPos;
+        }
+        m_next = pos;
+        if (batch.isEmpty()) {
+            // Nothing left to decode until the playhead moves or changes direction
+            m_wake.wait(&m_mutex);
+            m_mutex.unlock();
+            continue;
+        }
+        m_mutex.unlock();
+
+        // Decode in increasing order so that a batch only needs one seek in the source
+        std::sort(batch.begin(), batch.end());
+        for (int position : batch) {
+            m_mutex.lock();
+            const bool outdated = m_abort || generation != m_generation;
+            const bool late = (position - qRound(m_clock)) * step() <= 0;
+            m_mutex.unlock();
+            if (outdated) {
+                break;
+            }
+            if (late) {
+                continue;
+            }
+            m_producer->seek(position);
+            Mlt::Frame *frame = m_producer->get_frame();
+            if (!frame) {
+                continue;
+            }
+            frame->set("kdenlive:epoch", epoch);
+            mlt_image_format format = mlt_image_yuv420p;
+            int width = m_width;
+            int height = m_height;
+            frame->get_image(format, width, height);
+            SharedFrame shared(*frame);
+            delete frame;
+            m_mutex.lock();
+            if (!m_abort && generation == m_generation) {
+                m_frames.insert(position, shared);
+            }
+            m_mutex.unlock();
+        }
+    }
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef PLAYBACKPREFETCHER_H
+#define PLAYBACKPREFETCHER_H
+
+#include "scopes/sharedframe.h"
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFuture>
+#include <QTimer>
+
+namespace Mlt
+{
+class Producer;
+}
+
+/**
+  Plays a producer at reverse or fast forward speeds.
+
+  Asking MLT to play backwards means one backwards seek per displayed
+  frame, which is very slow with long GOP media. Instead, the positions
+  that will be displayed are decoded in batches covering about one GOP,
+  each batch in increasing order so that the decoder only seeks once per
+  batch. Decoding happens in a worker thread that fills a small ring of
+  frames ahead of the playhead, while a timer on the GUI thread advances
+  the playhead at the requested speed and shows the matching frame. When
+  decoding is too slow, late frames are skipped instead of stalling the
+  playhead.
+
+  The producer must not be used by a consumer while the prefetcher is
+  active, and must stay valid until stop() returns.
+ */
+class PlaybackPrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaybackPrefetcher(QObject *parent = nullptr);
+    ~PlaybackPrefetcher();
+
+    /** @brief Returns true if playback at this speed should use the prefetcher instead of the consumer */
+    static bool usePrefetch(double speed);
+
+    void start(Mlt::Producer *producer, int width, int height, double fps, int position, double speed, int epoch);
+    /** @brief Stops playback and the worker thread, returns the last displayed position */
+    int stop();
+    bool isActive() const;
+    void setSpeed(double speed);
+    double speed() const;
+    /** @brief Last displayed position */
+    int position() const;
+    /** @brief Move the playhead, discarding prefetched frames */
+    void seek(int position);
+    /** @brief Discard prefetched frames after a change in the producer, new frames get the epoch tag */
+    void invalidate(int epoch);
+
+signals:
+    void showFrame(const SharedFrame &frame);
+    /** @brief Playback reached the start or end of the producer */
+    void finished(int position);
+
+private slots:
+    void slotTick();
+
+private:
+    Mlt::Producer *m_producer;
+    int m_width;
+    int m_height;
+    int m_length;
+    double m_speed;
+    /** @brief Position of the playhead, moved by m_speed on each tick */
+    double m_clock;
+    int m_displayed;
+    /** @brief Next position the worker will decode */
+    int m_next;
+    int m_epoch;
+    /** @brief Incremented when prefetched frames become useless, so that running batches are dropped */
+    int m_generation;
+    bool m_abort;
+    int m_boundTicks;
+    QMap<int, SharedFrame> m_frames;
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QFuture<void> m_worker;
+    QTimer m_timer;
+
+    /** @brief Worker thread loop */
+    void decodeFrames();
+    /** @brief Distance in frames between two displayed positions */
+    int step() const;
+    /** @brief Number of displayed frames decoded in a batch */
+    int batchSize() const;
+};
+
+#endif
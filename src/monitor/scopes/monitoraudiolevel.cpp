@@ -78,8 +78,10 @@ void MonitorAudioLevel::refreshScope(const QSize & /*size*/, bool /*full*/)
                 // There was an error processing audio from frame
                 continue;
             }
+            // Meter the channels actually present in the frame, the clip's stream info may not match the project layout
+            const int levelChannels = audioChannels > 0 ? channels : 0;
             QVector<int> levels;
-            for (int i = 0; i < audioChannels; i++) {
+            for (int i = 0; i < levelChannels; i++) {
                 QString s = QStringLiteral("meta.media.audio_level.%1").arg(i);
                 double audioLevel = mFrame.get_double(s.toLatin1().constData());
                 if (audioLevel == 0.0) {
@@ -0,0 +1,542 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "archivewriter.h"
+
+#include <klocalizedstring.h>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMimeDatabase>
+#include <QQueue>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <zlib.h>
+
+// Uncompressed size of a compression block
+static const int BlockSize = 1024 * 1024;
+// Deflate window, the end of the previous block is used as dictionary
+static const int DictionarySize = 32768;
+static const int TarBlock = 512;
+// Amount of uncompressed data written between two saves of the resume state
+static const qint64 StateInterval = 64 * 1024 * 1024;
+
+static void writeNumber(char *field, int length, qint64 value)
+{
+    // Octal with a terminating nul, or GNU base-256 for values that do not fit
+    const QByteArray digits = QByteArray::number(value, 8);
+    if (digits.size() < length) {
+        const QByteArray padded = digits.rightJustified(length - 1, '0');
+        memcpy(field, padded.constData(), length - 1);
+        return;
+    }
+    field[0] = (char) 0x80;
+    for (int i = length - 1; i > 0; --i) {
+        field[i] = (char)(value & 0xff);
+        value >>= 8;
+    }
+}
+
+static QByteArray tarHeader(const QByteArray &name, qint64 size, char type, int mode, qint64 mtime, const QByteArray &user, const QByteArray &group)
+{
+    QByteArray header(TarBlock, '\0');
+    char *h = header.data();
+    memcpy(h, name.constData(), qMin(name.size(), 100));
+    writeNumber(h + 100, 8, mode);
+    writeNumber(h + 108, 8, 0);
+    writeNumber(h + 116, 8, 0);
+    writeNumber(h + 124, 12, size);
+    writeNumber(h + 136, 12, mtime);
+    h[156] = type;
+    memcpy(h + 257, "ustar  ", 8);
+    memcpy(h + 265, user.constData(), qMin(user.size(), 31));
+    memcpy(h + 297, group.constData(), qMin(group.size(), 31));
+    memset(h + 148, ' ', 8);
+    uint checksum = 0;
+    for (int i = 0; i < TarBlock; ++i) {
+        checksum += (uchar) h[i];
+    }
+    const QByteArray sum = QByteArray::number(checksum, 8).rightJustified(6, '0');
+    memcpy(h + 148, sum.constData(), 6);
+    h[154] = '\0';
+    h[155] = ' ';
+    return header;
+}
+
+static int unixMode(QFile::Permissions permissions)
+{
+    static const QFile::Permission flags[9] = {QFile::ExeOther, QFile::WriteOther, QFile::ReadOther,
+                                               QFile::ExeGroup, QFile::WriteGroup, QFile::ReadGroup,
+                                               QFile::ExeOwner, QFile::WriteOwner, QFile::ReadOwner};
+    int mode = 0;
+    for (int i = 0; i < 9; ++i) {
+        if (permissions & flags[i]) {
+            mode |= 1 << i;
+        }
+    }
+    // Unknown permissions, use a readable file
+    return mode == 0 ? 0644 : mode;
+}
+
+static void appendLittleEndian(QByteArray &data, quint32 value)
+{
+    for (int i = 0; i < 4; ++i) {
+        data.append((char)(value & 0xff));
+        value >>= 8;
+    }
+}
+
+ArchiveWriter::ArchiveWriter(const QString &archiveName, QObject *parent) :
+    QObject(parent),
+    m_archiveName(archiveName),
+    m_storeCompressed(false),
+    m_time(QDateTime::currentDateTime().toTime_t()),
+    m_size(0),
+    m_abort(0)
+{
+    // Entries created now must match the ones of an interrupted archive
+    QFile state(stateName());
+    if (state.open(QIODevice::ReadOnly)) {
+        const QJsonObject values = QJsonDocument::fromJson(state.readAll()).object();
+        if (values.contains(QStringLiteral("time"))) {
+            m_time = (qint64) values.value(QStringLiteral("time")).toDouble();
+        }
+    }
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void ArchiveWriter::setStoreCompressedMedia(bool store)
+{
+    m_storeCompressed = store;
+}
+
+QString ArchiveWriter::partName() const
+{
+    return m_archiveName + QStringLiteral(".part");
+}
+
+QString ArchiveWriter::stateName() const
+{
+    return m_archiveName + QStringLiteral(".state");
+}
+
+void ArchiveWriter::appendSegment(const QByteArray &bytes)
+{
+    if (bytes.isEmpty()) {
+        return;
+    }
+    Segment segment;
+    segment.offset = m_size;
+    segment.size = bytes.size();
+    segment.bytes = bytes;
+    segment.store = false;
+    m_segments.append(segment);
+    m_size += segment.size;
+}
+
+void ArchiveWriter::appendHeader(const QString &archivePath, qint64 size, char type, int mode, qint64 mtime, const QString &user, const QString &group)
+{
+    const QByteArray userName = user.toUtf8();
+    const QByteArray groupName = group.toUtf8();
+    QByteArray name = archivePath.toUtf8();
+    if (name.size() > 99) {
+        // GNU long name entry, followed by the entry with a truncated name
+        const QByteArray longName = name + '\0';
+        QByteArray entry = tarHeader(QByteArrayLiteral("././@LongLink"), longName.size(), 'L', 0, 0, userName, groupName);
+        entry.append(longName);
+        entry.append(QByteArray((TarBlock - longName.size() % TarBlock) % TarBlock, '\0'));
+        appendSegment(entry);
+        name.truncate(99);
+    }
+    appendSegment(tarHeader(name, size, type, mode, mtime, userName, groupName));
+}
+
+void ArchiveWriter::addDirectory(const QString &archivePath, const QString &user, const QString &group)
+{
+    QString path = archivePath;
+    if (!path.endsWith(QLatin1Char('/'))) {
+        path.append(QLatin1Char('/'));
+    }
+    appendHeader(path, 0, '5', 040755, m_time, user, group);
+}
+
+void ArchiveWriter::addFile(const QString &localPath, const QString &archivePath, const QString &user, const QString &group)
+{
+    QFileInfo info(localPath);
+    const qint64 size = info.size();
+    appendHeader(archivePath, size, '0', 0100000 | unixMode(info.permissions()), info.lastModified().toTime_t(), user, group);
+    if (size == 0) {
+        return;
+    }
+    Segment segment;
+    segment.offset = m_size;
+    segment.size = size;
+    segment.path = localPath;
+    segment.store = m_storeCompressed && isCompressedMedia(localPath);
+    m_segments.append(segment);
+    m_size += size;
+    if (size % TarBlock != 0) {
+        appendSegment(QByteArray(TarBlock - size % TarBlock, '\0'));
+    }
+}
+
+void ArchiveWriter::addData(const QByteArray &data, const QString &archivePath, const QString &user, const QString &group)
+{
+    appendHeader(archivePath, data.size(), '0', 0100644, m_time, user, group);
+    QByteArray entry = data;
+    entry.append(QByteArray((TarBlock - data.size() % TarBlock) % TarBlock, '\0'));
+    appendSegment(entry);
+}
+
+qint64 ArchiveWriter::totalSize() const
+{
+    // Entries are followed by two empty blocks
+    return m_size + 2 * TarBlock;
+}
+
+QByteArray ArchiveWriter::signature() const
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (const Segment &segment : m_segments) {
+        if (segment.path.isEmpty()) {
+            hash.addData(segment.bytes);
+        } else {
+            // Size and modification time are in the header
+            hash.addData(segment.path.toUtf8());
+            hash.addData(segment.store ? "s" : "c", 1);
+        }
+    }
+    return hash.result().toHex();
+}
+
+bool ArchiveWriter::canResume() const
+{
+    return canResume(signature());
+}
+
+bool ArchiveWriter::canResume(const QByteArray &signature) const
+{
+    QFile state(stateName());
+    if (!state.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonObject values = QJsonDocument::fromJson(state.readAll()).object();
+    if (values.value(QStringLiteral("signature")).toString().toLatin1() != signature) {
+        return false;
+    }
+    const qint64 offset = (qint64) values.value(QStringLiteral("offset")).toDouble();
+    const qint64 compressed = (qint64) values.value(QStringLiteral("compressed")).toDouble();
+    return offset > 0 && offset < totalSize() && QFileInfo(partName()).size() >= compressed;
+}
+
+bool ArchiveWriter::saveState(const QByteArray &signature, qint64 offset, qint64 compressed, quint32 crc) const
+{
+    QJsonObject values;
+    values.insert(QStringLiteral("signature"), QString::fromLatin1(signature));
+    values.insert(QStringLiteral("time"), (double) m_time);
+    values.insert(QStringLiteral("offset"), (double) offset);
+    values.insert(QStringLiteral("compressed"), (double) compressed);
+    values.insert(QStringLiteral("crc"), (double) crc);
+    QSaveFile state(stateName());
+    if (!state.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    state.write(QJsonDocument(values).toJson(QJsonDocument::Compact));
+    return state.commit();
+}
+
+void ArchiveWriter::cancel()
+{
+    m_abort.store(1);
+}
+
+bool ArchiveWriter::isCancelled() const
+{
+    return m_abort.load() != 0;
+}
+
+QString ArchiveWriter::errorString() const
+{
+    return m_error;
+}
+
+// static
+bool ArchiveWriter::isCompressedMedia(const QString &path)
+{
+    QMimeDatabase db;
+    const QMimeType type = db.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+    const QString name = type.name();
+    if (name.startsWith(QLatin1String("video/"))) {
+        return true;
+    }
+    if (name.startsWith(QLatin1String("audio/"))) {
+        // Uncompressed audio still benefits from deflate
+        return !type.inherits(QStringLiteral("audio/x-wav")) && !type.inherits(QStringLiteral("audio/x-aiff"));
+    }
+    static const QStringList compressedTypes {QStringLiteral("image/jpeg"), QStringLiteral("image/png"), QStringLiteral("image/webp"), QStringLiteral("image/gif"),
+                                              QStringLiteral("application/zip"), QStringLiteral("application/gzip"), QStringLiteral("application/x-xz"),
+                                              QStringLiteral("application/x-bzip")};
+    for (const QString &compressed : compressedTypes) {
+        if (type.inherits(compressed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ArchiveWriter::readStream(qint64 offset, qint64 length, QByteArray &data)
+{
+    data.resize(length);
+    char *dest = data.data();
+    // Trailing empty blocks
+    if (offset + length > m_size) {
+        const qint64 start = qMax(offset, m_size);
+        memset(dest + (start - offset), 0, offset + length - start);
+        length = start - offset;
+    }
+    Segment key;
+    key.offset = offset;
+    QVector<Segment>::const_iterator it = std::upper_bound(m_segments.constBegin(), m_segments.constEnd(), key, [](const Segment &a, const Segment &b) {
+        return a.offset < b.offset;
+    });
+    if (it != m_segments.constBegin()) {
+        --it;
+    }
+    qint64 done = 0;
+    while (done < length && it != m_segments.constEnd()) {
+        const qint64 position = offset + done - it->offset;
+        const qint64 count = qMin(length - done, it->size - position);
+        if (it->path.isEmpty()) {
+            memcpy(dest + done, it->bytes.constData() + position, count);
+        } else {
+            if (m_source.fileName() != it->path || !m_source.isOpen()) {
+                m_source.close();
+                m_source.setFileName(it->path);
+                if (!m_source.open(QIODevice::ReadOnly)) {
+                    m_error = i18n("Cannot read file %1", it->path);
+                    return false;
+                }
+            }
+            if (m_source.pos() != position && !m_source.seek(position)) {
+                m_error = i18n("Cannot read file %1", it->path);
+                return false;
+            }
+            if (m_source.read(dest + done, count) != count) {
+                m_error = i18n("File %1 was modified during archiving", it->path);
+                return false;
+            }
+        }
+        done += count;
+        ++it;
+    }
+    return true;
+}
+
+bool ArchiveWriter::nextBlock(qint64 offset, Block &block)
+{
+    qint64 end = qMin(offset + BlockSize, totalSize());
+    block.store = false;
+    Segment key;
+    key.offset = offset;
+    QVector<Segment>::const_iterator it = std::upper_bound(m_segments.constBegin(), m_segments.constEnd(), key, [](const Segment &a, const Segment &b) {
+        return a.offset < b.offset;
+    });
+    if (it != m_segments.constBegin() && offset < m_size) {
+        --it;
+        // Stored and compressed data do not share a block
+        block.store = it->store;
+        for (; it != m_segments.constEnd() && it->offset < end; ++it) {
+            if (it->store != block.store) {
+                end = it->offset;
+                break;
+            }
+        }
+    }
+    block.last = end >= totalSize();
+    return readStream(offset, end - offset, block.data);
+}
+
+// static
+ArchiveWriter::CompressedBlock ArchiveWriter::compressBlock(const Block &block)
+{
+    CompressedBlock result;
+    result.size = block.data.size();
+    result.crc = crc32(0L, (const Bytef *) block.data.constData(), (uInt) block.data.size());
+    result.ok = false;
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // Raw deflate, the gzip header and trailer are written once for the whole archive
+    if (deflateInit2(&stream, block.store ? Z_NO_COMPRESSION : Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return result;
+    }
+    if (!block.store && !block.dictionary.isEmpty()) {
+        deflateSetDictionary(&stream, (const Bytef *) block.dictionary.constData(), (uInt) block.dictionary.size());
+    }
+    result.data.resize((int) deflateBound(&stream, (uLong) block.data.size()) + 64);
+    stream.next_in = (Bytef *) block.data.constData();
+    stream.avail_in = (uInt) block.data.size();
+    stream.next_out = (Bytef *) result.data.data();
+    stream.avail_out = (uInt) result.data.size();
+    // Blocks other than the last end on a byte boundary without the final bit, so that they can be concatenated
+    const int flush = block.last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true) {
+        const int ret = deflate(&stream, flush);
+        if (ret == Z_STREAM_ERROR) {
+            break;
+        }
+        if (block.last ? ret == Z_STREAM_END : (stream.avail_in == 0 && stream.avail_out > 0)) {
+            result.ok = true;
+            break;
+        }
+        const int used = (int) stream.total_out;
+        result.data.resize(result.data.size() * 2);
+        stream.next_out = (Bytef *) result.data.data() + used;
+        stream.avail_out = (uInt)(result.data.size() - used);
+    }
+    result.data.resize((int) stream.total_out);
+    deflateEnd(&stream);
+    return result;
+}
+
+bool ArchiveWriter::write(bool resume)
+{
+    m_error.clear();
+    m_abort.store(0);
+    const qint64 total = totalSize();
+    qint64 offset = 0;
+    qint64 compressed = 0;
+    quint32 crc = crc32(0L, nullptr, 0);
+    QByteArray window;
+    QFile out(partName());
+    // The entries do not change while writing, only hash them once
+    const QByteArray entriesSignature = signature();
+    if (resume && canResume(entriesSignature)) {
+        QFile state(stateName());
+        state.open(QIODevice::ReadOnly);
+        const QJsonObject values = QJsonDocument::fromJson(state.readAll()).object();
+        offset = (qint64) values.value(QStringLiteral("offset")).toDouble();
+        compressed = (qint64) values.value(QStringLiteral("compressed")).toDouble();
+        crc = (quint32) values.value(QStringLiteral("crc")).toDouble();
+        if (!out.open(QIODevice::ReadWrite) || !out.resize(compressed) || !out.seek(compressed)) {
+            m_error = i18n("Cannot write to file %1", out.fileName());
+            return false;
+        }
+        const qint64 start = qMax((qint64) 0, offset - DictionarySize);
+        if (!readStream(start, offset - start, window)) {
+            return false;
+        }
+    } else {
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            m_error = i18n("Cannot write to file %1", out.fileName());
+            return false;
+        }
+        // gzip member header: deflate, no flags, unix
+        QByteArray header("\x1f\x8b\x08\x00", 4);
+        appendLittleEndian(header, (quint32) m_time);
+        header.append('\0');
+        header.append('\x03');
+        out.write(header);
+        compressed = header.size();
+    }
+    emit progress(offset, total);
+    qint64 savedOffset = offset;
+    QElapsedTimer saveTimer;
+    saveTimer.start();
+
+    // Blocks are read in order on this thread, compressed on the pool and written back in order
+    QQueue<QFuture<CompressedBlock> > pending;
+    const int maxPending = 2 * qMax(1, m_pool.maxThreadCount());
+    qint64 next = offset;
+    bool failed = false;
+    while (true) {
+        while (!failed && !isCancelled() && next < total && pending.count() < maxPending) {
+            Block block;
+            if (!nextBlock(next, block)) {
+                failed = true;
+                break;
+            }
+            block.dictionary = window;
+            if (block.data.size() >= DictionarySize) {
+                window = block.data.right(DictionarySize);
+            } else {
+                window = (window + block.data).right(DictionarySize);
+            }
+            next += block.data.size();
+            pending.enqueue(QtConcurrent::run(&m_pool, &ArchiveWriter::compressBlock, block));
+        }
+        if (pending.isEmpty()) {
+            break;
+        }
+        const CompressedBlock result = pending.dequeue().result();
+        if (failed) {
+            // Let the remaining blocks finish, their position is lost
+            continue;
+        }
+        if (!result.ok) {
+            m_error = i18n("Compression error");
+            failed = true;
+            continue;
+        }
+        if (out.write(result.data) != result.data.size() || !out.flush()) {
+            m_error = i18n("Cannot write to file %1", out.fileName());
+            failed = true;
+            continue;
+        }
+        crc = (quint32) crc32_combine(crc, result.crc, (z_off_t) result.size);
+        offset += result.size;
+        compressed += result.data.size();
+        if (offset < total && (offset - savedOffset >= StateInterval || saveTimer.elapsed() >= 1000)) {
+            // Saving the state syncs it to disk, don't do it for every block
+            saveState(entriesSignature, offset, compressed, crc);
+            savedOffset = offset;
+            saveTimer.restart();
+        }
+        emit progress(offset, total);
+    }
+    m_source.close();
+    if (failed || offset < total) {
+        out.close();
+        if (offset > savedOffset && offset < total) {
+            // Resume after the last block written
+            saveState(entriesSignature, offset, compressed, crc);
+        }
+        if (!failed) {
+            m_error = i18n("Archiving was interrupted, it can be resumed");
+        }
+        return false;
+    }
+
+    QByteArray trailer;
+    appendLittleEndian(trailer, crc);
+    appendLittleEndian(trailer, (quint32)(total & 0xffffffff));
+    if (out.write(trailer) != trailer.size()) {
+        m_error = i18n("Cannot write to file %1", out.fileName());
+        return false;
+    }
+    out.close();
+    QFile::remove(m_archiveName);
+    if (!QFile::rename(partName(), m_archiveName)) {
+        m_error = i18n("Cannot write to file %1", m_archiveName);
+        return false;
+    }
+    QFile::remove(stateName());
+    return true;
+}
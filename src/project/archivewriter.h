@@ -0,0 +1,114 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef ARCHIVEWRITER_H
+#define ARCHIVEWRITER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+/**
+ * @class ArchiveWriter
+ * @brief Writes a gzip compressed tar archive, compressing blocks in parallel.
+ *
+ * The tar stream is cut in blocks that are deflated independently on a thread
+ * pool, each block using the end of the previous one as dictionary, and the
+ * results are appended in order to form a single standard gzip member (the
+ * way pigz works). Files containing already compressed media can be stored
+ * in deflate's uncompressed blocks, which costs no cpu.
+ *
+ * The archive is written to a .part file next to the final name, with a
+ * small state file regularly recording the last complete block. An interrupted or
+ * cancelled archiving of the same files can be resumed from there.
+ */
+class ArchiveWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ArchiveWriter(const QString &archiveName, QObject *parent = nullptr);
+    ~ArchiveWriter();
+
+    /** @brief Store files containing compressed media (video, audio, jpeg,...) without compressing them again */
+    void setStoreCompressedMedia(bool store);
+    void addDirectory(const QString &archivePath, const QString &user, const QString &group);
+    void addFile(const QString &localPath, const QString &archivePath, const QString &user, const QString &group);
+    void addData(const QByteArray &data, const QString &archivePath, const QString &user, const QString &group);
+    /** @brief Size of the uncompressed tar stream */
+    qint64 totalSize() const;
+    /** @brief Returns true if a previous archiving of the same entries was interrupted */
+    bool canResume() const;
+    /** @brief Writes the archive, blocking until finished or cancelled. Safe to call from a worker thread. */
+    bool write(bool resume);
+    /** @brief Stop writing after the blocks being compressed, the archive can then be resumed */
+    void cancel();
+    bool isCancelled() const;
+    QString errorString() const;
+    /** @brief Returns true if the file is compressed media that gains nothing from deflate */
+    static bool isCompressedMedia(const QString &path);
+
+signals:
+    void progress(qint64 done, qint64 total);
+
+private:
+    struct Segment {
+        qint64 offset;
+        qint64 size;
+        /** @brief Literal bytes (headers, padding, data), used if path is empty */
+        QByteArray bytes;
+        QString path;
+        bool store;
+    };
+    struct Block {
+        QByteArray data;
+        QByteArray dictionary;
+        bool store;
+        bool last;
+    };
+    struct CompressedBlock {
+        QByteArray data;
+        quint32 crc;
+        qint64 size;
+        bool ok;
+    };
+
+    QString m_archiveName;
+    bool m_storeCompressed;
+    /** @brief Modification time of the generated entries, kept when resuming so that the stream is identical */
+    qint64 m_time;
+    QVector<Segment> m_segments;
+    qint64 m_size;
+    QAtomicInt m_abort;
+    QString m_error;
+    QThreadPool m_pool;
+    /** @brief File currently read by nextBlock() */
+    QFile m_source;
+
+    QString partName() const;
+    QString stateName() const;
+    /** @brief Hash identifying the entries, so that a resumed archive is written with the same content */
+    QByteArray signature() const;
+    void appendSegment(const QByteArray &bytes);
+    void appendHeader(const QString &archivePath, qint64 size, char type, int mode, qint64 mtime, const QString &user, const QString &group);
+    /** @brief Read length bytes of the tar stream at offset, returns false on read error */
+    bool readStream(qint64 offset, qint64 length, QByteArray &data);
+    /** @brief Read the block starting at offset, it stops at segment boundaries changing the store mode */
+    bool nextBlock(qint64 offset, Block &block);
+    bool canResume(const QByteArray &signature) const;
+    bool saveState(const QByteArray &signature, qint64 offset, qint64 compressed, quint32 crc) const;
+    static CompressedBlock compressBlock(const Block &block);
+};
+
+#endif
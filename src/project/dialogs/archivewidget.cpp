@@ -19,6 +19,7 @@
 
 #include "archivewidget.h"
 #include "projectsettings.h"
+#include "project/archivewriter.h"
 #include "titler/titlewidget.h"
 #include "mltcontroller/clipcontroller.h"
 
@@ -40,7 +41,8 @@ ArchiveWidget::ArchiveWidget(const QString &projectName, const QDomDocument &doc
     , m_copyJob(nullptr)
     , m_name(projectName.section(QLatin1Char('.'), 0, -2))
     , m_doc(doc)
-    , m_temp(nullptr)
+    , m_archiveWriter(nullptr)
+    , m_resumeArchive(false)
     , m_abortArchive(false)
     , m_extractMode(false)
     , m_progressTimer(nullptr)
@@ -53,7 +55,7 @@ ArchiveWidget::ArchiveWidget(const QString &projectName, const QDomDocument &doc
     archive_url->setUrl(QUrl::fromLocalFile(QDir::homePath()));
     connect(archive_url, &KUrlRequester::textChanged, this, &ArchiveWidget::slotCheckSpace);
     connect(this, SIGNAL(archivingFinished(bool)), this, SLOT(slotArchivingFinished(bool)));
-    connect(this, SIGNAL(archiveProgress(int)), this, SLOT(slotArchivingProgress(int)));
+    connect(compressed_archive, &QAbstractButton::toggled, store_media, &QWidget::setEnabled);
     connect(proxy_only, &QCheckBox::stateChanged, this, &ArchiveWidget::slotProxyOnly);
 
     // Setup categories
@@ -212,7 +214,8 @@ ArchiveWidget::ArchiveWidget(const QUrl &url, QWidget *parent):
     QDialog(parent),
     m_requestedSize(0),
     m_copyJob(nullptr),
-    m_temp(nullptr),
+    m_archiveWriter(nullptr),
+    m_resumeArchive(false),
     m_abortArchive(false),
     m_extractMode(true),
     m_extractUrl(url),
@@ -231,6 +234,7 @@ ArchiveWidget::ArchiveWidget(const QUrl &url, QWidget *parent):
     connect(this, &ArchiveWidget::showMessage, this, &ArchiveWidget::slotDisplayMessage);
 
     compressed_archive->setHidden(true);
+    store_media->setHidden(true);
     proxy_only->setHidden(true);
     project_files->setHidden(true);
     files_list->setHidden(true);
@@ -246,6 +250,11 @@ ArchiveWidget::ArchiveWidget(const QUrl &url, QWidget *parent):
 
 ArchiveWidget::~ArchiveWidget()
 {
+    if (m_archiveWriter) {
+        m_archiveWriter->cancel();
+        m_archiveThread.waitForFinished();
+        delete m_archiveWriter;
+    }
     delete m_extractArchive;
     delete m_progressTimer;
 }
@@ -321,6 +330,11 @@ bool ArchiveWidget::closeAccepted()
         if (m_copyJob) {
             m_copyJob->kill();
         }
+        if (m_archiveWriter) {
+            // The partial archive is kept and can be resumed later
+            m_archiveWriter->cancel();
+            m_archiveThread.waitForFinished();
+        }
     }
     return true;
 }
@@ -507,6 +521,9 @@ bool ArchiveWidget::slotStartArchiving(bool firstPass)
         if (m_copyJob) {
             m_copyJob->kill(KJob::EmitResult);
         }
+        if (m_archiveWriter) {
+            m_archiveWriter->cancel();
+        }
         m_abortArchive = true;
         return true;
     }
@@ -525,6 +542,7 @@ bool ArchiveWidget::slotStartArchiving(bool firstPass)
         archive_url->setEnabled(false);
         proxy_only->setEnabled(false);
         compressed_archive->setEnabled(false);
+        store_media->setEnabled(false);
     }
     QList<QUrl> files;
     QUrl destUrl;
@@ -835,12 +853,28 @@ bool ArchiveWidget::processProjectFile()
     }
 
     if (isArchive) {
-        m_temp = new QTemporaryFile;
-        if (!m_temp->open()) {
-            KMessageBox::error(this, i18n("Cannot create temporary file"));
+        QString archiveName(archive_url->url().toLocalFile() + QDir::separator() + m_name + QStringLiteral(".tar.gz"));
+        QFileInfo dirInfo(archive_url->url().toLocalFile());
+        QString user = dirInfo.owner();
+        QString group = dirInfo.group();
+        delete m_archiveWriter;
+        m_archiveWriter = new ArchiveWriter(archiveName);
+        m_archiveWriter->setStoreCompressedMedia(store_media->isChecked());
+        foreach (const QString &folder, m_foldersList) {
+            m_archiveWriter->addDirectory(folder, user, group);
+        }
+        QMapIterator<QString, QString> i(m_filesList);
+        while (i.hasNext()) {
+            i.next();
+            m_archiveWriter->addFile(i.key(), i.value(), user, group);
         }
-        m_temp->write(playList.toUtf8());
-        m_temp->close();
+        m_archiveWriter->addData(playList.toUtf8(), m_name + QStringLiteral(".kdenlive"), user, group);
+        m_resumeArchive = m_archiveWriter->canResume() && KMessageBox::questionYesNo(this, i18n("An interrupted archive %1 was found.\nDo you want to resume it?", archiveName)) == KMessageBox::Yes;
+        if (!m_resumeArchive && QFile::exists(archiveName) && KMessageBox::questionYesNo(this, i18n("File %1 already exists.\nDo you want to overwrite it?", archiveName)) == KMessageBox::No) {
+            emit archivingFinished(false);
+            return false;
+        }
+        connect(m_archiveWriter, &ArchiveWriter::progress, this, &ArchiveWidget::slotArchivingProgress);
         m_archiveThread = QtConcurrent::run(this, &ArchiveWidget::createArchive);
         return true;
     }
@@ -868,39 +902,8 @@ bool ArchiveWidget::processProjectFile()
 
 void ArchiveWidget::createArchive()
 {
-    QString archiveName(archive_url->url().toLocalFile() + QDir::separator() + m_name + QStringLiteral(".tar.gz"));
-    if (QFile::exists(archiveName) && KMessageBox::questionYesNo(this, i18n("File %1 already exists.\nDo you want to overwrite it?", archiveName)) == KMessageBox::No) {
-        return;
-    }
-    QFileInfo dirInfo(archive_url->url().toLocalFile());
-    QString user = dirInfo.owner();
-    QString group = dirInfo.group();
-    KTar archive(archiveName, QStringLiteral("application/x-gzip"));
-    archive.open(QIODevice::WriteOnly);
-
-    // Create folders
-    foreach (const QString &path, m_foldersList) {
-        archive.writeDir(path, user, group);
-    }
-
-    // Add files
-    int ix = 0;
-    QMapIterator<QString, QString> i(m_filesList);
-    while (i.hasNext()) {
-        i.next();
-        archive.addLocalFile(i.key(), i.value());
-        emit archiveProgress((int) 100 * ix / m_filesList.count());
-        ix++;
-    }
-
-    // Add project file
-    bool result = false;
-    if (m_temp) {
-        archive.addLocalFile(m_temp->fileName(), m_name + QStringLiteral(".kdenlive"));
-        result = archive.close();
-        delete m_temp;
-        m_temp = nullptr;
-    }
+    // Blocks are compressed in parallel while this thread reads the files
+    bool result = m_archiveWriter->write(m_resumeArchive);
     emit archivingFinished(result);
 }
 
@@ -909,6 +912,8 @@ void ArchiveWidget::slotArchivingFinished(bool result)
     if (result) {
         slotJobResult(true, i18n("Project was successfully archived."));
         buttonBox->button(QDialogButtonBox::Apply)->setEnabled(false);
+    } else if (m_archiveWriter && !m_archiveWriter->errorString().isEmpty()) {
+        slotJobResult(false, m_archiveWriter->errorString());
     } else {
         slotJobResult(false, i18n("There was an error processing project file"));
     }
@@ -917,6 +922,7 @@ void ArchiveWidget::slotArchivingFinished(bool result)
     archive_url->setEnabled(true);
     proxy_only->setEnabled(true);
     compressed_archive->setEnabled(true);
+    store_media->setEnabled(true);
     for (int i = 0; i < files_list->topLevelItemCount(); ++i) {
         files_list->topLevelItem(i)->setDisabled(false);
         for (int j = 0; j < files_list->topLevelItem(i)->childCount(); ++j) {
@@ -925,9 +931,16 @@ void ArchiveWidget::slotArchivingFinished(bool result)
     }
 }
 
-void ArchiveWidget::slotArchivingProgress(int p)
+void ArchiveWidget::slotArchivingProgress(qint64 done, qint64 total)
 {
-    progressBar->setValue(p);
+    if (total <= 0) {
+        return;
+    }
+    const int percent = static_cast<int>(100 * done / total);
+    if (percent != progressBar->value() || done == 0) {
+        progressBar->setValue(percent);
+        slotDisplayMessage(QStringLiteral("system-run"), i18n("Archiving... %1 of %2", KIO::convertSize(static_cast<KIO::filesize_t>(done)), KIO::convertSize(static_cast<KIO::filesize_t>(total))));
+    }
 }
 
 void ArchiveWidget::slotStartExtracting()
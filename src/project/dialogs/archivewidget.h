@@ -33,6 +33,7 @@
 
 class KJob;
 class KArchive;
+class ArchiveWriter;
 class ClipController;
 
 /**
@@ -63,7 +64,7 @@ private slots:
     void done(int r) Q_DECL_OVERRIDE;
     bool closeAccepted();
     void createArchive();
-    void slotArchivingProgress(int);
+    void slotArchivingProgress(qint64 done, qint64 total);
     void slotArchivingFinished(bool result);
     void slotStartExtracting();
     void doExtracting();
@@ -85,7 +86,9 @@ private:
     QMap<QUrl, QUrl> m_replacementList;
     QString m_name;
     QDomDocument m_doc;
-    QTemporaryFile *m_temp;
+    ArchiveWriter *m_archiveWriter;
+    /** @brief Continue an interrupted compressed archive */
+    bool m_resumeArchive;
     bool m_abortArchive;
     QFuture<void> m_archiveThread;
     QStringList m_foldersList;
@@ -107,7 +110,6 @@ private:
 
 signals:
     void archivingFinished(bool);
-    void archiveProgress(int);
     void extractingFinished();
     void showMessage(const QString &, const QString &);
 };
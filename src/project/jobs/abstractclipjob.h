@@ -45,7 +45,8 @@ public:
         TRANSCODEJOB = 4,
         FILTERCLIPJOB = 5,
         THUMBJOB = 5,
-        ANALYSECLIPJOB = 6
+        ANALYSECLIPJOB = 6,
+        SCENEDETECTJOB = 7
     };
     AbstractClipJob(JOBTYPE type, ClipType cType, const QString &id, QObject *parent = nullptr);
     virtual ~ AbstractClipJob();
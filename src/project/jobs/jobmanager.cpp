@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "project/clipstabilize.h"
 #include "meltjob.h"
 #include "filterjob.h"
+#include "scenedetectjob.h"
 #include "bin/bin.h"
 #include "mlt++/Mlt.h"
 
@@ -213,7 +214,7 @@ void JobManager::slotProcessJobs()
         connect(job, SIGNAL(jobProgress(QString, int, int)), this, SIGNAL(processLog(QString, int, int)));
         connect(job, &AbstractClipJob::cancelRunningJob, m_bin, &Bin::slotCancelRunningJob);
 
-        if (job->jobType == AbstractClipJob::MLTJOB || job->jobType == AbstractClipJob::ANALYSECLIPJOB) {
+        if (job->jobType == AbstractClipJob::MLTJOB || job->jobType == AbstractClipJob::ANALYSECLIPJOB || job->jobType == AbstractClipJob::SCENEDETECTJOB) {
             connect(job, SIGNAL(gotFilterJobResults(QString, int, int, stringMap, stringMap)), this, SIGNAL(gotFilterJobResults(QString, int, int, stringMap, stringMap)));
         }
         job->startJob();
@@ -240,6 +241,8 @@ QList<ProjectClip *> JobManager::filterClips(const QList<ProjectClip *> &clips,
         return CutClipJob::filterClips(clips, params);
     } else if (jobType == AbstractClipJob::FILTERCLIPJOB) {
         return FilterJob::filterClips(clips, params);
+    } else if (jobType == AbstractClipJob::SCENEDETECTJOB) {
+        return SceneDetectJob::filterClips(clips, params);
     } else if (jobType == AbstractClipJob::PROXYJOB) {
         return ProxyJob::filterClips(clips);
     }
@@ -272,6 +275,8 @@ void JobManager::prepareJobs(const QList<ProjectClip *> &clips, double fps, Abst
         jobs = CutClipJob::prepareAnalyseJob(fps, matching, params);
     } else if (jobType == AbstractClipJob::FILTERCLIPJOB) {
         jobs = FilterJob::prepareJob(matching, params);
+    } else if (jobType == AbstractClipJob::SCENEDETECTJOB) {
+        jobs = SceneDetectJob::prepareJob(matching, params);
     } else if (jobType == AbstractClipJob::PROXYJOB) {
         jobs = ProxyJob::prepareJob(m_bin, matching);
     }
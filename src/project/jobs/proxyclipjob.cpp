@@ -24,7 +24,10 @@
 #include "doc/kdenlivedoc.h"
 #include "bin/projectclip.h"
 #include "bin/bin.h"
+#include <QCryptographicHash>
+#include <QImageReader>
 #include <QProcess>
+#include <QStandardPaths>
 #include <QTemporaryFile>
 
 #include <klocalizedstring.h>
@@ -42,6 +45,12 @@ ProxyJob::ProxyJob(ClipType cType, const QString &id, const QStringList &paramet
     m_proxyParams = parameters.at(3);
     m_renderWidth = parameters.at(4).toInt();
     m_renderHeight = parameters.at(5).toInt();
+    if (parameters.count() > 6) {
+        m_storeFile = parameters.at(6);
+    }
+    // Render to a hidden file so that an incomplete proxy is never picked up
+    QFileInfo info(m_dest);
+    m_workFile = info.absoluteDir().absoluteFilePath(QStringLiteral(".part-") + info.fileName());
     m_playlist = playlist;
     replaceClip = true;
 }
@@ -55,7 +64,7 @@ void ProxyJob::startJob()
         m_isFfmpegJob = false;
         QStringList mltParameters;
         mltParameters << m_src;
-        mltParameters << QStringLiteral("-consumer") << QStringLiteral("avformat:") + m_dest;
+        mltParameters << QStringLiteral("-consumer") << QStringLiteral("avformat:") + m_workFile;
         QStringList params = m_proxyParams.split(QLatin1Char('-'), QString::SkipEmptyParts);
         double display_ratio;
         if (m_src.startsWith(QLatin1String("consumer:"))) {
@@ -112,57 +121,12 @@ void ProxyJob::startJob()
     } else if (clipType == Image) {
         m_isFfmpegJob = false;
         // Image proxy
-        QImage i(m_src);
-        if (i.isNull()) {
-            m_errorMessage.append(i18n("Cannot load image %1.", m_src));
-            setStatus(JobCrashed);
-            return;
-        }
-
-        QImage proxy;
-        // Images are scaled to profile size.
-        //TODO: Make it be configurable?
-        if (i.width() > i.height()) {
-            proxy = i.scaledToWidth(960);
+        if (createImageProxy() && publishProxy()) {
+            setStatus(JobDone);
         } else {
-            proxy = i.scaledToHeight(540);
-        }
-        if (m_exif > 1) {
-            // Rotate image according to exif data
-            QImage processed;
-            QMatrix matrix;
-
-            switch (m_exif) {
-            case 2:
-                matrix.scale(-1, 1);
-                break;
-            case 3:
-                matrix.rotate(180);
-                break;
-            case 4:
-                matrix.scale(1, -1);
-                break;
-            case 5:
-                matrix.rotate(270);
-                matrix.scale(-1, 1);
-                break;
-            case 6:
-                matrix.rotate(90);
-                break;
-            case 7:
-                matrix.rotate(90);
-                matrix.scale(-1, 1);
-                break;
-            case 8:
-                matrix.rotate(270);
-                break;
-            }
-            processed = proxy.transformed(matrix);
-            processed.save(m_dest);
-        } else {
-            proxy.save(m_dest);
+            QFile::remove(m_workFile);
+            setStatus(JobCrashed);
         }
-        setStatus(JobDone);
         return;
     } else {
         m_isFfmpegJob = true;
@@ -195,7 +159,7 @@ void ProxyJob::startJob()
 
         // Make sure we don't block when proxy file already exists
         parameters << QStringLiteral("-y");
-        parameters << m_dest;
+        parameters << m_workFile;
         m_jobProcess = new QProcess;
         m_jobProcess->setProcessChannelMode(QProcess::MergedChannels);
         m_jobProcess->start(KdenliveSettings::ffmpegpath(), parameters, QIODevice::ReadOnly);
@@ -207,7 +171,7 @@ void ProxyJob::startJob()
             emit cancelRunningJob(m_clipId, cancelProperties());
             m_jobProcess->close();
             m_jobProcess->waitForFinished();
-            QFile::remove(m_dest);
+            QFile::remove(m_workFile);
         }
         m_jobProcess->waitForFinished(400);
     }
@@ -216,23 +180,105 @@ void ProxyJob::startJob()
     if (m_jobStatus != JobAborted) {
         int result = m_jobProcess->exitStatus();
         if (result == QProcess::NormalExit) {
-            if (QFileInfo(m_dest).size() == 0) {
+            if (QFileInfo(m_workFile).size() == 0) {
                 // File was not created
                 processLogInfo();
                 m_errorMessage.append(i18n("Failed to create proxy clip."));
+                QFile::remove(m_workFile);
                 setStatus(JobCrashed);
-            } else {
+            } else if (publishProxy()) {
                 setStatus(JobDone);
+            } else {
+                setStatus(JobCrashed);
             }
         } else if (result == QProcess::CrashExit) {
             // Proxy process crashed
-            QFile::remove(m_dest);
+            QFile::remove(m_workFile);
             setStatus(JobCrashed);
         }
     }
     delete m_jobProcess;
 }
 
+bool ProxyJob::createImageProxy()
+{
+    QImageReader reader(m_src);
+    QSize size = reader.size();
+    if (!size.isValid()) {
+        m_errorMessage.append(i18n("Cannot load image %1.", m_src));
+        return false;
+    }
+    // Images are scaled to profile size.
+    //TODO: Make it be configurable?
+    QSize proxySize;
+    if (size.width() > size.height()) {
+        proxySize = size.scaled(960, size.height(), Qt::KeepAspectRatio);
+    } else {
+        proxySize = size.scaled(size.width(), 540, Qt::KeepAspectRatio);
+    }
+    // Decoders like jpeg can directly produce a downscaled image, which avoids decoding the full resolution
+    reader.setScaledSize(proxySize);
+    QImage proxy = reader.read();
+    if (proxy.isNull()) {
+        m_errorMessage.append(i18n("Cannot load image %1.", m_src));
+        return false;
+    }
+    if (m_exif > 1) {
+        // Rotate image according to exif data
+        QMatrix matrix;
+        switch (m_exif) {
+        case 2:
+            matrix.scale(-1, 1);
+            break;
+        case 3:
+            matrix.rotate(180);
+            break;
+        case 4:
+            matrix.scale(1, -1);
+            break;
+        case 5:
+            matrix.rotate(270);
+            matrix.scale(-1, 1);
+            break;
+        case 6:
+            matrix.rotate(90);
+            break;
+        case 7:
+            matrix.rotate(90);
+            matrix.scale(-1, 1);
+            break;
+        case 8:
+            matrix.rotate(270);
+            break;
+        }
+        proxy = proxy.transformed(matrix);
+    }
+    if (!proxy.save(m_workFile)) {
+        m_errorMessage.append(i18n("Cannot write to path: %1", m_dest));
+        return false;
+    }
+    return true;
+}
+
+bool ProxyJob::publishProxy()
+{
+    QFile::remove(m_dest);
+    if (!QFile::rename(m_workFile, m_dest)) {
+        QFile::remove(m_workFile);
+        m_errorMessage.append(i18n("Cannot write to path: %1", m_dest));
+        return false;
+    }
+    if (!m_storeFile.isEmpty() && m_storeFile != m_dest && !QFile::exists(m_storeFile)) {
+        // Keep a copy in the shared store so that other projects can reuse it
+        QFileInfo info(m_storeFile);
+        QString storeWorkFile = info.absoluteDir().absoluteFilePath(QStringLiteral(".part-") + info.fileName());
+        if (QFile::copy(m_dest, storeWorkFile) && !QFile::rename(storeWorkFile, m_storeFile)) {
+            QFile::remove(storeWorkFile);
+        }
+    }
+    return true;
+}
+
 void ProxyJob::processLogInfo()
 {
     if (!m_jobProcess || m_jobStatus == JobAborted) {
@@ -327,6 +373,15 @@ QHash<ProjectClip *, AbstractClipJob *> ProxyJob::prepareJob(Bin *bin, const QLi
     QHash<ProjectClip *, AbstractClipJob *> jobs;
     QSize renderSize = bin->getRenderSize();
     QString params = bin->getDocumentProperty(QStringLiteral("proxyparams")).simplified();
+    int minSize = bin->getDocumentProperty(QStringLiteral("proxyminsize")).toInt();
+    int proxyWidth = 640;
+    if (params.contains(QStringLiteral("scale="))) {
+        bool ok = false;
+        int width = params.section(QStringLiteral("scale="), 1, 1).section(QLatin1Char(':'), 0, 0).toInt(&ok);
+        if (ok && width > 0) {
+            proxyWidth = width;
+        }
+    }
     for (int i = 0; i < clips.count(); i++) {
         ProjectClip *item = clips.at(i);
         QString id = item->clipId();
@@ -343,6 +398,27 @@ QHash<ProjectClip *, AbstractClipJob *> ProxyJob::prepareJob(Bin *bin, const QLi
             bin->gotProxy(id, path);
             continue;
         }
+        QString storeFile;
+        if (item->clipType() == AV || item->clipType() == Video || item->clipType() == Image) {
+            storeFile = storePath(item, item->clipType() == Image ? QStringLiteral("image") : params, QLatin1Char('.') + QFileInfo(path).suffix());
+        }
+        if (!storeFile.isEmpty() && QFileInfo(storeFile).size() > 0) {
+            // Same file was already proxied with these settings, maybe by another project
+            item->setJobStatus(AbstractClipJob::PROXYJOB, JobDone);
+            bin->gotProxy(id, storeFile);
+            continue;
+        }
+        if (isEditFriendly(item, proxyWidth, minSize)) {
+            item->setProducerProperty(QStringLiteral("kdenlive:proxy"), QStringLiteral("-"));
+            item->setJobStatus(AbstractClipJob::PROXYJOB, JobDone);
+            bin->doDisplayMessage(i18n("Clip %1 does not need a proxy", item->name()), KMessageWidget::Information);
+            continue;
+        }
+        if (!storeFile.isEmpty() && QFileInfo(path).absolutePath() == QFileInfo(storeFile).absolutePath()) {
+            // The project uses the shared proxy folder, directly create the proxy in the store
+            path = storeFile;
+            storeFile.clear();
+        }
         QString sourcePath = item->url();
         if (item->clipType() == Playlist) {
             // Special case: playlists use the special 'consumer' producer to support resizing
@@ -365,10 +441,44 @@ QHash<ProjectClip *, AbstractClipJob *> ProxyJob::prepareJob(Bin *bin, const QLi
             }
         }
         qCDebug(KDENLIVE_LOG)<<" * *PROXY PATH: "<<path<<", "<<sourcePath;
-        parameters << path << sourcePath << item->getProducerProperty(QStringLiteral("_exif_orientation")) << params << QString::number(renderSize.width()) << QString::number(renderSize.height());
+        parameters << path << sourcePath << item->getProducerProperty(QStringLiteral("_exif_orientation")) << params << QString::number(renderSize.width()) << QString::number(renderSize.height()) << storeFile;
         ProxyJob *job = new ProxyJob(item->clipType(), id, parameters, playlist);
         jobs.insert(item, job);
     }
     return jobs;
 }
 
+
+// static
+const QString ProxyJob::storePath(ProjectClip *clip, const QString &params, const QString &extension)
+{
+    const QString hash = clip->hash();
+    if (hash.isEmpty()) {
+        return QString();
+    }
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    if (!dir.mkpath(QStringLiteral("proxy")) || !dir.cd(QStringLiteral("proxy"))) {
+        return QString();
+    }
+    // The file hash only covers the start and end of the file, add its size to the key
+    QByteArray key = params.toUtf8() + extension.toUtf8() + clip->getProducerProperty(QStringLiteral("kdenlive:file_size")).toUtf8();
+    QString profileKey = QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Md5).toHex().left(8));
+    return dir.absoluteFilePath(hash + QLatin1Char('-') + profileKey + extension);
+}
+
+// static
+bool ProxyJob::isEditFriendly(ProjectClip *clip, int proxyWidth, int minSize)
+{
+    if (clip->clipType() != AV && clip->clipType() != Video) {
+        return false;
+    }
+    // Codecs where each frame is encoded separately, seeking in them is as fast as in a proxy
+    static const QStringList intraCodecs = QStringList() << QStringLiteral("prores") << QStringLiteral("dnxhd") << QStringLiteral("mjpeg")
+                                           << QStringLiteral("cfhd") << QStringLiteral("dvvideo") << QStringLiteral("huffyuv") << QStringLiteral("ffvhuff")
+                                           << QStringLiteral("utvideo") << QStringLiteral("rawvideo") << QStringLiteral("v210") << QStringLiteral("qtrle");
+    if (!intraCodecs.contains(clip->codec(false))) {
+        return false;
+    }
+    int width = clip->getProducerIntProperty(QStringLiteral("meta.media.width"));
+    return width > 0 && width <= qMax(proxyWidth, minSize);
+}
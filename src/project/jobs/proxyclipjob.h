@@ -41,9 +41,17 @@ public:
     void processLogInfo() Q_DECL_OVERRIDE;
     static QList<ProjectClip *> filterClips(const QList<ProjectClip *> &clips);
     static QHash<ProjectClip *, AbstractClipJob *> prepareJob(Bin *bin, const QList<ProjectClip *> &clips);
+    /** @brief Returns the path of the clip's proxy in the proxy store shared by all projects.
+     *  The file name is built from the clip's file hash and a key of its size and the proxy parameters,
+     *  so that the same source file proxied with the same settings always gets the same name. */
+    static const QString storePath(ProjectClip *clip, const QString &params, const QString &extension);
 
 private:
+    /** @brief Final proxy path, the proxy is first rendered to m_workFile and renamed on success. */
     QString m_dest;
+    QString m_workFile;
+    /** @brief Copy of the proxy in the shared store, empty if m_dest is already in the store. */
+    QString m_storeFile;
     QString m_src;
     int m_exif;
     QString m_proxyParams;
@@ -52,6 +60,12 @@ private:
     int m_jobDuration;
     bool m_isFfmpegJob;
     QTemporaryFile *m_playlist;
+    /** @brief Create a scaled image proxy, decoding the image directly at proxy size when the format allows it. */
+    bool createImageProxy();
+    /** @brief Move the rendered proxy to its final path and copy it to the shared store. */
+    bool publishProxy();
+    /** @brief Returns true if the clip uses an intra frame codec at a size that does not need a proxy. */
+    static bool isEditFriendly(ProjectClip *clip, int proxyWidth, int minSize);
 };
 
 #endif
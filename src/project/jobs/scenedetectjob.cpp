@@ -0,0 +1,304 @@
+/***************************************************************************
+ *                                                                         *
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#include "scenedetectjob.h"
+#include "kdenlivesettings.h"
+#include "bin/projectclip.h"
+#include "lib/video/sceneCutDetector.h"
+#include "ui_scenecutdialog_ui.h"
+
+#include <QPointer>
+#include <QThread>
+#include <QtConcurrent>
+#include <klocalizedstring.h>
+#include <algorithm>
+
+#include <mlt++/Mlt.h>
+
+// Height of the frames used for analysis
+static const int ANALYSIS_HEIGHT = 120;
+// Clips are only split in segments of at least this duration, in seconds
+static const int MIN_SEGMENT_DURATION = 60;
+// Interval between two result updates sent to the Bin, in milliseconds
+static const int UPDATE_INTERVAL = 500;
+
+SceneDetectJob::SceneDetectJob(ClipType cType, const QString &id, const QString &url, int in, int out, double threshold, const stringMap &extraParams)
+    : AbstractClipJob(SCENEDETECTJOB, cType, id),
+      m_url(url),
+      m_in(in),
+      m_out(out),
+      m_threshold(threshold),
+      m_minSceneLength(1),
+      m_extra(extraParams),
+      m_processedFrames(0),
+      m_sentMarkers(0)
+{
+    m_jobStatus = JobWaiting;
+    description = i18n("Auto split");
+}
+
+SceneDetectJob::~SceneDetectJob()
+{
+    m_segmentPool.waitForDone();
+}
+
+void SceneDetectJob::startJob()
+{
+    if (m_url.isEmpty()) {
+        m_errorMessage.append(i18n("No producer for this clip."));
+        setStatus(JobCrashed);
+        return;
+    }
+    Mlt::Profile profile(KdenliveSettings::current_profile().toUtf8().constData());
+    // Analyse small frames, a cut is visible at any size
+    profile.set_width(qRound(ANALYSIS_HEIGHT * profile.dar() / 2) * 2);
+    profile.set_height(ANALYSIS_HEIGHT);
+    const double fps = profile.fps();
+    // Don't use scenes shorter than 1 second
+    m_minSceneLength = qMax(1, qRound(fps));
+    int out = m_out;
+    {
+        Mlt::Producer producer(profile, m_url.toUtf8().constData());
+        if (!producer.is_valid()) {
+            m_errorMessage.append(i18n("Cannot open file %1", m_url));
+            setStatus(JobCrashed);
+            return;
+        }
+        if (out < 0 || out >= producer.get_length()) {
+            out = producer.get_length() - 1;
+        }
+    }
+    if (out <= m_in) {
+        m_errorMessage.append(i18n("Clip zone undefined (%1 - %2).", m_in, out));
+        setStatus(JobCrashed);
+        return;
+    }
+    if (m_in > 0) {
+        m_extra.insert(QStringLiteral("offset"), QString::number(m_in));
+    }
+    const int length = out - m_in + 1;
+    int segments = qBound(1, (int)(length / (fps * MIN_SEGMENT_DURATION)), QThread::idealThreadCount());
+    m_segmentPool.setMaxThreadCount(segments);
+    QList<QFuture<void> > futures;
+    const int segmentLength = length / segments;
+    for (int i = 0; i < segments; ++i) {
+        int segmentIn = m_in + i * segmentLength;
+        int segmentOut = i == segments - 1 ? out : segmentIn + segmentLength - 1;
+        if (i > 0) {
+            // Start one frame earlier, to compare the segment's first frame with its predecessor
+            segmentIn--;
+        }
+        futures << QtConcurrent::run(&m_segmentPool, this, &SceneDetectJob::analyseSegment, &profile, segmentIn, segmentOut);
+    }
+    bool running = true;
+    while (running) {
+        running = !m_segmentPool.waitForDone(UPDATE_INTERVAL);
+        if (m_jobStatus == JobAborted) {
+            m_segmentPool.waitForDone();
+            if (m_sentMarkers > 0) {
+                // Let the Bin remove the markers it is showing for this job
+                stringMap extra;
+                extra.insert(QStringLiteral("key"), m_extra.value(QStringLiteral("key")));
+                extra.insert(QStringLiteral("streamed"), QStringLiteral("1"));
+                extra.insert(QStringLiteral("canceled"), QStringLiteral("1"));
+                stringMap jobResults;
+                jobResults.insert(m_extra.value(QStringLiteral("key")), QString());
+                emit gotFilterJobResults(m_clipId, -1, -1, jobResults, extra);
+            }
+            return;
+        }
+        sendPendingCuts();
+        emit jobProgress(m_clipId, 100 * m_processedFrames.load() / length, jobType);
+    }
+    // The markers shown while processing are replaced by the final sorted list, added in one undo step
+    stringMap extra = m_extra;
+    if (m_sentMarkers > 0) {
+        extra.insert(QStringLiteral("streamed"), QStringLiteral("1"));
+    }
+    stringMap jobResults;
+    jobResults.insert(m_extra.value(QStringLiteral("key")), cutList());
+    emit gotFilterJobResults(m_clipId, -1, -1, jobResults, extra);
+    m_jobStatus = JobDone;
+}
+
+void SceneDetectJob::analyseSegment(Mlt::Profile *profile, int in, int out)
+{
+    Mlt::Producer producer(*profile, m_url.toUtf8().constData());
+    if (!producer.is_valid()) {
+        return;
+    }
+    // Skip audio decoding
+    producer.set("audio_index", -1);
+    SceneCutDetector detector(m_threshold, m_minSceneLength);
+    detector.analyse(producer, in, out, [this](int position, bool cut, double score) {
+        m_processedFrames.ref();
+        if (cut) {
+            QMutexLocker lock(&m_cutsMutex);
+            m_pendingCuts << qMakePair(position, score);
+        }
+        return m_jobStatus != JobAborted;
+    });
+}
+
+void SceneDetectJob::sendPendingCuts()
+{
+    QVector<QPair<int, double> > pending;
+    m_cutsMutex.lock();
+    pending.swap(m_pendingCuts);
+    m_cutsMutex.unlock();
+    if (pending.isEmpty()) {
+        return;
+    }
+    std::sort(pending.begin(), pending.end());
+    QVector<QPair<int, double> > accepted;
+    for (const QPair<int, double> &cut : pending) {
+        // Segments don't know about each other's cuts, enforce the minimum scene length here
+        auto next = std::lower_bound(m_cuts.begin(), m_cuts.end(), cut);
+        if ((next != m_cuts.end() && next->first - cut.first < m_minSceneLength) || (next != m_cuts.begin() && cut.first - (next - 1)->first < m_minSceneLength)) {
+            continue;
+        }
+        m_cuts.insert(next, cut);
+        accepted << cut;
+    }
+    if (accepted.isEmpty() || !m_extra.contains(QStringLiteral("addmarkers"))) {
+        return;
+    }
+    QStringList result;
+    result.reserve(accepted.count());
+    for (const QPair<int, double> &cut : accepted) {
+        result << QStringLiteral("%1=%2").arg(cut.first - m_in).arg(qRound(cut.second * 100));
+    }
+    stringMap extra;
+    extra.insert(QStringLiteral("key"), m_extra.value(QStringLiteral("key")));
+    extra.insert(QStringLiteral("addmarkers"), m_extra.value(QStringLiteral("addmarkers")));
+    extra.insert(QStringLiteral("label"), m_extra.value(QStringLiteral("label")));
+    extra.insert(QStringLiteral("offset"), QString::number(m_in));
+    extra.insert(QStringLiteral("markerindex"), QString::number(m_sentMarkers + 1));
+    extra.insert(QStringLiteral("partial"), QStringLiteral("1"));
+    stringMap jobResults;
+    jobResults.insert(m_extra.value(QStringLiteral("key")), result.join(QLatin1Char(';')));
+    m_sentMarkers += accepted.count();
+    emit gotFilterJobResults(m_clipId, -1, -1, jobResults, extra);
+}
+
+const QString SceneDetectJob::cutList() const
+{
+    QStringList result;
+    result.reserve(m_cuts.count());
+    for (const QPair<int, double> &cut : m_cuts) {
+        result << QStringLiteral("%1=%2").arg(cut.first - m_in).arg(qRound(cut.second * 100));
+    }
+    return result.join(QLatin1Char(';'));
+}
+
+stringMap SceneDetectJob::cancelProperties()
+{
+    return stringMap();
+}
+
+const QString SceneDetectJob::statusMessage()
+{
+    QString statusInfo;
+    switch (m_jobStatus) {
+    case JobWorking:
+        statusInfo = description;
+        break;
+    case JobWaiting:
+        statusInfo = i18n("Waiting to process clip");
+        break;
+    default:
+        break;
+    }
+    return statusInfo;
+}
+
+// static
+QList<ProjectClip *> SceneDetectJob::filterClips(const QList<ProjectClip *> &clips, const QStringList &params)
+{
+    Q_UNUSED(params)
+    QList<ProjectClip *> result;
+    for (int i = 0; i < clips.count(); i++) {
+        ProjectClip *clip = clips.at(i);
+        ClipType type = clip->clipType();
+        if (type != AV && type != Video) {
+            // Clip will not be processed by this job
+            continue;
+        }
+        result << clip;
+    }
+    return result;
+}
+
+// static
+QHash<ProjectClip *, AbstractClipJob *> SceneDetectJob::prepareJob(const QList<ProjectClip *> &clips, const QStringList &parameters)
+{
+    Q_UNUSED(parameters)
+    QHash<ProjectClip *, AbstractClipJob *> jobs;
+    // Show config dialog
+    QPointer<QDialog> d = new QDialog(QApplication::activeWindow());
+    Ui::SceneCutDialog_UI ui;
+    ui.setupUi(d);
+    // Set  up categories
+    for (int i = 0; i < 5; ++i) {
+        ui.marker_type->insertItem(i, i18n("Category %1", i));
+        ui.marker_type->setItemData(i, CommentedTime::markerColor(i), Qt::DecorationRole);
+    }
+    ui.marker_type->setCurrentIndex(KdenliveSettings::default_marker_type());
+    if (d->exec() != QDialog::Accepted) {
+        delete d;
+        return jobs;
+    }
+    QMap<QString, QString> extraParams;
+    extraParams.insert(QStringLiteral("key"), QStringLiteral("shot_change_list"));
+    extraParams.insert(QStringLiteral("projecttreefilter"), QStringLiteral("1"));
+    QString keyword(QStringLiteral("%count"));
+    extraParams.insert(QStringLiteral("resultmessage"), i18n("Found %1 scenes.", keyword));
+    if (ui.store_data->isChecked()) {
+        // We want to save result as clip metadata
+        extraParams.insert(QStringLiteral("storedata"), QStringLiteral("1"));
+    }
+    bool zoneOnly = ui.zone_only->isChecked();
+    if (ui.add_markers->isChecked()) {
+        // We want to create markers
+        extraParams.insert(QStringLiteral("addmarkers"), QString::number(ui.marker_type->currentIndex()));
+        extraParams.insert(QStringLiteral("label"), i18n("Scene "));
+    }
+    if (ui.cut_scenes->isChecked()) {
+        // We want to cut scenes
+        extraParams.insert(QStringLiteral("cutscenes"), QStringLiteral("1"));
+    }
+    double threshold = ui.threshold->value() / 100.0;
+    delete d;
+
+    for (int i = 0; i < clips.count(); i++) {
+        int in = 0;
+        int out = -1;
+        ProjectClip *clip = clips.at(i);
+        if (zoneOnly) {
+            // Analyse clip zone only
+            QPoint zone = clip->zone();
+            in = zone.x();
+            out = zone.y();
+        }
+        SceneDetectJob *job = new SceneDetectJob(clip->clipType(), clip->clipId(), clip->url(), in, out, threshold, extraParams);
+        jobs.insert(clip, job);
+    }
+    return jobs;
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *                                                                         *
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA          *
+ ***************************************************************************/
+
+#ifndef SCENEDETECTJOB
+#define SCENEDETECTJOB
+
+#include "abstractclipjob.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QPair>
+#include <QThreadPool>
+#include <QVector>
+
+class ProjectClip;
+
+namespace Mlt
+{
+class Profile;
+}
+
+/**
+ * @class SceneDetectJob
+ * @brief This job finds scene cuts in a clip by comparing downscaled luma of decoded frames.
+ * Long clips are split in segments that are analysed in parallel, and cuts are sent to the
+ * Bin while the job runs so that markers appear progressively.
+ */
+
+class SceneDetectJob : public AbstractClipJob
+{
+    Q_OBJECT
+
+public:
+    /** @brief Creates the Job.
+     *  @param cType the Clip Type (AV, PLAYLIST, AUDIO, ...) as defined in definitions.h
+     *  @param id the id of the clip that requested this clip job
+     *  @param url the clip's source file
+     *  @param in first frame to analyse
+     *  @param out last frame to analyse, -1 for the end of the clip
+     *  @param threshold the cut score (0..1) above which a frame starts a new scene
+     *  @param extraParams the options passed back with the results (addmarkers, cutscenes, storedata, ...)
+     */
+    SceneDetectJob(ClipType cType, const QString &id, const QString &url, int in, int out, double threshold, const stringMap &extraParams);
+    virtual ~ SceneDetectJob();
+    void startJob() Q_DECL_OVERRIDE;
+    stringMap cancelProperties() Q_DECL_OVERRIDE;
+    const QString statusMessage() Q_DECL_OVERRIDE;
+    static QList<ProjectClip *> filterClips(const QList<ProjectClip *> &clips, const QStringList &params);
+    static QHash<ProjectClip *, AbstractClipJob *> prepareJob(const QList<ProjectClip *> &clips, const QStringList &parameters);
+
+private:
+    QString m_url;
+    int m_in;
+    int m_out;
+    double m_threshold;
+    int m_minSceneLength;
+    stringMap m_extra;
+    /** @brief Threads used for the segments of this job, kept apart from the global pool that runs the jobs. */
+    QThreadPool m_segmentPool;
+    QMutex m_cutsMutex;
+    /** @brief Cuts found by the segment threads and not yet sent, as position / score pairs. */
+    QVector<QPair<int, double> > m_pendingCuts;
+    /** @brief Sorted accepted cuts. */
+    QVector<QPair<int, double> > m_cuts;
+    QAtomicInt m_processedFrames;
+    /** @brief Number of cuts already sent as temporary markers. */
+    int m_sentMarkers;
+
+    void analyseSegment(Mlt::Profile *profile, int in, int out);
+    /** @brief Accept pending cuts and send them to the Bin, to be displayed as temporary markers if markers were requested. */
+    void sendPendingCuts();
+    const QString cutList() const;
+
+signals:
+    /** @brief When user requested a to process an Mlt::Filter, this will send back all necessary infos. */
+    void gotFilterJobResults(const QString &id, int startPos, int track, const stringMap &result, const stringMap &extra);
+};
+
+#endif
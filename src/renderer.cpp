@@ -34,6 +34,7 @@
 #include "monitor/glwidget.h"
 #include "mltcontroller/clipcontroller.h"
 #include "timeline/transitionhandler.h"
+#include "mltcontroller/timelineeditbatch.h"
 #include "core.h"
 #include <mlt++/Mlt.h>
 
@@ -69,7 +70,9 @@ Render::Render(Kdenlive::MonitorId rendererName, BinController *binController, G
     m_isLoopMode(false),
     m_blackClip(nullptr),
     m_isActive(false),
-    m_isRefreshing(false)
+    m_isRefreshing(false),
+    m_lockDuration(0),
+    m_cachedPosition(SEEK_INACTIVE)
 {
     qRegisterMetaType<stringMap> ("stringMap");
     analyseAudio = KdenliveSettings::monitor_audio();
@@ -90,6 +93,10 @@ Render::Render(Kdenlive::MonitorId rendererName, BinController *binController, G
     m_refreshTimer.setInterval(50);
     connect(&m_refreshTimer, &QTimer::timeout, this, &Render::refresh);
     connect(this, &Render::checkSeeking, this, &Render::slotCheckSeeking);
+    if (m_qmlView) {
+        connect(&m_prefetcher, &PlaybackPrefetcher::showFrame, m_qmlView, &GLWidget::showCachedFrame);
+        connect(&m_prefetcher, &PlaybackPrefetcher::finished, this, &Render::slotPrefetchFinished);
+    }
     if (m_name == Kdenlive::ProjectMonitor) {
         connect(m_binController, &BinController::prepareTimelineReplacement, this, &Render::prepareTimelineReplacement, Qt::DirectConnection);
         connect(m_binController, &BinController::replaceTimelineProducer, this, &Render::replaceTimelineProducer, Qt::DirectConnection);
@@ -105,6 +112,7 @@ Render::~Render()
 
 void Render::closeMlt()
 {
+    m_prefetcher.stop();
     delete m_showFrameEvent;
     delete m_pauseEvent;
     delete m_mltConsumer;
@@ -158,6 +166,23 @@ void Render::seek(int time)
 {
     resetZoneMode();
     time = qBound(0, time, m_mltProducer->get_length() - 1);
+    if (m_prefetcher.isActive()) {
+        m_prefetcher.seek(time);
+        return;
+    }
+    m_cachedPosition = SEEK_INACTIVE;
+    if (requestedSeekPosition == SEEK_INACTIVE && m_qmlView && !externalConsumer && m_mltProducer->get_speed() == 0) {
+        m_frameCache.setMaximumSize(KdenliveSettings::monitor_cachesize());
+        const SharedFrame frame = m_frameCache.find(frameCacheSource(), time);
+        if (frame.is_valid()) {
+            // Display the frame we already have, the consumer will start from here on play
+            m_mltProducer->seek(time);
+            // The consumer did not move, remember where we are for position queries
+            m_cachedPosition = time;
+            m_qmlView->showCachedFrame(frame);
+            return;
+        }
+    }
     if (requestedSeekPosition == SEEK_INACTIVE) {
         requestedSeekPosition = time;
         if (m_mltProducer->get_speed() != 0) {
@@ -329,6 +354,8 @@ void Render::loadUrl(const QString &url)
 
 bool Render::updateProducer(Mlt::Producer *producer)
 {
+    stopPrefetch();
+    invalidateFrameCache();
     if (m_mltProducer) {
         if (strcmp(m_mltProducer->get("resource"), "<tractor>") == 0) {
             // We need to make some cleanup
@@ -362,6 +389,8 @@ bool Render::setProducer(Mlt::Producer *producer, int position, bool isActive)
     m_refreshTimer.stop();
     requestedSeekPosition = SEEK_INACTIVE;
     QMutexLocker locker(&m_mutex);
+    stopPrefetch();
+    invalidateFrameCache();
     QString currentId;
     int consumerPosition = 0;
     if (!producer && m_mltProducer && m_mltProducer->parent().get("id") == QLatin1String("black")) {
@@ -452,6 +481,8 @@ int Render::setSceneList(QString playlist, int position)
     requestedSeekPosition = SEEK_INACTIVE;
     m_refreshTimer.stop();
     QMutexLocker locker(&m_mutex);
+    stopPrefetch();
+    invalidateFrameCache();
     //if (m_winid == -1) return -1;
     int error = 0;
 
@@ -686,6 +717,7 @@ void Render::stop()
     requestedSeekPosition = SEEK_INACTIVE;
     m_refreshTimer.stop();
     QMutexLocker locker(&m_mutex);
+    stopPrefetch();
     m_isActive = false;
     if (m_mltProducer) {
         if (m_isZoneMode) {
@@ -707,6 +739,7 @@ void Render::stop(const GenTime &startTime)
     requestedSeekPosition = SEEK_INACTIVE;
     m_refreshTimer.stop();
     QMutexLocker locker(&m_mutex);
+    stopPrefetch();
     m_isActive = false;
     if (m_mltProducer) {
         if (m_isZoneMode) {
@@ -748,6 +781,14 @@ void Render::switchPlay(bool play, double speed)
     if (m_isZoneMode) {
         resetZoneMode();
     }
+    if (play && startPrefetch(speed)) {
+        return;
+    }
+    if (!play && m_prefetcher.isActive()) {
+        stopPrefetch();
+        return;
+    }
+    stopPrefetch();
     if (play) {
         double currentSpeed = m_mltProducer->get_speed();
         if (m_name == Kdenlive::ClipMonitor && m_mltConsumer->position() == m_mltProducer->get_out() && speed > 0) {
@@ -787,6 +828,10 @@ void Render::play(double speed)
     if (!m_mltProducer || !m_isActive) {
         return;
     }
+    if (startPrefetch(speed)) {
+        return;
+    }
+    stopPrefetch();
     double current_speed = m_mltProducer->get_speed();
     if (current_speed == speed) {
         return;
@@ -817,6 +862,10 @@ void Render::play(const GenTime &startTime)
     if (!m_mltProducer || !m_mltConsumer || !m_isActive) {
         return;
     }
+    stopPrefetch();
+    if (m_mltConsumer->is_stopped()) {
+        m_mltConsumer->start();
+    }
     m_mltProducer->seek((int)(startTime.frames(m_fps)));
     m_mltProducer->set_speed(1.0);
     m_isRefreshing = true;
@@ -841,6 +890,7 @@ bool Render::playZone(const GenTime &startTime, const GenTime &stopTime)
     if (!m_mltProducer || !m_mltConsumer || !m_isActive) {
         return false;
     }
+    stopPrefetch();
     m_mltProducer->seek((int)(startTime.frames(m_fps)));
     m_mltProducer->set_speed(0);
     m_mltConsumer->purge();
@@ -892,6 +942,7 @@ void Render::seekToFrameDiff(int diff)
 
 void Render::doRefresh()
 {
+    invalidateFrameCache();
     if (m_mltProducer && (playSpeed() == 0) && m_isActive) {
         if (m_isRefreshing) {
             m_refreshTimer.start();
@@ -904,6 +955,7 @@ void Render::doRefresh()
 void Render::refresh()
 {
     m_refreshTimer.stop();
+    invalidateFrameCache();
     if (!m_mltProducer || !m_isActive) {
         return;
     }
@@ -958,6 +1010,9 @@ bool Render::isPlaying() const
 
 double Render::playSpeed() const
 {
+    if (m_prefetcher.isActive()) {
+        return m_prefetcher.speed();
+    }
     if (m_mltProducer) {
         return m_mltProducer->get_speed();
     }
@@ -966,6 +1021,9 @@ double Render::playSpeed() const
 
 GenTime Render::seekPosition() const
 {
+    if (m_prefetcher.isActive()) {
+        return GenTime(m_prefetcher.position(), m_fps);
+    }
     if (m_mltConsumer) {
         return GenTime((int) m_mltConsumer->position(), m_fps);
     } else {
@@ -975,6 +1033,9 @@ GenTime Render::seekPosition() const
 
 int Render::seekFramePosition() const
 {
+    if (m_prefetcher.isActive()) {
+        return m_prefetcher.position();
+    }
     if (m_mltProducer && m_mltProducer->get_speed() == 0) {
         return (int) m_mltProducer->position();
     }
@@ -1007,11 +1068,96 @@ int Render::getCurrentSeekPosition() const
     if (requestedSeekPosition != SEEK_INACTIVE) {
         return requestedSeekPosition;
     }
+    if (m_cachedPosition != SEEK_INACTIVE) {
+        return m_cachedPosition;
+    }
+    if (m_prefetcher.isActive()) {
+        return m_prefetcher.position();
+    }
     return (int) m_mltConsumer->position();
 }
 
+void Render::storeFrame(const SharedFrame &frame)
+{
+    if (!m_qmlView || externalConsumer || !m_mltProducer || frame.get_image_format() != mlt_image_yuv420p) {
+        return;
+    }
+    // Frames rendered before the last change are outdated
+    if (frame.get_int("kdenlive:epoch") != m_qmlView->frameEpoch()) {
+        return;
+    }
+    m_frameCache.setMaximumSize(KdenliveSettings::monitor_cachesize());
+    m_frameCache.insert(frameCacheSource(), frame);
+}
+
+const FrameCache &Render::frameCache() const
+{
+    return m_frameCache;
+}
+
+void Render::invalidateFrameCache()
+{
+    m_frameCache.clear();
+    m_cachedPosition = SEEK_INACTIVE;
+    if (m_qmlView) {
+        m_qmlView->invalidateFrames();
+        if (m_prefetcher.isActive()) {
+            m_prefetcher.invalidate(m_qmlView->frameEpoch());
+        }
+    }
+}
+
+bool Render::startPrefetch(double speed)
+{
+    if (!KdenliveSettings::monitor_shuttleprefetch() || !PlaybackPrefetcher::usePrefetch(speed) || !m_qmlView || m_qmlView->glslManager() || externalConsumer) {
+        return false;
+    }
+    if (m_prefetcher.isActive()) {
+        m_prefetcher.setSpeed(speed);
+        return true;
+    }
+    resetZoneMode();
+    m_cachedPosition = SEEK_INACTIVE;
+    int position = m_mltProducer->get_speed() == 0 ? m_mltProducer->position() : m_mltConsumer->position();
+    // The prefetcher now owns the producer, the consumer must not request frames
+    m_mltProducer->set_speed(0);
+    if (!m_mltConsumer->is_stopped()) {
+        m_mltConsumer->stop();
+    }
+    m_mltConsumer->purge();
+    m_isRefreshing = false;
+    m_prefetcher.start(m_mltProducer, m_qmlView->profile()->width(), m_qmlView->profile()->height(), m_fps, position, speed, m_qmlView->frameEpoch());
+    return true;
+}
+
+void Render::stopPrefetch()
+{
+    if (!m_prefetcher.isActive()) {
+        return;
+    }
+    int position = m_prefetcher.stop();
+    if (m_mltProducer) {
+        m_mltProducer->seek(position);
+    }
+}
+
+void Render::slotPrefetchFinished(int position)
+{
+    stopPrefetch();
+    emit rendererStopped(position);
+}
+
+QString Render::frameCacheSource() const
+{
+    return QString::fromUtf8(m_mltProducer->parent().get("id")) + QLatin1Char(':') + QString::number(m_mltProducer->get_in());
+}
+
 bool Render::checkFrameNumber(int pos)
 {
+    if (pos != m_cachedPosition) {
+        // The consumer displayed another frame, the cached one is gone
+        m_cachedPosition = SEEK_INACTIVE;
+    }
     if (pos == requestedSeekPosition) {
         requestedSeekPosition = SEEK_INACTIVE;
     }
@@ -1064,24 +1210,10 @@ void Render::showAudio(Mlt::Frame &frame)
         return;
     }
 
-    mlt_audio_format audio_format = mlt_audio_s16;
-    //FIXME: should not be hardcoded..
-    int freq = 48000;
-    int num_channels = 2;
-    int samples = 0;
-    qint16 *data = (qint16 *)frame.get_audio(audio_format, freq, num_channels, samples);
-
-    if (!data) {
-        return;
-    }
-
-    // Data format: [ c00 c10 c01 c11 c02 c12 c03 c13 ... c0{samples-1} c1{samples-1} for 2 channels.
-    // So the vector is of size samples*channels.
-    audioShortVector sampleVector(samples * num_channels);
-    memcpy(sampleVector.data(), data, samples * num_channels * sizeof(qint16));
-
-    if (samples > 0) {
-        emit audioSamplesSignal(sampleVector, freq, num_channels, samples);
+    // The block references the frame's samples, scopes read them without copy
+    AudioBlock block = AudioBlock::fromFrame(frame);
+    if (block.isValid()) {
+        emit audioSamplesSignal(block);
     }
 }
 
@@ -1203,6 +1335,7 @@ void Render::unlockService(Mlt::Tractor *tractor)
     if (tractor) {
         delete tractor;
     }
+    invalidateFrameCache();
     if (!m_mltProducer) {
         return;
     }
@@ -1214,6 +1347,11 @@ void Render::unlockService(Mlt::Tractor *tractor)
     service.unlock();
 }
 
+qint64 Render::lastLockDuration() const
+{
+    return m_lockDuration;
+}
+
 void Render::mltInsertSpace(const QMap<int, int> &trackClipStartList, const QMap<int, int> &trackTransitionStartList, int track, const GenTime &duration, const GenTime &timeOffset)
 {
     if (!m_mltProducer) {
@@ -1230,135 +1368,37 @@ void Render::mltInsertSpace(const QMap<int, int> &trackClipStartList, const QMap
 
     Mlt::Service service(parentProd.get_service());
     Mlt::Tractor tractor(service);
-    service.lock();
     int diff = duration.frames(m_fps);
     int offset = timeOffset.frames(m_fps);
-    int insertPos;
+    TimelineEditBatch batch(tractor);
 
     if (track != -1) {
         // insert space in one track only
-        //TODO: memleak
-        Mlt::Producer trackProducer(tractor.track(track));
-        Mlt::Playlist trackPlaylist((mlt_playlist) trackProducer.get_service());
-        insertPos = trackClipStartList.value(track);
+        int insertPos = trackClipStartList.value(track);
         if (insertPos != -1) {
-            insertPos += offset;
-            int clipIndex = trackPlaylist.get_clip_index_at(insertPos);
-            if (diff > 0) {
-                trackPlaylist.insert_blank(clipIndex, diff - 1);
-            } else {
-                if (!trackPlaylist.is_blank(clipIndex)) {
-                    clipIndex --;
-                }
-                if (!trackPlaylist.is_blank(clipIndex)) {
-                    //qCDebug(KDENLIVE_LOG) << "//// ERROR TRYING TO DELETE SPACE FROM " << insertPos;
-                }
-                int position = trackPlaylist.clip_start(clipIndex);
-                int blankDuration = trackPlaylist.clip_length(clipIndex);
-                if (blankDuration + diff == 0) {
-                    trackPlaylist.remove(clipIndex);
-                } else {
-                    trackPlaylist.remove_region(position, -diff);
-                }
-            }
-            trackPlaylist.consolidate_blanks(0);
+            batch.shiftTrack(track, insertPos + offset, diff);
         }
-        // now move transitions
-        mlt_service serv = m_mltProducer->parent().get_service();
-        mlt_service nextservice = mlt_service_get_producer(serv);
-        mlt_properties properties = MLT_SERVICE_PROPERTIES(nextservice);
-        QString mlt_type = mlt_properties_get(properties, "mlt_type");
-        QString resource = mlt_properties_get(properties, "mlt_service");
-
-        while (mlt_type == QLatin1String("transition")) {
-            mlt_transition tr = (mlt_transition) nextservice;
-            int currentTrack = mlt_transition_get_b_track(tr);
-            int currentIn = (int) mlt_transition_get_in(tr);
-            int currentOut = (int) mlt_transition_get_out(tr);
-            insertPos = trackTransitionStartList.value(track);
-            if (insertPos != -1) {
-                insertPos += offset;
-                if (track == currentTrack && currentOut > insertPos && resource != QLatin1String("mix")) {
-                    mlt_transition_set_in_and_out(tr, currentIn + diff, currentOut + diff);
-                }
-            }
-            nextservice = mlt_service_producer(nextservice);
-            if (nextservice == nullptr) {
-                break;
-            }
-            properties = MLT_SERVICE_PROPERTIES(nextservice);
-            mlt_type = mlt_properties_get(properties, "mlt_type");
-            resource = mlt_properties_get(properties, "mlt_service");
+        insertPos = trackTransitionStartList.value(track);
+        if (insertPos != -1) {
+            batch.shiftTransitions(track, insertPos + offset, diff);
         }
     } else {
         for (int trackNb = tractor.count() - 1; trackNb >= 1; --trackNb) {
-            Mlt::Producer trackProducer(tractor.track(trackNb));
-            Mlt::Playlist trackPlaylist((mlt_playlist) trackProducer.get_service());
-
-            //int clipNb = trackPlaylist.count();
-            insertPos = trackClipStartList.value(trackNb);
+            int insertPos = trackClipStartList.value(trackNb);
             if (insertPos != -1) {
-                insertPos += offset;
-
-                /* //qCDebug(KDENLIVE_LOG)<<"-------------\nTRACK "<<trackNb<<" HAS "<<clipNb<<" CLPIS";
-                 //qCDebug(KDENLIVE_LOG) << "INSERT SPACE AT: "<<insertPos<<", DIFF: "<<diff<<", TK: "<<trackNb;
-                        for (int i = 0; i < clipNb; ++i) {
-                            //qCDebug(KDENLIVE_LOG)<<"CLIP "<<i<<", START: "<<trackPlaylist.clip_start(i)<<", END: "<<trackPlaylist.clip_start(i) + trackPlaylist.clip_length(i);
-                     if (trackPlaylist.is_blank(i)) //qCDebug(KDENLIVE_LOG)<<"++ BLANK ++ ";
-                     //qCDebug(KDENLIVE_LOG)<<"-------------";
-                 }
-                 //qCDebug(KDENLIVE_LOG)<<"END-------------";*/
-
-                int clipIndex = trackPlaylist.get_clip_index_at(insertPos);
-                if (diff > 0) {
-                    trackPlaylist.insert_blank(clipIndex, diff - 1);
-                } else {
-                    if (!trackPlaylist.is_blank(clipIndex)) {
-                        clipIndex --;
-                    }
-                    if (!trackPlaylist.is_blank(clipIndex)) {
-                        //qCDebug(KDENLIVE_LOG) << "//// ERROR TRYING TO DELETE SPACE FROM " << insertPos;
-                    }
-                    int position = trackPlaylist.clip_start(clipIndex);
-                    int blankDuration = trackPlaylist.clip_length(clipIndex);
-                    if (diff + blankDuration == 0) {
-                        trackPlaylist.remove(clipIndex);
-                    } else {
-                        trackPlaylist.remove_region(position, - diff);
-                    }
-                }
-                trackPlaylist.consolidate_blanks(0);
+                batch.shiftTrack(trackNb, insertPos + offset, diff);
             }
         }
-        // now move transitions
-        mlt_service serv = m_mltProducer->parent().get_service();
-        mlt_service nextservice = mlt_service_get_producer(serv);
-        mlt_properties properties = MLT_SERVICE_PROPERTIES(nextservice);
-        QString mlt_type = mlt_properties_get(properties, "mlt_type");
-        QString resource = mlt_properties_get(properties, "mlt_service");
-
-        while (mlt_type == QLatin1String("transition")) {
-            mlt_transition tr = (mlt_transition) nextservice;
-            int currentIn = (int) mlt_transition_get_in(tr);
-            int currentOut = (int) mlt_transition_get_out(tr);
-            int currentTrack = mlt_transition_get_b_track(tr);
-            insertPos = trackTransitionStartList.value(currentTrack);
-            if (insertPos != -1) {
-                insertPos += offset;
-                if (currentOut > insertPos && resource != QLatin1String("mix")) {
-                    mlt_transition_set_in_and_out(tr, currentIn + diff, currentOut + diff);
-                }
+        QMapIterator<int, int> i(trackTransitionStartList);
+        while (i.hasNext()) {
+            i.next();
+            if (i.value() != -1) {
+                batch.shiftTransitions(i.key(), i.value() + offset, diff);
             }
-            nextservice = mlt_service_producer(nextservice);
-            if (nextservice == nullptr) {
-                break;
-            }
-            properties = MLT_SERVICE_PROPERTIES(nextservice);
-            mlt_type = mlt_properties_get(properties, "mlt_type");
-            resource = mlt_properties_get(properties, "mlt_service");
         }
     }
-    service.unlock();
+    m_lockDuration = batch.apply();
+    invalidateFrameCache();
     mltCheckLength(&tractor);
     m_isRefreshing = true;
     m_mltConsumer->set("refresh", 1);
@@ -37,6 +37,8 @@
 #include "gentime.h"
 #include "definitions.h"
 #include "monitor/abstractmonitor.h"
+#include "monitor/framecache.h"
+#include "monitor/playbackprefetcher.h"
 #include "mltcontroller/effectscontroller.h"
 #include <mlt/framework/mlt_types.h>
 
@@ -211,6 +213,8 @@ Q_OBJECT public:
     Mlt::Tractor *lockService();
     /** @brief Unlock the MLT service */
     void unlockService(Mlt::Tractor *tractor);
+    /** @brief Time the MLT service stayed locked during the last space insertion or removal, in microseconds */
+    qint64 lastLockDuration() const;
     const QString activeClipId();
     /** @brief Fill a combobox with the found blackmagic devices */
     static bool getBlackMagicDeviceList(KComboBox *devicelist, bool force = false);
@@ -231,6 +235,10 @@ Q_OBJECT public:
 
     /** @brief Ask to set this monitor as active */
     void setActiveMonitor();
+    /** @brief Keep a frame displayed by the monitor so that seeking back to it does not need a new rendering */
+    void storeFrame(const SharedFrame &frame);
+    /** @brief The cache of displayed frames, used for statistics */
+    const FrameCache &frameCache() const;
 
     QSemaphore showFrameSemaphore;
     bool externalConsumer;
@@ -286,6 +294,22 @@ private:
     bool m_isActive;
     /** @brief True if the consumer is currently refreshing itself. */
     bool m_isRefreshing;
+    /** @brief Lock time of the last timeline edit batch, see lastLockDuration(). */
+    qint64 m_lockDuration;
+    /** @brief Frames recently displayed by the monitor, cleared on every change to the producer. */
+    FrameCache m_frameCache;
+    /** @brief Position of the cached frame displayed by the last seek, SEEK_INACTIVE once the consumer renders again. */
+    int m_cachedPosition;
+    /** @brief Drop cached frames and the ones currently being rendered. */
+    void invalidateFrameCache();
+    /** @brief Key identifying the current producer in the frame cache. */
+    QString frameCacheSource() const;
+    /** @brief Decodes frames ahead of the playhead for reverse and fast forward playback. */
+    PlaybackPrefetcher m_prefetcher;
+    /** @brief Play at this speed with the prefetcher if possible, returns false if the consumer has to be used. */
+    bool startPrefetch(double speed);
+    /** @brief Stop prefetched playback and move the producer to the last displayed frame. */
+    void stopPrefetch();
     void closeMlt();
     QMap<QString, Mlt::Producer *> m_slowmotionProducers;
 
@@ -307,6 +331,7 @@ private slots:
     /** @brief Refreshes the monitor display. */
     void refresh();
     void slotCheckSeeking();
+    void slotPrefetchFinished(int position);
 
 signals:
     /** @brief The renderer stopped, either playing or rendering. */
@@ -16,6 +16,7 @@
 #include <stdint.h>
 
 #include "../../definitions.h"
+#include "lib/audio/audioBlock.h"
 #include "../abstractscopewidget.h"
 
 class Render;
@@ -31,7 +32,7 @@ public:
     virtual ~AbstractAudioScopeWidget();
 
 public slots:
-    void slotReceiveAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
+    void slotReceiveAudio(const AudioBlock &block);
 
 protected:
     /** @brief This is just a wrapper function, subclasses can use renderAudioScope. */
@@ -42,7 +43,7 @@ protected:
         when calculation has finished, to allow multi-threading.
         accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible. */
     virtual QImage renderAudioScope(uint accelerationFactor,
-                                    const audioShortVector &audioFrame, const int freq, const int num_channels, const int num_samples,
+                                    const AudioBlock &audioFrame, const int freq, const int num_channels, const int num_samples,
                                     const int newData) = 0;
 
     int m_freq;
@@ -50,7 +51,7 @@ protected:
     int m_nSamples;
 
 private:
-    audioShortVector m_audioFrame;
+    AudioBlock m_audioFrame;
     QAtomicInt m_newData;
 
 };
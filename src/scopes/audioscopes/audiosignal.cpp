@@ -38,7 +38,7 @@ AudioSignal::~AudioSignal()
 {
 }
 
-QImage AudioSignal::renderAudioScope(uint, const audioShortVector &audioFrame,
+QImage AudioSignal::renderAudioScope(uint, const AudioBlock &audioFrame,
                                      const int, const int num_channels, const int samples, const int)
 {
     QTime start = QTime::currentTime();
@@ -156,9 +156,13 @@ QImage AudioSignal::renderBackground(uint)
     return QImage();
 }
 
-void AudioSignal::slotReceiveAudio(audioShortVector audioSamples, int, int num_channels, int samples)
+void AudioSignal::slotReceiveAudio(const AudioBlock &audioSamples)
 {
-
+    const int num_channels = audioSamples.channels();
+    const int samples = audioSamples.samples();
+    if (samples == 0) {
+        return;
+    }
     int num_samples = samples > 200 ? 200 : samples;
 
     QByteArray chanSignal;
@@ -42,7 +42,7 @@ public:
     QRect scopeRect() Q_DECL_OVERRIDE;
     QImage renderHUD(uint accelerationFactor) Q_DECL_OVERRIDE;
     QImage renderBackground(uint accelerationFactor) Q_DECL_OVERRIDE;
-    QImage renderAudioScope(uint accelerationFactor, const audioShortVector &audioFrame, const int, const int num_channels, const int samples, const int) Q_DECL_OVERRIDE;
+    QImage renderAudioScope(uint accelerationFactor, const AudioBlock &audioFrame, const int, const int num_channels, const int samples, const int) Q_DECL_OVERRIDE;
 
     QString widgetName() const Q_DECL_OVERRIDE
     {
@@ -69,7 +69,7 @@ private:
 
 public slots:
     void showAudio(const QByteArray &);
-    void slotReceiveAudio(audioShortVector audioSamples, int, int num_channels, int samples);
+    void slotReceiveAudio(const AudioBlock &audioSamples);
 private slots:
     void slotNoAudioTimeout();
 
@@ -154,7 +154,7 @@ QImage AudioSpectrum::renderBackground(uint)
     return QImage();
 }
 
-QImage AudioSpectrum::renderAudioScope(uint, const audioShortVector &audioFrame, const int freq, const int num_channels,
+QImage AudioSpectrum::renderAudioScope(uint, const AudioBlock &audioFrame, const int freq, const int num_channels,
                                        const int num_samples, const int)
 {
     if (
@@ -49,7 +49,7 @@ protected:
     ///// Implemented methods /////
     QRect scopeRect() Q_DECL_OVERRIDE;
     QImage renderHUD(uint accelerationFactor) Q_DECL_OVERRIDE;
-    QImage renderAudioScope(uint accelerationFactor, const audioShortVector &audioFrame, const int freq, const int num_channels, const int num_samples, const int newData) Q_DECL_OVERRIDE;
+    QImage renderAudioScope(uint accelerationFactor, const AudioBlock &audioFrame, const int freq, const int num_channels, const int num_samples, const int newData) Q_DECL_OVERRIDE;
     QImage renderBackground(uint accelerationFactor) Q_DECL_OVERRIDE;
     void readConfig() Q_DECL_OVERRIDE;
     void writeConfig();
@@ -307,7 +307,7 @@ QImage Spectrogram::renderHUD(uint)
         return QImage();
     }
 }
-QImage Spectrogram::renderAudioScope(uint, const audioShortVector &audioFrame, const int freq,
+QImage Spectrogram::renderAudioScope(uint, const AudioBlock &audioFrame, const int freq,
                                      const int num_channels, const int num_samples, const int newData)
 {
     if (
@@ -126,7 +126,7 @@ private slots:
     void checkActiveColourScopes();
 
     void slotDistributeFrame(const QImage &image);
-    void slotDistributeAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
+    void slotDistributeAudio(const AudioBlock &block);
     /**
       Allows a scope to explicitly request a new frame, even if the scope's autoRefresh is disabled.
       */
@@ -380,6 +380,7 @@ void StopmotionWidget::slotConfigure()
     ui.sm_prenotify->setChecked(KdenliveSettings::sm_prenotify());
     ui.sm_loop->setChecked(KdenliveSettings::sm_loop());
     ui.sm_framesplayback->setValue(KdenliveSettings::sm_framesplayback());
+    ui.sm_frameformat->setCurrentIndex(KdenliveSettings::sm_frameformat());
 
     if (d.exec() == QDialog::Accepted) {
         KdenliveSettings::setSm_loop(ui.sm_loop->isChecked());
@@ -387,6 +388,7 @@ void StopmotionWidget::slotConfigure()
         KdenliveSettings::setSm_framesplayback(ui.sm_framesplayback->value());
         KdenliveSettings::setSm_notifytime(ui.sm_notifytime->value());
         KdenliveSettings::setSm_prenotify(ui.sm_prenotify->isChecked());
+        KdenliveSettings::setSm_frameformat(ui.sm_frameformat->currentIndex());
         m_intervalTimer.setInterval(KdenliveSettings::captureinterval() * 1000);
     }
 }
@@ -654,6 +656,14 @@ void StopmotionWidget::slotCaptureFrame()
         m_intervalTimer.stop();
         return;
     }
+    if (m_captureDevice->isWriterSaturated()) {
+        // Disk is not keeping up, hold this capture instead of queuing more frames
+        log_box->insertItem(0, i18n("Waiting for previous frames to be written"));
+        if (!capture_interval->isChecked()) {
+            m_captureAction->setChecked(false);
+        }
+        return;
+    }
     QString currentPath = getPathForFrame(m_sequenceFrame);
     m_captureDevice->captureFrame(currentPath);
     KNotification::event(QStringLiteral("FrameCaptured"), i18n("Frame Captured"), QPixmap(), this);
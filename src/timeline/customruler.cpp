@@ -31,6 +31,8 @@
 #include <QMouseEvent>
 #include <QStylePainter>
 
+#include <cmath>
+
 // Height of the ruler display
 static int MAX_HEIGHT;
 // Height of the ruler display + timeline preview ruler
@@ -51,6 +53,11 @@ static int littleMarkDistance;
 static int mediumMarkDistance;
 static int bigMarkDistance;
 
+// Width of the cached ruler tiles
+static const int TILE_WIDTH = 256;
+// Maximum number of cached tiles
+static const int TILE_CACHE = 48;
+
 #define SEEK_INACTIVE (-1)
 
 #include "definitions.h"
@@ -67,8 +74,11 @@ CustomRuler::CustomRuler(const Timecode &tc, const QList<QAction *> &rulerAction
     m_headPosition(SEEK_INACTIVE),
     m_clickedGuide(-1),
     m_rate(-1),
-    m_mouseMove(NO_MOVE)
+    m_mouseMove(NO_MOVE),
+    m_frameLabels(KdenliveSettings::frametimecode()),
+    m_tileRatio(1)
 {
+    m_tiles.setMaxCost(TILE_CACHE);
     setFont(QFontDatabase::systemFont(QFontDatabase::SmallestReadableFont));
     QFontMetricsF fontMetrics(font());
     // Define size variables
@@ -105,6 +115,7 @@ CustomRuler::CustomRuler(const Timecode &tc, const QList<QAction *> &rulerAction
 void CustomRuler::updateProjectFps(const Timecode &t)
 {
     m_timecode = t;
+    clearCache();
     mediumMarkDistance = FRAME_SIZE * m_timecode.fps();
     bigMarkDistance = FRAME_SIZE * m_timecode.fps() * 60;
     setPixelPerMark(m_rate);
@@ -141,9 +152,11 @@ void CustomRuler::slotGoToGuide(QAction *act)
 
 void CustomRuler::setZone(const QPoint &p)
 {
+    int zoneStart = m_zoneStart;
+    int zoneEnd = m_zoneEnd;
     m_zoneStart = p.x();
     m_zoneEnd = p.y();
-    update();
+    updateZoneArea(qMin(zoneStart, m_zoneStart), qMax(zoneEnd, m_zoneEnd));
 }
 
 void CustomRuler::mouseReleaseEvent(QMouseEvent *event)
@@ -221,11 +234,7 @@ void CustomRuler::mouseMoveEvent(QMouseEvent *event)
             }
             if (m_mouseMove == HORIZONTAL_MOVE) {
                 if (pos != m_headPosition && pos != m_view->cursorPos()) {
-                    int x = m_headPosition == SEEK_INACTIVE ? pos : m_headPosition;
-                    m_headPosition = pos;
-                    int min = qMin(x, m_headPosition);
-                    int max = qMax(x, m_headPosition);
-                    update(min * m_factor - offset() - 3, LABEL_SIZE, (max - min) * m_factor + 6, FULL_HEIGHT - LABEL_SIZE);
+                    updateRuler(pos);
                     emit seekCursorPos(pos);
                     m_view->slotCheckPositionScrolling();
                 }
@@ -248,9 +257,7 @@ void CustomRuler::mouseMoveEvent(QMouseEvent *event)
             m_zoneStart += move;
             m_zoneEnd += move;
         }
-        int min = qMin(m_zoneStart, zoneStart);
-        int max = qMax(m_zoneEnd, zoneEnd);
-        update(min * m_factor - m_offset - 2, LABEL_SIZE, (max - min + 1) * m_factor + 4, FULL_HEIGHT - LABEL_SIZE);
+        updateZoneArea(qMin(m_zoneStart, zoneStart), qMax(m_zoneEnd, zoneEnd));
 
     } else {
         int pos = (int)((event->x() + m_offset));
@@ -315,8 +322,14 @@ int CustomRuler::outPoint() const
 void CustomRuler::slotMoveRuler(int newPos)
 {
     if (m_offset != newPos) {
+        int dx = m_offset - newPos;
         m_offset = newPos;
-        update();
+        if (qAbs(dx) < width()) {
+            // Only the exposed part needs to be painted
+            scroll(dx, 0);
+        } else {
+            update();
+        }
     }
 }
 
@@ -327,22 +340,67 @@ int CustomRuler::offset() const
 
 void CustomRuler::slotCursorMoved(int oldpos, int newpos)
 {
-    int min = qMin(oldpos, newpos);
-    int max = qMax(oldpos, newpos);
+    if (m_headPosition != SEEK_INACTIVE) {
+        updateCursorArea(m_headPosition);
+    }
     m_headPosition = newpos;
-    update(min * m_factor - m_offset - FONT_WIDTH, LABEL_SIZE, (max - min) * m_factor + FONT_WIDTH * 2 + 2, FULL_HEIGHT - LABEL_SIZE);
+    updateCursorArea(oldpos);
+    updateCursorArea(newpos);
 }
 
 void CustomRuler::updateRuler(int pos)
 {
-    int x = m_headPosition;
+    if (m_headPosition != SEEK_INACTIVE) {
+        updateCursorArea(m_headPosition);
+    }
     m_headPosition = pos;
-    if (x == SEEK_INACTIVE) {
-        x = pos;
+    updateCursorArea(pos);
+}
+
+void CustomRuler::updateCursorArea(int frame)
+{
+    // Covers the seek head and the cursor pointer
+    update(frame * m_factor - m_offset - FONT_WIDTH - 1, LABEL_SIZE, FONT_WIDTH * 2 + 3, height() - LABEL_SIZE);
+}
+
+void CustomRuler::updateZoneArea(int start, int end)
+{
+    // Zone handles are drawn up to FONT_WIDTH / 2 pixels away from the zone
+    int left = start * m_factor - FONT_WIDTH;
+    int right = (end + 1) * m_factor + FONT_WIDTH;
+    invalidateTiles(left, right);
+    update(left - m_offset, LABEL_SIZE, right - left, height() - LABEL_SIZE);
+}
+
+void CustomRuler::invalidateTiles(int left, int right)
+{
+    const int first = qMax(0, left) / TILE_WIDTH;
+    const int last = qMax(0, right) / TILE_WIDTH;
+    for (int i = first; i <= last; ++i) {
+        m_tiles.remove(i);
+    }
+}
+
+void CustomRuler::clearCache()
+{
+    m_tiles.clear();
+    m_labels.clear();
+}
+
+const QString CustomRuler::label(int frame)
+{
+    QHash<int, QString>::const_iterator it = m_labels.constFind(frame);
+    if (it != m_labels.constEnd()) {
+        return it.value();
     }
-    int min = qMin(x, m_headPosition);
-    int max = qMax(x, m_headPosition);
-    update(min * m_factor - offset() - 3, LABEL_SIZE, (max - min) * m_factor + 6, FULL_HEIGHT - LABEL_SIZE);
+    QString lab;
+    if (m_frameLabels) {
+        lab = QString::number(frame);
+    } else {
+        lab = m_timecode.getTimecodeFromFrames(frame);
+    }
+    m_labels.insert(frame, lab);
+    return lab;
 }
 
 void CustomRuler::setPixelPerMark(int rate, bool force)
@@ -352,6 +410,7 @@ void CustomRuler::setPixelPerMark(int rate, bool force)
     }
     int scale = comboScale[rate];
     m_rate = rate;
+    clearCache();
     m_factor = 1.0 / (double) scale * FRAME_SIZE;
     m_scale = 1.0 / (double) scale;
     double fend = m_scale * littleMarkDistance;
@@ -418,91 +477,116 @@ void CustomRuler::setDuration(int d)
     update(qMin(oldduration, m_duration) * m_factor - 1 - offset(), 0, qAbs(oldduration - m_duration) * m_factor + 2, FULL_HEIGHT);
 }
 
+// Draw vertical marks every distance pixels, from top to the bottom of the ruler
+static void drawMarks(QPainter &p, const QRect &paintRect, int offset, double distance, int top)
+{
+    if (distance <= 5) {
+        return;
+    }
+    double f = std::floor((paintRect.left() + offset) / distance) * distance;
+    const int end = paintRect.right() + offset;
+    QLineF l(f - offset, top, f - offset, MAX_HEIGHT);
+    for (; f <= end; f += distance) {
+        p.drawLine(l);
+        l.translate(distance, 0);
+    }
+}
+
 // virtual
 void CustomRuler::paintEvent(QPaintEvent *e)
 {
     QStylePainter p(this);
-    const QRect &paintRect = e->rect();
-    p.setClipRect(paintRect);
+    const QRegion &paintRegion = e->region();
+    p.setClipRegion(paintRegion);
+    if (m_frameLabels != KdenliveSettings::frametimecode() || !qFuzzyCompare(m_tileRatio, devicePixelRatioF())) {
+        m_frameLabels = KdenliveSettings::frametimecode();
+        m_tileRatio = devicePixelRatioF();
+        clearCache();
+    }
+
+    // Copy the ruler from the cached tiles, only rendering the missing ones
+    const QVector<QRect> rects = paintRegion.rects();
+    int lastTile = -1;
+    for (const QRect &rect : rects) {
+        const int first = qMax(lastTile + 1, (rect.left() + m_offset) / TILE_WIDTH);
+        const int last = (rect.right() + m_offset) / TILE_WIDTH;
+        for (int i = first; i <= last; ++i) {
+            p.drawPixmap(i * TILE_WIDTH - m_offset, 0, tile(i));
+        }
+        lastTile = qMax(lastTile, last);
+    }
+
+    if (m_headPosition == m_view->cursorPos()) {
+        m_headPosition = SEEK_INACTIVE;
+    }
+    if (m_headPosition != SEEK_INACTIVE) {
+        p.fillRect(m_headPosition * m_factor - m_offset - 1, LABEL_SIZE + 1, 3, FULL_HEIGHT - LABEL_SIZE - 1, palette().linkVisited());
+    }
+
+    // draw pointer
+    const int value = m_view->cursorPos() * m_factor - m_offset;
+    QPolygon pa(3);
+    pa.setPoints(3, value - FONT_WIDTH, FULL_HEIGHT - FONT_WIDTH, value + FONT_WIDTH, FULL_HEIGHT - FONT_WIDTH, value, FULL_HEIGHT);
+    p.setBrush(palette().brush(QPalette::Text));
+    p.setPen(Qt::NoPen);
+    p.drawPolygon(pa);
+}
+
+QPixmap CustomRuler::tile(int index)
+{
+    QPixmap *cached = m_tiles.object(index);
+    if (cached) {
+        return *cached;
+    }
+    QPixmap pix(TILE_WIDTH * m_tileRatio, height() * m_tileRatio);
+    pix.setDevicePixelRatio(m_tileRatio);
+    QPainter p(&pix);
+    p.setFont(font());
+    paintTile(p, QRect(0, 0, TILE_WIDTH, height()), index * TILE_WIDTH);
+    p.end();
+    m_tiles.insert(index, new QPixmap(pix));
+    return pix;
+}
+
+void CustomRuler::paintTile(QPainter &p, const QRect &paintRect, int offset)
+{
     p.fillRect(paintRect, palette().midlight().color());
 
     // Draw zone background
     const int zoneStart = (int)(m_zoneStart * m_factor);
     const int zoneEnd = (int)((m_zoneEnd + 1) * m_factor);
     int zoneHeight = LABEL_SIZE * 0.8;
-    p.fillRect(zoneStart - m_offset, MAX_HEIGHT - zoneHeight + 1, zoneEnd - zoneStart, zoneHeight - 1, m_zoneBG);
-
-    double f, fend;
-    const int offsetmax = ((paintRect.right() + m_offset) / FRAME_SIZE + 1) * FRAME_SIZE;
-    int offsetmin;
+    p.fillRect(zoneStart - offset, MAX_HEIGHT - zoneHeight + 1, zoneEnd - zoneStart, zoneHeight - 1, m_zoneBG);
 
     p.setPen(palette().text().color());
     // draw time labels
-    if (paintRect.y() < LABEL_SIZE) {
-        offsetmin = (paintRect.left() + m_offset) / m_textSpacing;
-        offsetmin = offsetmin * m_textSpacing;
-        for (f = offsetmin; f < offsetmax; f += m_textSpacing) {
-            QString lab;
-            if (KdenliveSettings::frametimecode()) {
-                lab = QString::number((int)(f / m_factor + 0.5));
-            } else {
-                lab = m_timecode.getTimecodeFromFrames((int)(f / m_factor + 0.5));
-            }
-            p.drawText(f - m_offset + 2, LABEL_SIZE, lab);
-        }
+    const int offsetmax = paintRect.right() + offset;
+    int offsetmin = (paintRect.left() + offset) / m_textSpacing;
+    for (double f = offsetmin * m_textSpacing; f < offsetmax; f += m_textSpacing) {
+        p.drawText(f - offset + 2, LABEL_SIZE, label((int)(f / m_factor + 0.5)));
     }
     p.setPen(palette().dark().color());
-    offsetmin = (paintRect.left() + m_offset) / littleMarkDistance;
-    offsetmin = offsetmin * littleMarkDistance;
-    // draw the little marks
-    fend = m_scale * littleMarkDistance;
-    if (fend > 5) {
-        QLineF l(offsetmin - m_offset, LITTLE_MARK_X, offsetmin - m_offset, MAX_HEIGHT);
-        for (f = offsetmin; f < offsetmax; f += fend) {
-            l.translate(fend, 0);
-            p.drawLine(l);
-        }
-    }
-
-    offsetmin = (paintRect.left() + m_offset) / mediumMarkDistance;
-    offsetmin = offsetmin * mediumMarkDistance;
-    // draw medium marks
-    fend = m_scale * mediumMarkDistance;
-    if (fend > 5) {
-        QLineF l(offsetmin - m_offset - fend, MIDDLE_MARK_X, offsetmin - m_offset - fend, MAX_HEIGHT);
-        for (f = offsetmin - fend; f < offsetmax + fend; f += fend) {
-            l.translate(fend, 0);
-            p.drawLine(l);
-        }
-    }
+    // draw the little, medium and big marks
+    drawMarks(p, paintRect, offset, m_scale * littleMarkDistance, LITTLE_MARK_X);
+    drawMarks(p, paintRect, offset, m_scale * mediumMarkDistance, MIDDLE_MARK_X);
+    drawMarks(p, paintRect, offset, m_scale * bigMarkDistance, LABEL_SIZE);
 
-    offsetmin = (paintRect.left() + m_offset) / bigMarkDistance;
-    offsetmin = offsetmin * bigMarkDistance;
-    // draw big marks
-    fend = m_scale * bigMarkDistance;
-    if (fend > 5) {
-        QLineF l(offsetmin - m_offset, LABEL_SIZE, offsetmin - m_offset, MAX_HEIGHT);
-        for (f = offsetmin; f < offsetmax; f += fend) {
-            l.translate(fend, 0);
-            p.drawLine(l);
-        }
-    }
     // draw zone handles
     if (zoneStart > 0) {
         QPolygon pa(4);
-        pa.setPoints(4, zoneStart - m_offset + FONT_WIDTH / 2, MAX_HEIGHT - zoneHeight, zoneStart - m_offset, MAX_HEIGHT - zoneHeight, zoneStart - m_offset, MAX_HEIGHT, zoneStart - m_offset + FONT_WIDTH / 2, MAX_HEIGHT);
+        pa.setPoints(4, zoneStart - offset + FONT_WIDTH / 2, MAX_HEIGHT - zoneHeight, zoneStart - offset, MAX_HEIGHT - zoneHeight, zoneStart - offset, MAX_HEIGHT, zoneStart - offset + FONT_WIDTH / 2, MAX_HEIGHT);
         p.drawPolyline(pa);
     }
 
     if (zoneEnd > 0) {
         QColor center(Qt::white);
         center.setAlpha(150);
-        QRect rec(zoneStart - m_offset + (zoneEnd - zoneStart - zoneHeight) / 2 + 2, MAX_HEIGHT - zoneHeight + 2, zoneHeight - 4, zoneHeight - 4);
+        QRect rec(zoneStart - offset + (zoneEnd - zoneStart - zoneHeight) / 2 + 2, MAX_HEIGHT - zoneHeight + 2, zoneHeight - 4, zoneHeight - 4);
         p.fillRect(rec, center);
         p.drawRect(rec);
 
         QPolygon pa(4);
-        pa.setPoints(4, zoneEnd - m_offset - FONT_WIDTH / 2, MAX_HEIGHT - zoneHeight, zoneEnd - m_offset, MAX_HEIGHT - zoneHeight, zoneEnd - m_offset, MAX_HEIGHT, zoneEnd - m_offset - FONT_WIDTH / 2, MAX_HEIGHT);
+        pa.setPoints(4, zoneEnd - offset - FONT_WIDTH / 2, MAX_HEIGHT - zoneHeight, zoneEnd - offset, MAX_HEIGHT - zoneHeight, zoneEnd - offset, MAX_HEIGHT, zoneEnd - offset - FONT_WIDTH / 2, MAX_HEIGHT);
         p.drawPolyline(pa);
     }
 
@@ -513,23 +597,26 @@ void CustomRuler::paintEvent(QPaintEvent *e)
         p.fillRect(paintRect.left(), MAX_HEIGHT + 1, paintRect.width(), PREVIEW_SIZE - 1, palette().mid().color());
         QColor preview(Qt::green);
         preview.setAlpha(120);
-        double chunkWidth = KdenliveSettings::timelinechunks() * m_factor;
-        foreach (int frame, m_renderingPreviews) {
-            double xPos = frame * m_factor  - m_offset;
-            if (xPos + chunkWidth < paintRect.x() || xPos > paintRect.right()) {
-                continue;
-            }
-            QRectF rec(xPos, MAX_HEIGHT + 1, chunkWidth, PREVIEW_SIZE - 1);
+        // Only the intervals inside the painted area are drawn, one rectangle per interval
+        const int startFrame = qMax(0, (int)((paintRect.x() + offset) / m_factor));
+        const int endFrame = (int)((paintRect.right() + offset) / m_factor) + 2;
+        const QVector<IntervalSet::Interval> rendered = m_renderingPreviews.intervals(startFrame, endFrame);
+        for (const IntervalSet::Interval &interval : rendered) {
+            QRectF rec(interval.first * m_factor - offset, MAX_HEIGHT + 1, (interval.second - interval.first) * m_factor, PREVIEW_SIZE - 1);
             p.fillRect(rec, preview);
         }
         preview = QColor(200, 0, 0);
         preview.setAlpha(120);
-        foreach (int frame, m_dirtyRenderingPreviews) {
-            double xPos = frame * m_factor  - m_offset;
-            if (xPos + chunkWidth < paintRect.x() || xPos > paintRect.right()) {
-                continue;
-            }
-            QRectF rec(xPos, MAX_HEIGHT + 1, chunkWidth, PREVIEW_SIZE - 1);
+        const QVector<IntervalSet::Interval> dirty = m_dirtyRenderingPreviews.intervals(startFrame, endFrame);
+        for (const IntervalSet::Interval &interval : dirty) {
+            QRectF rec(interval.first * m_factor - offset, MAX_HEIGHT + 1, (interval.second - interval.first) * m_factor, PREVIEW_SIZE - 1);
+            p.fillRect(rec, preview);
+        }
+        preview = QColor(230, 140, 0);
+        preview.setAlpha(120);
+        const QVector<IntervalSet::Interval> processing = m_processingPreviews.intervals(startFrame, endFrame);
+        for (const IntervalSet::Interval &interval : processing) {
+            QRectF rec(interval.first * m_factor - offset, MAX_HEIGHT + 1, (interval.second - interval.first) * m_factor, PREVIEW_SIZE - 1);
             p.fillRect(rec, preview);
         }
         preview = palette().dark().color();
@@ -537,62 +624,79 @@ void CustomRuler::paintEvent(QPaintEvent *e)
         p.fillRect(paintRect.left(), MAX_HEIGHT + 1, paintRect.width(), 2, preview);
         p.drawLine(paintRect.left(), MAX_HEIGHT + PREVIEW_SIZE, paintRect.right(), MAX_HEIGHT + PREVIEW_SIZE);
     }
+}
 
-    if (m_headPosition == m_view->cursorPos()) {
-        m_headPosition = SEEK_INACTIVE;
-    }
-    if (m_headPosition != SEEK_INACTIVE) {
-        p.fillRect(m_headPosition * m_factor - m_offset - 1, LABEL_SIZE + 1, 3, FULL_HEIGHT - LABEL_SIZE - 1, palette().linkVisited());
+void CustomRuler::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::FontChange) {
+        m_tiles.clear();
     }
-
-    // draw pointer
-    const int value = m_view->cursorPos() * m_factor - m_offset;
-    QPolygon pa(3);
-    pa.setPoints(3, value - FONT_WIDTH, FULL_HEIGHT - FONT_WIDTH, value + FONT_WIDTH, FULL_HEIGHT - FONT_WIDTH, value, FULL_HEIGHT);
-    p.setBrush(palette().brush(QPalette::Text));
-    p.setPen(Qt::NoPen);
-    p.drawPolygon(pa);
+    QWidget::changeEvent(event);
 }
 
 void CustomRuler::activateZone()
 {
     m_zoneBG.setAlpha(KdenliveSettings::useTimelineZoneToEdit() ? 180 : 60);
+    m_tiles.clear();
     update();
 }
 
-bool CustomRuler::isUnderPreview(int start, int end)
+bool CustomRuler::isUnderPreview(int start, int end) const
 {
-    QList<int> allPreviews;
-    allPreviews << m_renderingPreviews << m_dirtyRenderingPreviews;
-    qSort(allPreviews);
-    foreach (int ix, allPreviews) {
-        if (ix >= start && ix <= end) {
-            return true;
-        }
-    }
-    return false;
+    return m_renderingPreviews.intersects(start, end) || m_dirtyRenderingPreviews.intersects(start, end);
 }
 
 bool CustomRuler::updatePreview(int frame, bool rendered, bool refresh)
 {
     bool result = false;
+    const int chunkSize = KdenliveSettings::timelinechunks();
     if (rendered) {
-        m_renderingPreviews << frame;
-        m_dirtyRenderingPreviews.removeAll(frame);
+        m_renderingPreviews.insert(frame, frame + chunkSize);
+        m_dirtyRenderingPreviews.remove(frame, frame + chunkSize);
+        m_processingPreviews.remove(frame, frame + chunkSize);
     } else {
-        if (m_renderingPreviews.removeAll(frame) > 0) {
-            m_dirtyRenderingPreviews << frame;
+        if (!m_renderingPreviews.remove(frame, frame + chunkSize).isEmpty()) {
+            m_dirtyRenderingPreviews.insert(frame, frame + chunkSize);
             result = true;
         }
     }
-    std::sort(m_renderingPreviews.begin(), m_renderingPreviews.end());
-    std::sort(m_dirtyRenderingPreviews.begin(), m_dirtyRenderingPreviews.end());
-    if (refresh && !m_hidePreview) {
-        update(frame * m_factor - offset(), MAX_HEIGHT, KdenliveSettings::timelinechunks() * m_factor + 1, PREVIEW_SIZE);
+    if (refresh) {
+        updatePreviewArea(frame, frame + chunkSize);
     }
     return result;
 }
 
+QList<int> CustomRuler::invalidateChunks(int start, int end)
+{
+    const QVector<IntervalSet::Interval> removed = m_renderingPreviews.remove(start, end);
+    for (const IntervalSet::Interval &interval : removed) {
+        m_dirtyRenderingPreviews.insert(interval.first, interval.second);
+    }
+    m_processingPreviews.remove(start, end);
+    return IntervalSet::points(removed, KdenliveSettings::timelinechunks());
+}
+
+void CustomRuler::setProcessingChunks(const QList<int> &chunks)
+{
+    if (chunks.isEmpty()) {
+        return;
+    }
+    const int chunkSize = KdenliveSettings::timelinechunks();
+    for (int frame : chunks) {
+        m_processingPreviews.insert(frame, frame + chunkSize);
+    }
+    updatePreviewArea(m_processingPreviews.first(), m_processingPreviews.end());
+}
+
+void CustomRuler::clearProcessingChunks()
+{
+    if (m_processingPreviews.isEmpty()) {
+        return;
+    }
+    updatePreviewArea(m_processingPreviews.first(), m_processingPreviews.end());
+    m_processingPreviews.clear();
+}
+
 void CustomRuler::hidePreview(bool hide)
 {
     m_hidePreview = hide;
@@ -605,13 +709,20 @@ void CustomRuler::hidePreview(bool hide)
         setFixedHeight(MAX_HEIGHT + PREVIEW_SIZE + 1);
         //MAX_HEIGHT = height() - LABEL_SIZE / 3;
     }
+    m_tiles.clear();
     update();
 }
 
 void CustomRuler::updatePreviewDisplay(int start, int end)
+{
+    updatePreviewArea(start, end + KdenliveSettings::timelinechunks());
+}
+
+void CustomRuler::updatePreviewArea(int start, int end)
 {
     if (!m_hidePreview) {
-        update(start * m_factor - offset(), MAX_HEIGHT, (end - start) * KdenliveSettings::timelinechunks() * m_factor + 1, PREVIEW_SIZE);
+        invalidateTiles(start * m_factor, end * m_factor + 1);
+        update(start * m_factor - offset(), MAX_HEIGHT, (end - start) * m_factor + 1, PREVIEW_SIZE);
     }
 }
 
@@ -619,10 +730,11 @@ const QPair <QStringList, QStringList> CustomRuler::previewChunks() const
 {
     QStringList clean;
     QStringList dirty;
-    foreach (int frame, m_renderingPreviews) {
+    const int chunkSize = KdenliveSettings::timelinechunks();
+    foreach (int frame, m_renderingPreviews.points(chunkSize)) {
         clean << QString::number(frame);
     }
-    foreach (int frame, m_dirtyRenderingPreviews) {
+    foreach (int frame, m_dirtyRenderingPreviews.points(chunkSize)) {
         dirty << QString::number(frame);
     }
     QPair <QStringList, QStringList> resultChunks;
@@ -633,12 +745,12 @@ const QPair <QStringList, QStringList> CustomRuler::previewChunks() const
 
 const QList<int> CustomRuler::getProcessedChunks() const
 {
-    return m_renderingPreviews;
+    return m_renderingPreviews.points(KdenliveSettings::timelinechunks());
 }
 
 const QList<int> CustomRuler::getDirtyChunks() const
 {
-    return m_dirtyRenderingPreviews;
+    return m_dirtyRenderingPreviews.points(KdenliveSettings::timelinechunks());
 }
 
 bool CustomRuler::hasPreviewRange() const
@@ -650,40 +762,40 @@ void CustomRuler::clearChunks()
 {
     m_renderingPreviews.clear();
     m_dirtyRenderingPreviews.clear();
+    m_processingPreviews.clear();
+    m_tiles.clear();
     update();
 }
 
-QList<int> CustomRuler::addChunks(QList<int> chunks, bool add)
+QList<int> CustomRuler::addChunks(int start, int end, bool add)
 {
-    qSort(chunks);
     QList<int> toProcess;
+    if (start >= end) {
+        return toProcess;
+    }
+    const int chunkSize = KdenliveSettings::timelinechunks();
     if (add) {
-        foreach (int frame, chunks) {
-            if (m_renderingPreviews.contains(frame)) {
-                // already rendered, ignore
-                continue;
-            }
-            if (m_dirtyRenderingPreviews.contains(frame)) {
-                continue;
+        // New dirty chunks are the holes left by rendered and already dirty chunks
+        QVector<IntervalSet::Interval> known = m_renderingPreviews.intervals(start, end);
+        known << m_dirtyRenderingPreviews.intervals(start, end);
+        std::sort(known.begin(), known.end());
+        known << IntervalSet::Interval(end, end);
+        QVector<IntervalSet::Interval> holes;
+        int frame = start;
+        for (const IntervalSet::Interval &interval : known) {
+            if (interval.first > frame) {
+                holes << IntervalSet::Interval(frame, interval.first);
+                m_dirtyRenderingPreviews.insert(frame, interval.first);
             }
-            m_dirtyRenderingPreviews << frame;
-            // This is a new dirty chunk
-            toProcess << frame;
+            frame = qMax(frame, interval.second);
         }
+        toProcess = IntervalSet::points(holes, chunkSize);
     } else {
-        foreach (int frame, chunks) {
-            if (m_renderingPreviews.removeAll(frame) > 0) {
-                // A preview file existed for this chunk, ask deletion
-                toProcess << frame;
-            }
-            m_dirtyRenderingPreviews.removeAll(frame);
-        }
-    }
-    std::sort(m_renderingPreviews.begin(), m_renderingPreviews.end());
-    std::sort(m_dirtyRenderingPreviews.begin(), m_dirtyRenderingPreviews.end());
-    if (!m_hidePreview) {
-        update(chunks.constFirst() * m_factor - offset(), MAX_HEIGHT, (chunks.last() - chunks.constFirst()) * KdenliveSettings::timelinechunks() * m_factor + 1, PREVIEW_SIZE);
+        // A preview file existed for these chunks, ask deletion
+        toProcess = IntervalSet::points(m_renderingPreviews.remove(start, end), chunkSize);
+        m_dirtyRenderingPreviews.remove(start, end);
+        m_processingPreviews.remove(start, end);
     }
+    updatePreviewArea(start, end);
     return toProcess;
 }
-
@@ -28,8 +28,12 @@
 
 #include <QWidget>
 #include <QPair>
+#include <QCache>
+#include <QHash>
+#include <QPixmap>
 
 #include "timeline/customtrackview.h"
+#include "timeline/intervalset.h"
 #include "timecode.h"
 
 enum RULER_MOVE { RULER_CURSOR = 0, RULER_START = 1, RULER_MIDDLE = 2, RULER_END = 3 };
@@ -59,12 +63,20 @@ public:
     /** @brief Returns a list of dirty timeline preview chunks (that need to be generated) */
     const QList<int> getDirtyChunks() const;
     void clearChunks();
-    QList<int> addChunks(QList<int> chunks, bool add);
+    /** @brief Add the chunks of frames [start, end) to the preview zone, or remove them from it
+     *  Returns the chunks that need rendering when adding, the previously rendered ones when removing */
+    QList<int> addChunks(int start, int end, bool add);
+    /** @brief Mark the rendered chunks of frames [start, end) as dirty, returns the chunks that were rendered */
+    QList<int> invalidateChunks(int start, int end);
+    /** @brief Mark chunks as being rendered */
+    void setProcessingChunks(const QList<int> &chunks);
+    void clearProcessingChunks();
     /** @brief Returns true if a timeline preview zone has already be defined */
     bool hasPreviewRange() const;
-    /** @brief Refresh timeline preview range */
+    /** @brief Refresh timeline preview display for chunks from start to end (included) */
     void updatePreviewDisplay(int start, int end);
-    bool isUnderPreview(int start, int end);
+    /** @brief Returns true if some frame of [start, end) is in the preview zone */
+    bool isUnderPreview(int start, int end) const;
     void hidePreview(bool hide);
 
 protected:
@@ -73,6 +85,7 @@ protected:
     void mousePressEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
     void mouseReleaseEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
     void mouseMoveEvent(QMouseEvent *event) Q_DECL_OVERRIDE;
+    void changeEvent(QEvent *event) Q_DECL_OVERRIDE;
 
 private:
     Timecode m_timecode;
@@ -99,8 +112,33 @@ private:
     int m_startRate;
     MOUSE_MOVE m_mouseMove;
     QMenu *m_goMenu;
-    QList<int> m_renderingPreviews;
-    QList<int> m_dirtyRenderingPreviews;
+    /** @brief Frames of the rendered, dirty and currently rendering preview chunks */
+    IntervalSet m_renderingPreviews;
+    IntervalSet m_dirtyRenderingPreviews;
+    IntervalSet m_processingPreviews;
+    /** @brief Rendered ruler (labels, marks, zone and preview chunks) by tile index, without cursor */
+    QCache<int, QPixmap> m_tiles;
+    /** @brief Formatted time labels by frame, for the current frame rate and format */
+    QHash<int, QString> m_labels;
+    /** @brief True if the cached labels are frame numbers instead of timecodes */
+    bool m_frameLabels;
+    /** @brief Device pixel ratio of the cached tiles */
+    qreal m_tileRatio;
+    /** @brief Repaint the preview area of frames [start, end) */
+    void updatePreviewArea(int start, int end);
+    /** @brief Repaint the seek head and cursor pointer area at frame */
+    void updateCursorArea(int frame);
+    /** @brief Invalidate and repaint the zone area between frames start and end */
+    void updateZoneArea(int start, int end);
+    /** @brief Remove the cached tiles covering the ruler pixels [left, right] */
+    void invalidateTiles(int left, int right);
+    /** @brief Remove all cached tiles and labels, needed when zoom or frame rate changes */
+    void clearCache();
+    /** @brief Returns the cached tile, rendering it if needed */
+    QPixmap tile(int index);
+    /** @brief Draw the ruler, except the cursor, for the ruler pixels starting at offset */
+    void paintTile(QPainter &p, const QRect &paintRect, int offset);
+    const QString label(int frame);
 
 public slots:
     void slotMoveRuler(int newPos);
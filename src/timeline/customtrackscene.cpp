@@ -20,6 +20,8 @@
 #include "customtrackscene.h"
 #include "timeline.h"
 
+#include <algorithm>
+
 CustomTrackScene::CustomTrackScene(Timeline *timeline, QObject *parent) :
     QGraphicsScene(parent),
     isZooming(false),
@@ -42,11 +44,15 @@ double CustomTrackScene::getSnapPointForPos(double pos, bool doSnap)
         } else {
             maximumOffset = 6 / m_scale.x();
         }
-        for (int i = 0; i < m_snapPoints.size(); ++i) {
-            if (qAbs((int)(pos - m_snapPoints.at(i).frames(m_timeline->fps()))) < maximumOffset) {
-                return m_snapPoints.at(i).frames(m_timeline->fps());
+        // Snap points are sorted, skip the ones too far before pos
+        const GenTime first((pos - maximumOffset - 1) / m_timeline->fps());
+        QList<GenTime>::const_iterator it = std::lower_bound(m_snapPoints.constBegin(), m_snapPoints.constEnd(), first);
+        for (; it != m_snapPoints.constEnd(); ++it) {
+            const double snap = it->frames(m_timeline->fps());
+            if (qAbs((int)(pos - snap)) < maximumOffset) {
+                return snap;
             }
-            if (m_snapPoints.at(i).frames(m_timeline->fps()) > pos) {
+            if (snap > pos) {
                 break;
             }
         }
@@ -61,25 +67,20 @@ void CustomTrackScene::setSnapList(const QList<GenTime> &snaps)
 
 GenTime CustomTrackScene::previousSnapPoint(const GenTime &pos) const
 {
-    for (int i = 0; i < m_snapPoints.size(); ++i) {
-        if (m_snapPoints.at(i) >= pos) {
-            if (i == 0) {
-                return GenTime();
-            }
-            return m_snapPoints.at(i - 1);
-        }
+    QList<GenTime>::const_iterator it = std::lower_bound(m_snapPoints.constBegin(), m_snapPoints.constEnd(), pos);
+    if (it == m_snapPoints.constBegin() || it == m_snapPoints.constEnd()) {
+        return GenTime();
     }
-    return GenTime();
+    return *(it - 1);
 }
 
 GenTime CustomTrackScene::nextSnapPoint(const GenTime &pos) const
 {
-    foreach (const GenTime &seekPoint, m_snapPoints) {
-        if (seekPoint > pos) {
-            return seekPoint;
-        }
+    QList<GenTime>::const_iterator it = std::upper_bound(m_snapPoints.constBegin(), m_snapPoints.constEnd(), pos);
+    if (it == m_snapPoints.constEnd()) {
+        return pos;
     }
-    return pos;
+    return *it;
 }
 
 void CustomTrackScene::setScale(double scale, double vscale)
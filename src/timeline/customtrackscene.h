@@ -42,6 +42,7 @@ class CustomTrackScene : public QGraphicsScene
 public:
     explicit CustomTrackScene(Timeline *timeline, QObject *parent = nullptr);
     ~CustomTrackScene();
+    /** @brief Set the snap points, which must be sorted */
     void setSnapList(const QList<GenTime> &snaps);
     GenTime previousSnapPoint(const GenTime &pos) const;
     GenTime nextSnapPoint(const GenTime &pos) const;
@@ -66,9 +66,12 @@
 #include <QScrollBar>
 #include <QApplication>
 #include <QMimeData>
+#include <QSet>
 
 #include <QGraphicsDropShadowEffect>
 
+#include <algorithm>
+
 #define SEEK_INACTIVE (-1)
 //#define DEBUG
 
@@ -3731,6 +3734,8 @@ void CustomTrackView::addTrack(const TrackInfo &type, int ix)
     }
     // insert track in MLT's playlist
     transitionInfos = m_document->renderer()->mltInsertTrack(ix,  type.trackName, type.type == VideoTrack);
+    // MLT moved the transitions of the following tracks
+    m_timeline->transitionHandler->invalidateIndex();
     Mlt::Tractor *tractor = m_document->renderer()->lockService();
     m_document->renderer()->unlockService(tractor);
     // Reload timeline and m_tracks structure from MLT's playlist
@@ -3796,6 +3801,7 @@ void CustomTrackView::removeTrack(int ix)
         if (mixTr) {
             field->disconnect_service(*mixTr.data());
         }
+        m_timeline->transitionHandler->invalidateIndex();
     }
     // Prepare groups for reload
     QDomDocument doc;
@@ -3831,6 +3837,7 @@ void CustomTrackView::removeTrack(int ix)
 
     // Delete track in MLT playlist
     tractor->remove_track(ix);
+    m_timeline->transitionHandler->invalidateIndex();
     m_document->renderer()->unlockService(tractor);
     reloadTimeline();
     // Refresh track compositing and audio mix
@@ -4206,6 +4213,7 @@ void CustomTrackView::insertSpace(const QList<ItemInfo> &clipsToMove, const QLis
         rebuildGroup(grp);
     }
     m_document->renderer()->mltInsertSpace(trackClipStartList, trackTransitionStartList, track, duration, offset);
+    m_timeline->transitionHandler->invalidateIndex();
 }
 
 void CustomTrackView::deleteClip(const QString &clipId, QUndoCommand *deleteCommand)
@@ -4380,6 +4388,7 @@ void CustomTrackView::completeSpaceOperation(int track, GenTime &timeOffset, boo
             m_commandStack->push(command);
             if (!fromStart) {
                 m_document->renderer()->mltInsertSpace(trackClipStartList, trackTransitionStartList, track, timeOffset, GenTime());
+                m_timeline->transitionHandler->invalidateIndex();
             }
         }
     }
@@ -5854,7 +5863,7 @@ double CustomTrackView::getSnapPointForPos(double pos)
 
 void CustomTrackView::updateSnapPoints(AbstractClipItem *selected, QList<GenTime> offsetList, bool skipSelectedItems)
 {
-    QList<GenTime> snaps;
+    QSet<GenTime> snaps;
     if (selected && offsetList.isEmpty()) {
         offsetList.append(selected->cropDuration());
     }
@@ -5873,22 +5882,16 @@ void CustomTrackView::updateSnapPoints(AbstractClipItem *selected, QList<GenTime
             }
             GenTime start = item->startPos();
             GenTime end = item->endPos();
-            if (!snaps.contains(start)) {
-                snaps.append(start);
-            }
-            if (!snaps.contains(end)) {
-                snaps.append(end);
-            }
+            snaps.insert(start);
+            snaps.insert(end);
             if (!offsetList.isEmpty()) {
                 for (int j = 0; j < offsetList.size(); ++j) {
                     GenTime offset = end - offsetList.at(j);
                     if (offset > GenTime()) {
-                        if (!snaps.contains(offset)) {
-                            snaps.append(offset);
-                        }
+                        snaps.insert(offset);
                         offset = start - offsetList.at(j);
-                        if (offset > GenTime() && !snaps.contains(offset)) {
-                            snaps.append(offset);
+                        if (offset > GenTime()) {
+                            snaps.insert(offset);
                         }
                     }
                 }
@@ -5903,14 +5906,12 @@ void CustomTrackView::updateSnapPoints(AbstractClipItem *selected, QList<GenTime
             }
             for (int j = 0; j < markers.size(); ++j) {
                 GenTime t = markers.at(j);
-                if (!snaps.contains(t)) {
-                    snaps.append(t);
-                }
+                snaps.insert(t);
                 if (!offsetList.isEmpty()) {
                     for (int k = 0; k < offsetList.size(); ++k) {
                         GenTime offset = t - offsetList.at(k);
-                        if (offset > GenTime() && !snaps.contains(offset)) {
-                            snaps.append(offset);
+                        if (offset > GenTime()) {
+                            snaps.insert(offset);
                         }
                     }
                 }
@@ -5922,22 +5923,16 @@ void CustomTrackView::updateSnapPoints(AbstractClipItem *selected, QList<GenTime
             }
             GenTime start = transition->startPos();
             GenTime end = transition->endPos();
-            if (!snaps.contains(start)) {
-                snaps.append(start);
-            }
-            if (!snaps.contains(end)) {
-                snaps.append(end);
-            }
+            snaps.insert(start);
+            snaps.insert(end);
             if (!offsetList.isEmpty()) {
                 for (int j = 0; j < offsetList.size(); ++j) {
                     GenTime offset = end - offsetList.at(j);
                     if (offset > GenTime()) {
-                        if (!snaps.contains(offset)) {
-                            snaps.append(offset);
-                        }
+                        snaps.insert(offset);
                         offset = start - offsetList.at(j);
-                        if (offset > GenTime() && !snaps.contains(offset)) {
-                            snaps.append(offset);
+                        if (offset > GenTime()) {
+                            snaps.insert(offset);
                         }
                     }
                 }
@@ -5947,30 +5942,22 @@ void CustomTrackView::updateSnapPoints(AbstractClipItem *selected, QList<GenTime
 
     // add cursor position
     GenTime pos = GenTime(m_cursorPos, m_document->fps());
-    if (!snaps.contains(pos)) {
-        snaps.append(pos);
-    }
+    snaps.insert(pos);
     if (!offsetList.isEmpty()) {
         for (int j = 0; j < offsetList.size(); ++j) {
             GenTime offset = pos - offsetList.at(j);
-            if (!snaps.contains(offset)) {
-                snaps.append(offset);
-            }
+            snaps.insert(offset);
         }
     }
 
     // add guides
     for (int i = 0; i < m_guides.count(); ++i) {
         GenTime cur_pos = m_guides.at(i)->position();
-        if (!snaps.contains(cur_pos)) {
-            snaps.append(cur_pos);
-        }
+        snaps.insert(cur_pos);
         if (!offsetList.isEmpty()) {
             for (int j = 0; j < offsetList.size(); ++j) {
                 GenTime offset = cur_pos - offsetList.at(j);
-                if (!snaps.contains(offset)) {
-                    snaps.append(offset);
-                }
+                snaps.insert(offset);
             }
         }
     }
@@ -5978,16 +5965,13 @@ void CustomTrackView::updateSnapPoints(AbstractClipItem *selected, QList<GenTime
     // add render zone
     QPoint z = m_document->zone();
     pos = GenTime(z.x(), m_document->fps());
-    if (!snaps.contains(pos)) {
-        snaps.append(pos);
-    }
+    snaps.insert(pos);
     pos = GenTime(z.y(), m_document->fps());
-    if (!snaps.contains(pos)) {
-        snaps.append(pos);
-    }
+    snaps.insert(pos);
 
-    qSort(snaps);
-    m_scene->setSnapList(snaps);
+    QList<GenTime> sortedSnaps = snaps.toList();
+    std::sort(sortedSnaps.begin(), sortedSnaps.end());
+    m_scene->setSnapList(sortedSnaps);
     //for (int i = 0; i < m_snapPoints.size(); ++i)
     //    //qCDebug(KDENLIVE_LOG) << "SNAP POINT: " << m_snapPoints.at(i).frames(25);
 }
@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "intervalset.h"
+
+void IntervalSet::insert(int start, int end)
+{
+    if (start >= end) {
+        return;
+    }
+    QMap<int, int>::iterator it = m_intervals.upperBound(start);
+    if (it != m_intervals.begin()) {
+        QMap<int, int>::iterator previous = it - 1;
+        if (previous.value() >= start) {
+            // Extend the interval containing or touching start
+            start = previous.key();
+            end = qMax(end, previous.value());
+            it = m_intervals.erase(previous);
+        }
+    }
+    while (it != m_intervals.end() && it.key() <= end) {
+        end = qMax(end, it.value());
+        it = m_intervals.erase(it);
+    }
+    m_intervals.insert(start, end);
+}
+
+QVector<IntervalSet::Interval> IntervalSet::remove(int start, int end)
+{
+    QVector<Interval> removed;
+    if (start >= end) {
+        return removed;
+    }
+    QMap<int, int>::iterator it = m_intervals.upperBound(start);
+    if (it != m_intervals.begin() && (it - 1).value() > start) {
+        --it;
+    }
+    // Parts of the intervals outside of [start, end) are put back afterwards
+    Interval head(0, 0);
+    Interval tail(0, 0);
+    while (it != m_intervals.end() && it.key() < end) {
+        const int from = it.key();
+        const int to = it.value();
+        if (from < start) {
+            head = Interval(from, start);
+        }
+        if (to > end) {
+            tail = Interval(end, to);
+        }
+        removed << Interval(qMax(from, start), qMin(to, end));
+        it = m_intervals.erase(it);
+    }
+    if (head.first < head.second) {
+        m_intervals.insert(head.first, head.second);
+    }
+    if (tail.first < tail.second) {
+        m_intervals.insert(tail.first, tail.second);
+    }
+    return removed;
+}
+
+void IntervalSet::clear()
+{
+    m_intervals.clear();
+}
+
+bool IntervalSet::isEmpty() const
+{
+    return m_intervals.isEmpty();
+}
+
+int IntervalSet::count() const
+{
+    return m_intervals.count();
+}
+
+bool IntervalSet::contains(int frame) const
+{
+    return intersects(frame, frame + 1);
+}
+
+bool IntervalSet::intersects(int start, int end) const
+{
+    if (start >= end) {
+        return false;
+    }
+    // Last interval starting before end
+    QMap<int, int>::const_iterator it = m_intervals.lowerBound(end);
+    if (it == m_intervals.constBegin()) {
+        return false;
+    }
+    --it;
+    return it.value() > start;
+}
+
+QVector<IntervalSet::Interval> IntervalSet::intervals(int start, int end) const
+{
+    QVector<Interval> result;
+    if (start >= end) {
+        return result;
+    }
+    QMap<int, int>::const_iterator it = m_intervals.upperBound(start);
+    if (it != m_intervals.constBegin() && (it - 1).value() > start) {
+        --it;
+    }
+    for (; it != m_intervals.constEnd() && it.key() < end; ++it) {
+        result << Interval(qMax(it.key(), start), qMin(it.value(), end));
+    }
+    return result;
+}
+
+QVector<IntervalSet::Interval> IntervalSet::intervals() const
+{
+    QVector<Interval> result;
+    result.reserve(m_intervals.count());
+    for (QMap<int, int>::const_iterator it = m_intervals.constBegin(); it != m_intervals.constEnd(); ++it) {
+        result << Interval(it.key(), it.value());
+    }
+    return result;
+}
+
+int IntervalSet::first() const
+{
+    return m_intervals.isEmpty() ? -1 : m_intervals.firstKey();
+}
+
+int IntervalSet::end() const
+{
+    return m_intervals.isEmpty() ? -1 : m_intervals.last();
+}
+
+QList<int> IntervalSet::points(int step) const
+{
+    return points(intervals(), step);
+}
+
+QList<int> IntervalSet::points(const QVector<Interval> &intervals, int step)
+{
+    QList<int> result;
+    if (step <= 0) {
+        return result;
+    }
+    for (const Interval &interval : intervals) {
+        for (int frame = interval.first; frame < interval.second; frame += step) {
+            result << frame;
+        }
+    }
+    return result;
+}
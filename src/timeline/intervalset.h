@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef INTERVALSET_H
+#define INTERVALSET_H
+
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+
+/**
+ * @class IntervalSet
+ * @brief A set of frames stored as sorted, non overlapping [start, end) intervals.
+ *
+ * Adjacent and overlapping intervals are merged on insertion, so a range of
+ * chunks of any length costs a single entry. Insertion, removal and queries
+ * are logarithmic in the number of intervals, plus the number of intervals
+ * they touch.
+ */
+class IntervalSet
+{
+public:
+    typedef QPair<int, int> Interval;
+
+    /** @brief Add frames [start, end) to the set */
+    void insert(int start, int end);
+    /** @brief Remove frames [start, end) from the set, returns the removed intervals */
+    QVector<Interval> remove(int start, int end);
+    void clear();
+    bool isEmpty() const;
+    /** @brief Number of intervals, not of frames */
+    int count() const;
+    bool contains(int frame) const;
+    /** @brief Returns true if some frame of [start, end) is in the set */
+    bool intersects(int start, int end) const;
+    /** @brief Intervals of the set overlapping [start, end), clipped to it */
+    QVector<Interval> intervals(int start, int end) const;
+    QVector<Interval> intervals() const;
+    /** @brief First frame in the set, or -1 if empty */
+    int first() const;
+    /** @brief Frame after the last one in the set, or -1 if empty */
+    int end() const;
+    /** @brief Positions every step frames inside the intervals, starting at each interval's start */
+    QList<int> points(int step) const;
+    static QList<int> points(const QVector<Interval> &intervals, int step);
+
+private:
+    /** @brief Interval start -> interval end (excluded) */
+    QMap<int, int> m_intervals;
+};
+
+#endif
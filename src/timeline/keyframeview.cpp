@@ -40,6 +40,8 @@ KeyframeView::KeyframeView(int handleSize, QObject *parent) : QObject(parent)
     , m_handleSize(handleSize)
     , m_useOffset(false)
     , m_offset(0)
+    , m_curveDuration(-1)
+    , m_curveOffset(0)
 {
 }
 
@@ -129,6 +131,72 @@ void KeyframeView::drawKeyFrames(const QRectF &br, int length, bool active, QPai
         }
     }
 
+    if (m_curveDuration != duration || m_curveOffset != m_offset) {
+        buildCurves();
+    }
+    // Cached curves are in frame / normalized value units, map them to the clip rect
+    const QTransform toClip(br.width() / duration, 0, 0, -br.height(), br.x(), br.bottom());
+    const QTransform toView = toClip * transformation;
+    foreach (const CurveCache &curve, m_curves) {
+        const bool edited = curve.name == m_inTimeline;
+        painter->setPen(edited ? QColor(Qt::white) : Qt::NoPen);
+        if (active && edited) {
+            for (int i = 0; i < curve.keys.count(); ++i) {
+                const QPointF point = toView.map(curve.keys.at(i).second);
+                painter->setBrush(curve.keys.at(i).first == activeKeyframe ? QColor(Qt::red) : QColor(Qt::blue));
+                painter->drawEllipse(QRectF(point - h / 2, point + h / 2));
+            }
+        }
+        if (edited) {
+            QColor col(Qt::white);
+            col.setAlpha(active ? 120 : 80);
+            painter->setBrush(col);
+        } else {
+            QColor col;
+            switch (curve.colorIndex) {
+            case 0:
+                col = Qt::blue;
+                break;
+            case 1:
+                col = Qt::green;
+                break;
+            case 2:
+                col = Qt::yellow;
+                break;
+            case 3:
+                col = Qt::red;
+                break;
+            case 4:
+                col = Qt::magenta;
+                break;
+            default:
+                col = Qt::cyan;
+                break;
+            }
+            col.setAlpha(80);
+            painter->setBrush(col);
+        }
+        painter->drawPath(toView.map(curve.path));
+    }
+    painter->restore();
+}
+
+void KeyframeView::invalidateCurves()
+{
+    m_curves.clear();
+    m_curveDuration = -1;
+}
+
+QPointF KeyframeView::curvePoint(int frame, double value, const ParameterInfo &info) const
+{
+    return QPointF(frame, (value * info.factor - info.min) / (info.max - info.min));
+}
+
+void KeyframeView::buildCurves()
+{
+    m_curves.clear();
+    m_curveDuration = duration;
+    m_curveOffset = m_offset;
     int cnt = m_keyProperties.count();
     QStringList paramNames;
     paramNames.reserve(cnt);
@@ -147,11 +215,15 @@ void KeyframeView::drawKeyFrames(const QRectF &br, int length, bool active, QPai
             // this is probably an animated rect
             continue;
         }
-        Mlt::Animation drawAnim = m_keyProperties.get_animation(paramName.toUtf8().constData());
+        const QByteArray name = paramName.toUtf8();
+        Mlt::Animation drawAnim = m_keyProperties.get_animation(name.constData());
         if (!drawAnim.is_valid()) {
             continue;
         }
-        QPainterPath path;
+        CurveCache curve;
+        curve.name = paramName;
+        curve.colorIndex = paramNames.indexOf(paramName);
+        QPainterPath &path = curve.path;
         // Find first key before our clip start, get frame for rect left first
         int firstKF = qMax(0, drawAnim.previous_key(-m_offset));
         int lastKF = drawAnim.next_key(duration - m_offset);
@@ -159,12 +231,11 @@ void KeyframeView::drawKeyFrames(const QRectF &br, int length, bool active, QPai
             lastKF = duration - m_offset;
         }
         int frame = firstKF;
-        double value = m_keyProperties.anim_get_double(paramName.toUtf8().constData(), frame, duration - m_offset);
-        QPointF start = keyframePoint(br, frame + m_offset, value, info.factor, info.min, info.max);
-        path.moveTo(br.x(), br.bottom());
-        path.lineTo(br.x(), start.y());
+        double value = m_keyProperties.anim_get_double(name.constData(), frame, duration - m_offset);
+        QPointF start = curvePoint(frame + m_offset, value, info);
+        path.moveTo(0, 0);
+        path.lineTo(0, start.y());
         path.lineTo(start);
-        painter->setPen(paramName == m_inTimeline ? QColor(Qt::white) : Qt::NoPen);
         for (int i = 0; i < drawAnim.key_count(); ++i) {
             int currentFrame = drawAnim.key_get_frame(i);
             if (currentFrame < firstKF) {
@@ -173,15 +244,11 @@ void KeyframeView::drawKeyFrames(const QRectF &br, int length, bool active, QPai
             if (currentFrame > lastKF) {
                 break;
             }
-            if (active && paramName == m_inTimeline) {
-                painter->setBrush((drawAnim.key_get_frame(i) == activeKeyframe) ? QColor(Qt::red) : QColor(Qt::blue));
-                painter->drawEllipse(QRectF(transformation.map(start) - h / 2, transformation.map(start) + h / 2));
-            }
+            curve.keys.append(qMakePair(currentFrame, start));
             if (i + 1 < drawAnim.key_count()) {
                 frame = drawAnim.key_get_frame(i + 1);
-                value = m_keyProperties.anim_get_double(paramName.toUtf8().constData(), frame, duration - m_offset);
-                QPointF end = keyframePoint(br, frame + m_offset, value, info.factor, info.min, info.max);
-                //QPointF end = keyframePoint(br, i + 1);
+                value = m_keyProperties.anim_get_double(name.constData(), frame, duration - m_offset);
+                QPointF end = curvePoint(frame + m_offset, value, info);
                 switch (drawAnim.key_get_type(i)) {
                 case mlt_keyframe_discrete:
                     path.lineTo(end.x(), start.y());
@@ -192,13 +259,14 @@ void KeyframeView::drawKeyFrames(const QRectF &br, int length, bool active, QPai
                     break;
                 case mlt_keyframe_smooth:
                     frame = drawAnim.key_get_frame(qMax(i - 1, 0));
-                    value = m_keyProperties.anim_get_double(paramName.toUtf8().constData(), frame, duration - m_offset);
-                    QPointF pre = keyframePoint(br, frame + m_offset, value, info.factor, info.min, info.max);
+                    value = m_keyProperties.anim_get_double(name.constData(), frame, duration - m_offset);
+                    QPointF pre = curvePoint(frame + m_offset, value, info);
                     frame = drawAnim.key_get_frame(qMin(i + 2, drawAnim.key_count() - 1));
-                    value = m_keyProperties.anim_get_double(paramName.toUtf8().constData(), frame, duration - m_offset);
-                    QPointF post = keyframePoint(br, frame + m_offset, value, info.factor, info.min, info.max);
+                    value = m_keyProperties.anim_get_double(name.constData(), frame, duration - m_offset);
+                    QPointF post = curvePoint(frame + m_offset, value, info);
                     QPointF c1 = (end - pre) / 6.0; // + start
                     QPointF c2 = (start - post) / 6.0; // + end
+                    // Clamping only depends on x ratios, so it gives the same curve once scaled to the clip
                     double mid = (end.x() - start.x()) / 2;
                     if (c1.x() >  mid) {
                         c1 = c1 * mid / c1.x();    // scale down tangent vector to not go beyond middle
@@ -211,42 +279,12 @@ void KeyframeView::drawKeyFrames(const QRectF &br, int length, bool active, QPai
                 }
                 start = end;
             } else {
-                path.lineTo(br.right(), start.y());
+                path.lineTo(duration, start.y());
             }
         }
-        path.lineTo(br.right(), br.bottom());
-        if (paramName == m_inTimeline) {
-            QColor col(Qt::white);
-            col.setAlpha(active ? 120 : 80);
-            painter->setBrush(col);
-        } else {
-            QColor col;
-            switch (paramNames.indexOf(paramName)) {
-            case 0:
-                col = Qt::blue;
-                break;
-            case 1:
-                col = Qt::green;
-                break;
-            case 2:
-                col = Qt::yellow;
-                break;
-            case 3:
-                col = Qt::red;
-                break;
-            case 4:
-                col = Qt::magenta;
-                break;
-            default:
-                col = Qt::cyan;
-                break;
-            }
-            col.setAlpha(80);
-            painter->setBrush(col);
-        }
-        painter->drawPath(transformation.map(path));
+        path.lineTo(duration, 0);
+        m_curves.append(curve);
     }
-    painter->restore();
 }
 
 void KeyframeView::drawKeyFrameChannels(const QRectF &br, int in, int out, QPainter *painter, const QList<QPoint> &maximas, int limitKeyframes, const QColor &textColor)
@@ -558,6 +596,7 @@ double KeyframeView::editedKeyFrameValue()
 
 void KeyframeView::updateKeyFramePos(const QRectF &br, int frame, const double y)
 {
+    invalidateCurves();
     if (!m_keyAnim.is_key(activeKeyframe)) {
         return;
     }
@@ -635,6 +674,7 @@ mlt_keyframe_type KeyframeView::type(int frame)
 
 void KeyframeView::addKeyframe(int frame, double value, mlt_keyframe_type type)
 {
+    invalidateCurves();
     m_keyProperties.anim_set(m_inTimeline.toUtf8().constData(), value, frame - m_offset, duration - m_offset, type);
     // Last keyframe should stick to end
     if (frame == duration - 1) {
@@ -663,6 +703,7 @@ void KeyframeView::addKeyframe(int frame, double value, mlt_keyframe_type type)
 
 void KeyframeView::addDefaultKeyframe(ProfileInfo profile, int frame, mlt_keyframe_type type)
 {
+    invalidateCurves();
     double value = m_keyframeDefault;
     if (m_keyAnim.key_count() == 1 && frame != m_keyAnim.key_get_frame(0)) {
         value = m_keyProperties.anim_get_double(m_inTimeline.toUtf8().constData(), m_keyAnim.key_get_frame(0), duration - m_offset);
@@ -705,6 +746,7 @@ void KeyframeView::addDefaultKeyframe(ProfileInfo profile, int frame, mlt_keyfra
 
 void KeyframeView::removeKeyframe(int frame)
 {
+    invalidateCurves();
     m_keyAnim.remove(frame);
     if (frame == duration - 1 && frame == attachToEnd) {
         attachToEnd = -2;
@@ -755,6 +797,7 @@ void KeyframeView::attachKeyframeToEnd(bool attach)
 
 void KeyframeView::editKeyframeType(int type)
 {
+    invalidateCurves();
     if (m_keyAnim.is_key(activeKeyframe)) {
         // This is a keyframe
         double val = m_keyProperties.anim_get_double(m_inTimeline.toUtf8().constData(), activeKeyframe, duration - m_offset);
@@ -809,6 +852,7 @@ const QString KeyframeView::serialize(const QString &name, bool rectAnimation)
 
 QList<QPoint> KeyframeView::loadKeyframes(const QString &data)
 {
+    invalidateCurves();
     QList<QPoint> result;
     m_keyframeType = NoKeyframe;
     m_inTimeline = QStringLiteral("imported");
@@ -868,6 +912,7 @@ QList<QPoint> KeyframeView::loadKeyframes(const QString &data)
 
 bool KeyframeView::loadKeyframes(const QLocale &locale, const QDomElement &effect, int cropStart, int length)
 {
+    invalidateCurves();
     m_keyframeType = NoKeyframe;
     duration = length;
     m_inTimeline.clear();
@@ -956,6 +1001,7 @@ bool KeyframeView::loadKeyframes(const QLocale &locale, const QDomElement &effec
 
 void KeyframeView::setOffset(int frames)
 {
+    invalidateCurves();
     if (duration == 0 || !m_keyAnim.is_valid()) {
         return;
     }
@@ -1000,6 +1046,7 @@ int KeyframeView::checkNegatives(const QString &data, int maxDuration)
 
 void KeyframeView::reset()
 {
+    invalidateCurves();
     if (m_keyframeType == NoKeyframe) {
         // nothing to do
         return;
@@ -29,6 +29,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "mlt++/MltProperties.h"
 #include "mlt++/MltAnimation.h"
 
+#include <QPainterPath>
+#include <QVector>
+
 class QAction;
 
 /**
@@ -133,6 +136,23 @@ private:
         QString defaultValue;
     };
     QMap<QString, ParameterInfo> m_paramInfos;
+    /** @brief Curve of an animated parameter, x in frames and y in 0..1 of the parameter range. */
+    struct CurveCache {
+        QString name;
+        int colorIndex;
+        QPainterPath path;
+        /** @brief Keyframe frames with their point on the curve, used to draw handles. */
+        QVector<QPair<int, QPointF> > keys;
+    };
+    /** @brief Curves in painting order, independent of zoom and track height. */
+    QVector<CurveCache> m_curves;
+    /** @brief Duration and offset the curves were built for, -1 if they must be rebuilt. */
+    int m_curveDuration;
+    int m_curveOffset;
+    /** @brief Discard the cached curves, must be called on any keyframe change. */
+    void invalidateCurves();
+    void buildCurves();
+    QPointF curvePoint(int frame, double value, const ParameterInfo &info) const;
 
 signals:
     void updateKeyframes(const QRectF &r = QRectF());
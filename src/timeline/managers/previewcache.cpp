@@ -0,0 +1,285 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "previewcache.h"
+
+#include <mlt++/Mlt.h>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QScopedPointer>
+#include <QVector>
+#include <cstring>
+
+PreviewCache::PreviewCache() :
+    m_clock(0),
+    m_size(0),
+    m_maxSize(0)
+{
+}
+
+void PreviewCache::setDirectory(const QDir &dir, const QString &extension)
+{
+    m_dir = dir;
+    m_extension = extension;
+    m_entries.clear();
+    m_lru.clear();
+    m_size = 0;
+    // Existing chunks are considered used in the order they were rendered
+    const QRegExp keyName(QStringLiteral("[0-9a-f]{32}"));
+    const QFileInfoList files = m_dir.entryInfoList(QStringList() << QStringLiteral("*.") + m_extension, QDir::Files, QDir::Time | QDir::Reversed);
+    for (const QFileInfo &info : files) {
+        const QString key = info.completeBaseName();
+        if (!keyName.exactMatch(key)) {
+            // Partially rendered chunk or old style file
+            continue;
+        }
+        Entry entry;
+        entry.size = info.size();
+        entry.lastUse = ++m_clock;
+        m_entries.insert(key, entry);
+        m_lru.insert(entry.lastUse, key);
+        m_size += entry.size;
+    }
+}
+
+void PreviewCache::setMaximumSize(int megaBytes)
+{
+    m_maxSize = (qint64) megaBytes * 1024 * 1024;
+}
+
+QString PreviewCache::fileName(const QString &key) const
+{
+    return m_dir.absoluteFilePath(QStringLiteral("%1.%2").arg(key, m_extension));
+}
+
+QString PreviewCache::partFileName(const QString &key) const
+{
+    return m_dir.absoluteFilePath(QStringLiteral("%1.part.%2").arg(key, m_extension));
+}
+
+bool PreviewCache::contains(const QString &key) const
+{
+    return m_entries.contains(key);
+}
+
+void PreviewCache::touch(const QString &key)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_lru.remove(it->lastUse);
+    it->lastUse = ++m_clock;
+    m_lru.insert(it->lastUse, key);
+}
+
+void PreviewCache::insert(const QString &key, const QMap<int, QString> &displayed)
+{
+    QFileInfo info(fileName(key));
+    if (!info.exists()) {
+        return;
+    }
+    if (m_entries.contains(key)) {
+        touch(key);
+        return;
+    }
+    Entry entry;
+    entry.size = info.size();
+    entry.lastUse = ++m_clock;
+    m_entries.insert(key, entry);
+    m_lru.insert(entry.lastUse, key);
+    m_size += entry.size;
+    evict(displayed);
+}
+
+void PreviewCache::remove(const QString &key)
+{
+    QHash<QString, Entry>::iterator it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_size -= it->size;
+        m_lru.remove(it->lastUse);
+        m_entries.erase(it);
+    }
+    QFile::remove(fileName(key));
+}
+
+qint64 PreviewCache::size() const
+{
+    return m_size;
+}
+
+void PreviewCache::evict(const QMap<int, QString> &displayed)
+{
+    if (m_maxSize <= 0 || m_size <= m_maxSize) {
+        return;
+    }
+    const QSet<QString> protectedKeys = displayed.values().toSet();
+    QMap<quint64, QString>::iterator it = m_lru.begin();
+    while (m_size > m_maxSize && it != m_lru.end()) {
+        const QString key = it.value();
+        if (protectedKeys.contains(key)) {
+            ++it;
+            continue;
+        }
+        it = m_lru.erase(it);
+        m_size -= m_entries.take(key).size;
+        QFile::remove(fileName(key));
+    }
+}
+
+void PreviewCache::hashProperties(Mlt::Properties &properties, QByteArray &data, QHash<void *, QByteArray> &cache, bool skipRange)
+{
+    void *id = properties.get_properties();
+    QHash<void *, QByteArray>::const_iterator it = cache.constFind(id);
+    if (it != cache.constEnd()) {
+        data.append(it.value());
+        return;
+    }
+    QByteArray props;
+    const int count = properties.count();
+    for (int i = 0; i < count; ++i) {
+        const char *name = properties.get_name(i);
+        if (name == nullptr || name[0] == '_' || qstrncmp(name, "kdenlive:", 9) == 0 || qstrncmp(name, "meta.", 5) == 0) {
+            // Internal, Kdenlive only or probed data: no effect on rendering
+            continue;
+        }
+        if (skipRange && (qstrcmp(name, "in") == 0 || qstrcmp(name, "out") == 0 || qstrcmp(name, "length") == 0)) {
+            continue;
+        }
+        props.append(name).append('=').append(properties.get(i)).append('\n');
+    }
+    cache.insert(id, props);
+    data.append(props);
+}
+
+bool PreviewCache::isAnimated(Mlt::Properties &properties)
+{
+    const int count = properties.count();
+    for (int i = 0; i < count; ++i) {
+        const char *name = properties.get_name(i);
+        if (name == nullptr || name[0] == '_' || qstrncmp(name, "kdenlive:", 9) == 0) {
+            continue;
+        }
+        // Keyframes are written as position=value, plain values have no '='
+        const char *value = properties.get(i);
+        if (value != nullptr && strchr(value, '=') != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QMap<int, QString> PreviewCache::chunkKeys(Mlt::Tractor &tractor, const QList<int> &chunks, int chunkSize, const QByteArray &salt)
+{
+    QMap<int, QString> keys;
+    QHash<void *, QByteArray> cache;
+    // Tracks and transitions are collected once for all chunks
+    QList<Mlt::Playlist *> tracks;
+    QList<int> trackIndexes;
+    for (int i = 0; i < tractor.count(); ++i) {
+        QScopedPointer<Mlt::Producer> track(tractor.track(i));
+        const QString id = track->get("id");
+        if (id == QLatin1String("timeline_preview") || id == QLatin1String("overlay_track")) {
+            continue;
+        }
+        tracks << new Mlt::Playlist(*track);
+        trackIndexes << i;
+    }
+    QList<Mlt::Transition *> transitions;
+    QScopedPointer<Mlt::Field> field(tractor.field());
+    mlt_service nextservice = mlt_service_get_producer(field->get_service());
+    while (nextservice != nullptr && mlt_service_identify(nextservice) == transition_type) {
+        transitions << new Mlt::Transition((mlt_transition) nextservice);
+        nextservice = mlt_service_producer(nextservice);
+    }
+    QByteArray global;
+    bool globalAnimated = false;
+    for (int i = 0; i < tractor.filter_count(); ++i) {
+        QScopedPointer<Mlt::Filter> filter(tractor.filter(i));
+        hashProperties(*filter, global, cache);
+        globalAnimated = globalAnimated || isAnimated(*filter);
+    }
+    QVector<bool> trackAnimated(tracks.count(), false);
+    for (int t = 0; t < tracks.count(); ++t) {
+        for (int i = 0; i < tracks.at(t)->filter_count() && !trackAnimated.at(t); ++i) {
+            QScopedPointer<Mlt::Filter> filter(tracks.at(t)->filter(i));
+            trackAnimated[t] = isAnimated(*filter);
+        }
+    }
+    QVector<bool> transitionAnimated(transitions.count(), false);
+    for (int i = 0; i < transitions.count(); ++i) {
+        // Other transitions are hashed with their position relative to the chunk, like their keyframes
+        transitionAnimated[i] = transitions.at(i)->get_int("always_active") == 1 && isAnimated(*transitions.at(i));
+    }
+
+    for (int frame : chunks) {
+        const int end = frame + chunkSize;
+        QByteArray data = salt;
+        data.append(global);
+        if (globalAnimated) {
+            data.append("position ").append(QByteArray::number(frame)).append('\n');
+        }
+        for (int t = 0; t < tracks.count(); ++t) {
+            Mlt::Playlist *playlist = tracks.at(t);
+            data.append("track ").append(QByteArray::number(trackIndexes.at(t))).append('\n');
+            // The track length changes with any edit, only its state and effects matter
+            data.append("hide=").append(playlist->get("hide")).append('\n');
+            for (int i = 0; i < playlist->filter_count(); ++i) {
+                QScopedPointer<Mlt::Filter> filter(playlist->filter(i));
+                hashProperties(*filter, data, cache);
+            }
+            if (trackAnimated.at(t)) {
+                data.append("position ").append(QByteArray::number(frame)).append('\n');
+            }
+            for (int ix = playlist->get_clip_index_at(frame); ix < playlist->count(); ++ix) {
+                QScopedPointer<Mlt::ClipInfo> info(playlist->clip_info(ix));
+                if (!info || info->start >= end) {
+                    break;
+                }
+                // Positions are relative to the chunk so that a moved region keeps its key
+                data.append(playlist->is_blank(ix) ? "blank " : "clip ").append(QByteArray::number(info->start - frame)).append(' ').append(QByteArray::number(info->frame_in)).append(' ').append(QByteArray::number(info->frame_out)).append('\n');
+                if (playlist->is_blank(ix)) {
+                    continue;
+                }
+                hashProperties(*info->producer, data, cache);
+                for (int i = 0; i < info->producer->filter_count(); ++i) {
+                    QScopedPointer<Mlt::Filter> filter(info->producer->filter(i));
+                    hashProperties(*filter, data, cache);
+                }
+                for (int i = 0; i < info->cut->filter_count(); ++i) {
+                    QScopedPointer<Mlt::Filter> filter(info->cut->filter(i));
+                    hashProperties(*filter, data, cache);
+                }
+            }
+        }
+        for (int tr = 0; tr < transitions.count(); ++tr) {
+            Mlt::Transition *transition = transitions.at(tr);
+            const bool always = transition->get_int("always_active") == 1;
+            const int in = transition->get_in();
+            const int out = transition->get_out();
+            if (!always && (out < frame || in >= end)) {
+                continue;
+            }
+            data.append("transition ").append(QByteArray::number(transition->get_a_track())).append(' ').append(QByteArray::number(transition->get_b_track()));
+            if (!always) {
+                data.append(' ').append(QByteArray::number(in - frame)).append(' ').append(QByteArray::number(out - frame));
+            } else if (transitionAnimated.at(tr)) {
+                data.append(" position ").append(QByteArray::number(frame));
+            }
+            data.append('\n');
+            hashProperties(*transition, data, cache, true);
+        }
+        keys.insert(frame, QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex()));
+    }
+    qDeleteAll(tracks);
+    qDeleteAll(transitions);
+    return keys;
+}
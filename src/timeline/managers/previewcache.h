@@ -0,0 +1,92 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include <QDir>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+
+namespace Mlt
+{
+class Tractor;
+class Properties;
+}
+
+/**
+ * @class PreviewCache
+ * @brief Content addressed storage of the timeline preview chunks.
+ *
+ * A chunk file is named after a hash of everything MLT uses to render its
+ * frame range: the clips of each track with their producer, in point and
+ * position relative to the chunk, the filters and the transitions, as well
+ * as the rendering parameters. Keyframes of track filters, global filters
+ * and always active transitions are at absolute positions, so the chunk
+ * position is part of the key when one of them is animated. A region of the
+ * timeline that comes back to a previously rendered state, after an undo or
+ * a move, gets the same key and its chunk is reused without rendering or
+ * copying anything.
+ *
+ * Files are evicted in least recently used order once the cache grows over
+ * its maximum size. Chunks currently displayed in the timeline are kept.
+ */
+class PreviewCache
+{
+public:
+    PreviewCache();
+
+    /** @brief Use dir to store the chunks, indexing the chunk files it already contains */
+    void setDirectory(const QDir &dir, const QString &extension);
+    /** @brief Maximum size of the chunk files, in MB */
+    void setMaximumSize(int megaBytes);
+    QString fileName(const QString &key) const;
+    /** @brief Temporary file name used while the chunk is being rendered */
+    QString partFileName(const QString &key) const;
+    bool contains(const QString &key) const;
+    /** @brief Mark the chunk as used, it becomes the last one to be evicted */
+    void touch(const QString &key);
+    /** @brief Register the chunk file that was just written, then evict old chunks except the displayed ones
+     *  @param displayed keys of the chunks used by the timeline, by position */
+    void insert(const QString &key, const QMap<int, QString> &displayed);
+    /** @brief Delete a chunk file */
+    void remove(const QString &key);
+    qint64 size() const;
+
+    /** @brief Compute the keys of the chunks of chunkSize frames starting at each frame of chunks
+     *  @param salt data identifying the rendering parameters
+     *  The tractor should be locked by the caller. */
+    static QMap<int, QString> chunkKeys(Mlt::Tractor &tractor, const QList<int> &chunks, int chunkSize, const QByteArray &salt);
+
+private:
+    struct Entry {
+        qint64 size;
+        quint64 lastUse;
+    };
+    QDir m_dir;
+    QString m_extension;
+    QHash<QString, Entry> m_entries;
+    /** @brief Use stamp -> key, oldest first */
+    QMap<quint64, QString> m_lru;
+    quint64 m_clock;
+    qint64 m_size;
+    qint64 m_maxSize;
+
+    void evict(const QMap<int, QString> &displayed);
+    /** @brief Append the properties that affect rendering, cached by properties object
+     *  @param skipRange leave out in, out and length, for services whose position is hashed relative to the chunk */
+    static void hashProperties(Mlt::Properties &properties, QByteArray &data, QHash<void *, QByteArray> &cache, bool skipRange = false);
+    /** @brief Returns true if a property is animated with keyframes, which are at absolute positions for track and global services */
+    static bool isAnimated(Mlt::Properties &properties);
+};
+
+#endif
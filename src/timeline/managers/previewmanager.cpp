@@ -26,6 +26,7 @@
 #include <QtConcurrent>
 #include <QStandardPaths>
 #include <QProcess>
+#include <QElapsedTimer>
 
 PreviewManager::PreviewManager(KdenliveDoc *doc, CustomRuler *ruler, Mlt::Tractor *tractor) : QObject()
     , m_doc(doc)
@@ -43,9 +44,6 @@ PreviewManager::~PreviewManager()
 {
     if (m_initialized) {
         abortRendering();
-        if (m_undoDir.dirName() == QLatin1String("undo")) {
-            m_undoDir.removeRecursively();
-        }
         if ((m_doc->url().isEmpty() && m_cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot).isEmpty()) || m_cacheDir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot).isEmpty()) {
             if (m_cacheDir.dirName() == QLatin1String("preview")) {
                 m_cacheDir.removeRecursively();
@@ -71,28 +69,29 @@ bool PreviewManager::initialize()
         m_doc->displayMessage(i18n("Cannot create folder %1", m_cacheDir.absolutePath()), ErrorMessage);
         return false;
     }
-    if (m_cacheDir.dirName() != QLatin1String("preview") || m_cacheDir == QDir() || (!m_cacheDir.exists(QStringLiteral("undo")) && !m_cacheDir.mkdir(QStringLiteral("undo"))) || !m_cacheDir.absolutePath().contains(documentId)) {
+    if (m_cacheDir.dirName() != QLatin1String("preview") || m_cacheDir == QDir() || !m_cacheDir.absolutePath().contains(documentId)) {
         m_doc->displayMessage(i18n("Something is wrong with cache folder %1", m_cacheDir.absolutePath()), ErrorMessage);
         return false;
     }
-    if (!loadParams()) {
-        m_doc->displayMessage(i18n("Invalid timeline preview parameters"), ErrorMessage);
+    // Make sure our cache dir is inside the temporary folder
+    if (!m_cacheDir.makeAbsolute()) {
+        m_doc->displayMessage(i18n("Something is wrong with cache folders"), ErrorMessage);
         return false;
     }
-    m_undoDir = QDir(m_cacheDir.absoluteFilePath(QStringLiteral("undo")));
-
-    // Make sure our cache dirs are inside the temporary folder
-    if (!m_cacheDir.makeAbsolute() || !m_undoDir.makeAbsolute() || !m_undoDir.mkpath(QStringLiteral("."))) {
-        m_doc->displayMessage(i18n("Something is wrong with cache folders"), ErrorMessage);
+    // Chunks are shared by all undo steps, remove the undo history of older versions
+    QDir undoDir = m_cacheDir;
+    if (undoDir.cd(QStringLiteral("undo")) && undoDir.dirName() == QLatin1String("undo")) {
+        undoDir.removeRecursively();
+    }
+    if (!loadParams()) {
+        m_doc->displayMessage(i18n("Invalid timeline preview parameters"), ErrorMessage);
         return false;
     }
-
-    connect(this, &PreviewManager::cleanupOldPreviews, this, &PreviewManager::doCleanupOldPreviews);
-    connect(m_doc, &KdenliveDoc::removeInvalidUndo, this, &PreviewManager::slotRemoveInvalidUndo, Qt::DirectConnection);
     m_previewTimer.setSingleShot(true);
     m_previewTimer.setInterval(3000);
     connect(&m_previewTimer, &QTimer::timeout, this, &PreviewManager::startPreviewRender);
     connect(this, &PreviewManager::previewRender, this, &PreviewManager::gotPreviewRender);
+    connect(this, &PreviewManager::previewStats, this, &PreviewManager::gotPreviewStats);
     connect(&m_previewGatherTimer, &QTimer::timeout, this, &PreviewManager::slotProcessDirtyChunks);
     m_initialized = true;
     return true;
@@ -113,28 +112,44 @@ bool PreviewManager::buildPreviewTrack()
 
 void PreviewManager::loadChunks(const QStringList &previewChunks, QStringList dirtyChunks, const QDateTime &documentDate)
 {
+    QList<int> frames;
+    frames.reserve(previewChunks.count());
     for (const QString &frame : previewChunks) {
-        const QString fileName = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(frame).arg(m_extension));
-        QFile file(fileName);
-        if (file.exists()) {
+        frames << frame.toInt();
+    }
+    const QMap<int, QString> keys = chunkKeys(frames);
+    QList<int> found;
+    for (int frame : frames) {
+        const QString key = keys.value(frame);
+        if (!m_cache.contains(key)) {
+            // Chunk file from an older version, named after its position
+            QFile file(m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(frame).arg(m_extension)));
+            if (!file.exists()) {
+                dirtyChunks << QString::number(frame);
+                continue;
+            }
             if (!documentDate.isNull() && QFileInfo(file).lastModified() > documentDate) {
                 // Timeline preview file was created after document, invalidate
                 file.remove();
-                dirtyChunks << frame;
-            } else {
-                gotPreviewRender(frame.toInt(), fileName, 1000);
+                dirtyChunks << QString::number(frame);
+                continue;
             }
-        } else {
-            dirtyChunks << frame;
+            if (!file.rename(m_cache.fileName(key))) {
+                dirtyChunks << QString::number(frame);
+                continue;
+            }
+            m_cache.insert(key, m_chunkKeys);
         }
+        m_chunkKeys.insert(frame, key);
+        found << frame;
     }
+    reloadChunks(found);
     if (!dirtyChunks.isEmpty()) {
-        QList<int> list;
-        list.reserve(dirtyChunks.count());
+        int chunkSize = KdenliveSettings::timelinechunks();
         foreach (const QString &i, dirtyChunks) {
-            list << i.toInt();
+            int frame = i.toInt();
+            m_ruler->addChunks(frame, frame + chunkSize, true);
         }
-        m_ruler->addChunks(list, true);
         m_ruler->update();
     }
 }
@@ -202,108 +217,55 @@ bool PreviewManager::loadParams()
     if (KdenliveSettings::gpu_accel()) {
         m_consumerParams << QStringLiteral("glsl.=1");
     }
+    m_cache.setDirectory(m_cacheDir, m_extension);
+    m_cache.setMaximumSize(KdenliveSettings::preview_cachesize());
     return true;
 }
 
 void PreviewManager::invalidatePreviews(const QList<int> &chunks)
 {
-    QMutexLocker lock(&m_previewMutex);
     bool timer = false;
     if (m_previewTimer.isActive()) {
         m_previewTimer.stop();
         timer = true;
     }
-    int stackIx = m_doc->commandStack()->index();
-    int stackMax = m_doc->commandStack()->count();
-    if (stackIx == stackMax && !m_undoDir.exists(QString::number(stackIx - 1))) {
-        // We just added a new command in stack, archive existing chunks
-        int ix = stackIx - 1;
-        m_undoDir.mkdir(QString::number(ix));
-        bool foundPreviews = false;
-        foreach (int i, chunks) {
-            QString current = QStringLiteral("%1.%2").arg(i).arg(m_extension);
-            if (m_cacheDir.rename(current, QStringLiteral("undo/%1/%2").arg(ix).arg(current))) {
-                foundPreviews = true;
-            }
-        }
-        if (!foundPreviews) {
-            // No preview files found, remove undo folder
-            m_undoDir.rmdir(QString::number(ix));
-        } else {
-            // new chunks archived, cleanup old ones
-            emit cleanupOldPreviews();
-        }
-    } else {
-        // Restore existing chunks, delete others
-        // Check if we just undo the last stack action, then backup, otherwise delete
-        bool lastUndo = false;
-        if (stackIx == stackMax - 1) {
-            if (!m_undoDir.exists(QString::number(stackMax))) {
-                lastUndo = true;
-                bool foundPreviews = false;
-                m_undoDir.mkdir(QString::number(stackMax));
-                foreach (int i, chunks) {
-                    QString current = QStringLiteral("%1.%2").arg(i).arg(m_extension);
-                    if (m_cacheDir.rename(current, QStringLiteral("undo/%1/%2").arg(stackMax).arg(current))) {
-                        foundPreviews = true;
-                    }
-                }
-                if (!foundPreviews) {
-                    m_undoDir.rmdir(QString::number(stackMax));
-                }
-            }
-        }
-        bool moveFile = true;
-        QDir tmpDir = m_undoDir;
-        if (!tmpDir.cd(QString::number(stackIx))) {
-            moveFile = false;
-        }
-        QList<int> foundChunks;
-        foreach (int i, chunks) {
-            QString cacheFileName = QStringLiteral("%1.%2").arg(i).arg(m_extension);
-            if (!lastUndo) {
-                m_cacheDir.remove(cacheFileName);
-            }
-            if (moveFile) {
-                if (QFile::copy(tmpDir.absoluteFilePath(cacheFileName), m_cacheDir.absoluteFilePath(cacheFileName))) {
-                    foundChunks << i;
-                }
-            }
-        }
-        qSort(foundChunks);
-        reloadChunks(foundChunks);
-    }
+    // Chunks that came back to a previously rendered state are loaded from cache
+    reuseChunks(chunks);
     m_doc->setModified(true);
     if (timer) {
         m_previewTimer.start();
     }
 }
 
-void PreviewManager::doCleanupOldPreviews()
+QMap<int, QString> PreviewManager::chunkKeys(const QList<int> &chunks)
 {
-    if (m_undoDir.dirName() != QLatin1String("undo")) {
-        return;
-    }
-    QStringList dirs = m_undoDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    Mlt::Profile *profile = m_tractor->profile();
+    QByteArray salt = m_consumerParams.join(QLatin1Char(' ')).toUtf8();
+    salt.append(QStringLiteral(" %1 %2x%3 %4/%5 %6/%7 %8 %9\n").arg(m_extension).arg(profile->width()).arg(profile->height()).arg(profile->frame_rate_num()).arg(profile->frame_rate_den()).arg(profile->sample_aspect_num()).arg(profile->sample_aspect_den()).arg(profile->progressive()).arg(profile->colorspace()).toUtf8());
+    m_tractor->lock();
+    const QMap<int, QString> keys = PreviewCache::chunkKeys(*m_tractor, chunks, KdenliveSettings::timelinechunks(), salt);
+    m_tractor->unlock();
+    return keys;
+}
 
-    // Use QCollator to do a natural sorting so that 10 is after 2
-    QCollator collator;
-    collator.setNumericMode(true);
-    std::sort(
-        dirs.begin(),
-        dirs.end(),
-    [&collator](const QString & file1, const QString & file2) {
-        return collator.compare(file1, file2) < 0;
-    });
-    bool ok;
-    while (dirs.count() > 5) {
-        QDir tmp = m_undoDir;
-        QString dirName = dirs.takeFirst();
-        dirName.toInt(&ok);
-        if (ok && tmp.cd(dirName)) {
-            tmp.removeRecursively();
+QMap<int, QString> PreviewManager::reuseChunks(const QList<int> &chunks)
+{
+    QMap<int, QString> missing;
+    if (chunks.isEmpty()) {
+        return missing;
+    }
+    const QMap<int, QString> keys = chunkKeys(chunks);
+    QList<int> found;
+    for (QMap<int, QString>::const_iterator it = keys.constBegin(); it != keys.constEnd(); ++it) {
+        if (m_cache.contains(it.value())) {
+            m_chunkKeys.insert(it.key(), it.value());
+            found << it.key();
+        } else {
+            missing.insert(it.key(), it.value());
         }
     }
+    reloadChunks(found);
+    return missing;
 }
 
 void PreviewManager::clearPreviewRange()
@@ -314,7 +276,7 @@ void PreviewManager::clearPreviewRange()
     m_tractor->lock();
     bool hasPreview = m_previewTrack != nullptr;
     foreach (int ix, toProcess) {
-        m_cacheDir.remove(QStringLiteral("%1.%2").arg(ix).arg(m_extension));
+        m_cache.remove(m_chunkKeys.value(ix));
         if (!hasPreview) {
             continue;
         }
@@ -328,6 +290,7 @@ void PreviewManager::clearPreviewRange()
         m_previewTrack->consolidate_blanks();
     }
     m_tractor->unlock();
+    m_chunkKeys.clear();
     m_ruler->clearChunks();
 }
 
@@ -337,18 +300,24 @@ void PreviewManager::addPreviewRange(bool add)
     int chunkSize = KdenliveSettings::timelinechunks();
     int startChunk = p.x() / chunkSize;
     int endChunk = rintl(p.y() / chunkSize);
-    QList<int> frames;
-    for (int i = startChunk; i <= endChunk; i++) {
-        frames << i *chunkSize;
-    }
-    QList<int> toProcess = m_ruler->addChunks(frames, add);
+    QList<int> toProcess = m_ruler->addChunks(startChunk * chunkSize, (endChunk + 1) * chunkSize, add);
     if (toProcess.isEmpty()) {
         return;
     }
     if (add) {
+        const QMap<int, QString> missing = reuseChunks(toProcess);
+        if (missing.isEmpty()) {
+            return;
+        }
         if (m_previewThread.isRunning()) {
             // just add required frames to current rendering job
-            m_waitingThumbs << toProcess;
+            m_previewMutex.lock();
+            for (QMap<int, QString>::const_iterator it = missing.constBegin(); it != missing.constEnd(); ++it) {
+                m_waitingThumbs.insert(it.key(), it.value());
+                m_chunkKeys.insert(it.key(), it.value());
+            }
+            m_previewMutex.unlock();
+            m_ruler->setProcessingChunks(missing.keys());
         } else if (KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
@@ -360,7 +329,7 @@ void PreviewManager::addPreviewRange(bool add)
         m_tractor->lock();
         bool hasPreview = m_previewTrack != nullptr;
         foreach (int ix, toProcess) {
-            m_cacheDir.remove(QStringLiteral("%1.%2").arg(ix).arg(m_extension));
+            m_cache.remove(m_chunkKeys.take(ix));
             if (!hasPreview) {
                 continue;
             }
@@ -388,6 +357,7 @@ void PreviewManager::abortRendering()
     m_abortPreview = true;
     emit abortPreview();
     m_previewThread.waitForFinished();
+    m_ruler->clearProcessingChunks();
     // Re-init time estimation
     emit previewRender(0, QString(), 0);
 }
@@ -402,9 +372,17 @@ void PreviewManager::startPreviewRender()
         // Abort any rendering
         abortRendering();
         m_waitingThumbs.clear();
+        const QMap<int, QString> missing = reuseChunks(chunks);
+        if (missing.isEmpty()) {
+            return;
+        }
         const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
         m_doc->saveMltPlaylist(sceneList);
-        m_waitingThumbs = chunks;
+        m_waitingThumbs = missing;
+        for (QMap<int, QString>::const_iterator it = missing.constBegin(); it != missing.constEnd(); ++it) {
+            m_chunkKeys.insert(it.key(), it.value());
+        }
+        m_ruler->setProcessingChunks(missing.keys());
         m_previewThread = QtConcurrent::run(this, &PreviewManager::doPreviewRender, sceneList);
     }
 }
@@ -416,19 +394,34 @@ void PreviewManager::doPreviewRender(const QString &scene)
     // initialize progress bar
     emit previewRender(0, QString(), 0);
     int ct = 0;
-    qSort(m_waitingThumbs);
-    while (!m_waitingThumbs.isEmpty()) {
-        int i = m_waitingThumbs.takeFirst();
-        ct++;
-        QString fileName = QStringLiteral("%1.%2").arg(i).arg(m_extension);
+    // Rendering statistics: frames rendered, time until melt reports its first frame and time spent encoding
+    int renderedFrames = 0;
+    qint64 startupTime = 0;
+    qint64 encodingTime = 0;
+    while (true) {
+        m_previewMutex.lock();
         if (m_waitingThumbs.isEmpty()) {
+            m_previewMutex.unlock();
+            break;
+        }
+        QMap<int, QString>::iterator next = m_waitingThumbs.begin();
+        int i = next.key();
+        const QString key = next.value();
+        m_waitingThumbs.erase(next);
+        int remaining = m_waitingThumbs.count();
+        m_previewMutex.unlock();
+        ct++;
+        const QString fileName = m_cache.fileName(key);
+        // Render to a temporary file so that an interrupted rendering never leaves a chunk in cache
+        const QString partName = m_cache.partFileName(key);
+        if (remaining == 0) {
             progress = 1000;
         } else {
-            progress = (double)(ct) / (ct + m_waitingThumbs.count()) * 1000;
+            progress = (double)(ct) / (ct + remaining) * 1000;
         }
-        if (m_cacheDir.exists(fileName)) {
+        if (QFile::exists(fileName)) {
             // This chunk already exists
-            emit previewRender(i, m_cacheDir.absoluteFilePath(fileName), progress);
+            emit previewRender(i, fileName, progress);
             continue;
         }
         // Build rendering process
@@ -436,24 +429,54 @@ void PreviewManager::doPreviewRender(const QString &scene)
         args << scene;
         args << QStringLiteral("in=") + QString::number(i);
         args << QStringLiteral("out=") + QString::number(i + chunkSize - 1);
-        args << QStringLiteral("-consumer") << QStringLiteral("avformat:") + m_cacheDir.absoluteFilePath(fileName);
-        args << m_consumerParams;
+        args << QStringLiteral("-consumer") << QStringLiteral("avformat:") + partName;
+        args << m_consumerParams << QStringLiteral("progress=1");
         QProcess previewProcess;
         connect(this, &PreviewManager::abortPreview, &previewProcess, &QProcess::kill, Qt::DirectConnection);
+        QElapsedTimer chunkTimer;
+        chunkTimer.start();
+        qint64 firstFrame = -1;
+        QString errorLog;
         previewProcess.start(KdenliveSettings::rendererpath(), args);
         if (previewProcess.waitForStarted()) {
-            previewProcess.waitForFinished(-1);
+            // Read melt's progress output as it comes to measure startup and encoding time
+            bool finished = false;
+            while (!finished) {
+                finished = previewProcess.waitForFinished(200) || previewProcess.state() == QProcess::NotRunning;
+                const QStringList lines = QString::fromLocal8Bit(previewProcess.readAllStandardError()).split(QRegExp(QStringLiteral("[\\r\\n]")), QString::SkipEmptyParts);
+                for (const QString &line : lines) {
+                    if (line.simplified().startsWith(QLatin1String("Current Frame"))) {
+                        if (firstFrame < 0) {
+                            firstFrame = chunkTimer.elapsed();
+                        }
+                    } else {
+                        errorLog.append(line + QLatin1Char('\n'));
+                    }
+                }
+            }
             if (previewProcess.exitStatus() != QProcess::NormalExit || previewProcess.exitCode() != 0) {
                 // Something went wrong
                 if (m_abortPreview) {
                     emit previewRender(0, QString(), 1000);
                 } else {
-                    emit previewRender(i, previewProcess.readAllStandardError(), -1);
+                    emit previewRender(i, errorLog, -1);
                 }
-                QFile::remove(m_cacheDir.absoluteFilePath(fileName));
+                QFile::remove(partName);
                 break;
             } else {
-                emit previewRender(i, m_cacheDir.absoluteFilePath(fileName), progress);
+                qint64 elapsed = chunkTimer.elapsed();
+                if (firstFrame < 0) {
+                    firstFrame = elapsed;
+                }
+                renderedFrames += chunkSize;
+                startupTime += firstFrame;
+                encodingTime += elapsed - firstFrame;
+                if (!QFile::rename(partName, fileName)) {
+                    QFile::remove(partName);
+                    emit previewRender(i, QString(), -1);
+                    break;
+                }
+                emit previewRender(i, fileName, progress);
             }
         } else {
             emit previewRender(i, QString(), -1);
@@ -461,6 +484,9 @@ void PreviewManager::doPreviewRender(const QString &scene)
         }
     }
     //QFile::remove(scene);
+    if (renderedFrames > 0) {
+        emit previewStats(renderedFrames, startupTime, encodingTime);
+    }
     m_abortPreview = false;
 }
 
@@ -477,41 +503,28 @@ void PreviewManager::slotProcessDirtyChunks()
     }
 }
 
-void PreviewManager::slotRemoveInvalidUndo(int ix)
-{
-    QMutexLocker lock(&m_previewMutex);
-    if (m_undoDir.dirName() != QLatin1String("undo")) {
-        // Make sure we delete correct folder
-        return;
-    }
-    QStringList dirs = m_undoDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    bool ok;
-    foreach (const QString &dir, dirs) {
-        if (dir.toInt(&ok) >= ix && ok == true) {
-            QDir tmp = m_undoDir;
-            if (tmp.cd(dir)) {
-                tmp.removeRecursively();
-            }
-        }
-    }
-}
-
 void PreviewManager::invalidatePreview(int startFrame, int endFrame)
 {
     int chunkSize = KdenliveSettings::timelinechunks();
     int start = startFrame / chunkSize;
     int end = lrintf(endFrame / chunkSize);
     start *= chunkSize;
-    end *= chunkSize;
+    end = (end + 1) * chunkSize;
     if (!m_ruler->isUnderPreview(start, end)) {
         return;
     }
     m_previewGatherTimer.stop();
     abortPreview();
-    m_tractor->lock();
-    bool hasPreview = m_previewTrack != nullptr;
-    for (int i = start; i <= end; i += chunkSize) {
-        if (m_ruler->updatePreview(i, false) && hasPreview) {
+    const QList<int> invalidated = m_ruler->invalidateChunks(start, end);
+    // Content changed, the new keys are computed when the chunks are processed
+    QMap<int, QString>::iterator it = m_chunkKeys.lowerBound(start);
+    while (it != m_chunkKeys.end() && it.key() < end) {
+        it = m_chunkKeys.erase(it);
+    }
+    m_ruler->updatePreviewDisplay(start, end - chunkSize);
+    if (m_previewTrack != nullptr && !invalidated.isEmpty()) {
+        m_tractor->lock();
+        foreach (int i, invalidated) {
             int ix = m_previewTrack->get_clip_index_at(i);
             if (m_previewTrack->is_blank(ix)) {
                 continue;
@@ -519,11 +532,9 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
             Mlt::Producer *prod = m_previewTrack->replace_with_blank(ix);
             delete prod;
         }
-    }
-    if (hasPreview) {
         m_previewTrack->consolidate_blanks();
+        m_tractor->unlock();
     }
-    m_tractor->unlock();
     m_previewGatherTimer.start();
 }
 
@@ -535,9 +546,10 @@ void PreviewManager::reloadChunks(const QList<int> &chunks)
     m_tractor->lock();
     foreach (int ix, chunks) {
         if (m_previewTrack->is_blank_at(ix)) {
-            const QString fileName = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(ix).arg(m_extension));
-            Mlt::Producer prod(*m_tractor->profile(), nullptr, fileName.toUtf8().constData());
+            const QString key = m_chunkKeys.value(ix);
+            Mlt::Producer prod(*m_tractor->profile(), nullptr, m_cache.fileName(key).toUtf8().constData());
             if (prod.is_valid()) {
+                m_cache.touch(key);
                 m_ruler->updatePreview(ix, true);
                 prod.set("mlt_service", "avformat-novalidate");
                 m_previewTrack->insert_at(ix, &prod, 1);
@@ -555,12 +567,23 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
         return;
     }
     if (file.isEmpty() || progress < 0) {
+        m_ruler->clearProcessingChunks();
         m_doc->previewProgress(progress);
         if (progress < 0) {
             m_doc->displayMessage(i18n("Preview rendering failed, check your parameters. %1Show details...%2", QString("<a href=\"" + QString::fromLatin1(QUrl::toPercentEncoding(file)) + QStringLiteral("\">")), QStringLiteral("</a>")), MltError);
         }
         return;
     }
+    const QString key = QFileInfo(file).completeBaseName();
+    m_cache.insert(key, m_chunkKeys);
+    if (m_chunkKeys.value(frame) != key) {
+        // Timeline changed since the chunk was queued, only keep it in cache
+        if (progress >= 1000) {
+            m_ruler->clearProcessingChunks();
+        }
+        m_doc->previewProgress(progress);
+        return;
+    }
     m_tractor->lock();
     if (m_previewTrack->is_blank_at(frame)) {
         Mlt::Producer prod(*m_tractor->profile(), nullptr, file.toUtf8().constData());
@@ -576,6 +599,19 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
     }
     m_previewTrack->consolidate_blanks();
     m_tractor->unlock();
+    if (progress >= 1000) {
+        // Last chunk of the job
+        m_ruler->clearProcessingChunks();
+    }
     m_doc->previewProgress(progress);
     m_doc->setModified(true);
 }
+
+void PreviewManager::gotPreviewStats(int frames, qint64 startupTime, qint64 encodingTime)
+{
+    double fps = encodingTime > 0 ? frames * 1000.0 / encodingTime : 0;
+    m_doc->displayMessage(i18n("Timeline preview: %1 frames rendered in %2s at %3 fps (process startup %4s)", frames,
+                               QString::number((startupTime + encodingTime) / 1000., 'f', 1),
+                               QString::number(fps, 'f', 1),
+                               QString::number(startupTime / 1000., 'f', 1)), InformationMessage);
+}
@@ -21,6 +21,7 @@
 #define PREVIEWMANAGER_H
 
 #include "definitions.h"
+#include "previewcache.h"
 
 #include <QDir>
 #include <QMutex>
@@ -44,6 +45,8 @@ class Playlist;
  * This allow us to get a preview with a smooth playback of our project.
  * Only the preview zone is rendered. Once defined, a preview zone shows as a red line below
  * the timeline ruler. As chunks are rendered, the zone turns to green.
+ * Chunk files are stored in a PreviewCache, named after the content of their frame range, so
+ * that undoing an operation or moving back a region reuses the chunks rendered before.
  */
 
 class PreviewManager : public QObject
@@ -57,7 +60,7 @@ public:
     bool initialize();
     /** @brief: a timeline operation caused changes to frames between startFrame and endFrame. */
     void invalidatePreview(int startFrame, int endFrame);
-    /** @brief: after a small  delay (some operations trigger several invalidatePreview calls), take care of these invalidated chunks. */
+    /** @brief: after a small  delay (some operations trigger several invalidatePreview calls), reload the invalidated chunks already in cache. */
     void invalidatePreviews(const QList<int> &chunks);
     /** @brief: user adds current timeline zone to the preview zone. */
     void addPreviewRange(bool add);
@@ -87,8 +90,11 @@ private:
     Mlt::Playlist *m_previewTrack;
     /** @brief: The directory used to store the preview files. */
     QDir m_cacheDir;
-    /** @brief: The directory used to store undo history of preview files (child of m_cacheDir). */
-    QDir m_undoDir;
+    /** @brief: The rendered chunk files, by content key. */
+    PreviewCache m_cache;
+    /** @brief: Content key of the chunks displayed in timeline or queued for rendering, by chunk frame. */
+    QMap<int, QString> m_chunkKeys;
+    /** @brief: Protects m_waitingThumbs, shared with the rendering thread. */
     QMutex m_previewMutex;
     QStringList m_consumerParams;
     QString m_extension;
@@ -98,18 +104,19 @@ private:
     QTimer m_previewGatherTimer;
     bool m_initialized;
     bool m_abortPreview;
-    QList<int> m_waitingThumbs;
+    /** @brief: Chunks waiting to be rendered: chunk frame -> content key. */
+    QMap<int, QString> m_waitingThumbs;
     QFuture <void> m_previewThread;
-    /** @brief: After an undo/redo, if we have preview history, use it. */
+    /** @brief: Load chunks whose file is in cache on the preview track. */
     void reloadChunks(const QList<int> &chunks);
+    /** @brief: Compute the content keys of chunks in current timeline. */
+    QMap<int, QString> chunkKeys(const QList<int> &chunks);
+    /** @brief: Load the chunks found in cache, returns the others with their content key. */
+    QMap<int, QString> reuseChunks(const QList<int> &chunks);
 
 private slots:
-    /** @brief: To avoid filling the hard drive, remove preview undo history after 5 steps. */
-    void doCleanupOldPreviews();
     /** @brief: Start the real rendering process. */
     void doPreviewRender(const QString &scene);
-    /** @brief: If user does an undo, then makes a new timeline operation, delete undo history of more recent stack . */
-    void slotRemoveInvalidUndo(int ix);
     /** @brief: When the timer collecting invalid zones is done, process. */
     void slotProcessDirtyChunks();
 
@@ -118,11 +125,13 @@ public slots:
     void startPreviewRender();
     /** @brief: A chunk has been created, notify ruler. */
     void gotPreviewRender(int frame, const QString &file, int progress);
+    /** @brief: A rendering session ended, display its performance summary. */
+    void gotPreviewStats(int frames, qint64 startupTime, qint64 encodingTime);
 
 signals:
     void abortPreview();
-    void cleanupOldPreviews();
     void previewRender(int frame, const QString &file, int progress);
+    void previewStats(int frames, qint64 startupTime, qint64 encodingTime);
 };
 
 #endif
@@ -482,6 +482,8 @@ void Timeline::getTransitions()
             service = mlt_service_producer(service);
         }
     }
+    // Broken transitions were removed from the field
+    transitionHandler->invalidateIndex();
     m_doc->updateCompositionMode(compositeMode);
 }
 
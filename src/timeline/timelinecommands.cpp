@@ -50,20 +50,42 @@ AddEffectCommand::AddEffectCommand(CustomTrackView *view, const int track, const
 // virtual
 void AddEffectCommand::undo()
 {
+    QDomElement effect = this->effect();
     if (m_doIt) {
-        m_view->deleteEffect(m_track, m_pos, m_effect);
+        m_view->deleteEffect(m_track, m_pos, effect);
     } else {
-        m_view->addEffect(m_track, m_pos, m_effect);
+        m_view->addEffect(m_track, m_pos, effect);
     }
+    store(effect);
 }
 // virtual
 void AddEffectCommand::redo()
 {
+    QDomElement effect = this->effect();
     if (m_doIt) {
-        m_view->addEffect(m_track, m_pos, m_effect);
+        m_view->addEffect(m_track, m_pos, effect);
     } else {
-        m_view->deleteEffect(m_track, m_pos, m_effect);
+        m_view->deleteEffect(m_track, m_pos, effect);
     }
+    store(effect);
+}
+
+QDomElement AddEffectCommand::effect() const
+{
+    return m_compactEffect.isNull() ? m_effect : m_compactEffect.toElement();
+}
+
+void AddEffectCommand::store(const QDomElement &effect)
+{
+    // Adding the effect sets its index, keep the element as left by the view
+    m_compactEffect = CompactEffect(effect);
+    m_effect = QDomElement();
+}
+// virtual
+qint64 AddEffectCommand::memorySize() const
+{
+    // Compact states are accounted by CompactEffect
+    return UndoMemory::nodeSize(m_effect);
 }
 
 AddTimelineClipCommand::AddTimelineClipCommand(CustomTrackView *view, const QString &clipId, const ItemInfo &info, const EffectsList &effects, PlaylistState::ClipState state, bool doIt, bool doRemove, bool refreshMonitor, QUndoCommand *parent) :
@@ -104,6 +126,11 @@ void AddTimelineClipCommand::redo()
     }
     m_doIt = true;
 }
+// virtual
+qint64 AddTimelineClipCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_effects);
+}
 
 AddTrackCommand::AddTrackCommand(CustomTrackView *view, int ix, const TrackInfo &info, bool addTrack, QUndoCommand *parent) :
     QUndoCommand(parent),
@@ -161,23 +188,43 @@ AddTransitionCommand::AddTransitionCommand(CustomTrackView *view, const ItemInfo
 // virtual
 void AddTransitionCommand::undo()
 {
+    QDomElement params = this->params();
     if (m_remove) {
-        m_view->addTransition(m_info, m_track, m_params, m_refresh);
+        m_view->addTransition(m_info, m_track, params, m_refresh);
     } else {
-        m_view->deleteTransition(m_info, m_track, m_params, m_refresh);
+        m_view->deleteTransition(m_info, m_track, params, m_refresh);
     }
+    store(params);
 }
 // virtual
 void AddTransitionCommand::redo()
 {
+    QDomElement params = this->params();
     if (m_doIt) {
         if (m_remove) {
-            m_view->deleteTransition(m_info, m_track, m_params, m_refresh);
+            m_view->deleteTransition(m_info, m_track, params, m_refresh);
         } else {
-            m_view->addTransition(m_info, m_track, m_params, m_refresh);
+            m_view->addTransition(m_info, m_track, params, m_refresh);
         }
     }
     m_doIt = true;
+    store(params);
+}
+
+QDomElement AddTransitionCommand::params() const
+{
+    return m_compactParams.isNull() ? m_params : m_compactParams.toElement();
+}
+
+void AddTransitionCommand::store(const QDomElement &params)
+{
+    m_compactParams = CompactEffect(params);
+    m_params = QDomElement();
+}
+// virtual
+qint64 AddTransitionCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_params);
 }
 
 ChangeClipTypeCommand::ChangeClipTypeCommand(CustomTrackView *view, const ItemInfo &info, PlaylistState::ClipState state, PlaylistState::ClipState originalState, QUndoCommand *parent) :
@@ -293,6 +340,7 @@ EditEffectCommand::EditEffectCommand(CustomTrackView *view, const int track, con
     m_track(track),
     m_oldeffect(oldeffect),
     m_effect(effect),
+    m_compacted(false),
     m_pos(pos),
     m_stackPos(stackPos),
     m_doIt(doIt),
@@ -338,22 +386,59 @@ bool EditEffectCommand::mergeWith(const QUndoCommand *other)
     if (m_pos != static_cast<const EditEffectCommand *>(other)->m_pos) {
         return false;
     }
-    m_effect = static_cast<const EditEffectCommand *>(other)->m_effect.cloneNode().toElement();
+    const EditEffectCommand *command = static_cast<const EditEffectCommand *>(other);
+    compact();
+    if (command->m_compacted) {
+        // Stay in the compact form, rebuilding the xml would copy and intern the whole effect again
+        m_newState = command->m_newState.apply(command->m_oldState).diff(m_oldState);
+    } else {
+        m_newState = CompactEffect(command->m_effect).diff(m_oldState);
+    }
     return true;
 }
 // virtual
 void EditEffectCommand::undo()
 {
-    m_view->updateEffect(m_track, m_pos, m_oldeffect, true, m_replaceEffect, m_refreshMonitor, m_updateClip);
+    m_view->updateEffect(m_track, m_pos, oldEffect(), true, m_replaceEffect, m_refreshMonitor, m_updateClip);
+    compact();
 }
 // virtual
 void EditEffectCommand::redo()
 {
     if (m_doIt) {
-        m_view->updateEffect(m_track, m_pos, m_effect, m_refreshEffectStack, m_replaceEffect, m_refreshMonitor, m_updateClip);
+        m_view->updateEffect(m_track, m_pos, newEffect(), m_refreshEffectStack, m_replaceEffect, m_refreshMonitor, m_updateClip);
     }
     m_doIt = true;
     m_refreshEffectStack = true;
+    compact();
+}
+
+QDomElement EditEffectCommand::oldEffect() const
+{
+    return m_compacted ? m_oldState.toElement() : m_oldeffect;
+}
+
+QDomElement EditEffectCommand::newEffect() const
+{
+    return m_compacted ? m_newState.apply(m_oldState).toElement() : m_effect;
+}
+
+void EditEffectCommand::compact()
+{
+    if (m_compacted) {
+        return;
+    }
+    // Successive edits of an effect only differ by a few values
+    m_oldState = CompactEffect(m_oldeffect);
+    m_newState = CompactEffect(m_effect).diff(m_oldState);
+    m_oldeffect = QDomElement();
+    m_effect = QDomElement();
+    m_compacted = true;
+}
+// virtual
+qint64 EditEffectCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_oldeffect) + UndoMemory::nodeSize(m_effect);
 }
 
 EditGuideCommand::EditGuideCommand(CustomTrackView *view, const GenTime &oldPos, const QString &oldcomment, const GenTime &pos, const QString &comment, bool doIt, QUndoCommand *parent) :
@@ -395,6 +480,7 @@ EditTransitionCommand::EditTransitionCommand(CustomTrackView *view, const int tr
     m_view(view),
     m_track(track),
     m_oldeffect(oldeffect),
+    m_compacted(false),
     m_pos(pos),
     m_doIt(doIt)
 {
@@ -425,19 +511,55 @@ bool EditTransitionCommand::mergeWith(const QUndoCommand *other)
     if (m_pos != static_cast<const EditTransitionCommand *>(other)->m_pos) {
         return false;
     }
-    m_effect = static_cast<const EditTransitionCommand *>(other)->m_effect;
+    const EditTransitionCommand *command = static_cast<const EditTransitionCommand *>(other);
+    compact();
+    if (command->m_compacted) {
+        // Stay in the compact form, rebuilding the xml would copy and intern the whole effect again
+        m_newState = command->m_newState.apply(command->m_oldState).diff(m_oldState);
+    } else {
+        m_newState = CompactEffect(command->m_effect).diff(m_oldState);
+    }
     return true;
 }
 // virtual
 void EditTransitionCommand::undo()
 {
-    m_view->updateTransition(m_track, m_pos, m_effect, m_oldeffect, m_doIt);
+    m_view->updateTransition(m_track, m_pos, newEffect(), oldEffect(), m_doIt);
+    compact();
 }
 // virtual
 void EditTransitionCommand::redo()
 {
-    m_view->updateTransition(m_track, m_pos, m_oldeffect, m_effect, m_doIt);
+    m_view->updateTransition(m_track, m_pos, oldEffect(), newEffect(), m_doIt);
     m_doIt = true;
+    compact();
+}
+
+QDomElement EditTransitionCommand::oldEffect() const
+{
+    return m_compacted ? m_oldState.toElement() : m_oldeffect;
+}
+
+QDomElement EditTransitionCommand::newEffect() const
+{
+    return m_compacted ? m_newState.apply(m_oldState).toElement() : m_effect;
+}
+
+void EditTransitionCommand::compact()
+{
+    if (m_compacted) {
+        return;
+    }
+    m_oldState = CompactEffect(m_oldeffect);
+    m_newState = CompactEffect(m_effect).diff(m_oldState);
+    m_oldeffect = QDomElement();
+    m_effect = QDomElement();
+    m_compacted = true;
+}
+// virtual
+qint64 EditTransitionCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_oldeffect) + UndoMemory::nodeSize(m_effect);
 }
 
 GroupClipsCommand::GroupClipsCommand(CustomTrackView *view, const QList<ItemInfo> &clipInfos, const QList<ItemInfo> &transitionInfos, bool group, bool doIt, QUndoCommand *parent) :
@@ -694,21 +816,26 @@ void RazorClipCommand::redo()
     }
     m_doIt = true;
 }
+// virtual
+qint64 RazorClipCommand::memorySize() const
+{
+    return UndoMemory::nodeSize(m_originalStack);
+}
 
 RazorTransitionCommand::RazorTransitionCommand(CustomTrackView *view, const ItemInfo &info, const QDomElement &params, const GenTime &cutTime, bool doIt, QUndoCommand *parent) :
     QUndoCommand(parent),
     m_view(view),
     m_info(info),
+    m_originalParams(params),
     m_cutTime(cutTime),
     m_doIt(doIt)
 {
-    m_originalParams = params.cloneNode(true).toElement();
     setText(i18n("Razor clip"));
 }
 // virtual
 void RazorTransitionCommand::undo()
 {
-    m_view->cutTransition(m_info, m_cutTime, false, m_originalParams);
+    m_view->cutTransition(m_info, m_cutTime, false, m_originalParams.toElement());
 }
 // virtual
 void RazorTransitionCommand::redo()
@@ -27,25 +27,32 @@
 #include <QDomElement>
 #include "definitions.h"
 #include "effectslist/effectslist.h"
+#include "effectslist/compacteffect.h"
+#include "doc/undomemory.h"
 class GenTime;
 class CustomTrackView;
 class Timeline;
 
-class AddEffectCommand : public QUndoCommand
+class AddEffectCommand : public QUndoCommand, public UndoMemory
 {
 public:
     AddEffectCommand(CustomTrackView *view, const int track, const GenTime &pos, const QDomElement &effect, bool doIt, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     CustomTrackView *m_view;
     int m_track;
+    /** @brief The effect as passed by the caller, until the command is first executed */
     QDomElement m_effect;
+    CompactEffect m_compactEffect;
     GenTime m_pos;
     bool m_doIt;
+    QDomElement effect() const;
+    void store(const QDomElement &effect);
 };
 
-class AddTimelineClipCommand : public QUndoCommand
+class AddTimelineClipCommand : public QUndoCommand, public UndoMemory
 {
 public:
     /** @brief Add clip in timeline.
@@ -63,6 +70,7 @@ public:
     AddTimelineClipCommand(CustomTrackView *view, const QString &clipId, const ItemInfo &info, const EffectsList &effects, PlaylistState::ClipState state, bool doIt, bool doRemove, bool refreshMonitor, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     CustomTrackView *m_view;
     QString m_clipId;
@@ -87,20 +95,25 @@ private:
     TrackInfo m_info;
 };
 
-class AddTransitionCommand : public QUndoCommand
+class AddTransitionCommand : public QUndoCommand, public UndoMemory
 {
 public:
     AddTransitionCommand(CustomTrackView *view, const ItemInfo &info, int transitiontrack, const QDomElement &params, bool remove, bool doIt, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     CustomTrackView *m_view;
     ItemInfo m_info;
+    /** @brief The transition as passed by the caller, until the command is first executed */
     QDomElement m_params;
+    CompactEffect m_compactParams;
     int m_track;
     bool m_doIt;
     bool m_remove;
     bool m_refresh;
+    QDomElement params() const;
+    void store(const QDomElement &params);
 };
 
 class ChangeClipTypeCommand : public QUndoCommand
@@ -164,7 +177,7 @@ private:
     int m_newState;
 };
 
-class EditEffectCommand : public QUndoCommand
+class EditEffectCommand : public QUndoCommand, public UndoMemory
 {
 public:
     EditEffectCommand(CustomTrackView *view, const int track, const GenTime &pos, const QDomElement &oldeffect, const QDomElement &effect, int stackPos, bool refreshEffectStack, bool updateClip, bool doIt, bool refreshMonitor, QUndoCommand *parent = nullptr);
@@ -172,11 +185,17 @@ public:
     bool mergeWith(const QUndoCommand *command) Q_DECL_OVERRIDE;
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     CustomTrackView *m_view;
     const int m_track;
+    /** @brief The effects as passed by the caller, until the command is first executed */
     QDomElement m_oldeffect;
     QDomElement m_effect;
+    /** @brief Compact history: the old effect, and the changes leading to the new one */
+    CompactEffect m_oldState;
+    CompactEffectDelta m_newState;
+    bool m_compacted;
     const GenTime m_pos;
     int m_stackPos;
     bool m_doIt;
@@ -184,6 +203,9 @@ private:
     bool m_updateClip;
     bool m_replaceEffect;
     bool m_refreshMonitor;
+    QDomElement oldEffect() const;
+    QDomElement newEffect() const;
+    void compact();
 };
 
 class EditGuideCommand : public QUndoCommand
@@ -201,7 +223,7 @@ private:
     bool m_doIt;
 };
 
-class EditTransitionCommand : public QUndoCommand
+class EditTransitionCommand : public QUndoCommand, public UndoMemory
 {
 public:
     EditTransitionCommand(CustomTrackView *view, const int track, const GenTime &pos, const QDomElement &oldeffect, const QDomElement &effect, bool doIt, QUndoCommand *parent = nullptr);
@@ -209,13 +231,22 @@ public:
     bool mergeWith(const QUndoCommand *command) Q_DECL_OVERRIDE;
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     CustomTrackView *m_view;
     const int m_track;
+    /** @brief The transitions as passed by the caller, until the command is first executed */
     QDomElement m_effect;
     QDomElement m_oldeffect;
+    /** @brief Compact history: the old transition, and the changes leading to the new one */
+    CompactEffect m_oldState;
+    CompactEffectDelta m_newState;
+    bool m_compacted;
     const GenTime m_pos;
     bool m_doIt;
+    QDomElement oldEffect() const;
+    QDomElement newEffect() const;
+    void compact();
 };
 
 class GroupClipsCommand : public QUndoCommand
@@ -336,12 +367,13 @@ private:
     bool m_refresh;
 };
 
-class RazorClipCommand : public QUndoCommand
+class RazorClipCommand : public QUndoCommand, public UndoMemory
 {
 public:
     RazorClipCommand(CustomTrackView *view, const ItemInfo &info, const EffectsList &stack, const GenTime &cutTime, bool doIt = true, QUndoCommand *parent = nullptr);
     void undo() Q_DECL_OVERRIDE;
     void redo() Q_DECL_OVERRIDE;
+    qint64 memorySize() const Q_DECL_OVERRIDE;
 private:
     CustomTrackView *m_view;
     ItemInfo m_info;
@@ -359,7 +391,7 @@ public:
 private:
     CustomTrackView *m_view;
     ItemInfo m_info;
-    QDomElement m_originalParams;
+    CompactEffect m_originalParams;
     GenTime m_cutTime;
     bool m_doIt;
 };
@@ -24,6 +24,7 @@
 
 TransitionHandler::TransitionHandler(Mlt::Tractor *tractor) : QObject()
     , m_tractor(tractor)
+    , m_index(tractor)
 {
 }
 
@@ -202,7 +203,7 @@ void TransitionHandler::plantTransition(Mlt::Field *field, Mlt::Transition &tr,
             //new_trans_props.inherit(trans_props);
             cloneProperties(new_trans_props, trans_props);
             trList.append(cp);
-            field->disconnect_service(transition);
+            unplantTransition(field, transition.get_transition());
         }
         //else qCDebug(KDENLIVE_LOG) << "// FOUND TRANS OK, "<<resource<< ", A_: " << aTrack << ", B_ "<<bTrack;
 
@@ -214,11 +215,13 @@ void TransitionHandler::plantTransition(Mlt::Field *field, Mlt::Transition &tr,
         resource = mlt_properties_get(properties, "mlt_service");
     }
     field->plant_transition(tr, a_track, b_track);
+    m_index.insert(tr.get_transition());
 
     // re-add upper transitions
     for (int i = trList.count() - 1; i >= 0; --i) {
         ////qCDebug(KDENLIVE_LOG)<< "REPLANT ON TK: "<<trList.at(i)->get_a_track()<<", "<<trList.at(i)->get_b_track();
         field->plant_transition(*trList.at(i), trList.at(i)->get_a_track(), trList.at(i)->get_b_track());
+        m_index.insert(trList.at(i)->get_transition());
     }
     qDeleteAll(trList);
 }
@@ -254,22 +257,18 @@ void TransitionHandler::updateTransitionParams(const QString &type, int a_track,
     QScopedPointer<Mlt::Field> field(m_tractor->field());
     field->lock();
     double fps = m_tractor->get_fps();
-    mlt_service nextservice = mlt_service_get_producer(field->get_service());
-    mlt_properties properties = MLT_SERVICE_PROPERTIES(nextservice);
-    QString resource = mlt_properties_get(properties, "mlt_service");
     int in_pos = (int) in.frames(fps);
     int out_pos = (int) out.frames(fps) - 1;
 
-    mlt_service_type mlt_type = mlt_service_identify(nextservice);
-    while (mlt_type == transition_type) {
-        mlt_transition tr = (mlt_transition) nextservice;
-        int currentTrack = mlt_transition_get_b_track(tr);
+    const QList<mlt_transition> candidates = m_index.transitionsStartingBefore(b_track, in_pos);
+    for (mlt_transition tr : candidates) {
+        QString resource = mlt_properties_get(MLT_TRANSITION_PROPERTIES(tr), "mlt_service");
         int currentBTrack = mlt_transition_get_a_track(tr);
         int currentIn = (int) mlt_transition_get_in(tr);
         int currentOut = (int) mlt_transition_get_out(tr);
 
         // //qCDebug(KDENLIVE_LOG)<<"Looking for transition : " << currentIn <<'x'<<currentOut<< ", OLD oNE: "<<in_pos<<'x'<<out_pos;
-        if (resource == type && b_track == currentTrack && currentIn == in_pos && currentOut == out_pos) {
+        if (resource == type && currentIn == in_pos && currentOut == out_pos) {
             QMap<QString, QString> map = getTransitionParamsFromXml(xml);
             QMap<QString, QString>::Iterator it;
             QString key;
@@ -296,6 +295,7 @@ void TransitionHandler::updateTransitionParams(const QString &type, int a_track,
 
             if (currentBTrack != a_track) {
                 mlt_properties_set_int(transproperties, "a_track", a_track);
+                m_index.update(tr);
             }
             for (it = map.begin(); it != map.end(); ++it) {
                 key = it.key();
@@ -305,13 +305,6 @@ void TransitionHandler::updateTransitionParams(const QString &type, int a_track,
             }
             break;
         }
-        nextservice = mlt_service_producer(nextservice);
-        if (nextservice == nullptr) {
-            break;
-        }
-        properties = MLT_SERVICE_PROPERTIES(nextservice);
-        mlt_type = mlt_service_identify(nextservice);
-        resource = mlt_properties_get(properties, "mlt_service");
     }
     field->unlock();
     //askForRefresh();
@@ -322,34 +315,20 @@ bool TransitionHandler::deleteTransition(const QString &tag, int /*a_track*/, in
 {
     QScopedPointer<Mlt::Field> field(m_tractor->field());
     field->lock();
-    mlt_service nextservice = mlt_service_get_producer(field->get_service());
-    mlt_properties properties = MLT_SERVICE_PROPERTIES(nextservice);
-    QString resource = mlt_properties_get(properties, "mlt_service");
     double fps = m_tractor->get_fps();
     const int old_pos = (int)((in + out).frames(fps) / 2);
     bool found = false;
     ////qCDebug(KDENLIVE_LOG) << " del trans pos: " << in.frames(25) << '-' << out.frames(25);
 
-    mlt_service_type mlt_type = mlt_service_identify(nextservice);
-    while (mlt_type == transition_type) {
-        mlt_transition tr = (mlt_transition) nextservice;
-        int currentTrack = mlt_transition_get_b_track(tr);
-        int currentIn = (int) mlt_transition_get_in(tr);
+    const QList<mlt_transition> candidates = m_index.transitionsStartingBefore(b_track, old_pos);
+    for (mlt_transition tr : candidates) {
+        QString resource = mlt_properties_get(MLT_TRANSITION_PROPERTIES(tr), "mlt_service");
         int currentOut = (int) mlt_transition_get_out(tr);
-        ////qCDebug(KDENLIVE_LOG) << "// FOUND EXISTING TRANS, IN: " << currentIn << ", OUT: " << currentOut << ", TRACK: " << currentTrack;
-
-        if (resource == tag && b_track == currentTrack && currentIn <= old_pos && currentOut >= old_pos) {
+        if (resource == tag && currentOut >= old_pos) {
             found = true;
-            mlt_field_disconnect_service(field->get_field(), nextservice);
+            unplantTransition(field.data(), tr);
             break;
         }
-        nextservice = mlt_service_producer(nextservice);
-        if (nextservice == nullptr) {
-            break;
-        }
-        properties = MLT_SERVICE_PROPERTIES(nextservice);
-        mlt_type = mlt_service_identify(nextservice);
-        resource = mlt_properties_get(properties, "mlt_service");
     }
     field->unlock();
     //askForRefresh();
@@ -360,19 +339,9 @@ bool TransitionHandler::deleteTransition(const QString &tag, int /*a_track*/, in
 void TransitionHandler::deleteTrackTransitions(int ix)
 {
     QScopedPointer<Mlt::Field> field(m_tractor->field());
-    mlt_service nextservice = mlt_service_get_producer(field->get_service());
-    mlt_service_type type = mlt_service_identify(nextservice);
-    while (type == transition_type) {
-        Mlt::Transition transition((mlt_transition) nextservice);
-        nextservice = mlt_service_producer(nextservice);
-        int currentTrack = transition.get_b_track();
-        if (ix == currentTrack) {
-            field->disconnect_service(transition);
-        }
-        if (nextservice == nullptr) {
-            break;
-        }
-        type = mlt_service_identify(nextservice);
+    const QList<mlt_transition> transitions = m_index.trackTransitions(ix);
+    for (mlt_transition tr : transitions) {
+        unplantTransition(field.data(), tr);
     }
 }
 
@@ -389,20 +358,15 @@ bool TransitionHandler::moveTransition(const QString &type, int startTrack, int
 
     QScopedPointer<Mlt::Field> field(m_tractor->field());
     field->lock();
-    mlt_service nextservice = mlt_service_get_producer(field->get_service());
-    mlt_properties properties = MLT_SERVICE_PROPERTIES(nextservice);
-    QString resource = mlt_properties_get(properties, "mlt_service");
     int old_pos = (int)(old_in + old_out) / 2;
     bool found = false;
-    mlt_service_type mlt_type = mlt_service_identify(nextservice);
-    while (mlt_type == transition_type) {
-        Mlt::Transition transition((mlt_transition) nextservice);
-        nextservice = mlt_service_producer(nextservice);
-        int currentTrack = transition.get_b_track();
-        int currentIn = (int) transition.get_in();
+    const QList<mlt_transition> candidates = m_index.transitionsStartingBefore(startTrack, old_pos);
+    for (mlt_transition tr : candidates) {
+        Mlt::Transition transition(tr);
+        QString resource = transition.get("mlt_service");
         int currentOut = (int) transition.get_out();
 
-        if (resource == type && startTrack == currentTrack && currentIn <= old_pos && currentOut >= old_pos) {
+        if (resource == type && currentOut >= old_pos) {
             found = true;
             if (newTrack - startTrack != 0) {
                 Mlt::Properties trans_props(transition.get_properties());
@@ -411,19 +375,14 @@ bool TransitionHandler::moveTransition(const QString &type, int startTrack, int
                 // We cannot use MLT's property inherit because it also clones internal values like _unique_id which messes up the playlist
                 cloneProperties(new_trans_props, trans_props);
                 new_transition.set_in_and_out(new_in, new_out);
-                field->disconnect_service(transition);
+                unplantTransition(field.data(), tr);
                 plantTransition(field.data(), new_transition, newTransitionTrack, newTrack);
             } else {
                 transition.set_in_and_out(new_in, new_out);
+                m_index.update(tr);
             }
             break;
         }
-        if (nextservice == nullptr) {
-            break;
-        }
-        properties = MLT_SERVICE_PROPERTIES(nextservice);
-        mlt_type = mlt_service_identify(nextservice);
-        resource = mlt_properties_get(properties, "mlt_service");
     }
     field->unlock();
     //if (m_isBlocked == 0) m_mltConsumer->set("refresh", 1);
@@ -432,42 +391,32 @@ bool TransitionHandler::moveTransition(const QString &type, int startTrack, int
 
 Mlt::Transition *TransitionHandler::getTransition(const QString &name, int b_track, int a_track, bool internalTransition) const
 {
-    QScopedPointer<Mlt::Service> service(m_tractor->field());
-    while (service && service->is_valid()) {
-        if (service->type() == transition_type) {
-            Mlt::Transition t((mlt_transition) service->get_service());
-            if (name == t.get("mlt_service") && t.get_b_track() == b_track) {
-                if (a_track == -1 || t.get_a_track() == a_track) {
-                    int internal = t.get_int("internal_added");
-                    if (internal == 0) {
-                        if (!internalTransition) {
-                            return new Mlt::Transition(t);
-                        }
-                    } else if (internalTransition) {
-                        return new Mlt::Transition(t);
-                    }
+    const QList<mlt_transition> transitions = m_index.trackTransitions(b_track, a_track);
+    for (mlt_transition tr : transitions) {
+        Mlt::Transition t(tr);
+        if (name == t.get("mlt_service")) {
+            int internal = t.get_int("internal_added");
+            if (internal == 0) {
+                if (!internalTransition) {
+                    return new Mlt::Transition(t);
                 }
+            } else if (internalTransition) {
+                return new Mlt::Transition(t);
             }
         }
-        service.reset(service->producer());
     }
     return nullptr;
 }
 
 Mlt::Transition *TransitionHandler::getTrackTransition(const QStringList &names, int b_track, int a_track) const
 {
-    QScopedPointer<Mlt::Service> service(m_tractor->field());
-    while (service && service->is_valid()) {
-        if (service->type() == transition_type) {
-            Mlt::Transition t((mlt_transition) service->get_service());
-            int internal = t.get_int("internal_added");
-            if (internal >= 200) {
-                if (names.contains(t.get("mlt_service")) && t.get_b_track() == b_track && (a_track == -1 || t.get_a_track() == a_track)) {
-                    return new Mlt::Transition(t);
-                }
-            }
+    const QList<mlt_transition> transitions = m_index.trackTransitions(b_track, a_track);
+    for (mlt_transition tr : transitions) {
+        Mlt::Transition t(tr);
+        int internal = t.get_int("internal_added");
+        if (internal >= 200 && names.contains(t.get("mlt_service"))) {
+            return new Mlt::Transition(t);
         }
-        service.reset(service->producer());
     }
     return nullptr;
 }
@@ -515,27 +464,19 @@ void TransitionHandler::enableMultiTrack(bool enable)
         return;
     }
     QStringList compositeService { QStringLiteral("qtblend"), QStringLiteral("frei0r.cairoblend"),  QStringLiteral("movit.overlay") };
-    QScopedPointer<Mlt::Service> service(m_tractor->field());
     QScopedPointer<Mlt::Field> field(m_tractor->field());
     field->lock();
     if (enable) {
         // disable track composition (frei0r.cairoblend)
-        mlt_service nextservice = mlt_service_get_producer(field->get_service());
-        mlt_service_type type = mlt_service_identify(nextservice);
-        while (type == transition_type) {
-            Mlt::Transition transition((mlt_transition) nextservice);
-            nextservice = mlt_service_producer(nextservice);
-            int added = transition.get_int("internal_added");
-            if (added == 237) {
-                if (compositeService.contains(transition.get("mlt_service")) && transition.get_int("disable") == 0) {
+        for (const QString &serviceName : compositeService) {
+            const QList<mlt_transition> transitions = m_index.serviceTransitions(serviceName);
+            for (mlt_transition tr : transitions) {
+                Mlt::Transition transition(tr);
+                if (transition.get_int("internal_added") == 237 && transition.get_int("disable") == 0) {
                     transition.set("disable", 1);
                     transition.set("split_disable", 1);
                 }
             }
-            if (nextservice == nullptr) {
-                break;
-            }
-            type = mlt_service_identify(nextservice);
         }
         // Search for visible tracks and arrange them on a 2x2 grid.
         // If there are more than 4 visible tracks, the extra
@@ -575,29 +516,27 @@ void TransitionHandler::enableMultiTrack(bool enable)
                 transition.set("geometry", geometry.toUtf8().constData());
                 transition.set("always_active", 1);
                 field->plant_transition(transition, 0, i);
+                m_index.insert(transition.get_transition());
                 screen++;
             }
         }
     } else {
-        mlt_service nextservice = mlt_service_get_producer(field->get_service());
-        mlt_service_type type = mlt_service_identify(nextservice);
-        while (type == transition_type) {
-            Mlt::Transition transition((mlt_transition) nextservice);
-            nextservice = mlt_service_producer(nextservice);
-            int added = transition.get_int("internal_added");
-            if (added == 200) {
-                field->disconnect_service(transition);
-            } else if (added == 237) {
-                // re-enable track compositing
-                if (compositeService.contains(transition.get("mlt_service")) && transition.get_int("split_disable") == 1) {
+        const QList<mlt_transition> splitTransitions = m_index.serviceTransitions(QStringLiteral("composite"));
+        for (mlt_transition tr : splitTransitions) {
+            if (mlt_properties_get_int(MLT_TRANSITION_PROPERTIES(tr), "internal_added") == 200) {
+                unplantTransition(field.data(), tr);
+            }
+        }
+        // re-enable track compositing
+        for (const QString &serviceName : compositeService) {
+            const QList<mlt_transition> transitions = m_index.serviceTransitions(serviceName);
+            for (mlt_transition tr : transitions) {
+                Mlt::Transition transition(tr);
+                if (transition.get_int("internal_added") == 237 && transition.get_int("split_disable") == 1) {
                     transition.set("disable", 0);
                     transition.set("split_disable", (char *) nullptr);
                 }
             }
-            if (nextservice == nullptr) {
-                break;
-            }
-            type = mlt_service_identify(nextservice);
         }
     }
     field->unlock();
@@ -622,28 +561,21 @@ const QString TransitionHandler::compositeTransition()
 void TransitionHandler::rebuildTransitions(int mode, const QList<int> &videoTracks, int maxTrack)
 {
     QStringList compositeService { QStringLiteral("qtblend"), QStringLiteral("composite"), QStringLiteral("frei0r.cairoblend"),  QStringLiteral("movit.overlay") };
-    QList<int> disabled;
-    QScopedPointer<Mlt::Service> service(m_tractor->field());
     Mlt::Field *field = m_tractor->field();
     field->lock();
-    // Get the list of composite transitions
-    while (service && service->is_valid()) {
-        if (service->type() == transition_type) {
-            Mlt::Transition t((mlt_transition) service->get_service());
-            int internal = t.get_int("internal_added");
-            if (internal == 237) {
-                QString serviceName = t.get("mlt_service");
-                if (serviceName == QLatin1String("mix")) {
-                    field->disconnect_service(t);
-                } else if (compositeService.contains(serviceName)) {
-                    if (mode < 0) {
-                        mode = serviceName == QLatin1String("composite") ? 1 : 2;
-                    }
-                    field->disconnect_service(t);
-                }
+    // Remove the audio mix and composite transitions
+    const QStringList internalServices = QStringList(compositeService) << QStringLiteral("mix");
+    for (const QString &serviceName : internalServices) {
+        const QList<mlt_transition> transitions = m_index.serviceTransitions(serviceName);
+        for (mlt_transition tr : transitions) {
+            if (mlt_properties_get_int(MLT_TRANSITION_PROPERTIES(tr), "internal_added") != 237) {
+                continue;
+            }
+            if (mode < 0 && serviceName != QLatin1String("mix")) {
+                mode = serviceName == QLatin1String("composite") ? 1 : 2;
             }
+            unplantTransition(field, tr);
         }
-        service.reset(service->producer());
     }
     // Rebuild audio mix
     for (int i = 1; i < maxTrack; i++) {
@@ -658,6 +590,7 @@ void TransitionHandler::rebuildTransitions(int mode, const QList<int> &videoTrac
         transition.set("b_track", i);
         transition.set("internal_added", 237);
         field->plant_transition(transition, 0, i);
+        m_index.insert(transition.get_transition());
     }
 
     if (mode <= 0) {
@@ -688,11 +621,23 @@ void TransitionHandler::rebuildTransitions(int mode, const QList<int> &videoTrac
         }
         transition.set("internal_added", 237);
         field->plant_transition(transition, 0, track);
+        m_index.insert(transition.get_transition());
     }
     field->unlock();
     delete field;
 }
 
+void TransitionHandler::invalidateIndex()
+{
+    m_index.invalidate();
+}
+
+void TransitionHandler::unplantTransition(Mlt::Field *field, mlt_transition transition)
+{
+    mlt_field_disconnect_service(field->get_field(), MLT_TRANSITION_SERVICE(transition));
+    m_index.remove(transition);
+}
+
 // static
 bool TransitionHandler::sumAudioMixAvailable() {
     // TODO: remove whenever we require MLT > 6.4.x
@@ -27,6 +27,7 @@
 #define TRANSITIONHANDLER_H
 
 #include "definitions.h"
+#include "transitionindex.h"
 #include <mlt++/Mlt.h>
 
 class TransitionHandler : public QObject
@@ -61,9 +62,14 @@ public:
     /** @brief Initialize transition settings. */
     void initTransition(const QDomElement &xml);
     static bool sumAudioMixAvailable();
+    /** @brief Rebuild the transitions index on next lookup, must be called after the field was modified by other code. */
+    void invalidateIndex();
 
 private:
     Mlt::Tractor *m_tractor;
+    mutable TransitionIndex m_index;
+    /** @brief Disconnect a transition from the field and the index. */
+    void unplantTransition(Mlt::Field *field, mlt_transition transition);
 
 signals:
     void refresh();
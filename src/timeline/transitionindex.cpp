@@ -0,0 +1,195 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "transitionindex.h"
+
+#include <limits>
+
+bool TransitionIndex::Key::operator<(const Key &other) const
+{
+    if (bTrack != other.bTrack) {
+        return bTrack < other.bTrack;
+    }
+    if (in != other.in) {
+        return in < other.in;
+    }
+    return aTrack < other.aTrack;
+}
+
+TransitionIndex::TransitionIndex(Mlt::Tractor *tractor) :
+    m_tractor(tractor),
+    m_valid(false)
+{
+}
+
+TransitionIndex::~TransitionIndex()
+{
+    clear();
+}
+
+TransitionIndex::Key TransitionIndex::keyOf(mlt_transition transition)
+{
+    Key key;
+    key.bTrack = mlt_transition_get_b_track(transition);
+    key.in = (int) mlt_transition_get_in(transition);
+    key.aTrack = mlt_transition_get_a_track(transition);
+    return key;
+}
+
+void TransitionIndex::clear()
+{
+    QHash<mlt_transition, Entry>::const_iterator it = m_entries.constBegin();
+    for (; it != m_entries.constEnd(); ++it) {
+        mlt_transition_close(it.key());
+    }
+    m_entries.clear();
+    m_positions.clear();
+    m_services.clear();
+}
+
+void TransitionIndex::invalidate()
+{
+    clear();
+    m_valid = false;
+}
+
+void TransitionIndex::insert(mlt_transition transition)
+{
+    if (!m_valid || transition == nullptr || m_entries.contains(transition)) {
+        // An invalid index is rebuilt from the field anyway
+        return;
+    }
+    Entry entry;
+    entry.key = keyOf(transition);
+    entry.service = QString(mlt_properties_get(MLT_TRANSITION_PROPERTIES(transition), "mlt_service"));
+    mlt_properties_inc_ref(MLT_TRANSITION_PROPERTIES(transition));
+    m_entries.insert(transition, entry);
+    m_positions.insert(entry.key, transition);
+    m_services[entry.service].insert(transition);
+}
+
+void TransitionIndex::remove(mlt_transition transition)
+{
+    QHash<mlt_transition, Entry>::iterator it = m_entries.find(transition);
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_positions.remove(it->key, transition);
+    QHash<QString, QSet<mlt_transition> >::iterator service = m_services.find(it->service);
+    if (service != m_services.end()) {
+        service->remove(transition);
+        if (service->isEmpty()) {
+            m_services.erase(service);
+        }
+    }
+    m_entries.erase(it);
+    mlt_transition_close(transition);
+}
+
+void TransitionIndex::update(mlt_transition transition)
+{
+    QHash<mlt_transition, Entry>::iterator it = m_entries.find(transition);
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_positions.remove(it->key, transition);
+    it->key = keyOf(transition);
+    m_positions.insert(it->key, transition);
+}
+
+void TransitionIndex::rebuild()
+{
+    clear();
+    m_valid = true;
+    QScopedPointer<Mlt::Field> field(m_tractor->field());
+    mlt_service nextservice = mlt_service_get_producer(field->get_service());
+    while (nextservice != nullptr && mlt_service_identify(nextservice) == transition_type) {
+        insert((mlt_transition) nextservice);
+        nextservice = mlt_service_producer(nextservice);
+    }
+}
+
+void TransitionIndex::ensureValid()
+{
+    if (!m_valid) {
+        rebuild();
+    }
+}
+
+bool TransitionIndex::checkKeys(const QList<mlt_transition> &transitions)
+{
+    for (mlt_transition transition : transitions) {
+        const Key key = keyOf(transition);
+        const Key &indexed = m_entries.value(transition).key;
+        if (key.bTrack != indexed.bTrack || key.in != indexed.in || key.aTrack != indexed.aTrack) {
+            // The field was modified behind our back
+            invalidate();
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<mlt_transition> TransitionIndex::trackTransitions(int bTrack, int aTrack)
+{
+    QList<mlt_transition> result;
+    for (int pass = 0; pass < 2; ++pass) {
+        ensureValid();
+        result.clear();
+        Key first;
+        first.bTrack = bTrack;
+        first.in = std::numeric_limits<int>::min();
+        first.aTrack = std::numeric_limits<int>::min();
+        QMultiMap<Key, mlt_transition>::const_iterator it = m_positions.lowerBound(first);
+        for (; it != m_positions.constEnd() && it.key().bTrack == bTrack; ++it) {
+            if (aTrack == -1 || it.key().aTrack == aTrack) {
+                result << it.value();
+            }
+        }
+        if (checkKeys(result)) {
+            break;
+        }
+    }
+    return result;
+}
+
+QList<mlt_transition> TransitionIndex::transitionsStartingBefore(int bTrack, int position)
+{
+    QList<mlt_transition> result;
+    for (int pass = 0; pass < 2; ++pass) {
+        ensureValid();
+        result.clear();
+        Key first;
+        first.bTrack = bTrack;
+        first.in = std::numeric_limits<int>::min();
+        first.aTrack = std::numeric_limits<int>::min();
+        QMultiMap<Key, mlt_transition>::const_iterator it = m_positions.lowerBound(first);
+        for (; it != m_positions.constEnd() && it.key().bTrack == bTrack && it.key().in <= position; ++it) {
+            result << it.value();
+        }
+        if (checkKeys(result)) {
+            break;
+        }
+    }
+    return result;
+}
+
+QList<mlt_transition> TransitionIndex::serviceTransitions(const QString &service)
+{
+    QList<mlt_transition> result;
+    for (int pass = 0; pass < 2; ++pass) {
+        ensureValid();
+        result = m_services.value(service).toList();
+        if (checkKeys(result)) {
+            break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2018 by Jean-Baptiste Mardelle (jb@kdenlive.org)        *
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef TRANSITIONINDEX_H
+#define TRANSITIONINDEX_H
+
+#include <mlt++/Mlt.h>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QList>
+
+/**
+ * @class TransitionIndex
+ * @brief Index of the transitions planted in a tractor's field.
+ *
+ * Transitions are indexed by (b track, a track, in point) and by MLT service,
+ * so that finding the transitions of a track or of a type does not walk the
+ * whole field. The index must be told about every transition planted or
+ * unplanted through insert() and remove(), and about changes of tracks or in
+ * point through update(). Changes made to the field by other code must be
+ * followed by invalidate(), the index is then rebuilt on next use.
+ *
+ * Indexed transitions are referenced, so that a transition removed from the
+ * field without notification stays valid until it is detected as stale.
+ * Returned transitions are checked against their key, a mismatch rebuilds
+ * the index.
+ */
+class TransitionIndex
+{
+public:
+    explicit TransitionIndex(Mlt::Tractor *tractor);
+    ~TransitionIndex();
+
+    /** @brief Discard the index, it will be rebuilt from the field on next lookup */
+    void invalidate();
+    /** @brief Add a transition that was just planted */
+    void insert(mlt_transition transition);
+    /** @brief Remove a transition, before it is unplanted */
+    void remove(mlt_transition transition);
+    /** @brief Refresh the key of a transition after its tracks or in point changed */
+    void update(mlt_transition transition);
+
+    /** @brief Transitions of a b track ordered by in point, optionally restricted to an a track */
+    QList<mlt_transition> trackTransitions(int bTrack, int aTrack = -1);
+    /** @brief Transitions of a b track starting at or before position, ordered by in point */
+    QList<mlt_transition> transitionsStartingBefore(int bTrack, int position);
+    /** @brief Transitions using an MLT service */
+    QList<mlt_transition> serviceTransitions(const QString &service);
+
+private:
+    struct Key {
+        int bTrack;
+        int in;
+        int aTrack;
+        bool operator<(const Key &other) const;
+    };
+    struct Entry {
+        Key key;
+        QString service;
+    };
+    Mlt::Tractor *m_tractor;
+    bool m_valid;
+    QMultiMap<Key, mlt_transition> m_positions;
+    QHash<QString, QSet<mlt_transition> > m_services;
+    QHash<mlt_transition, Entry> m_entries;
+
+    static Key keyOf(mlt_transition transition);
+    void clear();
+    void rebuild();
+    void ensureValid();
+    /** @brief Returns false and invalidates the index if one of the transitions does not match its key */
+    bool checkKeys(const QList<mlt_transition> &transitions);
+};
+
+#endif
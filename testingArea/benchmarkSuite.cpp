@@ -0,0 +1,462 @@
+/*
+Copyright (C) 2018  Jean-Baptiste Mardelle  <jb@kdenlive.org>
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVector>
+#include <mlt++/Mlt.h>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "../src/doc/documentupgrader.h"
+#include "../src/gentime.h"
+#include "../src/lib/audio/audioBlock.h"
+#include "../src/lib/audio/fftCorrelation.h"
+#include "../src/lib/audio/fftTools.h"
+#include "../src/lib/video/colorConversion.h"
+#include "../src/project/archivewriter.h"
+#include "../src/scopes/colorscopes/histogramgenerator.h"
+#include "../src/scopes/colorscopes/rgbparadegenerator.h"
+#include "../src/scopes/colorscopes/vectorscopegenerator.h"
+#include "../src/scopes/colorscopes/waveformgenerator.h"
+#include "../src/timeline/intervalset.h"
+
+void printUsage(const char *path)
+{
+    std::cout << "This executable runs the performance benchmarks of Kdenlive's hot paths on" << std::endl
+              << "synthetic data, and compares the results with a previous run." << std::endl << std::endl
+              << path << " [options]" << std::endl
+              << "\t-h, --help\n\t\tDisplay this help" << std::endl
+              << "\t--list\n\t\tList the benchmarks" << std::endl
+              << "\t--filter=<text>\n\t\tOnly run the benchmarks whose name contains text" << std::endl
+              << "\t--iterations=<count>\n\t\tTimed runs of each benchmark, default 10" << std::endl
+              << "\t--output=<file>\n\t\tWrite the results as JSON to file, - for standard output (progress then goes to standard error)" << std::endl
+              << "\t--baseline=<file>\n\t\tCompare with the results of a previous --output" << std::endl
+              << "\t--tolerance=<percent>\n\t\tSlowdown of the median time reported as a regression, default 15" << std::endl
+              << "The exit code is 1 if a benchmark regressed compared to the baseline." << std::endl
+              << "Results are only comparable between runs on the same machine and build type." << std::endl;
+}
+
+struct Benchmark {
+    QString name;
+    /** @brief Prepares the data of one run, not timed */
+    std::function<void()> setup;
+    std::function<void()> run;
+};
+
+struct Result {
+    QString name;
+    int iterations;
+    double median;
+    double min;
+};
+
+Result runBenchmark(const Benchmark &benchmark, int iterations)
+{
+    // Warm up caches and lazy initializations
+    if (benchmark.setup) {
+        benchmark.setup();
+    }
+    benchmark.run();
+    std::vector<double> times;
+    for (int i = 0; i < iterations; ++i) {
+        if (benchmark.setup) {
+            benchmark.setup();
+        }
+        QElapsedTimer timer;
+        timer.start();
+        benchmark.run();
+        times.push_back(timer.nsecsElapsed() / 1000000.);
+    }
+    std::sort(times.begin(), times.end());
+    Result result;
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.median = times.at(times.size() / 2);
+    result.min = times.front();
+    return result;
+}
+
+// A project with clips, filters and transitions, saved by an older version so that the upgrade has work to do
+QByteArray syntheticProject(int clips, int tracks)
+{
+    QDomDocument doc;
+    QDomElement mlt = doc.createElement(QStringLiteral("mlt"));
+    doc.appendChild(mlt);
+    auto addProperty = [&doc](QDomElement &parent, const QString &name, const QString &value) {
+        QDomElement property = doc.createElement(QStringLiteral("property"));
+        property.setAttribute(QStringLiteral("name"), name);
+        property.appendChild(doc.createTextNode(value));
+        parent.appendChild(property);
+    };
+    QDomElement black = doc.createElement(QStringLiteral("producer"));
+    black.setAttribute(QStringLiteral("id"), QStringLiteral("black_track"));
+    addProperty(black, QStringLiteral("mlt_service"), QStringLiteral("color"));
+    addProperty(black, QStringLiteral("resource"), QStringLiteral("black"));
+    mlt.appendChild(black);
+    for (int i = 0; i < clips; ++i) {
+        QDomElement producer = doc.createElement(QStringLiteral("producer"));
+        producer.setAttribute(QStringLiteral("id"), QString::number(i + 1));
+        producer.setAttribute(QStringLiteral("out"), 1499);
+        if (i % 10 == 0) {
+            addProperty(producer, QStringLiteral("mlt_service"), QStringLiteral("qimage"));
+            addProperty(producer, QStringLiteral("resource"), QStringLiteral("/media/sequence%1/img_.png?begin:10").arg(i));
+        } else {
+            addProperty(producer, QStringLiteral("mlt_service"), QStringLiteral("avformat"));
+            addProperty(producer, QStringLiteral("resource"), QStringLiteral("/media/footage/clip_%1.mp4").arg(i));
+        }
+        addProperty(producer, QStringLiteral("kdenlive:clipname"), QStringLiteral("Clip %1").arg(i));
+        addProperty(producer, QStringLiteral("kdenlive:file_hash"), QString::number(qHash(i), 16));
+        mlt.appendChild(producer);
+    }
+    QDomElement tractor = doc.createElement(QStringLiteral("tractor"));
+    tractor.setAttribute(QStringLiteral("id"), QStringLiteral("maintractor"));
+    for (int t = 0; t < tracks; ++t) {
+        QDomElement playlist = doc.createElement(QStringLiteral("playlist"));
+        playlist.setAttribute(QStringLiteral("id"), QStringLiteral("playlist%1").arg(t + 1));
+        for (int i = t; i < clips; i += tracks) {
+            QDomElement blank = doc.createElement(QStringLiteral("blank"));
+            blank.setAttribute(QStringLiteral("length"), 25);
+            playlist.appendChild(blank);
+            QDomElement entry = doc.createElement(QStringLiteral("entry"));
+            entry.setAttribute(QStringLiteral("producer"), QString::number(i + 1));
+            entry.setAttribute(QStringLiteral("in"), 100);
+            entry.setAttribute(QStringLiteral("out"), 349);
+            for (int f = 0; f < 2; ++f) {
+                QDomElement filter = doc.createElement(QStringLiteral("filter"));
+                filter.setAttribute(QStringLiteral("in"), 100);
+                filter.setAttribute(QStringLiteral("out"), 349);
+                addProperty(filter, QStringLiteral("mlt_service"), f == 0 ? QStringLiteral("volume") : QStringLiteral("frei0r.brightness"));
+                addProperty(filter, QStringLiteral("kdenlive_id"), f == 0 ? QStringLiteral("volume") : QStringLiteral("brightness"));
+                addProperty(filter, QStringLiteral("tag"), f == 0 ? QStringLiteral("volume") : QStringLiteral("frei0r.brightness"));
+                addProperty(filter, QStringLiteral("gain"), QStringLiteral("1"));
+                entry.appendChild(filter);
+            }
+            playlist.appendChild(entry);
+        }
+        mlt.appendChild(playlist);
+        QDomElement track = doc.createElement(QStringLiteral("track"));
+        track.setAttribute(QStringLiteral("producer"), playlist.attribute(QStringLiteral("id")));
+        tractor.appendChild(track);
+    }
+    for (int t = 1; t < tracks; ++t) {
+        for (int i = 0; i < clips / tracks; i += 4) {
+            QDomElement transition = doc.createElement(QStringLiteral("transition"));
+            transition.setAttribute(QStringLiteral("in"), i * 275);
+            transition.setAttribute(QStringLiteral("out"), i * 275 + 24);
+            const bool luma = i % 8 == 0;
+            addProperty(transition, QStringLiteral("mlt_service"), luma ? QStringLiteral("luma") : QStringLiteral("mix"));
+            addProperty(transition, QStringLiteral("kdenlive_id"), luma ? QStringLiteral("luma") : QStringLiteral("mix"));
+            addProperty(transition, QStringLiteral("a_track"), QString::number(t - 1));
+            addProperty(transition, QStringLiteral("b_track"), QString::number(t));
+            addProperty(transition, QStringLiteral("combine"), QStringLiteral("1"));
+            tractor.appendChild(transition);
+        }
+    }
+    mlt.appendChild(tractor);
+    QDomElement kdenliveDoc = doc.createElement(QStringLiteral("kdenlivedoc"));
+    kdenliveDoc.setAttribute(QStringLiteral("version"), QStringLiteral("0.91"));
+    mlt.appendChild(kdenliveDoc);
+    return doc.toByteArray();
+}
+
+// A frame with gradients and noise, so that every scope has a spread distribution
+QImage syntheticImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    srand(42);
+    for (int y = 0; y < height; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            const int noise = rand() & 0x1f;
+            line[x] = qRgb((x * 255 / width + noise) & 0xff, (y * 255 / height + noise) & 0xff, ((x + y) & 0xff) ^ noise);
+        }
+    }
+    return image;
+}
+
+QVector<qint64> syntheticEnvelope(int size, int seed)
+{
+    QVector<qint64> envelope(size);
+    srand(seed);
+    for (int i = 0; i < size; ++i) {
+        envelope[i] = rand() % 65536 - 32768;
+    }
+    return envelope;
+}
+
+QJsonObject resultsToJson(const QVector<Result> &results)
+{
+    QJsonArray list;
+    for (const Result &result : results) {
+        QJsonObject item;
+        item.insert(QStringLiteral("name"), result.name);
+        item.insert(QStringLiteral("iterations"), result.iterations);
+        item.insert(QStringLiteral("median_ms"), result.median);
+        item.insert(QStringLiteral("min_ms"), result.min);
+        list.append(item);
+    }
+    QJsonObject json;
+    json.insert(QStringLiteral("version"), 1);
+    json.insert(QStringLiteral("qt"), QString::fromLatin1(qVersion()));
+    json.insert(QStringLiteral("mlt"), QString::fromLatin1(mlt_version_get_string()));
+    json.insert(QStringLiteral("results"), list);
+    return json;
+}
+
+int main(int argc, char *argv[])
+{
+    // Scopes paint on images only, no display is needed
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QStringList args = app.arguments();
+    args.removeFirst();
+    int iterations = 10;
+    double tolerance = 15;
+    bool listOnly = false;
+    QString filter;
+    QString output;
+    QString baseline;
+    for (const QString &arg : args) {
+        if (arg == QLatin1String("-h") || arg == QLatin1String("--help")) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (arg == QLatin1String("--list")) {
+            listOnly = true;
+        } else if (arg.startsWith(QLatin1String("--filter="))) {
+            filter = arg.section(QLatin1Char('='), 1);
+        } else if (arg.startsWith(QLatin1String("--iterations="))) {
+            iterations = qMax(1, arg.section(QLatin1Char('='), 1).toInt());
+        } else if (arg.startsWith(QLatin1String("--output="))) {
+            output = arg.section(QLatin1Char('='), 1);
+        } else if (arg.startsWith(QLatin1String("--baseline="))) {
+            baseline = arg.section(QLatin1Char('='), 1);
+        } else if (arg.startsWith(QLatin1String("--tolerance="))) {
+            tolerance = arg.section(QLatin1Char('='), 1).toDouble();
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    // Keep standard output for the JSON results when they are written there
+    std::ostream &report = output == QLatin1String("-") ? std::cerr : std::cout;
+    Mlt::Factory::init();
+    Mlt::Profile profile("atsc_1080p_25");
+
+    // Shared fixtures
+    const QByteArray project = syntheticProject(600, 6);
+    QDomDocument projectDoc;
+    projectDoc.setContent(project);
+    QDomDocument upgradeDoc;
+    const QImage frame = syntheticImage(1920, 1080);
+    const QVector<qint64> mainEnvelope = syntheticEnvelope(60000, 1);
+    const QVector<qint64> childEnvelope = syntheticEnvelope(20000, 2);
+    std::vector<float> correlation(mainEnvelope.size() + childEnvelope.size() + 1);
+    const int width = 1920;
+    const int height = 1080;
+    const int chromaWidth = width / 2;
+    std::vector<uint8_t> packed(static_cast<size_t>(chromaWidth * 4 * height));
+    std::vector<uint8_t> planar(static_cast<size_t>(width * height * 3 / 2));
+    srand(42);
+    for (uint8_t &value : packed) {
+        value = static_cast<uint8_t>(rand() & 0xff);
+    }
+    for (uint8_t &value : planar) {
+        value = static_cast<uint8_t>(rand() & 0xff);
+    }
+    std::vector<uint8_t> rgb(static_cast<size_t>(width * height * 4));
+    QTemporaryDir archiveDir;
+    QByteArray media(8 * 1024 * 1024, 0);
+    for (int i = 0; i < media.size(); ++i) {
+        media[i] = static_cast<char>((i / 64) ^ (rand() & 0x3));
+    }
+    Mlt::Producer noise(profile, "noise");
+    Mlt::Frame *noiseFrame = noise.get_frame();
+    const AudioBlock audio = noiseFrame ? AudioBlock::fromFrame(*noiseFrame) : AudioBlock();
+    delete noiseFrame;
+    FFTTools fft;
+    std::vector<float> spectrum(4096);
+    HistogramGenerator histogram;
+    WaveformGenerator waveform;
+    RGBParadeGenerator parade;
+    VectorscopeGenerator vectorscope;
+    IntervalSet previews;
+
+    QVector<Benchmark> benchmarks;
+    benchmarks << Benchmark {QStringLiteral("project/load"), nullptr, [&]() {
+        QDomDocument doc;
+        doc.setContent(project);
+    }};
+    benchmarks << Benchmark {QStringLiteral("project/save"), nullptr, [&]() {
+        projectDoc.toByteArray();
+    }};
+    benchmarks << Benchmark {QStringLiteral("project/upgrade"), [&]() {
+        upgradeDoc.setContent(project);
+    }, [&]() {
+        DocumentUpgrader upgrader(upgradeDoc, 0.91);
+        upgrader.setSumAudioMix(true);
+        upgrader.run();
+    }};
+    benchmarks << Benchmark {QStringLiteral("project/archive"), nullptr, [&]() {
+        ArchiveWriter writer(archiveDir.filePath(QStringLiteral("project.tar.gz")));
+        writer.addData(project, QStringLiteral("project/project.kdenlive"), QString(), QString());
+        writer.addData(media, QStringLiteral("project/media.raw"), QString(), QString());
+        writer.write(false);
+    }};
+    benchmarks << Benchmark {QStringLiteral("audio/correlation"), nullptr, [&]() {
+        FFTCorrelation::correlate(mainEnvelope.constData(), mainEnvelope.size(), childEnvelope.constData(), childEnvelope.size(), correlation.data());
+    }};
+    benchmarks << Benchmark {QStringLiteral("audio/fft"), nullptr, [&]() {
+        if (audio.isValid()) {
+            for (int channel = 0; channel < audio.channels(); ++channel) {
+                fft.fftNormalized(audio, channel, audio.channels(), spectrum.data(), FFTTools::Window_Hamming, 8192);
+            }
+        }
+    }};
+    benchmarks << Benchmark {QStringLiteral("scopes/histogram"), nullptr, [&]() {
+        histogram.calculateHistogram(QSize(512, 300), frame, HistogramGenerator::ComponentY | HistogramGenerator::ComponentR | HistogramGenerator::ComponentG | HistogramGenerator::ComponentB, HistogramGenerator::Rec_709, false);
+    }};
+    benchmarks << Benchmark {QStringLiteral("scopes/waveform"), nullptr, [&]() {
+        waveform.calculateWaveform(QSize(720, 256), frame, WaveformGenerator::PaintMode_Yellow, true, WaveformGenerator::Rec_709);
+    }};
+    benchmarks << Benchmark {QStringLiteral("scopes/rgbparade"), nullptr, [&]() {
+        parade.calculateRGBParade(QSize(720, 256), frame, RGBParadeGenerator::PaintMode_RGB, true, true);
+    }};
+    benchmarks << Benchmark {QStringLiteral("scopes/vectorscope"), nullptr, [&]() {
+        vectorscope.calculateVectorscope(QSize(512, 512), frame, 1, VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::ColorSpace_YUV, false);
+    }};
+    benchmarks << Benchmark {QStringLiteral("video/uyvy-rgb24"), nullptr, [&]() {
+        ColorConversion::convertPacked(ColorConversion::Uyvy, packed.data(), chromaWidth * 4, ColorConversion::Rgb24, rgb.data(), width * 3, width, height);
+    }};
+    benchmarks << Benchmark {QStringLiteral("video/yuv420p-rgba"), nullptr, [&]() {
+        const uint8_t *y = planar.data();
+        const uint8_t *u = y + width * height;
+        const uint8_t *v = u + chromaWidth * height / 2;
+        ColorConversion::convertYuv420p(y, width, u, chromaWidth, v, chromaWidth, ColorConversion::Rgba, rgb.data(), width * 4, width, height, ColorConversion::Rec709);
+    }};
+    benchmarks << Benchmark {QStringLiteral("timeline/preview-intervals"), [&]() {
+        previews.clear();
+    }, [&]() {
+        // Chunks rendered in random order, then queried like the ruler and preview manager do
+        srand(7);
+        for (int i = 0; i < 5000; ++i) {
+            const int chunk = (rand() % 20000) * 25;
+            previews.insert(chunk, chunk + 25);
+        }
+        int found = 0;
+        for (int frame = 0; frame < 500000; frame += 97) {
+            found += previews.contains(frame) ? 1 : 0;
+            found += previews.intervals(frame, frame + 2000).count();
+        }
+        previews.remove(100000, 200000);
+        Q_UNUSED(found)
+    }};
+
+    benchmarks << Benchmark {QStringLiteral("timeline/snap-points"), nullptr, [&]() {
+        // Clip bounds and offsets collected, sorted and queried like the timeline snapping does
+        const double fps = 30000. / 1001.;
+        QSet<GenTime> snaps;
+        srand(11);
+        for (int i = 0; i < 20000; ++i) {
+            const int start = rand() % 500000;
+            snaps.insert(GenTime(start, fps));
+            snaps.insert(GenTime(start + 250, fps) - GenTime(100, fps));
+        }
+        QList<GenTime> sorted = snaps.toList();
+        std::sort(sorted.begin(), sorted.end());
+        int found = 0;
+        for (int frame = 0; frame < 500000; frame += 31) {
+            found += std::lower_bound(sorted.constBegin(), sorted.constEnd(), GenTime(frame, fps)) - sorted.constBegin();
+        }
+        Q_UNUSED(found)
+    }};
+
+    QVector<Result> results;
+    for (const Benchmark &benchmark : benchmarks) {
+        if (!filter.isEmpty() && !benchmark.name.contains(filter)) {
+            continue;
+        }
+        if (listOnly) {
+            std::cout << benchmark.name.toStdString() << std::endl;
+            continue;
+        }
+        const Result result = runBenchmark(benchmark, iterations);
+        results << result;
+        report << result.name.toStdString() << "\n\tmedian: " << result.median << " ms, min: " << result.min << " ms" << std::endl;
+    }
+    if (listOnly) {
+        return 0;
+    }
+    if (!audio.isValid()) {
+        std::cerr << "MLT noise producer not available, audio/fft did not run" << std::endl;
+    }
+
+    if (!output.isEmpty()) {
+        const QByteArray json = QJsonDocument(resultsToJson(results)).toJson();
+        if (output == QLatin1String("-")) {
+            std::cout << json.constData() << std::flush;
+        } else {
+            QFile file(output);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                std::cerr << "Cannot write " << output.toStdString() << std::endl;
+                return 1;
+            }
+            file.write(json);
+        }
+    }
+
+    int regressions = 0;
+    if (!baseline.isEmpty()) {
+        QFile file(baseline);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::cerr << "Cannot read " << baseline.toStdString() << std::endl;
+            return 1;
+        }
+        const QJsonArray reference = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("results")).toArray();
+        QMap<QString, double> referenceTimes;
+        for (const QJsonValue &value : reference) {
+            const QJsonObject item = value.toObject();
+            referenceTimes.insert(item.value(QStringLiteral("name")).toString(), item.value(QStringLiteral("median_ms")).toDouble());
+        }
+        report << "Comparison with " << baseline.toStdString() << ", tolerance " << tolerance << "%" << std::endl;
+        for (const Result &result : results) {
+            if (!referenceTimes.contains(result.name) || referenceTimes.value(result.name) <= 0) {
+                report << result.name.toStdString() << "\n\tnot in baseline" << std::endl;
+                continue;
+            }
+            const double reference = referenceTimes.value(result.name);
+            const double change = (result.median - reference) * 100 / reference;
+            const bool regressed = change > tolerance;
+            if (regressed) {
+                regressions++;
+            }
+            report << result.name.toStdString() << "\n\t" << reference << " ms -> " << result.median << " ms, " << (change > 0 ? "+" : "") << change << "%"
+                      << (regressed ? "  REGRESSION" : "") << std::endl;
+        }
+        report << regressions << " regression(s)" << std::endl;
+    }
+    Mlt::Factory::close();
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+/*
+Copyright (C) 2018  Jean-Baptiste Mardelle  <jb@kdenlive.org>
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "../src/lib/video/colorConversion.h"
+
+using namespace ColorConversion;
+
+void printUsage(const char *path)
+{
+    std::cout << "This executable compares the SIMD YUV to RGB kernels with the scalar" << std::endl
+              << "implementation, checks that they produce identical images and prints" << std::endl
+              << "the time per frame." << std::endl << std::endl
+              << path << " [<width> <height> [<iterations>]]" << std::endl
+              << "\t-h, --help\n\t\tDisplay this help" << std::endl
+              << "Default is a 1920x1080 frame converted 200 times." << std::endl;
+}
+
+struct Case {
+    const char *name;
+    bool planar;
+    PackedFormat packed;
+    DestFormat dest;
+};
+
+void convert(const Case &c, const std::vector<uint8_t> &src, std::vector<uint8_t> &dest, int width, int height, Implementation implementation)
+{
+    const int bpp = (c.dest == Rgba || c.dest == Bgra) ? 4 : 3;
+    const int chromaWidth = (width + 1) / 2;
+    if (c.planar) {
+        const uint8_t *y = src.data();
+        const uint8_t *u = y + width * height;
+        const uint8_t *v = u + chromaWidth * ((height + 1) / 2);
+        convertYuv420p(y, width, u, chromaWidth, v, chromaWidth, c.dest, dest.data(), width * bpp, width, height, Rec709, implementation);
+    } else {
+        convertPacked(c.packed, src.data(), chromaWidth * 4, c.dest, dest.data(), width * bpp, width, height, Rec601, implementation);
+    }
+}
+
+double timeConversion(const Case &c, const std::vector<uint8_t> &src, std::vector<uint8_t> &dest, int width, int height, Implementation implementation, int iterations)
+{
+    convert(c, src, dest, width, height, implementation);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        convert(c, src, dest, width, height, implementation);
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    int width = 1920;
+    int height = 1080;
+    int iterations = 200;
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    if (argc > 2) {
+        width = atoi(argv[1]);
+        height = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        iterations = atoi(argv[3]);
+    }
+    if (width < 2 || height < 2 || iterations < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Random data covers the whole range, including values outside of the legal YUV range
+    const int chromaWidth = (width + 1) / 2;
+    std::vector<uint8_t> packed(static_cast<size_t>(chromaWidth * 4 * height));
+    std::vector<uint8_t> planar(static_cast<size_t>(width * height + 2 * chromaWidth * ((height + 1) / 2)));
+    srand(42);
+    for (uint8_t &value : packed) {
+        value = static_cast<uint8_t>(rand() & 0xff);
+    }
+    for (uint8_t &value : planar) {
+        value = static_cast<uint8_t>(rand() & 0xff);
+    }
+
+    const Case cases[] = {
+        {"UYVY -> RGB24", false, Uyvy, Rgb24},
+        {"UYVY -> RGBA", false, Uyvy, Rgba},
+        {"YUYV -> BGR24", false, Yuyv, Bgr24},
+        {"YUYV -> BGRA", false, Yuyv, Bgra},
+        {"YUV420P -> RGB24", true, Uyvy, Rgb24},
+        {"YUV420P -> RGBA", true, Uyvy, Rgba}
+    };
+    const Implementation implementations[] = {Sse2, Avx2};
+
+    std::cout << width << "x" << height << ", " << iterations << " iterations, best implementation: " << implementationName(Auto) << std::endl;
+    bool success = true;
+    for (const Case &c : cases) {
+        const std::vector<uint8_t> &src = c.planar ? planar : packed;
+        const size_t size = static_cast<size_t>(width * height * ((c.dest == Rgba || c.dest == Bgra) ? 4 : 3));
+        std::vector<uint8_t> reference(size);
+        std::vector<uint8_t> result(size);
+        const double scalarTime = timeConversion(c, src, reference, width, height, Scalar, iterations);
+        std::cout << c.name << "\n\tscalar: " << scalarTime << " ms" << std::endl;
+        for (Implementation implementation : implementations) {
+            if (!isSupported(implementation)) {
+                continue;
+            }
+            const double time = timeConversion(c, src, result, width, height, implementation, iterations);
+            const bool identical = result == reference;
+            success = success && identical;
+            std::cout << "\t" << implementationName(implementation) << ": " << time << " ms, x" << scalarTime / time
+                      << (identical ? "" : "  MISMATCH with scalar output") << std::endl;
+        }
+    }
+    return success ? 0 : 1;
+}
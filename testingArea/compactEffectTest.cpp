@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2018  Jean-Baptiste Mardelle  <jb@kdenlive.org>
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#include <QDomDocument>
+#include <iostream>
+
+#include "../src/effectslist/compacteffect.h"
+
+// Checks that undo states of an effect only differing by their keyframes
+// share one interned definition, and are restored as they were.
+
+static int s_failures = 0;
+
+static void check(bool condition, const char *message)
+{
+    if (!condition) {
+        std::cerr << "FAIL: " << message << std::endl;
+        s_failures++;
+    }
+}
+
+static QDomElement keyframeEffect(QDomDocument &doc, const QString &keyframes)
+{
+    doc.setContent(QStringLiteral("<effect id=\"volume\" tag=\"volume\" kdenlive_ix=\"1\">"
+                                  "<name>Volume (keyframable)</name>"
+                                  "<description>Adjust audio volume with keyframes</description>"
+                                  "<parameter type=\"keyframe\" name=\"gain\" max=\"300\" min=\"0\" default=\"100\" factor=\"100\">"
+                                  "<name>Gain</name></parameter>"
+                                  "<parameter type=\"fixed\" name=\"window\" value=\"75\"/>"
+                                  "</effect>"));
+    QDomElement effect = doc.documentElement();
+    effect.firstChildElement(QStringLiteral("parameter")).setAttribute(QStringLiteral("keyframes"), keyframes);
+    return effect;
+}
+
+int main()
+{
+    QDomDocument firstDoc;
+    QDomDocument secondDoc;
+    const qint64 before = CompactEffect::allocatedMemory();
+    const CompactEffect first(keyframeEffect(firstDoc, QStringLiteral("0=100;50=80;100=100")));
+    const qint64 firstSize = CompactEffect::allocatedMemory() - before;
+    const CompactEffect second(keyframeEffect(secondDoc, QStringLiteral("0=100;50=60;100=100")));
+    const qint64 secondSize = CompactEffect::allocatedMemory() - before - firstSize;
+    // The second state only adds its own values, not a new definition
+    check(secondSize == second.memorySize(), "keyframe states do not share their definition");
+    check(secondSize < firstSize, "second keyframe state is not smaller than the first one");
+
+    // A delta between states sharing a definition only holds the changes
+    const CompactEffectDelta delta = second.diff(first);
+    check(delta.memorySize() < second.memorySize(), "keyframe delta stores the whole state");
+
+    const QDomElement restored = delta.apply(first).toElement();
+    const QDomElement gain = restored.firstChildElement(QStringLiteral("parameter"));
+    check(gain.attribute(QStringLiteral("keyframes")) == QLatin1String("0=100;50=60;100=100"), "keyframes not restored");
+    check(!gain.hasAttribute(QStringLiteral("value")), "value attribute added to the keyframe parameter");
+    check(gain.nextSiblingElement(QStringLiteral("parameter")).attribute(QStringLiteral("value")) == QLatin1String("75"), "parameter value not restored");
+    check(restored.attribute(QStringLiteral("kdenlive_ix")) == QLatin1String("1"), "effect attributes not restored");
+
+    if (s_failures == 0) {
+        std::cout << "compact effect keyframe states: OK" << std::endl;
+    }
+    return s_failures == 0 ? 0 : 1;
+}
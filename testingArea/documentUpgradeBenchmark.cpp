@@ -0,0 +1,181 @@
+/*
+Copyright (C) 2018  Jean-Baptiste Mardelle  <jb@kdenlive.org>
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStringList>
+#include <mlt++/Mlt.h>
+#include <iostream>
+#include <sys/resource.h>
+
+#include "../src/doc/documentupgrader.h"
+#include "../src/effectslist/effectslist.h"
+
+void printUsage(const char *path)
+{
+    std::cout << "This executable upgrades a corpus of legacy Kdenlive project files with the" << std::endl
+              << "single pass element upgrade, and prints the parsing, upgrade and orphaned" << std::endl
+              << "producers check time and the peak memory for each of them. Files are not" << std::endl
+              << "modified." << std::endl << std::endl
+              << path << " <project file or folder> [<project file or folder> ...]" << std::endl
+              << "\t-h, --help\n\t\tDisplay this help" << std::endl
+              << "\t--iterations=<count>\n\t\tUpgrade each project count times, default 5" << std::endl
+              << "Folders are searched recursively for .kdenlive files. Each project is measured" << std::endl
+              << "in its own process, so that its peak memory does not include the previous ones." << std::endl
+              << "Conversions restructuring projects older than 0.91 (Kdenlive 15.04) need the" << std::endl
+              << "application and are not measured." << std::endl;
+}
+
+// Peak resident memory of the process, in KB
+long peakMemory()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+double documentVersion(const QDomDocument &doc)
+{
+    QDomElement mlt = doc.firstChildElement(QStringLiteral("mlt"));
+    if (mlt.isNull()) {
+        mlt = doc.firstChildElement(QStringLiteral("westley"));
+    }
+    QDomElement kdenliveDoc = mlt.firstChildElement(QStringLiteral("kdenlivedoc"));
+    if (!kdenliveDoc.isNull() && kdenliveDoc.hasAttribute(QStringLiteral("version"))) {
+        QString version = kdenliveDoc.attribute(QStringLiteral("version"));
+        return version.replace(QLatin1Char(','), QLatin1Char('.')).toDouble();
+    }
+    QDomElement main = mlt.firstChildElement(QStringLiteral("playlist"));
+    return EffectsList::property(main, QStringLiteral("kdenlive:docproperties.version")).toDouble();
+}
+
+void collectFiles(const QString &path, QStringList &files)
+{
+    QFileInfo info(path);
+    if (info.isFile()) {
+        files << info.absoluteFilePath();
+        return;
+    }
+    QDir dir(path);
+    const QFileInfoList entries = dir.entryInfoList(QStringList() << QStringLiteral("*.kdenlive"), QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QFileInfo &entry : entries) {
+        collectFiles(entry.absoluteFilePath(), files);
+    }
+}
+
+// Measure one project, run in a child process. Prints the version, size in KB,
+// producer count, parse, upgrade and orphan check times in ms and the memory
+// used above the process startup in KB, separated by tabs.
+int measureFile(const QString &path, int iterations)
+{
+    // Needed by the geometry conversion of old transitions
+    Mlt::Factory::init();
+    const long baseMemory = peakMemory();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cerr << "Cannot read " << path.toStdString() << std::endl;
+        return 1;
+    }
+    const QByteArray data = file.readAll();
+    double parseTime = 0;
+    double upgradeTime = 0;
+    double orphanTime = 0;
+    double version = 0;
+    int producers = 0;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        QDomDocument doc;
+        if (!doc.setContent(data)) {
+            std::cerr << "Cannot parse " << path.toStdString() << std::endl;
+            return 1;
+        }
+        parseTime += timer.nsecsElapsed() / 1000000.;
+        version = documentVersion(doc);
+        timer.restart();
+        // Same steps as DocumentValidator::upgrade, with its default profile size
+        DocumentUpgrader upgrader(doc, version);
+        upgrader.setProfileSize(720, 576);
+        upgrader.setSumAudioMix(version < 0.96);
+        upgrader.run();
+        upgradeTime += timer.nsecsElapsed() / 1000000.;
+        timer.restart();
+        DocumentUpgrader::checkOrphanedProducers(doc, upgrader.producers(), upgrader.entries());
+        orphanTime += timer.nsecsElapsed() / 1000000.;
+        producers = upgrader.producers().count();
+    }
+    std::cout << version << '\t' << data.size() / 1024 << '\t' << producers << '\t' << parseTime / iterations << '\t' << upgradeTime / iterations << '\t'
+              << orphanTime / iterations << '\t' << peakMemory() - baseMemory << std::endl;
+    Mlt::Factory::close();
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    args.removeFirst();
+    int iterations = 5;
+    QStringList files;
+    for (const QString &arg : args) {
+        if (arg == QLatin1String("-h") || arg == QLatin1String("--help")) {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (arg.startsWith(QLatin1String("--iterations="))) {
+            iterations = qMax(1, arg.section(QLatin1Char('='), 1).toInt());
+            continue;
+        }
+        if (arg.startsWith(QLatin1String("--measure="))) {
+            // Internal, used for the child processes
+            return measureFile(arg.section(QLatin1Char('='), 1), iterations);
+        }
+        collectFiles(arg, files);
+    }
+    if (files.isEmpty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    double totalParse = 0;
+    double totalUpgrade = 0;
+    double totalOrphans = 0;
+    long maxMemory = 0;
+    for (const QString &path : files) {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(app.applicationFilePath(), QStringList() << QStringLiteral("--iterations=%1").arg(iterations) << QStringLiteral("--measure=") + path);
+        if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            continue;
+        }
+        const QStringList values = QString::fromUtf8(process.readAllStandardOutput()).trimmed().split(QLatin1Char('\t'));
+        if (values.count() != 7) {
+            std::cerr << "Cannot measure " << path.toStdString() << std::endl;
+            continue;
+        }
+        totalParse += values.at(3).toDouble();
+        totalUpgrade += values.at(4).toDouble();
+        totalOrphans += values.at(5).toDouble();
+        const long memory = values.at(6).toLong();
+        maxMemory = qMax(maxMemory, memory);
+        std::cout << QFileInfo(path).fileName().toStdString() << "\n\tversion: " << values.at(0).toStdString() << ", " << values.at(1).toStdString() << " KB, "
+                  << values.at(2).toStdString() << " producers"
+                  << "\n\tparse: " << values.at(3).toStdString() << " ms, upgrade: " << values.at(4).toStdString() << " ms, orphaned producers: " << values.at(5).toStdString()
+                  << " ms, peak memory: " << memory / 1024 << " MB" << std::endl;
+    }
+    std::cout << files.count() << " projects, parse: " << totalParse << " ms, upgrade: " << totalUpgrade << " ms, orphaned producers: " << totalOrphans
+              << " ms, largest peak memory: " << maxMemory / 1024 << " MB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+Copyright (C) 2018  Jean-Baptiste Mardelle  <jb@kdenlive.org>
+This file is part of kdenlive. See www.kdenlive.org.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+*/
+
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QCoreApplication>
+#include <QVector>
+#include <mlt++/Mlt.h>
+#include <iostream>
+#include <cstdlib>
+
+#include "../src/lib/video/sceneCutDetector.h"
+
+void printUsage(const char *path)
+{
+    std::cout << "This executable compares the scene cut detector used by the Auto split" << std::endl
+              << "clip job with MLT's motion_est filter on the given files." << std::endl << std::endl
+              << path << " <video file> [<video file> ...]" << std::endl
+              << "\t-h, --help\n\t\tDisplay this help" << std::endl
+              << "\t--profile=<profile>\n\t\tUse the given profile for calculation (run: melt -query profiles)" << std::endl
+              << "\t--threshold=<percent>\n\t\tScene cut threshold of the detector, default 30" << std::endl
+              << "\t--height=<pixels>\n\t\tFrame height used for analysis, default 120" << std::endl
+              << "\t--no-motion-est\n\t\tOnly run the scene cut detector" << std::endl
+              ;
+}
+
+QVector<int> runMotionEst(Mlt::Profile &profile, const char *file)
+{
+    QVector<int> cuts;
+    Mlt::Producer producer(profile, file);
+    if (!producer.is_valid()) {
+        return cuts;
+    }
+    // Same settings as the former Auto split job
+    Mlt::Filter filter(profile, "motion_est");
+    if (!filter.is_valid()) {
+        std::cerr << "motion_est filter not available" << std::endl;
+        return cuts;
+    }
+    filter.set("shot_change_list", 0);
+    filter.set("denoise", 0);
+    producer.attach(filter);
+    Mlt::Consumer consumer(profile, "null");
+    consumer.set("all", 1);
+    consumer.set("terminate_on_pause", 1);
+    consumer.set("real_time", -1);
+    consumer.set("rescale", "nearest");
+    consumer.set("deinterlace_method", "onefield");
+    consumer.set("top_field_first", -1);
+    consumer.connect(producer);
+    consumer.run();
+    const QStringList list = QString::fromLatin1(filter.get("shot_change_list")).split(QLatin1Char(';'), QString::SkipEmptyParts);
+    foreach (const QString &item, list) {
+        cuts << item.section(QLatin1Char('='), 0, 0).toInt();
+    }
+    return cuts;
+}
+
+void printCuts(const QVector<int> &cuts)
+{
+    foreach (int pos, cuts) {
+        std::cout << " " << pos;
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    args.removeAt(0);
+
+    std::string profileName = "atsc_1080p_24";
+    int threshold = 30;
+    int height = 120;
+    bool motionEst = true;
+
+    // Load arguments
+    foreach (const QString &str, args) {
+
+        if (str.startsWith(QLatin1String("--profile="))) {
+            profileName = str.section(QLatin1Char('='), 1).toStdString();
+            args.removeOne(str);
+
+        } else if (str.startsWith(QLatin1String("--threshold="))) {
+            threshold = str.section(QLatin1Char('='), 1).toInt();
+            args.removeOne(str);
+
+        } else if (str.startsWith(QLatin1String("--height="))) {
+            height = str.section(QLatin1Char('='), 1).toInt();
+            args.removeOne(str);
+
+        } else if (str == "-h" || str == "--help") {
+            printUsage(argv[0]);
+            return 0;
+
+        } else if (str == "--no-motion-est") {
+            motionEst = false;
+            args.removeOne(str);
+        }
+
+    }
+
+    if (args.isEmpty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Mlt::Factory::init();
+    Mlt::Profile profile(profileName.c_str());
+    profile.set_width(qRound(height * profile.dar() / 2) * 2);
+    profile.set_height(height);
+    // Scenes are at least one second long, as in the Auto split job
+    const int minSceneLength = qMax(1, qRound(profile.fps()));
+
+    foreach (const QString &file, args) {
+        const QByteArray path = file.toUtf8();
+        std::cout << "File: " << path.constData() << std::endl;
+        Mlt::Producer producer(profile, path.constData());
+        if (!producer.is_valid()) {
+            std::cerr << "Cannot open " << path.constData() << std::endl;
+            continue;
+        }
+        producer.set("audio_index", -1);
+        const int length = producer.get_length();
+
+        QElapsedTimer timer;
+        timer.start();
+        SceneCutDetector detector(threshold / 100.0, minSceneLength);
+        QVector<int> cuts = detector.analyse(producer, 0, length - 1);
+        qint64 elapsed = timer.elapsed();
+        std::cout << "  detector:   " << elapsed << " ms, " << (elapsed > 0 ? length * 1000 / elapsed : 0) << " fps, "
+                  << cuts.count() << " cuts:";
+        printCuts(cuts);
+
+        if (motionEst) {
+            timer.restart();
+            QVector<int> reference = runMotionEst(profile, path.constData());
+            elapsed = timer.elapsed();
+            std::cout << "  motion_est: " << elapsed << " ms, " << (elapsed > 0 ? length * 1000 / elapsed : 0) << " fps, "
+                      << reference.count() << " cuts:";
+            printCuts(reference);
+            // Cuts found by both methods within 2 frames
+            int matching = 0;
+            foreach (int pos, cuts) {
+                foreach (int ref, reference) {
+                    if (qAbs(pos - ref) <= 2) {
+                        matching++;
+                        break;
+                    }
+                }
+            }
+            std::cout << "  matching:   " << matching << "/" << reference.count() << std::endl;
+        }
+    }
+    Mlt::Factory::close();
+    return 0;
+}